@@ -20,6 +20,7 @@ include $(CLEAR_VARS)
 #LOCAL_SRC_FILES := fp.cpp vpu_lib.cpp
 LOCAL_SRC_FILES := fp.cpp ncs_lib.cpp
 LOCAL_C_INCLUDES += $(LOCAL_PATH)/../ncsdk/include \
+                    $(LOCAL_PATH)/../../vpu-hal2/ncsdk2/api/include \
                     $(LOCAL_PATH)/../graph_compiler_NCS \
                     $(LOCAL_PATH)
 LOCAL_SHARED_LIBRARIES := libmvnc liblog libutils
@@ -15,6 +15,9 @@ LOCAL_MODULE_OWNER := intel
 LOCAL_MULTILIB := 64
 LOCAL_SRC_FILES := \
     VpuDriver.cpp \
+    VpuExecutionPool.cpp \
+    VpuModelFile.cpp \
+    VpuPartitionedNetwork.cpp \
     VpuPreparedModel.cpp
 
 LOCAL_C_INCLUDES += \
@@ -103,6 +106,12 @@ include $(CLEAR_VARS)
 
 include $(ZPATH)/graphAPI/graphAPI.mk
 include $(ZPATH)/graphTests/graphTests.mk
+include $(ZPATH)/myriadTests/myriadTests.mk
+include $(ZPATH)/blobCompiler/blobCompiler.mk
+include $(ZPATH)/layoutBench/layoutBench.mk
+include $(ZPATH)/cpuBench/cpuBench.mk
+include $(ZPATH)/cpuLoadGen/cpuLoadGen.mk
+include $(ZPATH)/fp16Bench/fp16Bench.mk
 include $(ZPATH)/ncsdk2/api/src/Android.mk
 include $(ZPATH)/dl/Android.mk
 
@@ -123,9 +123,11 @@ Return<void> VpuDriver::getSupportedOperations(const Model& model,
         return Void();
     }
 
+    bool cpuFallback = VpuPreparedModel::cpuFallbackEnabled();
     for (int i = 0; i < count; i++) {
         const auto& operation = model.operations[i];
-        supported[i] = VpuPreparedModel::isOperationSupported(operation, model);
+        supported[i] = VpuPreparedModel::isOperationSupported(operation, model) ||
+                       (cpuFallback && VpuPreparedModel::isOperationSupportedOnCpu(operation, model));
     }
 
     cb(ErrorStatus::NONE, supported);
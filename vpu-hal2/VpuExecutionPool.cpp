@@ -0,0 +1,248 @@
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#define LOG_TAG "VpuExecutionPool"
+
+#include "VpuExecutionPool.h"
+
+#include <cutils/log.h>
+#include <cutils/properties.h>
+#include <sstream>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace V1_0 {
+namespace vpu_driver {
+
+static size_t roundUpPow2(size_t v) {
+    size_t p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+LatencyHistogram::LatencyHistogram() : mCount(0), mSum(0), mMax(0) {
+    for (auto& b : mBuckets) b.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::record(uint64_t us) {
+    size_t idx = 0;
+    while (idx + 1 < kBuckets && (1ULL << idx) <= us) idx++;
+    mBuckets[idx].fetch_add(1, std::memory_order_relaxed);
+    mCount.fetch_add(1, std::memory_order_relaxed);
+    mSum.fetch_add(us, std::memory_order_relaxed);
+
+    uint64_t prev = mMax.load(std::memory_order_relaxed);
+    while (us > prev && !mMax.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {}
+}
+
+uint64_t LatencyHistogram::mean() const {
+    uint64_t n = count();
+    return n ? mSum.load(std::memory_order_relaxed) / n : 0;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    uint64_t n = count();
+    if (n == 0) return 0;
+    uint64_t target = static_cast<uint64_t>(n * p / 100.0 + 0.5);
+    if (target == 0) target = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+        seen += mBuckets[i].load(std::memory_order_relaxed);
+        if (seen >= target) return 1ULL << i;
+    }
+    return max();
+}
+
+std::string LatencyHistogram::toString(const char* name) const {
+    std::ostringstream out;
+    out << name << ": count=" << count() << " mean=" << mean() << "us"
+        << " p50<=" << percentile(50) << "us p90<=" << percentile(90) << "us"
+        << " p99<=" << percentile(99) << "us max=" << max() << "us [";
+    bool first = true;
+    for (size_t i = 0; i < kBuckets; i++) {
+        uint64_t c = mBuckets[i].load(std::memory_order_relaxed);
+        if (!c) continue;
+        out << (first ? "" : " ") << "<" << (1ULL << i) << ":" << c;
+        first = false;
+    }
+    out << "]";
+    return out.str();
+}
+
+VpuExecutionPool::VpuExecutionPool(size_t numWorkers, size_t queueDepth)
+    : mSlots(roundUpPow2(queueDepth ? queueDepth : 1)),
+      mMask(mSlots.size() - 1),
+      mHead(0),
+      mTail(0),
+      mQueued(0),
+      mPending(0),
+      mStopped(false) {
+    for (size_t i = 0; i < mSlots.size(); i++) {
+        mSlots[i].seq.store(i, std::memory_order_relaxed);
+    }
+    if (numWorkers == 0) numWorkers = 1;
+    for (size_t i = 0; i < numWorkers; i++) {
+        mWorkers.emplace_back([this] { workerLoop(); });
+    }
+    ALOGI("execution pool started: %zu workers, queue depth %zu", numWorkers, mSlots.size());
+}
+
+VpuExecutionPool::~VpuExecutionPool() {
+    {
+        // Let the queued requests drain: each one holds a callback the
+        // runtime is waiting on.
+        std::unique_lock<std::mutex> lock(mMutex);
+        mSpaceCv.wait(lock, [this] { return mPending.load() == 0; });
+        mStopped = true;
+    }
+    mWorkCv.notify_all();
+    mSpaceCv.notify_all();
+    for (auto& t : mWorkers) {
+        if (t.joinable()) t.join();
+    }
+    ALOGI("%s", dumpStats().c_str());
+}
+
+std::unique_ptr<VpuExecutionPool> VpuExecutionPool::createFromProperties() {
+    int workers = property_get_int32("vendor.vpu.exec.workers", kDefaultWorkers);
+    int depth = property_get_int32("vendor.vpu.exec.queue_depth", kDefaultQueueDepth);
+    if (workers <= 0) workers = kDefaultWorkers;
+    if (depth <= 0) depth = kDefaultQueueDepth;
+    return std::unique_ptr<VpuExecutionPool>(new VpuExecutionPool(workers, depth));
+}
+
+// Bounded MPMC ring (D. Vyukov): each slot carries a sequence number that
+// tells producers and consumers whose turn it is, so both sides only need a
+// CAS on their own cursor.
+bool VpuExecutionPool::push(Job& job) {
+    size_t pos = mTail.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = mSlots[pos & mMask];
+        size_t seq = slot.seq.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (mTail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.job = std::move(job);
+                slot.enqueued = Clock::now();
+                slot.seq.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // full
+        } else {
+            pos = mTail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool VpuExecutionPool::pop(Job& job, Clock::time_point& enqueued) {
+    size_t pos = mHead.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = mSlots[pos & mMask];
+        size_t seq = slot.seq.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0) {
+            if (mHead.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                job = std::move(slot.job);
+                slot.job = nullptr;
+                enqueued = slot.enqueued;
+                slot.seq.store(pos + mMask + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // empty
+        } else {
+            pos = mHead.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool VpuExecutionPool::trySubmit(Job job) {
+    if (mStopped.load()) return false;
+    // Count the job before it becomes visible so a worker can never retire
+    // it ahead of the increment.
+    mPending.fetch_add(1);
+    mQueued.fetch_add(1);
+    if (!push(job)) {
+        mQueued.fetch_sub(1);
+        mPending.fetch_sub(1);
+        return false;
+    }
+    {
+        // Taking the lock orders this wakeup against a worker that is about
+        // to sleep, so it cannot be lost.
+        std::lock_guard<std::mutex> lock(mMutex);
+    }
+    mWorkCv.notify_one();
+    return true;
+}
+
+bool VpuExecutionPool::submit(Job job) {
+    for (;;) {
+        if (trySubmit(job)) return true;
+        if (mStopped.load()) return false;
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mSpaceCv.wait(lock, [this] {
+            return mStopped.load() || mQueued.load() < mSlots.size();
+        });
+    }
+}
+
+void VpuExecutionPool::workerLoop() {
+    for (;;) {
+        Job job;
+        Clock::time_point enqueued;
+        if (!pop(job, enqueued)) {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWorkCv.wait(lock, [this] { return mStopped.load() || mQueued.load() > 0; });
+            if (mStopped.load() && mQueued.load() == 0) return;
+            continue;
+        }
+        mQueued.fetch_sub(1);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+        }
+        mSpaceCv.notify_all();
+
+        auto start = Clock::now();
+        mQueueWait.record(
+            std::chrono::duration_cast<std::chrono::microseconds>(start - enqueued).count());
+        job();
+        mRunTime.record(
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+
+        mPending.fetch_sub(1);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+        }
+        mSpaceCv.notify_all();
+    }
+}
+
+std::string VpuExecutionPool::dumpStats() const {
+    std::ostringstream out;
+    out << "execution pool workers=" << mWorkers.size() << " depth=" << mSlots.size()
+        << " queued=" << queued() << " pending=" << pending() << "\n"
+        << mQueueWait.toString("queue-wait") << "\n"
+        << mRunTime.toString("run-time");
+    return out.str();
+}
+
+}  // namespace vpu_driver
+}  // namespace V1_0
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
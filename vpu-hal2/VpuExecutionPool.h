@@ -0,0 +1,127 @@
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ANDROID_ML_NN_VPU_EXECUTIONPOOL_H
+#define ANDROID_ML_NN_VPU_EXECUTIONPOOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace V1_0 {
+namespace vpu_driver {
+
+// Log2-bucketed latency histogram in microseconds. Bucket i counts samples
+// in [2^(i-1), 2^i) us, the last bucket also takes everything above.
+class LatencyHistogram {
+public:
+    static constexpr size_t kBuckets = 24;
+
+    LatencyHistogram();
+    void record(uint64_t us);
+    uint64_t count() const { return mCount.load(std::memory_order_relaxed); }
+    uint64_t max() const { return mMax.load(std::memory_order_relaxed); }
+    uint64_t mean() const;
+    // Upper bound (us) of the bucket holding the given percentile, 0 < p <= 100.
+    uint64_t percentile(double p) const;
+    std::string toString(const char* name) const;
+
+private:
+    std::atomic<uint64_t> mBuckets[kBuckets];
+    std::atomic<uint64_t> mCount;
+    std::atomic<uint64_t> mSum;
+    std::atomic<uint64_t> mMax;
+};
+
+// Fixed pool of worker threads fed by a bounded lock-free MPMC ring.
+// Producers never take a lock on the fast path; the mutex/condition pairs
+// are only used to park idle workers and to apply backpressure on submitters
+// when the ring is full.
+class VpuExecutionPool {
+public:
+    typedef std::function<void()> Job;
+
+    // Defaults used when the vendor.vpu.exec.* properties are not set.
+    static constexpr int kDefaultWorkers = 1;
+    static constexpr int kDefaultQueueDepth = 8;
+
+    // queueDepth is rounded up to the next power of two.
+    VpuExecutionPool(size_t numWorkers, size_t queueDepth);
+    ~VpuExecutionPool();
+
+    // Builds a pool sized from vendor.vpu.exec.workers / vendor.vpu.exec.queue_depth.
+    static std::unique_ptr<VpuExecutionPool> createFromProperties();
+
+    // Enqueues a job, blocking while the ring is full. Returns false once the
+    // pool is being torn down.
+    bool submit(Job job);
+    // Non-blocking variant, returns false when the ring is full.
+    bool trySubmit(Job job);
+
+    size_t numWorkers() const { return mWorkers.size(); }
+    size_t capacity() const { return mSlots.size(); }
+    // Jobs waiting in the ring, and jobs either waiting or running.
+    size_t queued() const { return mQueued.load(std::memory_order_relaxed); }
+    size_t pending() const { return mPending.load(std::memory_order_relaxed); }
+
+    const LatencyHistogram& queueWaitHistogram() const { return mQueueWait; }
+    const LatencyHistogram& runTimeHistogram() const { return mRunTime; }
+    std::string dumpStats() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Slot {
+        std::atomic<size_t> seq;
+        Job job;
+        Clock::time_point enqueued;
+    };
+
+    bool push(Job& job);
+    bool pop(Job& job, Clock::time_point& enqueued);
+    void workerLoop();
+
+    std::vector<Slot> mSlots;
+    size_t mMask;
+    std::atomic<size_t> mHead;
+    std::atomic<size_t> mTail;
+    std::atomic<size_t> mQueued;
+    std::atomic<size_t> mPending;
+    std::atomic<bool> mStopped;
+
+    std::mutex mMutex;
+    std::condition_variable mWorkCv;
+    std::condition_variable mSpaceCv;
+    std::vector<std::thread> mWorkers;
+
+    LatencyHistogram mQueueWait;
+    LatencyHistogram mRunTime;
+};
+
+}  // namespace vpu_driver
+}  // namespace V1_0
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif // ANDROID_ML_NN_VPU_EXECUTIONPOOL_H
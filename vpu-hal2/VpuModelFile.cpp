@@ -0,0 +1,250 @@
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#define LOG_TAG "VpuModelFile"
+
+#include "VpuModelFile.h"
+
+#include <cutils/log.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace V1_0 {
+namespace vpu_driver {
+
+// File layout: magic, version, body size, the body (model structure and
+// constants), then every pool at the next kPoolAlignment boundary.
+static const char kMagic[8] = {'V', 'P', 'U', 'M', 'O', 'D', 'E', 'L'};
+static constexpr uint32_t kVersion = 1;
+// covers 4k, 16k and 64k pages, mmap offsets must be page aligned
+static constexpr uint64_t kPoolAlignment = 64 * 1024;
+
+static uint64_t alignUp(uint64_t v) {
+    return (v + kPoolAlignment - 1) / kPoolAlignment * kPoolAlignment;
+}
+
+namespace {
+
+class Writer {
+public:
+    template <typename T>
+    void put(const T& v) { mBuf.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+    template <typename T>
+    void putVec(const hidl_vec<T>& v) {
+        put(static_cast<uint32_t>(v.size()));
+        mBuf.append(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+    }
+    const std::string& data() const { return mBuf; }
+
+private:
+    std::string mBuf;
+};
+
+class Reader {
+public:
+    explicit Reader(const std::vector<char>& buf) : mBuf(buf) {}
+
+    template <typename T>
+    bool get(T& v) {
+        if (mBuf.size() - mPos < sizeof(v)) return false;
+        memcpy(&v, mBuf.data() + mPos, sizeof(v));
+        mPos += sizeof(v);
+        return true;
+    }
+    template <typename T>
+    bool getVec(hidl_vec<T>& v) {
+        uint32_t count = 0;
+        if (!get(count) || (mBuf.size() - mPos) / sizeof(T) < count) return false;
+        v.resize(count);
+        memcpy(v.data(), mBuf.data() + mPos, count * sizeof(T));
+        mPos += count * sizeof(T);
+        return true;
+    }
+    // every entry takes at least a byte, bounds counts read from the file
+    bool fits(uint32_t count) const { return count <= mBuf.size() - mPos; }
+    bool done() const { return mPos == mBuf.size(); }
+
+private:
+    const std::vector<char>& mBuf;
+    size_t mPos = 0;
+};
+
+}  // namespace
+
+bool VpuModelFile::write(const std::string& path, const Model& model,
+                         const std::vector<const uint8_t*>& poolBuffers) {
+    if (poolBuffers.size() != model.pools.size()) {
+        return false;
+    }
+
+    Writer body;
+    body.put(static_cast<uint32_t>(model.operands.size()));
+    for (const auto& operand : model.operands) {
+        body.put(static_cast<int32_t>(operand.type));
+        body.putVec(operand.dimensions);
+        body.put(operand.numberOfConsumers);
+        body.put(operand.scale);
+        body.put(operand.zeroPoint);
+        body.put(static_cast<int32_t>(operand.lifetime));
+        body.put(operand.location.poolIndex);
+        body.put(operand.location.offset);
+        body.put(operand.location.length);
+    }
+    body.put(static_cast<uint32_t>(model.operations.size()));
+    for (const auto& operation : model.operations) {
+        body.put(static_cast<int32_t>(operation.type));
+        body.putVec(operation.inputs);
+        body.putVec(operation.outputs);
+    }
+    body.putVec(model.inputIndexes);
+    body.putVec(model.outputIndexes);
+    body.putVec(model.operandValues);
+    body.put(static_cast<uint32_t>(model.pools.size()));
+    for (const auto& pool : model.pools) {
+        body.put(static_cast<uint64_t>(pool.size()));
+    }
+
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        ALOGE("cannot create %s", path.c_str());
+        return false;
+    }
+    uint64_t bodySize = body.data().size();
+    file.write(kMagic, sizeof(kMagic));
+    file.write(reinterpret_cast<const char*>(&kVersion), sizeof(kVersion));
+    file.write(reinterpret_cast<const char*>(&bodySize), sizeof(bodySize));
+    file.write(body.data().data(), bodySize);
+
+    uint64_t pos = sizeof(kMagic) + sizeof(kVersion) + sizeof(bodySize) + bodySize;
+    for (size_t i = 0; i < model.pools.size(); i++) {
+        uint64_t start = alignUp(pos);
+        std::string padding(start - pos, '\0');
+        file.write(padding.data(), padding.size());
+        file.write(reinterpret_cast<const char*>(poolBuffers[i]), model.pools[i].size());
+        pos = start + model.pools[i].size();
+    }
+    file.close();
+    if (file.fail()) {
+        ALOGE("failed to write %s", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool VpuModelFile::read(const std::string& path) {
+    mFd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (mFd < 0) {
+        ALOGE("cannot open %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    char magic[sizeof(kMagic)];
+    uint32_t version = 0;
+    uint64_t bodySize = 0;
+    if (pread(mFd, magic, sizeof(magic), 0) != sizeof(magic) ||
+        memcmp(magic, kMagic, sizeof(magic)) != 0 ||
+        pread(mFd, &version, sizeof(version), sizeof(magic)) != sizeof(version) ||
+        version != kVersion ||
+        pread(mFd, &bodySize, sizeof(bodySize), sizeof(magic) + sizeof(version)) != sizeof(bodySize)) {
+        ALOGE("%s is not a model file of version %u", path.c_str(), kVersion);
+        return false;
+    }
+    uint64_t bodyStart = sizeof(magic) + sizeof(version) + sizeof(bodySize);
+    off_t fileSize = lseek(mFd, 0, SEEK_END);
+    if (fileSize < 0 || bodySize > static_cast<uint64_t>(fileSize) - bodyStart) {
+        ALOGE("%s is truncated", path.c_str());
+        return false;
+    }
+    std::vector<char> buf(bodySize);
+    if (pread(mFd, buf.data(), bodySize, bodyStart) != static_cast<ssize_t>(bodySize)) {
+        ALOGE("%s is truncated", path.c_str());
+        return false;
+    }
+
+    Reader body(buf);
+    uint32_t count = 0;
+    bool ok = body.get(count) && body.fits(count);
+    mModel.operands.resize(ok ? count : 0);
+    for (auto& operand : mModel.operands) {
+        int32_t type = 0;
+        int32_t lifetime = 0;
+        ok = ok && body.get(type) && body.getVec(operand.dimensions) &&
+             body.get(operand.numberOfConsumers) && body.get(operand.scale) &&
+             body.get(operand.zeroPoint) && body.get(lifetime) &&
+             body.get(operand.location.poolIndex) && body.get(operand.location.offset) &&
+             body.get(operand.location.length);
+        operand.type = static_cast<OperandType>(type);
+        operand.lifetime = static_cast<OperandLifeTime>(lifetime);
+    }
+    ok = ok && body.get(count) && body.fits(count);
+    mModel.operations.resize(ok ? count : 0);
+    for (auto& operation : mModel.operations) {
+        int32_t type = 0;
+        ok = ok && body.get(type) && body.getVec(operation.inputs) && body.getVec(operation.outputs);
+        operation.type = static_cast<OperationType>(type);
+    }
+    ok = ok && body.getVec(mModel.inputIndexes) && body.getVec(mModel.outputIndexes) &&
+         body.getVec(mModel.operandValues) && body.get(count) && body.fits(count);
+    std::vector<uint64_t> poolSizes(ok ? count : 0);
+    for (auto& size : poolSizes) {
+        ok = ok && body.get(size);
+    }
+    if (!ok || !body.done()) {
+        ALOGE("%s is corrupted", path.c_str());
+        return false;
+    }
+
+    uint64_t pos = bodyStart + bodySize;
+    mModel.pools.resize(poolSizes.size());
+    for (size_t i = 0; i < poolSizes.size(); i++) {
+        uint64_t start = alignUp(pos);
+        if (start + poolSizes[i] > static_cast<uint64_t>(fileSize)) {
+            ALOGE("%s is truncated", path.c_str());
+            return false;
+        }
+        // the layout RunTimePoolInfo::set expects: fd, prot, offset low, offset high
+        native_handle_t* handle = native_handle_create(1, 3);
+        handle->data[0] = mFd;
+        handle->data[1] = PROT_READ;
+        handle->data[2] = static_cast<int>(start & 0xffffffff);
+        handle->data[3] = static_cast<int>(start >> 32);
+        mHandles.push_back(handle);
+        mModel.pools[i] = hidl_memory("mmap_fd", handle, poolSizes[i]);
+        pos = start + poolSizes[i];
+    }
+    return true;
+}
+
+VpuModelFile::~VpuModelFile() {
+    mModel.pools.resize(0);
+    for (auto handle : mHandles) {
+        native_handle_delete(handle);
+    }
+    if (mFd >= 0) {
+        close(mFd);
+    }
+}
+
+}  // namespace vpu_driver
+}  // namespace V1_0
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,61 @@
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ANDROID_ML_NN_VPU_MODELFILE_H
+#define ANDROID_ML_NN_VPU_MODELFILE_H
+
+#include <android/hardware/neuralnetworks/1.0/types.h>
+#include <cutils/native_handle.h>
+#include <string>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace V1_0 {
+namespace vpu_driver {
+
+// An NNAPI model saved to a file, constants and memory pools included, so it
+// can be compiled away from the app that built it (vpu_blob_compiler).
+// Pools are stored page aligned and come back as mmap_fd memories of the file
+// itself, the way the runtime hands over ANeuralNetworksMemory_createFromFd,
+// so a model read back hashes and converts exactly like the original one.
+class VpuModelFile {
+public:
+    VpuModelFile() = default;
+    VpuModelFile(const VpuModelFile&) = delete;
+    VpuModelFile& operator=(const VpuModelFile&) = delete;
+    ~VpuModelFile();
+
+    // poolBuffers[i] holds model.pools[i].size() bytes.
+    static bool write(const std::string& path, const Model& model,
+                      const std::vector<const uint8_t*>& poolBuffers);
+
+    // The pools stay valid while this object lives.
+    bool read(const std::string& path);
+    const Model& model() const { return mModel; }
+
+private:
+    Model mModel;
+    int mFd = -1;
+    std::vector<native_handle_t*> mHandles;
+};
+
+}  // namespace vpu_driver
+}  // namespace V1_0
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif // ANDROID_ML_NN_VPU_MODELFILE_H
@@ -0,0 +1,403 @@
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#define LOG_TAG "VpuPartitionedNetwork"
+
+#include "VpuPartitionedNetwork.h"
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <cutils/log.h>
+#include <caseless.hpp>
+#include <graph_tools.hpp>
+#include <ie_graph_splitter.hpp>
+#include <ie_util_internal.hpp>
+#include <precision_utils.h>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace V1_0 {
+namespace vpu_driver {
+
+const char kAffinityVpu[] = "MYRIAD";
+const char kAffinityCpu[] = "CPU";
+
+// Failed requests never run their completion callback, infer() polls for
+// them this often while partitions are in flight.
+static constexpr int kPollMs = 5;
+
+static Layout layoutForRank(size_t rank) {
+    switch (rank) {
+        case 1: return Layout::C;
+        case 2: return Layout::NC;
+        case 3: return Layout::CHW;
+        default: return Layout::NCHW;
+    }
+}
+
+// MKLDNN reads weights and constants as float.
+static Blob::Ptr widenBlob(const Blob::Ptr& blob,
+                           std::unordered_map<Blob*, Blob::Ptr>& widened) {
+    if (blob == nullptr || blob->precision() != Precision::FP16) {
+        return blob;
+    }
+    auto it = widened.find(blob.get());
+    if (it != widened.end()) {
+        return it->second;
+    }
+    TensorDesc desc = blob->getTensorDesc();
+    desc.setPrecision(Precision::FP32);
+    auto fp32 = make_shared_blob<float>(desc);
+    fp32->allocate();
+    PrecisionUtils::f16tof32Arrays(fp32->buffer().as<float*>(),
+                                   blob->cbuffer().as<const short*>(), blob->size());
+    widened[blob.get()] = fp32;
+    return fp32;
+}
+
+// Clones a layer for a CPU partition. The graph builder emits a few layers
+// the MYRIAD plugin understands through params alone but MKLDNN expects as
+// their typed classes.
+static CNNLayerPtr cloneForCpu(const CNNLayer& source,
+                               std::unordered_map<Blob*, Blob::Ptr>& widened) {
+    CNNLayerPtr layer;
+    if (CaselessEq<std::string>()(source.type, "Clamp") &&
+        dynamic_cast<const ClampLayer*>(&source) == nullptr) {
+        auto clamp = std::make_shared<ClampLayer>(LayerParams{source.name, source.type, source.precision});
+        static_cast<CNNLayer&>(*clamp) = source;
+        clamp->min_value = clamp->GetParamAsFloat("min");
+        clamp->max_value = clamp->GetParamAsFloat("max");
+        layer = clamp;
+    } else {
+        layer = clonelayer(source);
+    }
+    if (dynamic_cast<EltwiseLayer*>(layer.get()) != nullptr) {
+        layer->type = "Eltwise";
+    }
+
+    layer->precision = Precision::FP32;
+    for (auto& blob : layer->blobs) {
+        blob.second = widenBlob(blob.second, widened);
+    }
+    if (auto weightable = dynamic_cast<WeightableLayer*>(layer.get())) {
+        weightable->_weights = widenBlob(weightable->_weights, widened);
+        weightable->_biases = widenBlob(weightable->_biases, widened);
+    }
+    return layer;
+}
+
+VpuPartitionedNetwork::VpuPartitionedNetwork(ICNNNetwork& network, TargetDevice vpuTarget,
+                                             const std::map<std::string, std::string>& vpuConfig,
+                                             bool load) {
+    bool anyCpu = false;
+    std::unordered_set<CNNLayer*> visited;
+    InputsDataMap inputs;
+    network.getInputsInfo(inputs);
+    for (const auto& input : inputs) {
+        for (const auto& next : input.second->getInputData()->getInputTo()) {
+            details::UnorderedDFS(visited, next.second, [&anyCpu](const CNNLayerPtr& layer) {
+                anyCpu |= layer->affinity == kAffinityCpu;
+            }, true);
+        }
+    }
+    if (!anyCpu && vpuTarget == TargetDevice::eMYRIAD) {
+        buildSinglePartition(network, vpuTarget, vpuConfig);
+    } else {
+        buildPartitions(network, vpuTarget, vpuConfig);
+    }
+    ALOGI("%s", describe().c_str());
+    if (load) {
+        loadPartitions();
+    }
+}
+
+void VpuPartitionedNetwork::buildSinglePartition(ICNNNetwork& network, TargetDevice vpuTarget,
+                                                 const std::map<std::string, std::string>& vpuConfig) {
+    mParts.resize(1);
+    Partition& part = mParts[0];
+    part.device = kAffinityVpu;
+    part.target = vpuTarget;
+    part.source = &network;
+    part.config = vpuConfig;
+
+    InputsDataMap inputs;
+    OutputsDataMap outputs;
+    network.getInputsInfo(inputs);
+    network.getOutputsInfo(outputs);
+    for (const auto& input : inputs) part.inputs.insert(input.first);
+    for (const auto& output : outputs) part.outputs.insert(output.first);
+}
+
+void VpuPartitionedNetwork::buildPartitions(ICNNNetwork& network, TargetDevice vpuTarget,
+                                            const std::map<std::string, std::string>& vpuConfig) {
+    std::vector<LayersSet> subgraphs = splitGraph(network, {kAffinityVpu, kAffinityCpu});
+
+    // Const layers have no inputs, the splitter walks from the network inputs
+    // and never sees them. They go with their first consumer.
+    std::unordered_map<CNNLayerPtr, size_t> owner;
+    for (size_t i = 0; i < subgraphs.size(); i++) {
+        for (const auto& layer : subgraphs[i]) owner[layer] = i;
+    }
+    for (size_t i = 0; i < subgraphs.size(); i++) {
+        std::vector<CNNLayerPtr> sources;
+        for (const auto& layer : subgraphs[i]) {
+            for (const auto& in : layer->insData) {
+                auto creator = in.lock()->creatorLayer.lock();
+                if (creator != nullptr && creator->insData.empty() && owner.count(creator) == 0) {
+                    owner[creator] = i;
+                    sources.push_back(creator);
+                }
+            }
+        }
+        subgraphs[i].insert(sources.begin(), sources.end());
+    }
+    sortSubgraphs(subgraphs);
+
+    OutputsDataMap networkOutputs;
+    network.getOutputsInfo(networkOutputs);
+
+    // producer partition of every tensor that leaves a partition
+    std::map<std::string, size_t> producer;
+    mParts.resize(subgraphs.size());
+    for (size_t i = 0; i < subgraphs.size(); i++) {
+        Partition& part = mParts[i];
+        std::vector<CNNLayerPtr> layers(subgraphs[i].begin(), subgraphs[i].end());
+        part.device = layers[0]->affinity;
+        bool onCpu = part.device == kAffinityCpu || vpuTarget == TargetDevice::eCPU;
+
+        std::unordered_map<Blob*, Blob::Ptr> widened;
+        if (onCpu) {
+            part.network = cloneNet(layers, [&widened](const CNNLayer& source) {
+                return cloneForCpu(source, widened);
+            });
+            part.network->setPrecision(Precision::FP32);
+            for (const auto& layer : part.network->allLayers()) {
+                for (const auto& out : layer.second->outData) out->setPrecision(Precision::FP32);
+            }
+            InputsDataMap inputs;
+            part.network->getInputsInfo(inputs);
+            for (const auto& input : inputs) input.second->setPrecision(Precision::FP32);
+        } else {
+            part.network = cloneNet(layers);
+            part.network->setPrecision(network.getPrecision());
+        }
+        part.source = part.network.get();
+
+        std::ostringstream name;
+        name << "part" << i << "." << part.device;
+        part.network->setName(name.str());
+
+        if (!onCpu) {
+            part.target = vpuTarget;
+            part.config = vpuConfig;
+            auto key = part.config.find(VPU_CONFIG_KEY(BLOB_CACHE_KEY));
+            if (key != part.config.end()) {
+                key->second += "." + name.str();
+            }
+        }
+
+        for (const auto& layer : layers) {
+            for (const auto& out : layer->outData) {
+                if (networkOutputs.count(out->getName())) {
+                    part.network->addOutput(out->getName());
+                }
+            }
+        }
+
+        InputsDataMap inputs;
+        OutputsDataMap outputs;
+        part.network->getInputsInfo(inputs);
+        part.network->getOutputsInfo(outputs);
+        for (const auto& input : inputs) part.inputs.insert(input.first);
+        for (const auto& output : outputs) {
+            part.outputs.insert(output.first);
+            producer[output.first] = i;
+        }
+    }
+
+    // Wire the partitions up. Tensors crossing a cut are handed over in FP32,
+    // with the plain layout for their rank on both sides; one that is also a
+    // network output keeps the layout the caller reads it back in.
+    for (size_t i = 0; i < mParts.size(); i++) {
+        Partition& part = mParts[i];
+        for (const auto& name : part.inputs) {
+            auto it = producer.find(name);
+            if (it == producer.end()) {
+                continue;  // network input
+            }
+            Partition& from = mParts[it->second];
+            from.dependents.push_back(i);
+
+            DataPtr out = from.network->getData(name);
+            DataPtr in = part.network->getData(name);
+            Layout layout = networkOutputs.count(name) ? out->getLayout()
+                                                       : layoutForRank(out->getTensorDesc().getDims().size());
+            for (const auto& data : {out, in}) {
+                data->setPrecision(Precision::FP32);
+                data->setLayout(layout);
+            }
+            if (!mIntermediates.count(name)) {
+                auto blob = make_shared_blob<float>(out->getTensorDesc());
+                blob->allocate();
+                mIntermediates[name] = blob;
+            }
+        }
+    }
+    // a partition reading several tensors of one producer waits for it once
+    for (auto& part : mParts) {
+        std::sort(part.dependents.begin(), part.dependents.end());
+        part.dependents.erase(std::unique(part.dependents.begin(), part.dependents.end()),
+                              part.dependents.end());
+    }
+    for (auto& part : mParts) {
+        for (auto dependent : part.dependents) mParts[dependent].numDependencies++;
+    }
+}
+
+void VpuPartitionedNetwork::loadPartitions() {
+    for (size_t i = 0; i < mParts.size(); i++) {
+        Partition& part = mParts[i];
+        part.engine.reset(new ExecuteNetwork(*part.source, part.target));
+        part.engine->loadNetwork(part.config);
+        if (part.network == nullptr) {
+            continue;  // not split, runs synchronously
+        }
+        for (const auto& intermediate : mIntermediates) {
+            if (part.inputs.count(intermediate.first) || part.outputs.count(intermediate.first)) {
+                part.engine->setBlob(intermediate.first, intermediate.second);
+            }
+        }
+        part.engine->setCompletionCallback([this, i]() { onPartitionDone(i); });
+    }
+}
+
+std::string VpuPartitionedNetwork::describe() const {
+    std::ostringstream out;
+    out << mParts.size() << " partition(s)";
+    for (size_t i = 0; i < mParts.size(); i++) {
+        const Partition& part = mParts[i];
+        out << "; #" << i << " " << part.device;
+        if (part.network != nullptr) out << " " << part.network->layerCount() << " layers";
+        out << " in " << part.inputs.size() << " out " << part.outputs.size();
+        if (!part.dependents.empty()) {
+            out << " ->";
+            for (auto dependent : part.dependents) out << " #" << dependent;
+        }
+    }
+    return out.str();
+}
+
+void VpuPartitionedNetwork::setBlob(const std::string& name, const Blob::Ptr& blob) {
+    for (auto& part : mParts) {
+        if (part.inputs.count(name) || part.outputs.count(name)) {
+            part.engine->setBlob(name, blob);
+        }
+    }
+}
+
+TBlob<float>::Ptr VpuPartitionedNetwork::getBlob(const std::string& name) {
+    if (mParts.size() == 1) {
+        return mParts[0].engine->getBlob(name);
+    }
+    for (auto& part : mParts) {
+        if (part.outputs.count(name) || part.inputs.count(name)) {
+            return part.engine->getBlob(name);
+        }
+    }
+    // internal to a partition
+    return nullptr;
+}
+
+void VpuPartitionedNetwork::onPartitionDone(size_t index) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mDone.push_back(index);
+    mDoneCv.notify_one();
+}
+
+void VpuPartitionedNetwork::infer() {
+    if (mParts.size() == 1 && mParts[0].network == nullptr) {
+        mParts[0].engine->Infer();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDone.clear();
+    }
+    std::vector<size_t> waitingFor(mParts.size());
+    std::vector<bool> running(mParts.size(), false);
+    size_t inFlight = 0;
+    std::ostringstream error;
+
+    auto start = [&](size_t i) {
+        try {
+            mParts[i].engine->startAsync();
+            running[i] = true;
+            inFlight++;
+        } catch (const std::exception& e) {
+            error << " #" << i << ": " << e.what();
+        }
+    };
+    for (size_t i = 0; i < mParts.size(); i++) {
+        waitingFor[i] = mParts[i].numDependencies;
+        if (waitingFor[i] == 0) start(i);
+    }
+
+    while (inFlight > 0) {
+        std::vector<size_t> finished;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mDoneCv.wait_for(lock, std::chrono::milliseconds(kPollMs),
+                             [this]() { return !mDone.empty(); });
+            finished.swap(mDone);
+        }
+        if (finished.empty()) {
+            for (size_t i = 0; i < mParts.size(); i++) {
+                if (!running[i]) continue;
+                StatusCode status = mParts[i].engine->wait(IInferRequest::WaitMode::STATUS_ONLY);
+                if (status != RESULT_NOT_READY && status != INFER_NOT_STARTED) finished.push_back(i);
+            }
+        }
+
+        for (auto i : finished) {
+            if (!running[i]) continue;  // polled before its callback arrived
+            running[i] = false;
+            inFlight--;
+            StatusCode status = mParts[i].engine->wait();
+            if (status != OK) {
+                error << " #" << i << " (" << mParts[i].device << ") status " << status;
+                continue;
+            }
+            if (!error.str().empty()) continue;  // let the running ones drain
+            for (auto dependent : mParts[i].dependents) {
+                if (--waitingFor[dependent] == 0) start(dependent);
+            }
+        }
+    }
+
+    if (!error.str().empty()) {
+        THROW_IE_EXCEPTION << "partitioned inference failed:" << error.str();
+    }
+}
+
+}  // namespace vpu_driver
+}  // namespace V1_0
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,117 @@
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ANDROID_ML_NN_VPU_PARTITIONEDNETWORK_H
+#define ANDROID_ML_NN_VPU_PARTITIONEDNETWORK_H
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <cnn_network_impl.hpp>
+#include "vpu_plugin.hpp"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace V1_0 {
+namespace vpu_driver {
+
+// Layer affinities understood by VpuPartitionedNetwork.
+extern const char kAffinityVpu[];
+extern const char kAffinityCpu[];
+
+// Runs a network whose layers are tagged with kAffinityVpu or kAffinityCpu.
+// The network is cut into connected single-device partitions (splitGraph),
+// VPU partitions are compiled for the stick and CPU partitions are loaded on
+// the MKLDNN plugin with their FP16 weights widened to FP32. Tensors crossing
+// a cut live in one FP32 blob bound to the producing and to every consuming
+// partition, so nothing is copied between them. infer() starts each partition
+// as soon as the partitions it reads from are done, independent branches run
+// on both devices at the same time.
+// A network with no CPU layers stays a single partition on the original
+// network, exactly like a plain ExecuteNetwork.
+class VpuPartitionedNetwork {
+public:
+    // vpuTarget is the device VPU partitions load on; eCPU runs everything on
+    // MKLDNN, which is how the partitioning is exercised without a stick.
+    // With load false the partitions are only planned, see forEachVpuPartition.
+    VpuPartitionedNetwork(ICNNNetwork& network, TargetDevice vpuTarget,
+                          const std::map<std::string, std::string>& vpuConfig,
+                          bool load = true);
+
+    size_t numPartitions() const { return mParts.size(); }
+    std::string describe() const;
+
+    // Calls fn(network, config) with what each VPU partition is loaded with,
+    // so their blobs can be compiled ahead of time.
+    template <typename F>
+    void forEachVpuPartition(F fn) const {
+        for (const auto& part : mParts) {
+            if (part.target != TargetDevice::eCPU) fn(*part.source, part.config);
+        }
+    }
+
+    // Binds a network input or output to every partition reading or writing it.
+    void setBlob(const std::string& name, const Blob::Ptr& blob);
+    // Debug only: the blob of whichever partition produces or reads the tensor,
+    // null for tensors internal to one partition of a split network.
+    TBlob<float>::Ptr getBlob(const std::string& name);
+
+    // Runs all partitions once. Throws when one of them fails.
+    void infer();
+
+private:
+    struct Partition {
+        std::string device;
+        TargetDevice target = TargetDevice::eCPU;
+        // null for the single partition of a network with no CPU layers
+        InferenceEngine::details::CNNNetworkImplPtr network;
+        // what the engine is loaded from, network or the original one
+        ICNNNetwork* source = nullptr;
+        std::map<std::string, std::string> config;
+        std::unique_ptr<ExecuteNetwork> engine;
+        std::set<std::string> inputs;
+        std::set<std::string> outputs;
+        std::vector<size_t> dependents;
+        size_t numDependencies = 0;
+    };
+
+    void buildSinglePartition(ICNNNetwork& network, TargetDevice vpuTarget,
+                              const std::map<std::string, std::string>& vpuConfig);
+    void buildPartitions(ICNNNetwork& network, TargetDevice vpuTarget,
+                         const std::map<std::string, std::string>& vpuConfig);
+    void loadPartitions();
+    void onPartitionDone(size_t index);
+
+    std::vector<Partition> mParts;
+    // Blobs handed between partitions, they stay bound for the model lifetime.
+    std::map<std::string, Blob::Ptr> mIntermediates;
+
+    std::mutex mMutex;
+    std::condition_variable mDoneCv;
+    std::vector<size_t> mDone;
+};
+
+}  // namespace vpu_driver
+}  // namespace V1_0
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif // ANDROID_ML_NN_VPU_PARTITIONEDNETWORK_H
@@ -19,9 +19,18 @@
 
 #include <android-base/logging.h>
 #include <cutils/log.h>
+#include <cutils/properties.h>
+#include <algorithm>
+#include <linux/kcmp.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include <thread>
 #include "VpuPreparedModel.h"
+#include "VpuModelFile.h"
 #include "vpu_plugin.hpp"
+#include "IRConstantStore.h"
+#include "precision_utils.h"
+#include "fnv1a_hash.h"
 #include <fstream>
 
 #define DISABLE_ALL_QUANT
@@ -203,140 +212,14 @@ std::vector<uint32_t>& shapeToDims(const TensorDims& shape, Layout layout)
 }
 
 
-// Function to convert F32 into F16
-// F32: exp_bias:127 SEEEEEEE EMMMMMMM MMMMMMMM MMMMMMMM.
-// F16: exp_bias:15  SEEEEEMM MMMMMMMM
-#define EXP_MASK_F32 	 0x7F800000U
-#define EXP_MASK_F16     0x7C00U
-
-
-// small helper function to represent uint32_t value as float32
-float asfloat(uint32_t v) {
-    return *reinterpret_cast<float *>(&v);
-}
-
-// Function to convert F32 into F16
-float f16tof32(short x) {
-    // this is storage for output result
-    uint32_t u = x;
-
-    // get sign in 32bit format
-    uint32_t s = ((u & 0x8000) << 16);
-
-    // check for NAN and INF
-    if ((u & EXP_MASK_F16) == EXP_MASK_F16) {
-        // keep mantissa only
-        u &= 0x03FF;
-
-        // check if it is NAN and raise 10 bit to be align with intrin
-        if (u) {
-            u |= 0x0200;
-        }
-
-        u <<= (23 - 10);
-        u |= EXP_MASK_F32;
-        u |= s;
-    } else if ((x & EXP_MASK_F16) == 0) {  // check for zero and denormals. both are converted to zero
-        u = s;
-    } else {
-        // abs
-        u = (u & 0x7FFF);
-
-        // shift mantissa and exp from f16 to f32 position
-        u <<= (23 - 10);
-
-        // new bias for exp (f16 bias is 15 and f32 bias is 127)
-        u += ((127 - 15) << 23);
-
-        // add sign
-        u |= s;
-    }
-
-    // finaly represent result as float and return
-    return *reinterpret_cast<float *>(&u);
-}
-
-// This function convert f32 to f16 with rounding to nearest value to minimize error
-// the denormal values are converted to 0.
-short f32tof16(float x) {
-    // create minimal positive normal f16 value in f32 format
-    // exp:-14,mantissa:0 -> 2^-14 * 1.0
-    static float min16 = asfloat((127 - 14) << 23);
-
-    // create maximal positive normal f16 value in f32 and f16 formats
-    // exp:15,mantissa:11111 -> 2^15 * 1.(11111)
-    static float max16 = asfloat(((127 + 15) << 23) | 0x007FE000);
-    static uint32_t max16f16 = ((15 + 15) << 10) | 0x3FF;
-
-    // define and declare variable for intermidiate and output result
-    // the union is used to simplify representation changing
-    union {
-        float f;
-        uint32_t u;
-    } v;
-    v.f = x;
-
-    // get sign in 16bit format
-    uint32_t s = (v.u >> 16) & 0x8000;  // sign 16:  00000000 00000000 10000000 00000000
-
-    // make it abs
-    v.u &= 0x7FFFFFFF;  // abs mask: 01111111 11111111 11111111 11111111
-
-    // check NAN and INF
-    if ((v.u & EXP_MASK_F32) == EXP_MASK_F32) {
-        if (v.u & 0x007FFFFF) {
-            return s | (v.u >> (23 - 10)) | 0x0200;  // return NAN f16
-        } else {
-            return s | (v.u >> (23 - 10));  // return INF f16
-        }
-    }
-
-    // to make f32 round to nearest f16
-    // create halfULP for f16 and add it to origin value
-    float halfULP = asfloat(v.u & EXP_MASK_F32) * asfloat((127 - 11) << 23);
-    v.f += halfULP;
-
-    // if input value is not fit normalized f16 then return 0
-    // denormals are not covered by this code and just converted to 0
-    if (v.f < min16 * 0.5F) {
-        return s;
-    }
-
-    // if input value between min16/2 and min16 then return min16
-    if (v.f < min16) {
-        return s | (1 << 10);
-    }
-
-    // if input value more than maximal allowed value for f16
-    // then return this maximal value
-    if (v.f >= max16) {
-        return max16f16 | s;
-    }
-
-    // change exp bias from 127 to 15
-    v.u -= ((127 - 15) << 23);
-
-    // round to f16
-    v.u >>= (23 - 10);
-
-    return v.u | s;
-}
-
 void f16tof32Arrays(float *dst, const short *src, uint32_t& nelem, float scale = 1, float bias = 0) {
     VLOG(L1, "convert f16tof32Arrays...\n");
-    const short *_src = reinterpret_cast<const short *>(src);
-
-    for (uint32_t i = 0; i < nelem; i++) {
-        dst[i] = f16tof32(_src[i]) * scale + bias;
-    }
+    InferenceEngine::PrecisionUtils::f16tof32Arrays(dst, src, nelem, scale, bias);
 }
 
 void f32tof16Arrays(short *dst, const float *src, uint32_t& nelem, float scale = 1, float bias = 0) {
     VLOG(L1, "convert f32tof16Arrays...");
-    for (uint32_t i = 0; i < nelem; i++) {
-        dst[i] = f32tof16(src[i] * scale + bias);
-        //VLOG(L1, "element no: %d", i);
-    }
+    InferenceEngine::PrecisionUtils::f32tof16Arrays(dst, src, nelem, scale, bias);
 }
 
 int sizeOfData(OperandType type, std::vector<uint32_t> dims)
@@ -445,6 +328,95 @@ bool setRunTimePoolInfosFromHidlMemories(std::vector<RunTimePoolInfo>* poolInfos
     return true;
 }
 
+MappedPool::~MappedPool() {
+    if (info.buffer != nullptr && info.hidlMemory.name() == "mmap_fd") {
+        munmap(info.buffer, info.hidlMemory.size());
+    }
+}
+
+RequestPoolCache::RequestPoolCache(size_t capacity)
+    : mCapacity(capacity), mEnabled(true), mHits(0), mMisses(0) {
+}
+
+bool RequestPoolCache::sameFile(int fd1, int fd2) {
+    pid_t pid = getpid();
+    int ret = syscall(SYS_kcmp, pid, pid, KCMP_FILE, fd1, fd2);
+    if (ret < 0) {
+        ALOGE("kcmp failed (errno %d), request pools will be mapped per execution", errno);
+        mEnabled = false;
+        mEntries.clear();
+        return false;
+    }
+    return ret == 0;
+}
+
+std::shared_ptr<MappedPool> RequestPoolCache::lookup(const hidl_memory& hidlMemory) {
+    const native_handle_t* handle = hidlMemory.handle();
+    for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+        const hidl_memory& cached = (*it)->info.hidlMemory;
+        const native_handle_t* cachedHandle = cached.handle();
+        if (cached.name() != hidlMemory.name() || cached.size() != hidlMemory.size() ||
+            cachedHandle->numInts != handle->numInts) {
+            continue;
+        }
+        // mmap_fd carries prot and offset after the fd
+        if (!std::equal(cachedHandle->data + cachedHandle->numFds,
+                        cachedHandle->data + cachedHandle->numFds + cachedHandle->numInts,
+                        handle->data + handle->numFds)) {
+            continue;
+        }
+        if (!sameFile(cachedHandle->data[0], handle->data[0])) {
+            if (!mEnabled) return nullptr;
+            continue;
+        }
+        auto pool = *it;
+        mEntries.splice(mEntries.begin(), mEntries, it);
+        return pool;
+    }
+    return nullptr;
+}
+
+void RequestPoolCache::insert(const std::shared_ptr<MappedPool>& pool) {
+    mEntries.push_front(pool);
+    // Evicted mappings stay alive until in-flight executions drop them.
+    while (mEntries.size() > mCapacity) {
+        mEntries.pop_back();
+    }
+}
+
+bool RequestPoolCache::map(const hidl_vec<hidl_memory>& pools,
+                           std::vector<std::shared_ptr<MappedPool>>* mapped) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mapped->resize(pools.size());
+    for (size_t i = 0; i < pools.size(); i++) {
+        const hidl_memory& hidlMemory = pools[i];
+        const native_handle_t* handle = hidlMemory.handle();
+        bool cacheable = mEnabled && handle != nullptr && handle->numFds == 1;
+
+        std::shared_ptr<MappedPool> pool = cacheable ? lookup(hidlMemory) : nullptr;
+        if (pool != nullptr) {
+            if (pool->info.memory != nullptr) {
+                pool->info.memory->update();
+            }
+            mHits++;
+        } else {
+            pool = std::make_shared<MappedPool>();
+            if (!pool->info.set(hidlMemory)) {
+                LOG(ERROR) << "Could not map pool";
+                return false;
+            }
+            // set() keeps a copy of hidlMemory that owns a clone of the handle,
+            // which pins the open file while the entry is cached.
+            if (cacheable && mEnabled) {
+                insert(pool);
+            }
+            mMisses++;
+        }
+        (*mapped)[i] = pool;
+    }
+    return true;
+}
+
 // Updates the RunTimeOperandInfo with the newly calculated shape.
 // Allocate the buffer if we need to.
 static bool setInfoAndAllocateIfNeeded(RunTimeOperandInfo* info, const Shape& shape) {
@@ -526,11 +498,14 @@ IRBlob::Ptr Permute(IRBlob::Ptr ptr, const vec<unsigned int> &order)
 {
   VLOG(L1, "Permute");
 	auto dims = permuteDims(ptr->getTensorDesc().getDims(), order);
-	ptr->getTensorDesc().setDims(dims);
-//  TensorDesc& td = ptr->getTensorDesc();
-//  td.setDims(dims);
+	// only the dims change; the constant store may share ptr with other
+	// layers and models, so the relabelled dims go on a view of its buffer
+	// that holds ptr until the view is released
+	IRBlob::Ptr permuted(new IRBlob(TensorDesc(ptr->precision(), dims, ptr->getTensorDesc().getLayout()),
+	                                ptr->buffer().as<short*>()),
+	                     [ptr](IRBlob *view) { delete view; });
 
-  return ptr;
+  return permuted;
 }
 
 OutputPort VpuPreparedModel::handleFusion(const OutputPort &out, int32_t fusedOp)
@@ -541,7 +516,7 @@ OutputPort VpuPreparedModel::handleFusion(const OutputPort &out, int32_t fusedOp
     }
     else if (fusedOp == (int32_t)FusedActivationFunc::RELU1) {
       VLOG(L1, "fusedOp is RELU1");
-      return Clamp(out, 0, 1);
+      return Clamp(out, -1, 1);
     }
     else if (fusedOp == (int32_t)FusedActivationFunc::RELU6) {
       VLOG(L1, "fusedOp is RELU6");
@@ -657,21 +632,20 @@ IRBlob::Ptr VpuPreparedModel::GetConstOperandAsTensor(uint32_t index)
     else order = {0}; //(op.dimensions.size() < 2)
 
 		TensorDesc td(InferenceEngine::Precision::FP16, permuteDims(toDims(op.dimensions), order), Layout::ANY);
-        // todo: create a readOnly blob that accepts const pointers
-		InferenceEngine::TBlob<short>::Ptr blob = std::make_shared<InferenceEngine::TBlob<short>>(td);
-		blob->allocate();
-		auto mem = blob->data();
-		short *fp16Array = mem.as<short*>();
-		// convert from [(float *)buf, len] to fp16Array,
     uint32_t nelem = getNumberOfElements(op.dimensions);
-    VLOG(L1, "Model buffer oplength = %d bytes nelem= %d fp16Array= %d bytes sizeof model buf= %d bytes\n", len , nelem, sizeof(fp16Array), sizeof(buf));
-    if (blob->size() != nelem) {
-    VLOG(L1, "Model buffer len = %d bytes nelem= %d fp16Array= %d bytes\n",len , nelem, sizeof(fp16Array));
+    VLOG(L1, "Model buffer oplength = %d bytes nelem= %d", len, nelem);
+    if (len < nelem * sizeof(float)) {
+    VLOG(L1, "Model buffer len = %d bytes nelem= %d\n", len, nelem);
     nnAssert(true);
     }
 
-    f32tof16Arrays(fp16Array, (float *)buf, nelem);
-		return blob;
+    // the same weights in another layer, model or prepared model share one
+    // FP16 copy
+    return IRConstantStore::instance().get(buf, sizeof(float), td,
+        [](void *dst, const void *src, size_t n) {
+            InferenceEngine::PrecisionUtils::f32tof16Arrays(static_cast<short*>(dst),
+                                                            static_cast<const float*>(src), n);
+        });
 
 #else //FP32 support
         vec<unsigned int> order;
@@ -846,8 +820,9 @@ OutputPort VpuPreparedModel::getPort(int index)
                   mPorts[index]->setLayout(NC);
                   break;
               case 4:
-                  //mPorts[index]->setLayout(NHWC);
-                  mPorts[index]->setLayout(NCHW);
+                  // the bytes stay NHWC as NNAPI hands them over; the device
+                  // graph takes them so and reorders there if it has to
+                  mPorts[index]->setLayout(NHWC);
                   break;
               case 1:
                   mPorts[index]->setLayout(C);
@@ -1145,6 +1120,99 @@ bool VpuPreparedModel::initializeRunTimeOperandInfo() {
     return true;
 }
 
+// Bump when the NNAPI -> IR conversion or the way the model is hashed
+// changes, so blobs compiled from the old IR are not picked up from the blob
+// cache.
+static const uint32_t kModelHashVersion = 3;
+
+using InferenceEngine::fnv1aValue;
+
+template <typename T>
+static uint64_t hashVec(uint64_t h, const hidl_vec<T>& vec) {
+    return InferenceEngine::fnv1aSized(h, vec.data(), vec.size() * sizeof(T));
+}
+
+// Content hash of the model, including the constant data in operandValues
+// and the memory pools. Used as the blob cache key.
+std::string VpuPreparedModel::computeModelHash() const {
+    uint64_t h = InferenceEngine::kFnv1aOffset;
+    h = fnv1aValue(h, kModelHashVersion);
+
+    h = fnv1aValue(h, static_cast<uint64_t>(mModel.operands.size()));
+    for (const auto& operand : mModel.operands) {
+        h = fnv1aValue(h, static_cast<int32_t>(operand.type));
+        h = hashVec(h, operand.dimensions);
+        h = fnv1aValue(h, operand.scale);
+        h = fnv1aValue(h, operand.zeroPoint);
+        h = fnv1aValue(h, static_cast<int32_t>(operand.lifetime));
+        h = fnv1aValue(h, operand.location.poolIndex);
+        h = fnv1aValue(h, operand.location.offset);
+        h = fnv1aValue(h, operand.location.length);
+    }
+    h = fnv1aValue(h, static_cast<uint64_t>(mModel.operations.size()));
+    for (const auto& operation : mModel.operations) {
+        h = fnv1aValue(h, static_cast<int32_t>(operation.type));
+        h = hashVec(h, operation.inputs);
+        h = hashVec(h, operation.outputs);
+    }
+    h = hashVec(h, mModel.inputIndexes);
+    h = hashVec(h, mModel.outputIndexes);
+    h = hashVec(h, mModel.operandValues);
+
+    h = fnv1aValue(h, static_cast<uint64_t>(mPoolInfos.size()));
+    for (size_t i = 0; i < mPoolInfos.size(); i++) {
+        h = InferenceEngine::fnv1aSized(h, mPoolInfos[i].buffer, mModel.pools[i].size());
+    }
+
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(h));
+    return hex;
+}
+
+// Blob cache settings handed to the MYRIAD plugin, see README.md.
+static std::map<std::string, std::string> blobCacheConfig(const std::string& modelHash) {
+    std::map<std::string, std::string> config;
+    char dir[PROPERTY_VALUE_MAX];
+    char prebuiltDir[PROPERTY_VALUE_MAX];
+    property_get("vendor.vpu.blob_cache.dir", dir, "/data/vendor/vpu/blob_cache");
+    property_get("vendor.vpu.blob_cache.prebuilt_dir", prebuiltDir, "/vendor/etc/vpu/blobs");
+    int sizeMb = property_get_int32("vendor.vpu.blob_cache.size_mb", 64);
+    if (sizeMb > 0 && dir[0] != '\0') {
+        config[VPU_CONFIG_KEY(BLOB_CACHE_DIR)] = dir;
+        config[VPU_CONFIG_KEY(BLOB_CACHE_SIZE)] = std::to_string(sizeMb);
+    }
+    if (prebuiltDir[0] != '\0') {
+        config[VPU_CONFIG_KEY(BLOB_CACHE_PREBUILT_DIR)] = prebuiltDir;
+    }
+    if (!config.empty()) {
+        config[VPU_CONFIG_KEY(BLOB_CACHE_KEY)] = modelHash;
+    }
+    return config;
+}
+
+// vendor.vpu.dump_dir keeps the model, its IR and graph as <hash>.nnmodel,
+// <hash>.xml/.bin and <hash>.dot, the first two are vpu_blob_compiler input.
+void VpuPreparedModel::dumpModel(const std::string& modelHash)
+{
+    char dir[PROPERTY_VALUE_MAX];
+    property_get("vendor.vpu.dump_dir", dir, "");
+    if (dir[0] == '\0') {
+        return;
+    }
+    std::string base = std::string(dir) + "/" + modelHash;
+
+    std::vector<const uint8_t*> pools;
+    for (const auto& pool : mPoolInfos) pools.push_back(pool.buffer);
+    VpuModelFile::write(base + ".nnmodel", mModel, pools);
+
+    mNet.save(base);
+    std::fstream dot;
+    dot.open(base + ".dot", std::ios::out);
+    mNet.crateDotFile(dot);
+    dot.close();
+    VLOG(L1, "model dumped to %s.*", base.c_str());
+}
+
 /*
 bool VpuPreparedModel::initialize() {
     return setRunTimePoolInfosFromHidlMemories(&mPoolInfos, mModel.pools);
@@ -1153,12 +1221,45 @@ bool VpuPreparedModel::initialize() {
 bool VpuPreparedModel::initialize()
 {
     VLOG(L1, "initialize");
+    if (!prepareNetwork()) {
+        return false;
+    }
+
+    //vendor.vpu.device=CPU stands the CPU plugin in for the Myriad, see README.md
+    char device[PROPERTY_VALUE_MAX];
+    property_get("vendor.vpu.device", device, "MYRIAD");
+    TargetDevice vpuTarget = strcasecmp(device, "CPU") == 0 ? TargetDevice::eCPU : TargetDevice::eMYRIAD;
+
+    VLOG(L1, "initialize ExecuteNetwork");
+    try {
+        enginePtr.reset(new VpuPartitionedNetwork(*mNet.getNetwork(), vpuTarget,
+                                                  blobCacheConfig(mModelHash)));
+    } catch (const std::exception& e) {
+        ALOGE("failed to load network: %s", e.what());
+        return false;
+    }
+
+    mExecPool = VpuExecutionPool::createFromProperties();
+
+    return true;
+}
+
+bool VpuPreparedModel::prepareNetwork()
+{
     bool success = false;
+    IRBuilder::layer_name_count = 0;
 
     //Check operation supoorted or not, user may not call getOpertionSupported()
+    //Operations the Myriad can't run go to the CPU plugin when the fallback is on
+    bool cpuFallback = cpuFallbackEnabled();
+    std::vector<bool> opOnCpu;
     for (const auto& operation : mModel.operations) {
-        success = isOperationSupported(operation, mModel);
-        if (!success) {
+        if (isOperationSupported(operation, mModel)) {
+            opOnCpu.push_back(false);
+        } else if (cpuFallback && isOperationSupportedOnCpu(operation, mModel)) {
+            VLOG(L1, "operation %d runs on the CPU plugin", operation.type);
+            opOnCpu.push_back(true);
+        } else {
             VLOG(L1, "get unsupported operation in initialize()");
             return false;
         }
@@ -1227,9 +1328,12 @@ bool VpuPreparedModel::initialize()
             case OperationType::RESHAPE:
                 success = operationReshape(operation);
                 break;
-/*            case OperationType::ADD:
+            case OperationType::ADD:
                 success = operationAdd(operation);
-                break;*/
+                break;
+            case OperationType::MUL:
+                success = operationMUL(operation);
+                break;
             default:
                 VLOG(L1, "unsupported operation %d", operation.type);
                 return false;
@@ -1246,23 +1350,14 @@ bool VpuPreparedModel::initialize()
     //initialize IE operation input/output ports
 //    convertModel(mNet);
 
-    //debug graph
     mNet.buildNetwork();
-    std::fstream dot;
-    std::string graphfile("/data/graphfile");
-    dot.open("/data/graph.dot", std::ios::out);
-    mNet.save(graphfile);
-    mNet.crateDotFile(dot);
-    dot.close();
-
-    VLOG(L1, "initialize ExecuteNetwork");
-		enginePtr = new ExecuteNetwork(mNet, TargetDevice::eMYRIAD);
-		//enginePtr->prepareInput();
-		//enginePtr->prepareOutput();
-		//printf("load network\n");
-		enginePtr->loadNetwork();
+    auto constants = IRConstantStore::instance().stats();
+    VLOG(L1, "constant store: %zu blobs %zu bytes live, %zu of %zu lookups shared, %zu bytes saved",
+         constants.liveBlobs, constants.liveBytes, constants.hits, constants.lookups, constants.savedBytes);
+    mModelHash = computeModelHash();
+    dumpModel(mModelHash);
 
-		//auto ob = enginePtr->Infer(inData);
+    assignAffinity(opOnCpu);
 
     return true;
 }
@@ -1270,8 +1365,9 @@ bool VpuPreparedModel::initialize()
 void VpuPreparedModel::deinitialize()
 {
     VLOG(L1, "deinitialize");
-    delete enginePtr;
-    enginePtr = nullptr;
+    // drain in-flight requests before the engine goes away
+    mExecPool.reset();
+    enginePtr.reset();
 
     for (const auto& operand : mOperands) {
 /*        for (const auto& buf : operand.buffer) {
@@ -1334,8 +1430,8 @@ void VpuPreparedModel::asyncExecute(const Request& request,
                                        const sp<IExecutionCallback>& callback)
 {
 
-    std::vector<RunTimePoolInfo> requestPoolInfos;
-    if (!setRunTimePoolInfosFromHidlMemories(&requestPoolInfos, request.pools)) {
+    std::vector<std::shared_ptr<MappedPool>> requestPoolInfos;
+    if (!mRequestPools.map(request.pools, &requestPoolInfos)) {
         callback->notify(ErrorStatus::GENERAL_FAILURE);
         return;
     }
@@ -1343,36 +1439,26 @@ void VpuPreparedModel::asyncExecute(const Request& request,
     //std::vector<IRBlob::Ptr> input;
     //std::vector<TBlob<float>::Ptr> output;
     auto inOutData = [this, &requestPoolInfos](const std::vector<uint32_t>& indexes,
-                       const hidl_vec<RequestArgument>& arguments, bool inputFromRequest, ExecuteNetwork* enginePtr, std::vector<OutputPort> mPorts) {
-        //do memcpy for input data
+                       const hidl_vec<RequestArgument>& arguments, VpuPartitionedNetwork* enginePtr) {
         for (size_t i = 0; i < indexes.size(); i++) {
             RunTimeOperandInfo& operand = mOperands[indexes[i]];
             const RequestArgument& arg = arguments[i];
             auto poolIndex = arg.location.poolIndex;
             nnAssert(poolIndex < requestPoolInfos.size());
-            auto& r = requestPoolInfos[poolIndex];
-            VLOG(L1, "Copy request input/output to model input/output");
-            //std::ostringstream operandName; operandName << "operand."<<indexes[i]; //use mPort[i]->name
-            if (inputFromRequest){
-                //model/request oputput pointer pass to inference engine input
-                //memcpy(operand.buffer, r.buffer + arg.location.offset, operand.length)
-                //auto in = GetOperandAsTensor(operand, operand.buffer, operand.length);
-                auto inputBlob = GetInOutOperandAsBlob(operand, const_cast<uint8_t*>(r.buffer + arg.location.offset), operand.length); //if not doing memcpy
-                //VLOG(L1, "setBlob for mPorts[%d]->name %s", indexes[i], mPorts[indexes[i]]->name.c_str());
-                enginePtr->setBlob(mPorts[indexes[i]]->name, inputBlob); //setInputBlob(const std::string &,IRBlob::Ptr);
-
-              }
-            else {
-                //inference engine output pointer pass to model/request oputput
-                //copy model oputput to request output
-                //memcpy(r.buffer + arg.location.offset, operand.buffer, operand.length);
-                auto outputBlob = GetInOutOperandAsBlob(operand, const_cast<uint8_t*>(r.buffer + arg.location.offset), operand.length); //if not doing memcpy
-                enginePtr->setBlob(mPorts[indexes[i]]->name, outputBlob);
-
-              }
-
+            auto& r = requestPoolInfos[poolIndex]->info;
+            uint8_t* buffer = r.buffer + arg.location.offset;
+
+            // Request memory is wrapped, not copied, so a blob stays valid for
+            // as long as the request keeps pointing at the same pool mapping.
+            BoundBlob& bound = mBoundBlobs[indexes[i]];
+            if (bound.blob != nullptr && bound.buffer == buffer) {
+                continue;
+            }
+            VLOG(L1, "bind request buffer of operand %d", indexes[i]);
+            bound.blob = GetInOutOperandAsBlob(operand, buffer, operand.length);
+            bound.buffer = buffer;
+            enginePtr->setBlob(mPorts[indexes[i]]->name, bound.blob);
         }
-
     };
 
 
@@ -1385,20 +1471,30 @@ void VpuPreparedModel::asyncExecute(const Request& request,
 
     VLOG(L1, "pass request inputs/outputs buffer to network/model respectively");
 
-    inOutData(mModel.inputIndexes, request.inputs, true, enginePtr, mPorts);
-    inOutData(mModel.outputIndexes, request.outputs, false, enginePtr, mPorts);
+    // The engine has a single infer request; workers beyond the first only
+    // overlap pool mapping and callback delivery.
+    std::unique_lock<std::mutex> engineLock(mEngineMutex);
+    inOutData(mModel.inputIndexes, request.inputs, enginePtr.get());
+    inOutData(mModel.outputIndexes, request.outputs, enginePtr.get());
 
     VLOG(L1, "Run");
 
     //auto output = execute.Infer(input).wait();
-    enginePtr->Infer();
+    try {
+        enginePtr->infer();
+    } catch (const std::exception& e) {
+        ALOGE("inference failed: %s", e.what());
+        engineLock.unlock();
+        callback->notify(ErrorStatus::GENERAL_FAILURE);
+        return;
+    }
 
 
 //    VLOG(L1, "copy model output to request output");
 
     VLOG(L1, "update shared memories");
-    for (auto runtimeInfo : requestPoolInfos) {
-        runtimeInfo.update();
+    for (auto& pool : requestPoolInfos) {
+        pool->info.update();
     }
 
 #ifdef VPU_DEBUG
@@ -1435,6 +1531,7 @@ void VpuPreparedModel::asyncExecute(const Request& request,
         for(const auto& op : mModel.operations) {
             const auto& o = mOperands[op.outputs[0]];
             InferenceEngine::TBlob<float>::Ptr opBlob = enginePtr->getBlob(mPorts[op.outputs[0]]->name);
+            if (opBlob == nullptr) continue;
             VLOG(L1, "Operation %d has output 0(lifetime %d) are:", op.type, o.lifetime);
 
             nelem = (opBlob->size() > 20 ? 20 : opBlob->size());
@@ -1445,6 +1542,7 @@ void VpuPreparedModel::asyncExecute(const Request& request,
         }
     }
 #endif
+    engineLock.unlock();
 
     Return<void> returned = callback->notify(ErrorStatus::NONE);
     if (!returned.isOk()) {
@@ -1460,7 +1558,7 @@ Return<ErrorStatus> VpuPreparedModel::execute(const Request& request,
 
     VLOG(L1, "Begin to execute");
 
-    if (mPorts.size() == 0) {
+    if (mPorts.size() == 0 || mExecPool == nullptr) {
         ALOGE("No primitive to execute");
         callback->notify(ErrorStatus::INVALID_ARGUMENT);
         return ErrorStatus::INVALID_ARGUMENT;
@@ -1477,11 +1575,15 @@ Return<ErrorStatus> VpuPreparedModel::execute(const Request& request,
     }
 
 
-    // This thread is intentionally detached because the vpu driver service
-    // is expected to live forever.
-    std::thread([this, request, callback]{ asyncExecute(request, callback); }).detach();
+    // Blocks the caller while the queue is full, which bounds the number of
+    // requests a single prepared model can have outstanding.
+    if (!mExecPool->submit([this, request, callback]{ asyncExecute(request, callback); })) {
+        ALOGE("execution pool is shutting down");
+        callback->notify(ErrorStatus::DEVICE_UNAVAILABLE);
+        return ErrorStatus::DEVICE_UNAVAILABLE;
+    }
 
-    VLOG(L1, "Start execute thread done");
+    VLOG(L1, "execute request queued, %zu pending", mExecPool->pending());
 
     return ErrorStatus::NONE;
 }
@@ -1665,6 +1767,112 @@ bool VpuPreparedModel::isOperationSupported(const Operation& operation, const Mo
     return true;
 }
 
+bool VpuPreparedModel::cpuFallbackEnabled()
+{
+    if (property_get_int32("vendor.vpu.cpu_fallback", 1) == 0)
+        return false;
+
+    //claiming operations for a CPU plugin that doesn't load fails
+    //prepareModel() for models NNAPI would run on its own CPU path,
+    //so check once that it loads
+    static const bool cpuPluginLoads = [] {
+        try {
+            InferenceEngine::PluginDispatcher dispatcher({"/vendor/lib64","/vendor/lib","/system/lib64","/system/lib","","./"});
+            dispatcher.getSuitablePlugin(TargetDevice::eCPU);
+            return true;
+        } catch (const std::exception& e) {
+            ALOGW("CPU fallback disabled, the CPU plugin does not load: %s", e.what());
+            return false;
+        }
+    }();
+    return cpuPluginLoads;
+}
+
+bool VpuPreparedModel::isOperationSupportedOnCpu(const Operation& operation, const Model& model)
+{
+    //the CPU plugin partitions run in FP32
+    for (auto i : operation.inputs) {
+        if (model.operands[i].type == OperandType::TENSOR_QUANT8_ASYMM) {
+            VLOG_CHECKFAIL("cpu quant");
+            return false;
+        }
+    }
+
+    switch(operation.type) {
+        case OperationType::ADD:
+        case OperationType::MUL:
+        {
+            const auto& input0 = model.operands[operation.inputs[0]];
+            const auto& input1 = model.operands[operation.inputs[1]];
+            if (input0.dimensions != input1.dimensions) {
+                VLOG_CHECKFAIL("dims not match");
+                return false;
+            }
+            bool isIn0Const = input0.lifetime == OperandLifeTime::CONSTANT_COPY ||
+                              input0.lifetime == OperandLifeTime::CONSTANT_REFERENCE;
+            bool isIn1Const = input1.lifetime == OperandLifeTime::CONSTANT_COPY ||
+                              input1.lifetime == OperandLifeTime::CONSTANT_REFERENCE;
+            if (isIn0Const && isIn1Const) {
+                VLOG_CHECKFAIL("both inputs const");
+                return false;
+            }
+            //operationMUL has no const path; a const addend keeps its NHWC order,
+            //which only matches the NCHW port up to rank 2
+            if ((isIn0Const || isIn1Const) &&
+                (operation.type == OperationType::MUL || input0.dimensions.size() > 2)) {
+                VLOG_CHECKFAIL("const operand");
+                return false;
+            }
+            break;
+        }
+        case OperationType::RELU1:
+        case OperationType::RELU6:
+            break;
+        default:
+            return false;
+    }
+    VLOG(L1, "Operation %d supported by CPU", operation.type);
+
+    return true;
+}
+
+// Tags every layer of mNet with the device running it. Each operation claims
+// the layers between its output port and its input ports, the first claim
+// wins. Layers of Myriad operations the Myriad frontend has no parser for,
+// like the Clamp of a fused RELU1/RELU6, go to the CPU on their own.
+void VpuPreparedModel::assignAffinity(const std::vector<bool>& opOnCpu)
+{
+    static const std::set<std::string> cpuOnlyLayers = {"Clamp", "Const"};
+    std::set<CNNLayer*> claimed;
+
+    for (size_t i = 0; i < mModel.operations.size(); i++) {
+        const auto& operation = mModel.operations[i];
+        std::set<Data*> inputPorts;
+        for (auto index : operation.inputs) {
+            if (!isConst(index) && mPorts[index] != nullptr) inputPorts.insert(mPorts[index].get());
+        }
+        std::vector<CNNLayerPtr> pending;
+        for (auto index : operation.outputs) {
+            if (mPorts[index] != nullptr) pending.push_back(mPorts[index]->creatorLayer.lock());
+        }
+        while (!pending.empty()) {
+            auto layer = pending.back();
+            pending.pop_back();
+            if (layer == nullptr || !claimed.insert(layer.get()).second) continue;
+
+            bool onCpu = opOnCpu[i] || cpuOnlyLayers.count(layer->type) != 0;
+            layer->affinity = onCpu ? kAffinityCpu : kAffinityVpu;
+            VLOG(L1, "layer %s on %s", layer->name.c_str(), layer->affinity.c_str());
+            for (const auto& in : layer->insData) {
+                auto data = in.lock();
+                if (data != nullptr && inputPorts.count(data.get()) == 0) {
+                    pending.push_back(data->creatorLayer.lock());
+                }
+            }
+        }
+    }
+}
+
 bool VpuPreparedModel::isConst(int index)
 {
 	const auto op = mModel.operands[index];
@@ -2041,7 +2249,16 @@ bool VpuPreparedModel::operationFullyConnected(const Operation& operation)
     //FIX ME : Work around since input size indims[0] != output node (wdims[0])
     auto dims = permuteDims(weights->getTensorDesc().getDims(), {0, 1});
     dims[0] = indims[0];
-    weights->getTensorDesc().setDims(dims);
+    if (dims != weights->getTensorDesc().getDims()) {
+        // the constant store may share these weights with another model,
+        // reshape a copy of them
+        auto reshaped = std::make_shared<IRBlob>(TensorDesc(weights->precision(), dims, Layout::ANY));
+        reshaped->allocate();
+        std::fill_n(reshaped->buffer().as<short*>(), reshaped->size(), 0);
+        std::copy_n(weights->cbuffer().as<const short*>(), std::min(weights->size(), reshaped->size()),
+                    reshaped->buffer().as<short*>());
+        weights = reshaped;
+    }
     //WA end
 
     auto out = weights*input + bias;
@@ -2179,7 +2396,7 @@ bool VpuPreparedModel::operationRELU1(const Operation& operation)
      * 0: The output tensor of same shape as input0.
      */
 
-    mPorts[operation.outputs[0]] = Clamp(getPort(operation.inputs[0]),0,1);
+    mPorts[operation.outputs[0]] = Clamp(getPort(operation.inputs[0]),-1,1);
     return true;
 }
 
@@ -2651,6 +2868,9 @@ void VpuPreparedModel::convertModel(IRDocument &mNet)
             nnAssert(true);
     }
 */
+		// NNAPI reads 4-D results back as NHWC, so that is what the graph writes
+		if (mOperands[i].dimensions.size() == 4)
+			mPorts[i]->setLayout(NHWC);
 		mPorts[i]->setPrecision(InferenceEngine::Precision::FP32);
 		mNet.addOutput(mPorts[i]);
 
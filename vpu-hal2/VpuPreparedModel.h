@@ -34,12 +34,18 @@
 #include <hidlmemory/mapping.h>
 #include <hardware/hardware.h>
 #include <sys/mman.h>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 
 //#include <mvnc.h>
 
 //vpu include
 #include "vpu_plugin.hpp"
+#include "VpuExecutionPool.h"
+#include "VpuPartitionedNetwork.h"
 #include <fstream>
 
 using ::android::hidl::memory::V1_0::IMemory;
@@ -112,6 +118,46 @@ struct RunTimePoolInfo {
 bool setRunTimePoolInfosFromHidlMemories(std::vector<RunTimePoolInfo>* poolInfos,
                                          const hidl_vec<hidl_memory>& pools);
 
+// A request pool mapping that unmaps itself once the last user lets go of it.
+struct MappedPool {
+    RunTimePoolInfo info;
+
+    MappedPool() { info.buffer = nullptr; }
+    ~MappedPool();
+};
+
+// Keeps request memory pools mapped across executions. The runtime sends the
+// same ashmem/mmap_fd pools frame after frame, but binder installs a fresh fd
+// for them on every call, so entries are matched on the underlying open file
+// (kcmp) together with the hidl_memory name, size and mmap parameters.
+// Falls back to mapping per request when kcmp is not available.
+class RequestPoolCache {
+public:
+    static constexpr size_t kDefaultCapacity = 16;
+
+    explicit RequestPoolCache(size_t capacity = kDefaultCapacity);
+
+    // Resolves each pool to a mapping, reusing cached ones where possible.
+    bool map(const hidl_vec<hidl_memory>& pools,
+             std::vector<std::shared_ptr<MappedPool>>* mapped);
+
+    size_t hits() const { return mHits; }
+    size_t misses() const { return mMisses; }
+
+private:
+    bool sameFile(int fd1, int fd2);
+    std::shared_ptr<MappedPool> lookup(const hidl_memory& hidlMemory);
+    void insert(const std::shared_ptr<MappedPool>& pool);
+
+    std::mutex mMutex;
+    // most recently used first
+    std::list<std::shared_ptr<MappedPool>> mEntries;
+    size_t mCapacity;
+    bool mEnabled;
+    size_t mHits;
+    size_t mMisses;
+};
+
 
 
 // Base class used to create vpu drivers for the NN HAL.  This class
@@ -123,13 +169,23 @@ class VpuPreparedModel : public IPreparedModel {
 public:
     VpuPreparedModel(const Model& model)
           : // Make a copy of the model, as we need to preserve it.
-            mModel(model), mNet("nnNet") {
+            mModel(model), mNet("nnNet"), enginePtr(nullptr) {
 	}
     ~VpuPreparedModel() override {deinitialize();}
     bool initialize();
+    // Everything initialize() does short of loading: converts the model and
+    // tags each layer with its device. vpu_blob_compiler stops here.
+    bool prepareNetwork();
+    ICNNNetwork& network() { return *mNet.getNetwork(); }
+    // Content hash of the model, the blob cache key. Set by prepareNetwork().
+    const std::string& modelHash() const { return mModelHash; }
     Return<ErrorStatus> execute(const Request& request,
                                 const sp<IExecutionCallback>& callback) override;
     static bool isOperationSupported(const Operation& operation, const Model& model);
+    // Operations the MYRIAD plugin can't run but the CPU plugin can, see
+    // vendor.vpu.cpu_fallback.
+    static bool isOperationSupportedOnCpu(const Operation& operation, const Model& model);
+    static bool cpuFallbackEnabled();
     static bool validModel(const Model& model);
     static bool validateRequest(const Request& request, const Model& model);
 
@@ -137,7 +193,10 @@ private:
     void deinitialize();
     bool initializeRunTimeOperandInfo();
     void asyncExecute(const Request& request, const sp<IExecutionCallback>& callback);
+    std::string computeModelHash() const;
+    void dumpModel(const std::string& modelHash);
     void convertModel(IRDocument &mNet);
+    void assignAffinity(const std::vector<bool>& opOnCpu);
 
     bool operationAdd(const Operation& operation);
     bool operationAveragePool2D(const Operation& operation);
@@ -182,9 +241,22 @@ private:
     Model mModel;
     std::vector<RunTimeOperandInfo> mOperands;
     std::vector<RunTimePoolInfo> mPoolInfos;
+    RequestPoolCache mRequestPools;
+    // Blob last handed to the infer request for each model input/output
+    // operand, together with the request memory it wraps. Guarded by
+    // mEngineMutex.
+    struct BoundBlob {
+        const uint8_t* buffer = nullptr;
+        Blob::Ptr blob;
+    };
+    std::map<uint32_t, BoundBlob> mBoundBlobs;
     IRDocument mNet;
+    std::string mModelHash;
     std::vector<OutputPort> mPorts;  //typedef std::shared_ptr<Data> DataPtr;
-    ExecuteNetwork* enginePtr;
+    std::unique_ptr<VpuPartitionedNetwork> enginePtr;
+    // Runs asyncExecute for this model; owns the only threads touching enginePtr.
+    std::unique_ptr<VpuExecutionPool> mExecPool;
+    std::mutex mEngineMutex;
 //    std::vector<InferenceEngine::DataPtr> mPorts;
 
 };
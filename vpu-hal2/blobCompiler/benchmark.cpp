@@ -0,0 +1,134 @@
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark.h"
+
+#include <precision_utils.h>
+#include <cstdlib>
+
+#include "IRLayers.h"
+
+using namespace IRBuilder;
+using namespace InferenceEngine;
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace V1_0 {
+namespace vpu_driver {
+
+namespace {
+
+const int kConvNetDepths[] = {4, 8, 16, 32, 64};
+const int kMobileNetDepths[] = {4, 8, 16, 32};
+const int kInceptionDepths[] = {2, 4, 8, 16};
+
+IRBlob::Ptr weights(size_t count) {
+    IRBlob::Ptr blob(new TBlob<short>(Precision::FP16, C, {count}));
+    blob->allocate();
+    short* data = blob->buffer().as<short*>();
+    for (size_t i = 0; i < count; i++) {
+        data[i] = PrecisionUtils::f32tof16(0.01f * static_cast<float>(i % 17) - 0.08f);
+    }
+    return blob;
+}
+
+OutputPort conv(const OutputPort& src, int kernel, int outputs, int groups = 1) {
+    ConvolutionParams prms;
+    prms.groups = groups;
+    prms.kernel = {kernel, kernel};
+    prms.stride = {1, 1};
+    prms.pad_start = {kernel / 2, kernel / 2};
+    prms.pad_end = {kernel / 2, kernel / 2};
+    prms.num_output_planes = outputs;
+    prms.weights = weights(kernel * kernel * n(src) * outputs / groups);
+    return ReLU(Convolution(src, prms));
+}
+
+// 3x3 conv/ReLU pairs, halving the image every 8 of them
+OutputPort convNet(const OutputPort& input, int depth) {
+    OutputPort x = conv(input, 3, 32);
+    for (int i = 0; i < depth; i++) {
+        x = conv(x, 3, 32);
+        if (i % 8 == 7 && x->getDims()[2] > 8) {
+            x = Pooling(x, {2, 2}, {2, 2}, {0, 0}, PoolingLayer::MAX);
+        }
+    }
+    return x;
+}
+
+// depthwise 3x3 followed by pointwise 1x1
+OutputPort mobileNet(const OutputPort& input, int depth) {
+    OutputPort x = conv(input, 3, 32);
+    for (int i = 0; i < depth; i++) {
+        x = conv(x, 3, 32, 32);
+        x = conv(x, 1, 32);
+    }
+    return x;
+}
+
+// 1x1, 3x3 and pool branches concatenated, then reduced back to 32 channels
+OutputPort inception(const OutputPort& input, int depth) {
+    OutputPort x = conv(input, 3, 32);
+    for (int i = 0; i < depth; i++) {
+        auto a = conv(x, 1, 16);
+        auto b = conv(conv(x, 1, 16), 3, 16);
+        auto c = conv(Pooling(x, {3, 3}, {1, 1}, {1, 1}, PoolingLayer::MAX), 1, 16);
+        x = conv(Concat({a, b, c}), 1, 32);
+    }
+    return x;
+}
+
+}  // namespace
+
+std::vector<std::string> benchmarkModels() {
+    std::vector<std::string> names;
+    for (int depth : kConvNetDepths) names.push_back("convnet-" + std::to_string(depth));
+    for (int depth : kMobileNetDepths) names.push_back("mobilenet-" + std::to_string(depth));
+    for (int depth : kInceptionDepths) names.push_back("inception-" + std::to_string(depth));
+    return names;
+}
+
+std::unique_ptr<IRBuilder::IRDocument> buildBenchmarkModel(const std::string& name) {
+    size_t dash = name.rfind('-');
+    if (dash == std::string::npos) return nullptr;
+    std::string family = name.substr(0, dash);
+    int depth = atoi(name.c_str() + dash + 1);
+    if (depth <= 0) return nullptr;
+
+    OutputPort (*build)(const OutputPort&, int) = nullptr;
+    if (family == "convnet") {
+        build = convNet;
+    } else if (family == "mobilenet") {
+        build = mobileNet;
+    } else if (family == "inception") {
+        build = inception;
+    } else {
+        return nullptr;
+    }
+
+    layer_name_count = 0;
+    std::unique_ptr<IRDocument> doc(new IRDocument(name));
+    auto input = doc->createInput("operand.0", {1, 3, 64, 64});
+    OutputPort y = build(input->getInputData(), depth);
+    doc->addOutput(y);
+    doc->buildNetwork();
+    return doc;
+}
+
+}  // namespace vpu_driver
+}  // namespace V1_0
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
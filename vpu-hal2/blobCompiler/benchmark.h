@@ -0,0 +1,46 @@
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ANDROID_ML_NN_VPU_BLOB_COMPILER_BENCHMARK_H
+#define ANDROID_ML_NN_VPU_BLOB_COMPILER_BENCHMARK_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "IRDocument.h"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace V1_0 {
+namespace vpu_driver {
+
+// Synthetic networks of growing size for tracking graph transformer compile
+// time (vpu_blob_compiler -b). Three families, each at several depths:
+// plain conv/ReLU chains, depthwise + pointwise blocks, and inception style
+// branches joined by concats. Weights are constant, only the shapes matter
+// to the compiler.
+std::vector<std::string> benchmarkModels();
+
+// Builds one of the benchmarkModels(), nullptr for an unknown name.
+std::unique_ptr<IRBuilder::IRDocument> buildBenchmarkModel(const std::string& name);
+
+}  // namespace vpu_driver
+}  // namespace V1_0
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif // ANDROID_ML_NN_VPU_BLOB_COMPILER_BENCHMARK_H
@@ -0,0 +1,53 @@
+LOCAL_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := vpu_blob_compiler
+LOCAL_PROPRIETARY_MODULE := true
+LOCAL_MODULE_OWNER := intel
+LOCAL_MULTILIB := 64
+
+LOCAL_SRC_FILES := \
+    main.cpp \
+    benchmark.cpp
+
+LOCAL_C_INCLUDES += \
+	$(LOCAL_PATH) \
+	$(LOCAL_PATH)/.. \
+	$(LOCAL_PATH)/../graphAPI \
+	$(LOCAL_PATH)/../dl/inference-engine/thirdparty/pugixml/src \
+	$(LOCAL_PATH)/../dl/inference-engine/include \
+	$(LOCAL_PATH)/../dl/inference-engine/include/cpp \
+	$(LOCAL_PATH)/../dl/inference-engine/include/details \
+	$(LOCAL_PATH)/../dl/inference-engine/include/details/os \
+	$(LOCAL_PATH)/../dl/inference-engine/include/vpu \
+	$(LOCAL_PATH)/../dl/inference-engine/src/inference_engine \
+	$(LOCAL_PATH)/../dl/inference-engine/src/inference_engine/cpp_interfaces \
+	$(LOCAL_PATH)/../dl/inference-engine/src/inference_engine/cpp_interfaces/base \
+	$(LOCAL_PATH)/../dl/inference-engine/src/inference_engine/cpp_interfaces/impl \
+	$(LOCAL_PATH)/../dl/inference-engine/src/inference_engine/cpp_interfaces/interface \
+	$(LOCAL_PATH)/../dl/inference-engine/src/vpu/common \
+	$(LOCAL_PATH)/../dl/inference-engine/src/vpu/graph_transformer \
+	$(LOCAL_PATH)/../dl/inference-engine/src/vpu/myriad_plugin \
+	$(LOCAL_PATH)/../dl/inference-engine/temp/myriad/include
+
+LOCAL_CFLAGS += -std=c++11 -Wall -Wno-unknown-pragmas -Wno-strict-overflow -fPIC -Wformat -Wformat-security -fstack-protector-all
+LOCAL_CFLAGS += -Wno-unused-variable -Wno-unused-parameter -Wno-non-virtual-dtor -Wno-missing-field-initializers -fexceptions -frtti -Wno-error
+LOCAL_CFLAGS += -DENABLE_VPU -DENABLE_MYRIAD -DAKS -DIMPLEMENT_INFERENCE_ENGINE_API -D_FORTIFY_SOURCE=2 -fPIE
+
+# BlobCache and loadOrCompileBlob come from the plugin itself, so the keys
+# match the plugin build the device runs
+LOCAL_SHARED_LIBRARIES := \
+    libhidlbase \
+    libhidltransport \
+    libutils \
+    liblog \
+    libcutils \
+    android.hardware.neuralnetworks@1.0 \
+    android.hardware.neuralnetworks@1.0-vpu-impl \
+    libinference_engine \
+    libmyriadPlugin
+
+LOCAL_STATIC_LIBRARIES := libgraphAPI libpugixml libvpu_common
+
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,734 @@
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// vpu_blob_compiler compiles models into Myriad blobs ahead of time, see
+// README.md. It reads what the HAL leaves in vendor.vpu.dump_dir: the NNAPI
+// model (.nnmodel) or its IR (.xml, with the .bin next to it). It writes one
+// blob cache entry per Myriad partition. Installed as
+// vendor.vpu.blob_cache.prebuilt_dir, they let the device skip the graph
+// transformer. No stick is needed.
+//
+// It also profiles the graph transformer: -J and -t write the time, graph
+// size and memory of every pass, and -b compiles a built-in corpus of
+// synthetic networks instead of models, to track compile time as networks
+// grow.
+//
+// -C checks a batch compile (-B N) against batch 1: the blob has to repeat
+// the stages of the batch 1 blob once per image, with the same parameters
+// and data shapes, and share its weights.
+
+#define LOG_TAG "vpu_blob_compiler"
+
+#include <getopt.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <fnv1a_hash.h>
+#include <ie_cnn_net_reader.h>
+#include <mv_blob_format.h>
+#include <myriad_blob_cache.h>
+#include "VpuModelFile.h"
+#include "benchmark.h"
+#include "VpuPartitionedNetwork.h"
+#include "VpuPreparedModel.h"
+
+using namespace android::hardware::neuralnetworks::V1_0::vpu_driver;
+using namespace InferenceEngine;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// big enough that the compiler never evicts its own output
+const char kOutputSizeMb[] = "1048576";
+
+struct Options {
+    std::string outDir = ".";
+    int platform = MYRIAD_2;
+    size_t jobs = 0;
+    std::map<std::string, std::string> config;
+    std::string irKey;
+    bool raw = false;
+    bool quiet = false;
+    bool benchmark = false;
+    int runs = 3;
+    std::string jsonPath;
+    std::string tracePath;
+    bool hwReport = false;
+    size_t batch = 0;   // the model's own
+    bool checkBatch = false;
+    int logLevel = VPU::Common::eLOGWARNING;
+    std::vector<std::string> models;
+};
+
+struct Result {
+    bool ok = false;
+    std::string error;
+    size_t blobs = 0;
+    size_t cached = 0;
+    double totalMs = 0;
+    // phase and milliseconds, in order
+    std::vector<std::pair<std::string, double>> phases;
+    // graph transformer runs, cache hits have none
+    std::vector<VPU::CompileProfile> profiles;
+};
+
+// A network the Myriad loads and the plugin config it is loaded with.
+struct VpuNetwork {
+    ICNNNetwork* network;
+    std::map<std::string, std::string> config;
+};
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+bool endsWith(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size() &&
+           str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// file name without directory and extension
+std::string stem(const std::string& path) {
+    size_t slash = path.rfind('/');
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    size_t dot = name.rfind('.');
+    return dot == std::string::npos ? name : name.substr(0, dot);
+}
+
+// 64-bit FNV-1a of the files, each after its length, the default key of an
+// IR model
+bool hashFiles(const std::vector<std::string>& paths, std::string& key) {
+    uint64_t h = kFnv1aOffset;
+    for (const auto& path : paths) {
+        std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!file.is_open()) return false;
+        h = fnv1aValue(h, static_cast<uint64_t>(file.tellg()));
+        file.seekg(0);
+        char buf[64 * 1024];
+        while (file.read(buf, sizeof(buf)) || file.gcount() > 0) {
+            h = fnv1a(h, buf, static_cast<size_t>(file.gcount()));
+        }
+    }
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(h));
+    key = hex;
+    return true;
+}
+
+void setBatch(ICNNNetwork& network, size_t batch) {
+    network.setBatchSize(batch);
+    // the inputs of networks built by IRDocument are not among the data
+    // setBatchSize walks
+    InputsDataMap inputs;
+    network.getInputsInfo(inputs);
+    for (const auto& input : inputs) {
+        auto dims = input.second->getTensorDesc().getDims();
+        dims[0] = batch;
+        input.second->getInputData()->setDims(dims);
+    }
+}
+
+// What checkBatchBlob compares: the sizes from the headers and how many
+// stages of each type and size the stage section has.
+struct BlobStages {
+    uint32_t inputSize = 0;
+    uint32_t outputSize = 0;
+    uint32_t weightsSize = 0;
+    uint32_t count = 0;
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> stages;
+};
+
+bool readBlobStages(const VPU::MyriadPlugin::GraphBlob& blob, BlobStages& stages) {
+    auto at = [&blob](size_t offset, size_t size) {
+        return offset + size <= blob.size() ? blob.data() + offset : nullptr;
+    };
+    VPU::mv_blob_header header;
+    VPU::mv_buffer_section_header buffers;
+    VPU::mv_stage_section_header section;
+    const char* ptr = at(sizeof(VPU::ElfN_Ehdr), sizeof(header));
+    if (ptr == nullptr) return false;
+    memcpy(&header, ptr, sizeof(header));
+    if ((ptr = at(header.buffer_section_offset, sizeof(buffers))) == nullptr) return false;
+    memcpy(&buffers, ptr, sizeof(buffers));
+    if ((ptr = at(header.stage_section_offset, sizeof(section))) == nullptr) return false;
+    memcpy(&section, ptr, sizeof(section));
+
+    stages.inputSize = section.input_size;
+    stages.outputSize = section.output_size;
+    stages.weightsSize = buffers.buffer_section_size;
+    stages.count = section.stage_count;
+    stages.stages.clear();
+    // next_stage is from the start of the section, 0 on the last stage
+    uint32_t offset = sizeof(section);
+    for (uint32_t i = 0; i < section.stage_count; i++) {
+        VPU::mv_stage_header stage;
+        if ((ptr = at(header.stage_section_offset + offset, sizeof(stage))) == nullptr) return false;
+        memcpy(&stage, ptr, sizeof(stage));
+        uint32_t end = stage.next_stage != 0 ? stage.next_stage : section.stage_section_size;
+        if (end <= offset) return false;
+        uint32_t type = stage.stage_type;
+        stages.stages[{type, end - offset}]++;
+        offset = end;
+    }
+    return true;
+}
+
+// The batch blob has to hold the stages of the batch 1 blob once per image,
+// the inputs and outputs of every image and the weights once. Returns what
+// differs, empty if nothing does.
+std::string checkBatchBlob(const VPU::MyriadPlugin::GraphBlob& batchBlob,
+                           const VPU::MyriadPlugin::GraphBlob& singleBlob, size_t batch) {
+    BlobStages batched;
+    BlobStages single;
+    if (!readBlobStages(batchBlob, batched) || !readBlobStages(singleBlob, single)) {
+        return "cannot read the stage section";
+    }
+    std::ostringstream out;
+    if (batched.count != single.count * batch) {
+        out << batched.count << " stages against " << single.count << " at batch 1";
+    } else if (batched.inputSize != single.inputSize * batch || batched.outputSize != single.outputSize * batch) {
+        out << "input and output of " << batched.inputSize << " and " << batched.outputSize
+            << " bytes against " << single.inputSize << " and " << single.outputSize << " at batch 1";
+    } else if (batched.weightsSize > single.weightsSize) {
+        out << batched.weightsSize << " bytes of weights against " << single.weightsSize << " at batch 1";
+    } else {
+        for (const auto& stage : single.stages) {
+            uint32_t count = batched.stages.count(stage.first) ? batched.stages.at(stage.first) : 0;
+            if (count != stage.second * batch) {
+                out << count << " stages of type " << stage.first.first << " and " << stage.first.second
+                    << " bytes against " << stage.second << " at batch 1";
+                break;
+            }
+        }
+    }
+    return out.str();
+}
+
+// The graph transformer has to generate for each image of the batch the
+// stages it generates at batch 1: everything they write to the blob but
+// where their data is has to be the same. Returns a stage that is not,
+// empty if none.
+std::string checkBatchStages(const VPU::CompileProfile& batched, const VPU::CompileProfile& single,
+                             size_t batch) {
+    std::map<uint64_t, size_t> counts;
+    for (auto signature : batched.stageSignatures) {
+        counts[signature]++;
+    }
+    for (size_t i = 0; i < single.stageSignatures.size(); i++) {
+        auto& count = counts[single.stageSignatures[i]];
+        if (count < batch) {
+            std::ostringstream out;
+            out << "stage " << i << " of batch 1 is in " << count << " images, not " << batch;
+            return out.str();
+        }
+        count -= batch;
+    }
+    return std::string();
+}
+
+// Compiles the networks into the output directory, skipping those already
+// there. rawBase names the raw .graph files when the options ask for them.
+void compileBlobs(const std::vector<VpuNetwork>& networks, const std::string& baseKey,
+                  const std::string& rawBase, const Options& options, Result& result) {
+    auto log = std::make_shared<VPU::Common::Logger>();
+    log->init(options.logLevel);
+
+    for (const auto& vpu : networks) {
+        if (options.batch != 0) {
+            setBatch(*vpu.network, options.batch);
+        }
+
+        // "" for a whole network, ".partN.MYRIAD" for a partition of one
+        std::string suffix = vpu.config.at(VPU_CONFIG_KEY(BLOB_CACHE_KEY)).substr(baseKey.size());
+
+        std::map<std::string, std::string> config = vpu.config;
+        if (options.benchmark) {
+            // no key, no cache: every run compiles
+            config.erase(VPU_CONFIG_KEY(BLOB_CACHE_KEY));
+        } else {
+            config[VPU_CONFIG_KEY(BLOB_CACHE_DIR)] = options.outDir;
+            config[VPU_CONFIG_KEY(BLOB_CACHE_SIZE)] = kOutputSizeMb;
+        }
+        config.erase(VPU_CONFIG_KEY(BLOB_CACHE_PREBUILT_DIR));
+        for (const auto& option : options.config) {
+            config[option.first] = option.second;
+        }
+
+        // the fastest of the benchmark runs
+        double bestMs = 0;
+        VPU::CompileProfile bestProfile;
+        VPU::MyriadPlugin::GraphBlob blob;
+        bool cached = false;
+        for (int run = 0; run < (options.benchmark ? options.runs : 1); run++) {
+            auto start = Clock::now();
+            VPU::Common::ParsedConfig parsedConfig(options.platform, config);
+            std::vector<VPU::BlobMetaData> metaData;
+            size_t numStages = 0;
+            VPU::CompileProfile profile;
+            cached = VPU::MyriadPlugin::loadOrCompileBlob(*vpu.network, parsedConfig, options.platform, log,
+                                                          blob, metaData, numStages, &profile);
+            double ms = msSince(start);
+            if (run == 0 || ms < bestMs) {
+                bestMs = ms;
+                bestProfile = profile;
+            }
+        }
+        result.phases.emplace_back("compile" + suffix, bestMs);
+        result.blobs++;
+        if (cached) {
+            result.cached++;
+        } else {
+            bestProfile.network += suffix;
+            result.profiles.push_back(bestProfile);
+        }
+
+        if (options.checkBatch && options.batch > 1) {
+            auto start = Clock::now();
+            // without the cache, the graph transformer has to run for the
+            // profiles, and the batch 1 blob would take the key of the batch one
+            std::map<std::string, std::string> uncachedConfig = config;
+            uncachedConfig.erase(VPU_CONFIG_KEY(BLOB_CACHE_KEY));
+            VPU::Common::ParsedConfig parsedConfig(options.platform, uncachedConfig);
+            std::vector<VPU::BlobMetaData> metaData;
+            size_t numStages = 0;
+            VPU::CompileProfile batchProfile = bestProfile;
+            if (cached) {
+                VPU::MyriadPlugin::GraphBlob batchBlob;
+                VPU::MyriadPlugin::loadOrCompileBlob(*vpu.network, parsedConfig, options.platform, log,
+                                                     batchBlob, metaData, numStages, &batchProfile);
+            }
+            VPU::MyriadPlugin::GraphBlob singleBlob;
+            VPU::CompileProfile singleProfile;
+            setBatch(*vpu.network, 1);
+            VPU::MyriadPlugin::loadOrCompileBlob(*vpu.network, parsedConfig, options.platform, log,
+                                                 singleBlob, metaData, numStages, &singleProfile);
+            setBatch(*vpu.network, options.batch);
+
+            std::string error = checkBatchBlob(blob, singleBlob, options.batch);
+            if (error.empty()) {
+                error = checkBatchStages(batchProfile, singleProfile, options.batch);
+            }
+            if (!error.empty()) {
+                THROW_IE_EXCEPTION << "batch " << options.batch << " check" << suffix << ": " << error;
+            }
+            result.phases.emplace_back("check" + suffix, msSince(start));
+        }
+
+        if (options.raw) {
+            std::string path = rawBase + suffix + ".graph";
+            std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+            file.write(blob.data(), blob.size());
+            file.close();
+            if (file.fail()) {
+                THROW_IE_EXCEPTION << "cannot write " << path;
+            }
+        }
+    }
+}
+
+void compileNnModel(const std::string& path, const Options& options, Result& result) {
+    auto start = Clock::now();
+    VpuModelFile file;
+    if (!file.read(path)) {
+        THROW_IE_EXCEPTION << "cannot read the model, see logcat";
+    }
+    if (!VpuPreparedModel::validModel(file.model())) {
+        THROW_IE_EXCEPTION << "invalid model";
+    }
+    result.phases.emplace_back("read", msSince(start));
+
+    start = Clock::now();
+    android::sp<VpuPreparedModel> prepared = new VpuPreparedModel(file.model());
+    if (!prepared->prepareNetwork()) {
+        THROW_IE_EXCEPTION << "unsupported operation or failed conversion, see logcat";
+    }
+    result.phases.emplace_back("convert", msSince(start));
+
+    // the same partitions, and so the same keys, as a device load
+    start = Clock::now();
+    std::map<std::string, std::string> config = {
+        {VPU_CONFIG_KEY(BLOB_CACHE_KEY), prepared->modelHash()}};
+    VpuPartitionedNetwork partitions(prepared->network(), TargetDevice::eMYRIAD, config, false);
+    std::vector<VpuNetwork> networks;
+    partitions.forEachVpuPartition([&networks](ICNNNetwork& network,
+                                               const std::map<std::string, std::string>& config) {
+        networks.push_back({&network, config});
+    });
+    result.phases.emplace_back("partition", msSince(start));
+
+    compileBlobs(networks, prepared->modelHash(), options.outDir + "/" + stem(path), options, result);
+}
+
+void compileIr(const std::string& path, const Options& options, Result& result) {
+    auto start = Clock::now();
+    std::string weights = path.substr(0, path.size() - 4) + ".bin";
+    CNNNetReader reader;
+    reader.ReadNetwork(path);
+    reader.ReadWeights(weights);
+    std::string key = options.irKey;
+    if (key.empty() && !hashFiles({path, weights}, key)) {
+        THROW_IE_EXCEPTION << "cannot read " << weights;
+    }
+    result.phases.emplace_back("read", msSince(start));
+
+    ICNNNetwork& network = reader.getNetwork();
+    compileBlobs({{&network, {{VPU_CONFIG_KEY(BLOB_CACHE_KEY), key}}}}, key,
+                 options.outDir + "/" + stem(path), options, result);
+}
+
+void compileBenchmarkModel(const std::string& name, const Options& options, Result& result) {
+    auto start = Clock::now();
+    auto doc = buildBenchmarkModel(name);
+    if (doc == nullptr) {
+        THROW_IE_EXCEPTION << "unknown benchmark model";
+    }
+    result.phases.emplace_back("build", msSince(start));
+
+    compileBlobs({{doc->getNetwork(), {{VPU_CONFIG_KEY(BLOB_CACHE_KEY), name}}}}, name,
+                 options.outDir + "/" + name, options, result);
+}
+
+Result compileModel(const std::string& path, const Options& options) {
+    Result result;
+    auto start = Clock::now();
+    try {
+        if (options.benchmark) {
+            compileBenchmarkModel(path, options, result);
+        } else if (endsWith(path, ".xml")) {
+            compileIr(path, options, result);
+        } else {
+            compileNnModel(path, options, result);
+        }
+        result.ok = true;
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+    result.totalMs = msSince(start);
+    return result;
+}
+
+std::string describe(const std::string& path, const Result& result) {
+    std::ostringstream out;
+    out.setf(std::ios::fixed);
+    out.precision(1);
+    out << path << ": ";
+    if (!result.ok) {
+        out << "FAILED " << result.error;
+        return out.str();
+    }
+    out << result.blobs << " blob(s), " << result.cached << " up to date, " << result.totalMs << " ms (";
+    for (size_t i = 0; i < result.phases.size(); i++) {
+        out << (i ? ", " : "") << result.phases[i].first << " " << result.phases[i].second;
+    }
+    out << ")";
+
+    // where the graph transformer time went, summed over the partitions
+    std::map<std::string, uint64_t> passUs;
+    for (const auto& profile : result.profiles) {
+        for (const auto& pass : profile.passes) {
+            passUs[pass.name] += pass.durationUs;
+        }
+    }
+    std::vector<std::pair<uint64_t, std::string>> slowest;
+    for (const auto& pass : passUs) {
+        slowest.emplace_back(pass.second, pass.first);
+    }
+    std::sort(slowest.rbegin(), slowest.rend());
+    for (size_t i = 0; i < slowest.size() && i < 3; i++) {
+        out << (i ? ", " : " slowest passes: ") << slowest[i].second << " " << slowest[i].first / 1000.;
+    }
+
+    // planned data memory against the most the network ever has live at
+    // once, the scratch buffer of the stages is on top of both
+    uint64_t ddrBytes = 0;
+    uint64_t ddrTempBytes = 0;
+    uint64_t ddrLowerBound = 0;
+    for (const auto& profile : result.profiles) {
+        ddrBytes += profile.ddrBytes - profile.ddrTempBytes;
+        ddrTempBytes += profile.ddrTempBytes;
+        ddrLowerBound += profile.ddrLowerBound;
+    }
+    if (!result.profiles.empty() && result.profiles[0].batchSize != 1) {
+        out << "; batch " << result.profiles[0].batchSize;
+    }
+    if (!result.profiles.empty()) {
+        out << "; DDR " << ddrBytes << " bytes (" << result.profiles[0].memoryPlanner
+            << ", lower bound " << ddrLowerBound << ") + " << ddrTempBytes << " scratch";
+    }
+    return out.str();
+}
+
+// The convolutions the cost model moved off the HW, and what it expects
+// from that against every convolution the HW can take.
+std::string describeHwStages(const Result& result) {
+    std::ostringstream out;
+    out.setf(std::ios::fixed);
+    out.precision(1);
+    for (const auto& profile : result.profiles) {
+        if (profile.hwStages.empty())
+            continue;
+        size_t onHw = 0;
+        for (const auto& choice : profile.hwStages) {
+            onHw += choice.chosenHw;
+        }
+        out << "  " << profile.network << ": " << onHw << " of " << profile.hwStages.size()
+            << " convolutions on HW, estimated " << profile.chosenPlanUs << " us against "
+            << profile.defaultPlanUs << " us with the heuristic\n";
+        for (const auto& choice : profile.hwStages) {
+            if (choice.chosenHw == choice.defaultHw)
+                continue;
+            out << "    " << choice.stage << ": " << (choice.chosenHw ? "HW" : "SW")
+                << ", HW " << choice.hwUs << " us, SW " << choice.swUs << " us\n";
+        }
+    }
+    return out.str();
+}
+
+bool writeJson(const std::string& path, const std::vector<std::string>& models,
+               const std::vector<Result>& results) {
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    out << "[";
+    for (size_t i = 0; i < models.size(); i++) {
+        const auto& result = results[i];
+        out << (i ? ",\n" : "\n") << "{\"model\": \"" << models[i] << "\", \"ok\": "
+            << (result.ok ? "true" : "false") << ", \"totalMs\": " << result.totalMs << ", \"compiles\": [";
+        for (size_t j = 0; j < result.profiles.size(); j++) {
+            out << (j ? ", " : "");
+            result.profiles[j].writeJson(out);
+        }
+        out << "]}";
+    }
+    out << "\n]\n";
+    out.close();
+    return !out.fail();
+}
+
+// Chrome trace (chrome://tracing, Perfetto), one row per model
+bool writeTrace(const std::string& path, const std::vector<std::string>& models,
+                const std::vector<Result>& results) {
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    out << "{\"traceEvents\": [\n";
+    for (size_t i = 0; i < models.size(); i++) {
+        out << (i ? ",\n" : "") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << i
+            << ", \"args\": {\"name\": \"" << models[i] << "\"}}";
+        for (const auto& profile : results[i].profiles) {
+            if (profile.passes.empty()) continue;
+            out << ",\n";
+            profile.writeTraceEvents(out, 0, static_cast<int>(i));
+        }
+    }
+    out << "\n]}\n";
+    out.close();
+    return !out.fail();
+}
+
+bool readList(const std::string& path, std::vector<std::string>& models) {
+    std::ifstream list(path);
+    if (!list.is_open()) return false;
+    std::string line;
+    while (std::getline(list, line)) {
+        size_t end = line.find_last_not_of(" \t\r");
+        if (end == std::string::npos || line[0] == '#') continue;
+        models.push_back(line.substr(0, end + 1));
+    }
+    return true;
+}
+
+bool parsePlatform(const std::string& name, int& platform) {
+    if (name == "MYRIAD_2" || name == "2450") {
+        platform = MYRIAD_2;
+    } else if (name == "MYRIAD_X" || name == "2480") {
+        platform = MYRIAD_X;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [options] model...\n"
+            "  model         .nnmodel dumped by the HAL, or IR .xml with the .bin next to it\n"
+            "  -o DIR        output directory, install it as vendor.vpu.blob_cache.prebuilt_dir (default .)\n"
+            "  -l FILE       also compile the models listed in FILE, one per line\n"
+            "  -j N          models compiled in parallel (default: one per core)\n"
+            "  -p PLATFORM   MYRIAD_2 or MYRIAD_X (default MYRIAD_2, what the HAL reports)\n"
+            "  -c KEY=VALUE  MYRIAD plugin option, must match what the network is loaded with\n"
+            "  -k KEY        blob cache key of IR models, the KEY_VPU_BLOB_CACHE_KEY the\n"
+            "                application loads them with (default: hash of the .xml and .bin)\n"
+            "  -r            also write the raw blob, <model>.graph, for the mvnc API\n"
+            "  -J FILE       write the graph transformer passes of every compile as JSON\n"
+            "  -t FILE       write them as a Chrome trace\n"
+            "  -b            compile the built-in benchmark networks instead of models, without\n"
+            "                the cache, keeping the fastest of -n runs (default 3); models name a subset\n"
+            "                compare memory planners with -c VPU_MEMORY_PLANNER=FIRST_FIT|BEST_FIT|CONFLICT_GRAPH\n"
+            "  -B N          compile for N images at once, the plugin repeats the stages of one\n"
+            "                image for each (default: the batch of the model)\n"
+            "  -C            with -B, check the batch blob repeats the stages of a batch 1 compile\n"
+            "                per image, with the same parameters and data shapes\n"
+            "  -H            report where the HW/SW stage selection put each convolution, against\n"
+            "                the heuristic (MYRIAD_X, -c VPU_HW_STAGES_OPTIMIZATION=YES\n"
+            "                -c VPU_HW_STAGE_SELECTION=COST_MODEL)\n"
+            "  -v            plugin info logs\n"
+            "  -q            only print failures and the summary\n",
+            argv0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    int opt;
+    while ((opt = getopt(argc, argv, "o:l:j:p:c:k:rJ:t:bn:B:CHvqh")) != -1) {
+        std::string arg = optarg ? optarg : "";
+        switch (opt) {
+            case 'o':
+                options.outDir = arg;
+                break;
+            case 'l':
+                if (!readList(arg, options.models)) {
+                    fprintf(stderr, "cannot read %s\n", arg.c_str());
+                    return 2;
+                }
+                break;
+            case 'j':
+                options.jobs = strtoul(arg.c_str(), nullptr, 10);
+                break;
+            case 'p':
+                if (!parsePlatform(arg, options.platform)) {
+                    fprintf(stderr, "unknown platform %s\n", arg.c_str());
+                    return 2;
+                }
+                break;
+            case 'c': {
+                size_t eq = arg.find('=');
+                if (eq == std::string::npos) {
+                    usage(argv[0]);
+                    return 2;
+                }
+                options.config[arg.substr(0, eq)] = arg.substr(eq + 1);
+                break;
+            }
+            case 'k':
+                options.irKey = arg;
+                break;
+            case 'r':
+                options.raw = true;
+                break;
+            case 'J':
+                options.jsonPath = arg;
+                break;
+            case 't':
+                options.tracePath = arg;
+                break;
+            case 'b':
+                options.benchmark = true;
+                break;
+            case 'n':
+                options.runs = std::max(1, atoi(arg.c_str()));
+                break;
+            case 'B':
+                options.batch = strtoul(arg.c_str(), nullptr, 10);
+                break;
+            case 'C':
+                options.checkBatch = true;
+                break;
+            case 'H':
+                options.hwReport = true;
+                break;
+            case 'v':
+                options.logLevel = VPU::Common::eLOGINFO;
+                break;
+            case 'q':
+                options.quiet = true;
+                break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    for (int i = optind; i < argc; i++) {
+        options.models.push_back(argv[i]);
+    }
+    if (options.benchmark && options.models.empty()) {
+        options.models = benchmarkModels();
+    }
+    if (options.models.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (options.jobs == 0) {
+        // benchmark compiles alone unless asked, parallel runs skew the times
+        options.jobs = options.benchmark ? 1 : std::max(1u, std::thread::hardware_concurrency());
+    }
+    options.jobs = std::min(options.jobs, options.models.size());
+
+    // Each worker takes the next model, conversion and graph transformer
+    // state is all per model.
+    std::vector<Result> results(options.models.size());
+    std::atomic<size_t> next(0);
+    std::mutex printMutex;
+    auto start = Clock::now();
+    auto worker = [&]() {
+        for (size_t i = next++; i < options.models.size(); i = next++) {
+            results[i] = compileModel(options.models[i], options);
+            if (!options.quiet || !results[i].ok) {
+                std::lock_guard<std::mutex> lock(printMutex);
+                printf("%s\n", describe(options.models[i], results[i]).c_str());
+                if (options.hwReport) {
+                    printf("%s", describeHwStages(results[i]).c_str());
+                }
+                fflush(stdout);
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < options.jobs; i++) {
+        threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    size_t failed = 0;
+    size_t blobs = 0;
+    double compileMs = 0;
+    for (const auto& result : results) {
+        if (!result.ok) failed++;
+        blobs += result.blobs;
+        compileMs += result.totalMs;
+    }
+    printf("%zu model(s), %zu blob(s), %zu failed, %.1f ms on %zu thread(s) (%.1f ms total)\n",
+           results.size(), blobs, failed, msSince(start), options.jobs, compileMs);
+
+    if (!options.jsonPath.empty() && !writeJson(options.jsonPath, options.models, results)) {
+        fprintf(stderr, "cannot write %s\n", options.jsonPath.c_str());
+        return 1;
+    }
+    if (!options.tracePath.empty() && !writeTrace(options.tracePath, options.models, results)) {
+        fprintf(stderr, "cannot write %s\n", options.tracePath.c_str());
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,257 @@
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// vpu_cpu_bench measures how the CPU plugin, which runs the partitions the
+// Myriad can't, scales with cores. For every core count of -c it forks a
+// child restricted to that many CPUs. The child loads the -m model once per
+// stream setting of -s and keeps -r requests per stream in flight for -t
+// seconds, then reports the frames per second, the mean latency of a
+// request and the speedup over the smallest core count.
+
+#include <getopt.h>
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <inference_engine.hpp>
+#include <ie_plugin_config.hpp>
+#include <ie_plugin_dispatcher.hpp>
+
+using namespace InferenceEngine;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// the cores a stream gets in auto mode, see CPU_THROUGHPUT_AUTO
+const int kCoresPerAutoStream = 4;
+
+struct Options {
+    std::string model;
+    std::vector<int> cores = {1, 2, 4, 8, 16, 32};
+    std::vector<std::string> streams = {"1", "auto"};
+    double seconds = 5;
+    int requestsPerStream = 2;
+};
+
+struct Result {
+    int streams;
+    int requests;
+    double fps;
+    double latencyMs;
+    long frames;
+};
+
+std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+int streamsFor(const std::string& setting, int cores) {
+    if (setting == "auto") return std::max(cores / kCoresPerAutoStream, 1);
+    if (setting == "percore") return cores;
+    return std::max(atoi(setting.c_str()), 1);
+}
+
+// The first `count` CPUs the process may run on.
+bool restrictToCpus(int count) {
+    cpu_set_t allowed, set;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed)) return false;
+    CPU_ZERO(&set);
+    for (int cpu = 0; cpu < CPU_SETSIZE && count > 0; cpu++) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            CPU_SET(cpu, &set);
+            count--;
+        }
+    }
+    return count == 0 && sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+Result run(const Options& options, int streams) {
+    CNNNetReader reader;
+    reader.ReadNetwork(options.model);
+    std::string weights = options.model.substr(0, options.model.rfind('.')) + ".bin";
+    reader.ReadWeights(weights);
+    CNNNetwork network = reader.getNetwork();
+    for (auto& input : network.getInputsInfo()) {
+        input.second->setPrecision(Precision::FP32);
+    }
+
+    PluginDispatcher dispatcher({"/vendor/lib64", "/vendor/lib", "/system/lib64", "/system/lib", "", "./"});
+    InferencePlugin plugin(dispatcher.getSuitablePlugin(TargetDevice::eCPU));
+    std::map<std::string, std::string> config = {
+            {PluginConfigParams::KEY_CPU_THROUGHPUT_STREAMS, std::to_string(streams)}};
+    ExecutableNetwork executable = plugin.LoadNetwork(network, config);
+
+    int count = streams * options.requestsPerStream;
+    std::vector<InferRequest> requests;
+    for (int i = 0; i < count; i++) {
+        requests.push_back(executable.CreateInferRequest());
+        for (auto& input : network.getInputsInfo()) {
+            Blob::Ptr blob = requests.back().GetBlob(input.first);
+            float* data = blob->buffer().as<float*>();
+            for (size_t j = 0; j < blob->size(); j++) data[j] = static_cast<float>(rand() % 256);
+        }
+    }
+
+    // one round unmeasured to create the primitives' scratch and fault the pages in
+    for (auto& request : requests) request.StartAsync();
+    for (auto& request : requests) request.Wait(IInferRequest::WaitMode::RESULT_READY);
+
+    std::vector<Clock::time_point> started(count);
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.seconds));
+    for (int i = 0; i < count; i++) {
+        started[i] = Clock::now();
+        requests[i].StartAsync();
+    }
+
+    // requests finish about in the order they started, so wait round robin
+    long frames = 0;
+    double latency = 0;
+    bool running = true;
+    while (running) {
+        for (int i = 0; i < count; i++) {
+            requests[i].Wait(IInferRequest::WaitMode::RESULT_READY);
+            auto now = Clock::now();
+            frames++;
+            latency += std::chrono::duration<double>(now - started[i]).count();
+            if (now >= deadline) {
+                running = false;
+                continue;
+            }
+            started[i] = now;
+            requests[i].StartAsync();
+        }
+    }
+    for (auto& request : requests) request.Wait(IInferRequest::WaitMode::RESULT_READY);
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    return {streams, count, frames / elapsed, latency / frames * 1e3, frames};
+}
+
+// Runs every stream setting on `cores` CPUs in a child process, so the
+// plugin sees the restricted affinity when it partitions the cores.
+bool runOnCores(const Options& options, int cores, std::vector<Result>& results) {
+    int fds[2];
+    if (pipe(fds)) return false;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        int status = 0;
+        if (!restrictToCpus(cores)) {
+            fprintf(stderr, "cannot run on %d CPUs\n", cores);
+            _exit(2);
+        }
+        for (const auto& setting : options.streams) {
+            Result result = {};
+            try {
+                result = run(options, streamsFor(setting, cores));
+            } catch (const std::exception& e) {
+                fprintf(stderr, "%d cores, %s streams: %s\n", cores, setting.c_str(), e.what());
+                status = 1;
+            }
+            if (write(fds[1], &result, sizeof(result)) != sizeof(result)) _exit(3);
+        }
+        close(fds[1]);
+        _exit(status);
+    }
+
+    close(fds[1]);
+    Result result;
+    while (read(fds[0], &result, sizeof(result)) == sizeof(result)) results.push_back(result);
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return pid > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s -m model.xml [options]\n"
+            "  -m xml    IR of the model, the weights next to it with a .bin extension\n"
+            "  -c list   core counts to run on (default 1,2,4,8,16,32)\n"
+            "  -s list   streams per run: a number, auto (a stream per %d cores)\n"
+            "            or percore (default 1,auto)\n"
+            "  -t sec    time per run (default 5)\n"
+            "  -r n      requests in flight per stream (default 2)\n",
+            argv0, kCoresPerAutoStream);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    int opt;
+    while ((opt = getopt(argc, argv, "m:c:s:t:r:h")) != -1) {
+        switch (opt) {
+            case 'm': options.model = optarg; break;
+            case 'c':
+                options.cores.clear();
+                for (const auto& item : split(optarg)) options.cores.push_back(atoi(item.c_str()));
+                break;
+            case 's': options.streams = split(optarg); break;
+            case 't': options.seconds = atof(optarg); break;
+            case 'r': options.requestsPerStream = std::max(atoi(optarg), 1); break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (options.model.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    cpu_set_t allowed;
+    int available = sched_getaffinity(0, sizeof(allowed), &allowed) ? 1 : CPU_COUNT(&allowed);
+
+    int failed = 0;
+    std::map<std::string, double> baseline;
+    printf("%6s %8s %9s %10s %11s %8s %9s\n", "cores", "streams", "requests", "fps", "latency ms", "scaling", "frames");
+    for (int cores : options.cores) {
+        if (cores < 1 || cores > available) {
+            printf("%6d skipped, %d CPUs available\n", cores, available);
+            continue;
+        }
+        std::vector<Result> results;
+        if (!runOnCores(options, cores, results)) failed++;
+        for (size_t i = 0; i < results.size() && i < options.streams.size(); i++) {
+            const Result& r = results[i];
+            if (!r.frames) continue;
+            const std::string& setting = options.streams[i];
+            if (!baseline.count(setting)) baseline[setting] = r.fps;
+            printf("%6d %8d %9d %10.1f %11.2f %7.2fx %9ld\n", cores, r.streams, r.requests, r.fps, r.latencyMs,
+                   r.fps / baseline[setting], r.frames);
+        }
+        fflush(stdout);
+    }
+    return failed ? 1 : 0;
+}
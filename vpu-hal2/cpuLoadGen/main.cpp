@@ -0,0 +1,256 @@
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// vpu_cpu_loadgen draws the throughput versus latency curve of the CPU
+// plugin under server-like traffic: single-sample requests arriving at
+// random (Poisson) times at a fixed offered rate, whether or not the
+// previous ones are done. For every mode of -b it loads the -m model either
+// unbatched or with KEY_CPU_BATCH_REQUESTS at that batch timeout, then
+// offers each rate of -q for -t seconds and reports the frames per second
+// it got and the latency percentiles, queueing for a free request included.
+
+#include <getopt.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <inference_engine.hpp>
+#include <ie_plugin_config.hpp>
+#include <ie_plugin_dispatcher.hpp>
+
+using namespace InferenceEngine;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    std::string model;
+    std::vector<double> rates = {50, 100, 200, 400, 800};
+    std::vector<std::string> modes = {"off", "500", "2000"};
+    int batch = 8;
+    int streams = 1;
+    int requests = 64;
+    double seconds = 10;
+};
+
+struct Result {
+    double fps;
+    double meanMs;
+    double p50Ms;
+    double p90Ms;
+    double p99Ms;
+    long frames;
+};
+
+std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t i = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+// The requests of a loaded network and which of them are free. Arrivals
+// that find no free request wait in a backlog in arrival order.
+class Load {
+public:
+    Load(ExecutableNetwork& executable, CNNNetwork& network, int count) : requests(count), arrival(count) {
+        for (int i = 0; i < count; i++) {
+            requests[i] = executable.CreateInferRequest();
+            for (auto& input : network.getInputsInfo()) {
+                Blob::Ptr blob = requests[i].GetBlob(input.first);
+                float* data = blob->buffer().as<float*>();
+                for (size_t j = 0; j < blob->size(); j++) data[j] = static_cast<float>(rand() % 256);
+            }
+            requests[i].SetCompletionCallback([this, i]() { done(i); });
+            free.push_back(i);
+        }
+    }
+
+    Result run(double rate, double seconds) {
+        std::mt19937 random(12345);
+        std::exponential_distribution<double> gap(rate);
+
+        latencies.clear();
+        auto start = Clock::now();
+        auto deadline = start + toDuration(seconds);
+        auto next = start;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            // hand the requests that arrived so far to the free ones
+            while (!backlog.empty() && !free.empty()) {
+                int i = free.front();
+                free.pop_front();
+                arrival[i] = backlog.front();
+                backlog.pop_front();
+                lock.unlock();
+                requests[i].StartAsync();
+                lock.lock();
+            }
+            if (next >= deadline && backlog.empty()) break;
+            if (next < deadline && Clock::now() >= next) {
+                backlog.push_back(next);
+                next += toDuration(gap(random));
+                continue;
+            }
+            if (next < deadline)
+                condVar.wait_until(lock, next);
+            else
+                condVar.wait(lock);
+        }
+        condVar.wait(lock, [this] { return free.size() == requests.size(); });
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::sort(latencies.begin(), latencies.end());
+        double sum = 0;
+        for (double latency : latencies) sum += latency;
+        long frames = static_cast<long>(latencies.size());
+        return {frames / elapsed, frames ? sum / frames : 0, percentile(latencies, 0.5),
+                percentile(latencies, 0.9), percentile(latencies, 0.99), frames};
+    }
+
+private:
+    static Clock::duration toDuration(double seconds) {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    }
+
+    void done(int i) {
+        std::unique_lock<std::mutex> lock(mutex);
+        latencies.push_back(std::chrono::duration<double, std::milli>(Clock::now() - arrival[i]).count());
+        free.push_back(i);
+        condVar.notify_all();
+    }
+
+    std::vector<InferRequest> requests;
+    std::vector<Clock::time_point> arrival;
+    std::deque<int> free;
+    std::deque<Clock::time_point> backlog;
+    std::vector<double> latencies;
+    std::mutex mutex;
+    std::condition_variable condVar;
+};
+
+void runMode(const Options& options, const std::string& mode) {
+    CNNNetReader reader;
+    reader.ReadNetwork(options.model);
+    std::string weights = options.model.substr(0, options.model.rfind('.')) + ".bin";
+    reader.ReadWeights(weights);
+    CNNNetwork network = reader.getNetwork();
+    for (auto& input : network.getInputsInfo()) {
+        input.second->setPrecision(Precision::FP32);
+    }
+
+    std::map<std::string, std::string> config = {
+            {PluginConfigParams::KEY_CPU_THROUGHPUT_STREAMS, std::to_string(options.streams)}};
+    if (mode == "off") {
+        network.setBatchSize(1);
+    } else {
+        // the requests stay single samples, the plugin batches them up to the network batch
+        network.setBatchSize(options.batch);
+        config[PluginConfigParams::KEY_CPU_BATCH_REQUESTS] = PluginConfigParams::YES;
+        config[PluginConfigParams::KEY_CPU_BATCH_TIMEOUT] = mode;
+    }
+
+    PluginDispatcher dispatcher({"/vendor/lib64", "/vendor/lib", "/system/lib64", "/system/lib", "", "./"});
+    InferencePlugin plugin(dispatcher.getSuitablePlugin(TargetDevice::eCPU));
+    ExecutableNetwork executable = plugin.LoadNetwork(network, config);
+
+    Load load(executable, network, options.requests);
+    // a short unmeasured run to create the primitives' scratch and fault the pages in
+    load.run(options.rates.front(), 0.5);
+
+    for (double rate : options.rates) {
+        Result r = load.run(rate, options.seconds);
+        printf("%8s %9.1f %9.1f %9.2f %9.2f %9.2f %9.2f %8ld\n", mode.c_str(), rate, r.fps, r.meanMs, r.p50Ms,
+               r.p90Ms, r.p99Ms, r.frames);
+        fflush(stdout);
+    }
+}
+
+void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s -m model.xml [options]\n"
+            "  -m xml    IR of the model, the weights next to it with a .bin extension\n"
+            "  -q list   offered loads in requests per second (default 50,100,200,400,800)\n"
+            "  -b list   off for single requests or a batch timeout in microseconds (default off,500,2000)\n"
+            "  -n batch  largest batch to form (default 8)\n"
+            "  -s n      CPU_THROUGHPUT_STREAMS (default 1)\n"
+            "  -r n      infer requests, bounds the requests in flight (default 64)\n"
+            "  -t sec    time per load (default 10)\n",
+            argv0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    int opt;
+    while ((opt = getopt(argc, argv, "m:q:b:n:s:r:t:h")) != -1) {
+        switch (opt) {
+            case 'm': options.model = optarg; break;
+            case 'q':
+                options.rates.clear();
+                for (const auto& item : split(optarg)) options.rates.push_back(atof(item.c_str()));
+                break;
+            case 'b': options.modes = split(optarg); break;
+            case 'n': options.batch = std::max(atoi(optarg), 1); break;
+            case 's': options.streams = std::max(atoi(optarg), 1); break;
+            case 'r': options.requests = std::max(atoi(optarg), 1); break;
+            case 't': options.seconds = atof(optarg); break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    options.rates.erase(std::remove_if(options.rates.begin(), options.rates.end(),
+                                       [](double rate) { return rate <= 0; }),
+                        options.rates.end());
+    if (options.model.empty() || options.rates.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int failed = 0;
+    printf("%8s %9s %9s %9s %9s %9s %9s %8s\n", "timeout", "offered", "fps", "mean ms", "p50 ms", "p90 ms",
+           "p99 ms", "frames");
+    for (const auto& mode : options.modes) {
+        try {
+            runMode(options, mode);
+        } catch (const std::exception& e) {
+            fprintf(stderr, "%s: %s\n", mode.c_str(), e.what());
+            failed++;
+        }
+    }
+    return failed ? 1 : 0;
+}
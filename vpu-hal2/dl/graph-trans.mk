@@ -8,6 +8,8 @@ LOCAL_MODULE_OWNER := intel
 LOCAL_MULTILIB := both
 #LOCAL_MULTILIB := 64
 LOCAL_SRC_FILES := \
+	inference-engine/src/vpu/graph_transformer/blob_sink.cpp \
+	inference-engine/src/vpu/graph_transformer/compile_profile.cpp \
 	inference-engine/src/vpu/graph_transformer/graph_transformer_impl.cpp \
 	inference-engine/src/vpu/graph_transformer/hw/common.cpp \
 	inference-engine/src/vpu/graph_transformer/hw/convolution.cpp \
@@ -15,6 +17,7 @@ LOCAL_SRC_FILES := \
 	inference-engine/src/vpu/graph_transformer/hw/fill_descriptors.cpp \
 	inference-engine/src/vpu/graph_transformer/hw/pack_concat.cpp \
 	inference-engine/src/vpu/graph_transformer/hw/pooling.cpp \
+	inference-engine/src/vpu/graph_transformer/hw/stage_selection.cpp \
 	inference-engine/src/vpu/graph_transformer/ir/in_out_convert.cpp \
 	inference-engine/src/vpu/graph_transformer/ir/parse_data.cpp \
 	inference-engine/src/vpu/graph_transformer/ir/parse_network.cpp \
@@ -22,6 +25,7 @@ LOCAL_SRC_FILES := \
 	inference-engine/src/vpu/graph_transformer/optimizations/convert_order.cpp \
 	inference-engine/src/vpu/graph_transformer/optimizations/eliminate_copy.cpp \
 	inference-engine/src/vpu/graph_transformer/optimizations/eliminate_reshape.cpp \
+	inference-engine/src/vpu/graph_transformer/optimizations/memory_planner.cpp \
 	inference-engine/src/vpu/graph_transformer/optimizations/pack_memory.cpp \
 	inference-engine/src/vpu/graph_transformer/optimizations/pack_postops.cpp \
 	inference-engine/src/vpu/graph_transformer/stages/batch_norm.cpp \
@@ -23,6 +23,7 @@ LOCAL_SRC_FILES := \
 	inference-engine/src/inference_engine/ie_device.cpp \
 	inference-engine/src/inference_engine/ie_graph_splitter.cpp \
 	inference-engine/src/inference_engine/ie_layouts.cpp \
+	inference-engine/src/inference_engine/layout_utils.cpp \
 	inference-engine/src/inference_engine/ie_util_internal.cpp \
 	inference-engine/src/inference_engine/ie_utils.cpp \
 	inference-engine/src/inference_engine/ie_version.cpp \
@@ -46,12 +47,15 @@ LOCAL_C_INCLUDES += \
 	$(LOCAL_PATH)/inference-engine/src/inference_engine/cpp_interfaces/interface \
 	$(LOCAL_PATH)/inference-engine/thirdparty/pugixml/src \
 	$(LOCAL_PATH)/inference-engine/thirdparty/ade/ade/include \
-	$(LOCAL_PATH)/inference-engine/thirdparty/ade/common/include
+	$(LOCAL_PATH)/inference-engine/thirdparty/ade/common/include \
+	$(LOCAL_PATH)/../ncsdk2/api/include
 
 
 LOCAL_CFLAGS += -std=c++11  -Wall -Wno-unknown-pragmas -Wno-strict-overflow -fPIC -Wformat -Wformat-security -fstack-protector-all
 LOCAL_CFLAGS += -Wno-unused-variable -Wno-unused-parameter -Wno-non-virtual-dtor -Wno-missing-field-initializers  -fexceptions -frtti -Wno-error
 LOCAL_CFLAGS += -DENABLE_VPU -DENABLE_MYRIAD -DAKS -DNDEBUG -DIMPLEMENT_INFERENCE_ENGINE_API -fvisibility=default -std=gnu++11 -D_FORTIFY_SOURCE=2 -fPIE -DUSE_STATIC_IE
+# lets the plugin dispatcher resolve eCPU to libMKLDNNPlugin.so for the CPU partitions
+LOCAL_CFLAGS += -DENABLE_MKL_DNN
 #LOCAL_CFLAGS += -DAKS -DNNLOG
 
 LOCAL_SHARED_LIBRARIES := liblog
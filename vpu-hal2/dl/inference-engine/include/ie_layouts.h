@@ -339,11 +339,21 @@ public:
     size_t Offset(SizeVector pos);
 };
 
+/**
+ * @brief Converts between layouts that differ by a transpose (NCHW/NHWC, NC/CN) with cache blocked, vectorized kernels
+ * @param dims Tensor dimension array (reverse NCHW order as in the IR: w,h,c,n)
+ * @param elemSize Size of an element in bytes, 1, 2 or 4
+ * @return false if the layouts or the element size are not handled, nothing is written then
+ */
+INFERENCE_ENGINE_API_CPP(bool) TransposeLayout(Layout sourceLayout, Layout destLayout, const void* sourceBuffer,
+                                               void* destBuffer, const SizeVector& dims, size_t elemSize);
+
 /**
  * @deprecated Please use TensorDesctiprors for conversion
  */
 template<typename T> void ConvertLayout(Layout sourceLayout, Layout destLayout, const T* sourceBuffer, T* destBuffer, SizeVector dims) {
     if (dims.size() == 0) return;
+    if (TransposeLayout(sourceLayout, destLayout, sourceBuffer, destBuffer, dims, sizeof(T))) return;
 
     SizeVector pos(dims.size(), 0);
     LayoutOffsetCounter srcOffsetCounter(sourceLayout, dims);
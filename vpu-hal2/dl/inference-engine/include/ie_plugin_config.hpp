@@ -53,6 +53,17 @@ DECLARE_CONFIG_VALUE(NO);
 */
 DECLARE_CONFIG_KEY(CPU_BIND_THREAD);
 
+/**
+* @brief The name for setting the number of CPU inference streams.
+* Each stream runs its own copy of the network on a separate subset of the cores, so requests infer in parallel.
+* It is passed to IInferencePlugin::SetConfig(), this option should be used with values:
+* a positive integer, PluginConfigParams::CPU_THROUGHPUT_NUMA (one stream per socket) or
+* PluginConfigParams::CPU_THROUGHPUT_AUTO (streams of a few cores each)
+*/
+DECLARE_CONFIG_KEY(CPU_THROUGHPUT_STREAMS);
+DECLARE_CONFIG_VALUE(CPU_THROUGHPUT_NUMA);
+DECLARE_CONFIG_VALUE(CPU_THROUGHPUT_AUTO);
+
 /**
 * @brief The name for setting performance counters option.
 * It is passed to IInferencePlugin::SetConfig(), this option should be used with values:
@@ -74,6 +85,28 @@ DECLARE_CONFIG_KEY(PERF_COUNT);
 */
 DECLARE_CONFIG_KEY(DYN_BATCH_LIMIT);
 
+/**
+* @brief The key makes the CPU plugin coalesce concurrent single-sample requests into one batched inference.
+* The network is loaded with the largest batch to form, bounded by KEY_DYN_BATCH_LIMIT if set, and
+* every infer request then exposes blobs of a single sample.
+* It is passed to IInferencePlugin::SetConfig(), this option should be used with values:
+* PluginConfigParams::YES or PluginConfigParams::NO
+*/
+DECLARE_CONFIG_KEY(CPU_BATCH_REQUESTS);
+
+/**
+* @brief The key defines how long, in microseconds, the first request of a batch may wait for others to join it.
+* Used with KEY_CPU_BATCH_REQUESTS. The paired value should be convertible to a non-negative integer.
+*/
+DECLARE_CONFIG_KEY(CPU_BATCH_TIMEOUT);
+
+/**
+* @brief The key gives the CPU plugin a file to keep the weights of a network in, converted to the layouts its primitives use.
+* The first load writes the file and later loads of the same network map it instead of converting the weights again.
+* The value is a file path; use one file per network.
+*/
+DECLARE_CONFIG_KEY(CPU_WEIGHTS_CACHE_FILE);
+
 /**
 * @brief The key controls threading inside Inference Engine.
 * It is passed to IInferencePlugin::SetConfig(), this option should be used with values:
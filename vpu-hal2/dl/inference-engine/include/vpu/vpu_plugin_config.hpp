@@ -56,5 +56,51 @@ DECLARE_VPU_CONFIG_KEY(INPUT_BIAS);
 */
 DECLARE_VPU_CONFIG_KEY(PRINT_RECEIVE_TENSOR_TIME);
 
+/**
+* @brief Directory for the compiled blob cache, MYRIAD plugin only.
+* Empty (default) disables the cache.
+*/
+DECLARE_VPU_CONFIG_KEY(BLOB_CACHE_DIR);
+
+/**
+* @brief Size limit of the compiled blob cache in megabytes, least recently used
+* blobs are removed above it. 0 disables the cache, default is 64.
+*/
+DECLARE_VPU_CONFIG_KEY(BLOB_CACHE_SIZE);
+
+/**
+* @brief Content hash of the model the network was built from. The plugin
+* combines it with the rest of the config to look up the compiled blob, so it
+* must change whenever the network does. Networks loaded without it are not cached.
+*/
+DECLARE_VPU_CONFIG_KEY(BLOB_CACHE_KEY);
+
+/**
+* @brief Read-only directory of blobs compiled ahead of time with the blob compiler,
+* looked up when BLOB_CACHE_DIR misses, MYRIAD plugin only. Empty (default) disables it.
+*/
+DECLARE_VPU_CONFIG_KEY(BLOB_CACHE_PREBUILT_DIR);
+
+/**
+* @brief Number of inferences the device runs concurrently for one graph, MYRIAD plugin only.
+* 0 (default) selects 2 on MYRIAD_X and 1 on MYRIAD2, the device rejects more
+* executors than it has.
+*/
+DECLARE_VPU_CONFIG_KEY(GRAPH_EXECUTORS);
+
+/**
+* @brief Depth of the input and output FIFOs of a graph, i.e. how many inferences
+* can be queued on the device before a request has to wait, MYRIAD plugin only.
+* Default is 4, the maximum is 64.
+*/
+DECLARE_VPU_CONFIG_KEY(FIFO_DEPTH);
+
+/**
+* @brief Load the network on every attached device that has room for it and spread
+* the infer requests over them, MYRIAD plugin only.
+* This option should be used with values: CONFIG_VALUE(NO) (default) or CONFIG_VALUE(YES)
+*/
+DECLARE_VPU_CONFIG_KEY(MULTI_DEVICE);
+
 }  // namespace VPUConfigParams
 }  // namespace InferenceEngine
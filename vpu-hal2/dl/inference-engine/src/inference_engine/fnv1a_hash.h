@@ -0,0 +1,71 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2017 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace InferenceEngine {
+
+// 64-bit FNV-1a, the hash every content key of the stack is built with:
+// the blob cache, the MKLDNN weights cache, the graph API constant store
+// and the weights the graph transformer shares between images. Start from
+// kFnv1aOffset; hash fixed-size fields with fnv1aValue and variable-size
+// ones with fnv1aSized, which puts their 64-bit length first, so the same
+// content gives the same key wherever it is computed.
+const uint64_t kFnv1aOffset = 0xcbf29ce484222325ULL;
+
+inline uint64_t fnv1a(uint64_t h, const void* data, size_t size) {
+    auto bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        h ^= bytes[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+template <typename T>
+inline uint64_t fnv1aValue(uint64_t h, const T& value) {
+    return fnv1a(h, &value, sizeof(value));
+}
+
+inline uint64_t fnv1aSized(uint64_t h, const void* data, size_t size) {
+    return fnv1a(fnv1aValue(h, static_cast<uint64_t>(size)), data, size);
+}
+
+inline uint64_t fnv1aString(uint64_t h, const std::string& value) {
+    return fnv1aSized(h, value.data(), value.size());
+}
+
+}  // namespace InferenceEngine
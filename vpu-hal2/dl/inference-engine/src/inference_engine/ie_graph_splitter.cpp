@@ -161,7 +161,7 @@ ISplitChecker::GraphSelectionResult DefaultSplitChecker::selectSubgraph(
     for (auto i : util::iota(std::size_t(1), subgraphs.size())) {
         auto size = subgraphs[i].size();
         if (size > maxSize) {
-            index = 1;
+            index = i;
             maxSize = size;
         }
     }
@@ -32,6 +32,7 @@
 #include <map>
 
 #include "ie_layouts.h"
+#include "layout_utils.h"
 #include <algorithm>
 
 using namespace InferenceEngine;
@@ -63,6 +64,12 @@ size_t LayoutOffsetCounter::Offset(SizeVector pos) {
     return res;
 }
 
+bool InferenceEngine::TransposeLayout(Layout sourceLayout, Layout destLayout, const void* sourceBuffer,
+                                      void* destBuffer, const SizeVector& dims, size_t elemSize) {
+    SizeVector ncDims(dims.rbegin(), dims.rend());
+    return LayoutUtils::convertLayout(sourceLayout, destLayout, ncDims, elemSize, sourceBuffer, destBuffer);
+}
+
 TensorDesc::TensorDesc(const Precision& precision, SizeVector dims, Layout layout): blockingDesc(dims, layout),
                                                                                     precision(precision) {
                                                                                             
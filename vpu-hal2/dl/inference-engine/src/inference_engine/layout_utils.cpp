@@ -0,0 +1,401 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2017 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+#include "layout_utils.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#define LAYOUT_UTILS_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LAYOUT_UTILS_NEON 1
+#endif
+
+using namespace InferenceEngine;
+
+namespace {
+
+// Elements per side of a cache block. A 32x32 block of floats is 4KB read
+// and 4KB written, well inside L1 on both sides of the transpose.
+const size_t kBlock = 32;
+
+// Transposes a K x K tile in registers: d[j * ds + i] = s[i * ss + j].
+// The generic one moves a single element.
+template<typename T>
+struct Tile {
+    static const size_t K = 1;
+    static void run(const T *s, size_t, T *d, size_t) { *d = *s; }
+};
+
+#if defined(LAYOUT_UTILS_SSE2)
+
+template<>
+struct Tile<uint32_t> {
+    static const size_t K = 4;
+    static void run(const uint32_t *s, size_t ss, uint32_t *d, size_t ds) {
+        __m128 r0 = _mm_loadu_ps(reinterpret_cast<const float *>(s));
+        __m128 r1 = _mm_loadu_ps(reinterpret_cast<const float *>(s + ss));
+        __m128 r2 = _mm_loadu_ps(reinterpret_cast<const float *>(s + 2 * ss));
+        __m128 r3 = _mm_loadu_ps(reinterpret_cast<const float *>(s + 3 * ss));
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(reinterpret_cast<float *>(d), r0);
+        _mm_storeu_ps(reinterpret_cast<float *>(d + ds), r1);
+        _mm_storeu_ps(reinterpret_cast<float *>(d + 2 * ds), r2);
+        _mm_storeu_ps(reinterpret_cast<float *>(d + 3 * ds), r3);
+    }
+};
+
+template<>
+struct Tile<uint16_t> {
+    static const size_t K = 8;
+    static void run(const uint16_t *s, size_t ss, uint16_t *d, size_t ds) {
+        __m128i r[8];
+        for (size_t i = 0; i < 8; i++) r[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i * ss));
+        // pairs of rows, then quads, then the two halves
+        __m128i a = _mm_unpacklo_epi16(r[0], r[1]), b = _mm_unpackhi_epi16(r[0], r[1]);
+        __m128i c = _mm_unpacklo_epi16(r[2], r[3]), e = _mm_unpackhi_epi16(r[2], r[3]);
+        __m128i f = _mm_unpacklo_epi16(r[4], r[5]), g = _mm_unpackhi_epi16(r[4], r[5]);
+        __m128i h = _mm_unpacklo_epi16(r[6], r[7]), k = _mm_unpackhi_epi16(r[6], r[7]);
+        __m128i ac0 = _mm_unpacklo_epi32(a, c), ac1 = _mm_unpackhi_epi32(a, c);
+        __m128i be0 = _mm_unpacklo_epi32(b, e), be1 = _mm_unpackhi_epi32(b, e);
+        __m128i fh0 = _mm_unpacklo_epi32(f, h), fh1 = _mm_unpackhi_epi32(f, h);
+        __m128i gk0 = _mm_unpacklo_epi32(g, k), gk1 = _mm_unpackhi_epi32(g, k);
+        __m128i out[8] = {
+            _mm_unpacklo_epi64(ac0, fh0), _mm_unpackhi_epi64(ac0, fh0),
+            _mm_unpacklo_epi64(ac1, fh1), _mm_unpackhi_epi64(ac1, fh1),
+            _mm_unpacklo_epi64(be0, gk0), _mm_unpackhi_epi64(be0, gk0),
+            _mm_unpacklo_epi64(be1, gk1), _mm_unpackhi_epi64(be1, gk1),
+        };
+        for (size_t i = 0; i < 8; i++) _mm_storeu_si128(reinterpret_cast<__m128i *>(d + i * ds), out[i]);
+    }
+};
+
+template<>
+struct Tile<uint8_t> {
+    static const size_t K = 8;
+    static void run(const uint8_t *s, size_t ss, uint8_t *d, size_t ds) {
+        __m128i r[8];
+        for (size_t i = 0; i < 8; i++) r[i] = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(s + i * ss));
+        __m128i a = _mm_unpacklo_epi8(r[0], r[1]), b = _mm_unpacklo_epi8(r[2], r[3]);
+        __m128i c = _mm_unpacklo_epi8(r[4], r[5]), e = _mm_unpacklo_epi8(r[6], r[7]);
+        __m128i ab0 = _mm_unpacklo_epi16(a, b), ab1 = _mm_unpackhi_epi16(a, b);
+        __m128i ce0 = _mm_unpacklo_epi16(c, e), ce1 = _mm_unpackhi_epi16(c, e);
+        // each holds two output rows of 8 bytes
+        __m128i out[4] = {
+            _mm_unpacklo_epi32(ab0, ce0), _mm_unpackhi_epi32(ab0, ce0),
+            _mm_unpacklo_epi32(ab1, ce1), _mm_unpackhi_epi32(ab1, ce1),
+        };
+        for (size_t i = 0; i < 4; i++) {
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(d + 2 * i * ds), out[i]);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(d + (2 * i + 1) * ds), _mm_unpackhi_epi64(out[i], out[i]));
+        }
+    }
+};
+
+#elif defined(LAYOUT_UTILS_NEON)
+
+template<>
+struct Tile<uint32_t> {
+    static const size_t K = 4;
+    static void run(const uint32_t *s, size_t ss, uint32_t *d, size_t ds) {
+        uint32x4x2_t t01 = vtrnq_u32(vld1q_u32(s), vld1q_u32(s + ss));
+        uint32x4x2_t t23 = vtrnq_u32(vld1q_u32(s + 2 * ss), vld1q_u32(s + 3 * ss));
+        vst1q_u32(d, vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0])));
+        vst1q_u32(d + ds, vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1])));
+        vst1q_u32(d + 2 * ds, vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0])));
+        vst1q_u32(d + 3 * ds, vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1])));
+    }
+};
+
+template<>
+struct Tile<uint16_t> {
+    static const size_t K = 8;
+    static uint32x4_t u32(uint16x8_t v) { return vreinterpretq_u32_u16(v); }
+    static uint16x8_t lows(uint32x4_t a, uint32x4_t b) {
+        return vcombine_u16(vget_low_u16(vreinterpretq_u16_u32(a)), vget_low_u16(vreinterpretq_u16_u32(b)));
+    }
+    static uint16x8_t highs(uint32x4_t a, uint32x4_t b) {
+        return vcombine_u16(vget_high_u16(vreinterpretq_u16_u32(a)), vget_high_u16(vreinterpretq_u16_u32(b)));
+    }
+    static void run(const uint16_t *s, size_t ss, uint16_t *d, size_t ds) {
+        uint16x8x2_t t01 = vtrnq_u16(vld1q_u16(s), vld1q_u16(s + ss));
+        uint16x8x2_t t23 = vtrnq_u16(vld1q_u16(s + 2 * ss), vld1q_u16(s + 3 * ss));
+        uint16x8x2_t t45 = vtrnq_u16(vld1q_u16(s + 4 * ss), vld1q_u16(s + 5 * ss));
+        uint16x8x2_t t67 = vtrnq_u16(vld1q_u16(s + 6 * ss), vld1q_u16(s + 7 * ss));
+        uint32x4x2_t u = vtrnq_u32(u32(t01.val[0]), u32(t23.val[0]));
+        uint32x4x2_t v = vtrnq_u32(u32(t01.val[1]), u32(t23.val[1]));
+        uint32x4x2_t w = vtrnq_u32(u32(t45.val[0]), u32(t67.val[0]));
+        uint32x4x2_t x = vtrnq_u32(u32(t45.val[1]), u32(t67.val[1]));
+        vst1q_u16(d, lows(u.val[0], w.val[0]));
+        vst1q_u16(d + ds, lows(v.val[0], x.val[0]));
+        vst1q_u16(d + 2 * ds, lows(u.val[1], w.val[1]));
+        vst1q_u16(d + 3 * ds, lows(v.val[1], x.val[1]));
+        vst1q_u16(d + 4 * ds, highs(u.val[0], w.val[0]));
+        vst1q_u16(d + 5 * ds, highs(v.val[0], x.val[0]));
+        vst1q_u16(d + 6 * ds, highs(u.val[1], w.val[1]));
+        vst1q_u16(d + 7 * ds, highs(v.val[1], x.val[1]));
+    }
+};
+
+template<>
+struct Tile<uint8_t> {
+    static const size_t K = 8;
+    static uint16x4_t u16(uint8x8_t v) { return vreinterpret_u16_u8(v); }
+    static uint32x2_t u32(uint16x4_t v) { return vreinterpret_u32_u16(v); }
+    static void run(const uint8_t *s, size_t ss, uint8_t *d, size_t ds) {
+        uint8x8x2_t t01 = vtrn_u8(vld1_u8(s), vld1_u8(s + ss));
+        uint8x8x2_t t23 = vtrn_u8(vld1_u8(s + 2 * ss), vld1_u8(s + 3 * ss));
+        uint8x8x2_t t45 = vtrn_u8(vld1_u8(s + 4 * ss), vld1_u8(s + 5 * ss));
+        uint8x8x2_t t67 = vtrn_u8(vld1_u8(s + 6 * ss), vld1_u8(s + 7 * ss));
+        uint16x4x2_t u = vtrn_u16(u16(t01.val[0]), u16(t23.val[0]));
+        uint16x4x2_t v = vtrn_u16(u16(t01.val[1]), u16(t23.val[1]));
+        uint16x4x2_t w = vtrn_u16(u16(t45.val[0]), u16(t67.val[0]));
+        uint16x4x2_t x = vtrn_u16(u16(t45.val[1]), u16(t67.val[1]));
+        uint32x2x2_t p = vtrn_u32(u32(u.val[0]), u32(w.val[0]));
+        uint32x2x2_t q = vtrn_u32(u32(v.val[0]), u32(x.val[0]));
+        uint32x2x2_t r = vtrn_u32(u32(u.val[1]), u32(w.val[1]));
+        uint32x2x2_t t = vtrn_u32(u32(v.val[1]), u32(x.val[1]));
+        vst1_u8(d, vreinterpret_u8_u32(p.val[0]));
+        vst1_u8(d + ds, vreinterpret_u8_u32(q.val[0]));
+        vst1_u8(d + 2 * ds, vreinterpret_u8_u32(r.val[0]));
+        vst1_u8(d + 3 * ds, vreinterpret_u8_u32(t.val[0]));
+        vst1_u8(d + 4 * ds, vreinterpret_u8_u32(p.val[1]));
+        vst1_u8(d + 5 * ds, vreinterpret_u8_u32(q.val[1]));
+        vst1_u8(d + 6 * ds, vreinterpret_u8_u32(r.val[1]));
+        vst1_u8(d + 7 * ds, vreinterpret_u8_u32(t.val[1]));
+    }
+};
+
+#endif
+
+// Transposes the block of rows [r0, r1) x cols [c0, c1): whole tiles in
+// registers, the ragged edges element by element.
+template<typename T>
+void transposeBlock(const T *src, T *dst, size_t rows, size_t cols,
+                    size_t r0, size_t r1, size_t c0, size_t c1) {
+    const size_t K = Tile<T>::K;
+    size_t r = r0;
+    for (; r + K <= r1; r += K) {
+        size_t c = c0;
+        for (; c + K <= c1; c += K) {
+            Tile<T>::run(src + r * cols + c, cols, dst + c * rows + r, rows);
+        }
+        for (; c < c1; c++) {
+            for (size_t k = 0; k < K; k++) dst[c * rows + r + k] = src[(r + k) * cols + c];
+        }
+    }
+    for (; r < r1; r++) {
+        for (size_t c = c0; c < c1; c++) dst[c * rows + r] = src[r * cols + c];
+    }
+}
+
+// Splits [0, units) over threads, the calling thread taking the first share.
+template<typename Body>
+void forEachUnit(size_t units, size_t threads, const Body &body) {
+    threads = std::min(threads, units);
+    if (threads <= 1) {
+        body(0, units);
+        return;
+    }
+    size_t share = (units + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    for (size_t begin = share; begin < units; begin += share) {
+        workers.emplace_back(body, begin, std::min(begin + share, units));
+    }
+    body(0, std::min(share, units));
+    for (auto &worker : workers) worker.join();
+}
+
+// A unit of work is one band of kBlock source rows of one image, so the
+// threads write disjoint runs of every destination row.
+template<typename T>
+void transposeTyped(const T *src, T *dst, size_t batch, size_t rows, size_t cols, size_t threads) {
+    size_t bands = (rows + kBlock - 1) / kBlock;
+    forEachUnit(batch * bands, threads, [=](size_t begin, size_t end) {
+        for (size_t unit = begin; unit < end; unit++) {
+            size_t n = unit / bands;
+            size_t r0 = (unit % bands) * kBlock;
+            size_t r1 = std::min(r0 + kBlock, rows);
+            const T *s = src + n * rows * cols;
+            T *d = dst + n * rows * cols;
+            for (size_t c0 = 0; c0 < cols; c0 += kBlock) {
+                transposeBlock(s, d, rows, cols, r0, r1, c0, std::min(c0 + kBlock, cols));
+            }
+        }
+    });
+}
+
+void u8ToFP16(ie_fp16 *dst, const uint8_t *src, size_t n) {
+    // every U8 value is exact in FP16, a table is all it takes
+    static const std::vector<ie_fp16> table = [] {
+        std::vector<ie_fp16> t(256);
+        for (size_t i = 0; i < t.size(); i++) t[i] = PrecisionUtils::f32tof16(static_cast<float>(i));
+        return t;
+    }();
+    for (size_t i = 0; i < n; i++) dst[i] = table[src[i]];
+}
+
+void fp32ToFP16(ie_fp16 *dst, const float *src, size_t n) {
+    PrecisionUtils::f32tof16Arrays(dst, src, n);
+}
+
+// The block is transposed into a buffer on the stack, then converted a
+// destination row at a time with the vector conversion. Short destination
+// rows (few channels) widen the block, and when the band spans whole rows
+// the block converts in one go.
+template<typename T, typename Convert>
+void transposeToFP16(const T *src, ie_fp16 *dst, size_t batch, size_t rows, size_t cols,
+                     size_t threads, Convert convert) {
+    typedef typename std::conditional<sizeof(T) == 1, uint8_t, uint32_t>::type Bits;
+    size_t bands = (rows + kBlock - 1) / kBlock;
+    forEachUnit(batch * bands, threads, [=](size_t begin, size_t end) {
+        Bits block[kBlock * kBlock];
+        for (size_t unit = begin; unit < end; unit++) {
+            size_t n = unit / bands;
+            size_t r0 = (unit % bands) * kBlock;
+            size_t height = std::min(r0 + kBlock, rows) - r0;
+            size_t width = kBlock * kBlock / height;
+            const Bits *s = reinterpret_cast<const Bits *>(src) + n * rows * cols + r0 * cols;
+            ie_fp16 *d = dst + n * rows * cols + r0;
+            for (size_t c0 = 0; c0 < cols; c0 += width) {
+                size_t c1 = std::min(c0 + width, cols);
+                transposeBlock(s + c0, block, height, cols, 0, height, 0, c1 - c0);
+                const T *converted = reinterpret_cast<const T *>(block);
+                if (height == rows) {
+                    convert(d + c0 * rows, converted, (c1 - c0) * rows);
+                    continue;
+                }
+                for (size_t c = c0; c < c1; c++) {
+                    convert(d + c * rows, converted + (c - c0) * height, height);
+                }
+            }
+        }
+    });
+}
+
+}  // namespace
+
+bool LayoutUtils::transposeShape(Layout from, Layout to, const SizeVector &dims,
+                                 size_t &batch, size_t &rows, size_t &cols) {
+    if (dims.size() == 4 && from == NCHW && to == NHWC) {
+        batch = dims[0], rows = dims[1], cols = dims[2] * dims[3];
+        return true;
+    }
+    if (dims.size() == 4 && from == NHWC && to == NCHW) {
+        batch = dims[0], rows = dims[2] * dims[3], cols = dims[1];
+        return true;
+    }
+    if (dims.size() == 2 && from == NC && to == CN) {
+        batch = 1, rows = dims[0], cols = dims[1];
+        return true;
+    }
+    if (dims.size() == 2 && from == CN && to == NC) {
+        batch = 1, rows = dims[1], cols = dims[0];
+        return true;
+    }
+    return false;
+}
+
+size_t LayoutUtils::transposeThreads(size_t bytes) {
+    // starting a thread costs tens of microseconds, a transpose runs at a few
+    // GB/s: a thread pays off for every couple of MB
+    const size_t kBytesPerThread = 2 << 20;
+    const size_t kMaxThreads = 8;
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(std::min(cores, kMaxThreads), bytes / kBytesPerThread));
+}
+
+bool LayoutUtils::transpose(const void *src, void *dst, size_t elemSize,
+                            size_t batch, size_t rows, size_t cols, size_t threads) {
+    if (threads == 0) threads = transposeThreads(batch * rows * cols * elemSize);
+    switch (elemSize) {
+    case 1:
+        transposeTyped(static_cast<const uint8_t *>(src), static_cast<uint8_t *>(dst), batch, rows, cols, threads);
+        return true;
+    case 2:
+        transposeTyped(static_cast<const uint16_t *>(src), static_cast<uint16_t *>(dst), batch, rows, cols, threads);
+        return true;
+    case 4:
+        transposeTyped(static_cast<const uint32_t *>(src), static_cast<uint32_t *>(dst), batch, rows, cols, threads);
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool LayoutUtils::convertLayout(Layout from, Layout to, const SizeVector &dims, size_t elemSize,
+                                const void *src, void *dst, size_t threads) {
+    size_t batch, rows, cols;
+    return transposeShape(from, to, dims, batch, rows, cols) &&
+           transpose(src, dst, elemSize, batch, rows, cols, threads);
+}
+
+bool LayoutUtils::convertLayoutToFP16(Layout from, Layout to, const SizeVector &dims,
+                                      Precision srcPrecision, const void *src, ie_fp16 *dst, size_t threads) {
+    size_t total = 1;
+    for (auto dim : dims) total *= dim;
+    size_t batch = 1, rows = 1, cols = total;
+    if (from != to && !transposeShape(from, to, dims, batch, rows, cols)) {
+        return false;
+    }
+    if (threads == 0) threads = transposeThreads(total * srcPrecision.size());
+
+    switch (srcPrecision) {
+    case Precision::U8:
+        if (from == to) {
+            u8ToFP16(dst, static_cast<const uint8_t *>(src), total);
+        } else {
+            transposeToFP16(static_cast<const uint8_t *>(src), dst, batch, rows, cols, threads, u8ToFP16);
+        }
+        return true;
+    case Precision::FP32:
+        if (from == to) {
+            fp32ToFP16(dst, static_cast<const float *>(src), total);
+        } else {
+            transposeToFP16(static_cast<const float *>(src), dst, batch, rows, cols, threads, fp32ToFP16);
+        }
+        return true;
+    case Precision::FP16:
+        if (from == to) {
+            memcpy(dst, src, total * sizeof(ie_fp16));
+            return true;
+        }
+        return transpose(src, dst, sizeof(ie_fp16), batch, rows, cols, threads);
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,76 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2017 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <ie_api.h>
+#include <ie_common.h>
+#include <ie_precision.hpp>
+
+#include "precision_utils.h"
+
+namespace InferenceEngine {
+
+namespace LayoutUtils {
+
+// Layout changes are batched 2-D transposes: NCHW <-> NHWC swaps C with HxW
+// per image, NC <-> CN swaps the two dims. dims are in the NCHW/NC order a
+// TensorDesc keeps them in. Returns false for any other pair, including
+// from == to.
+INFERENCE_ENGINE_API_CPP(bool) transposeShape(Layout from, Layout to, const SizeVector &dims,
+                                              size_t &batch, size_t &rows, size_t &cols);
+
+// How many threads a transpose of this many bytes is worth, 1 below a few MB.
+INFERENCE_ENGINE_API_CPP(size_t) transposeThreads(size_t bytes);
+
+// dst[n][c][r] = src[n][r][c] for elements of 1, 2 or 4 bytes, blocked for
+// the cache with in-register transposes (SSE2 / NEON) inside each block.
+// threads == 0 picks transposeThreads(). Returns false for other element
+// sizes.
+INFERENCE_ENGINE_API_CPP(bool) transpose(const void *src, void *dst, size_t elemSize,
+                                         size_t batch, size_t rows, size_t cols, size_t threads = 0);
+
+// Copies data of dims from one layout to another, see transposeShape().
+INFERENCE_ENGINE_API_CPP(bool) convertLayout(Layout from, Layout to, const SizeVector &dims, size_t elemSize,
+                                             const void *src, void *dst, size_t threads = 0);
+
+// convertLayout() fused with the conversion of U8 or FP32 data to FP16, so
+// the data is read and written once. from == to only converts. The FP16 bits
+// are those of PrecisionUtils::f32tof16.
+INFERENCE_ENGINE_API_CPP(bool) convertLayoutToFP16(Layout from, Layout to, const SizeVector &dims,
+                                                   Precision srcPrecision, const void *src, ie_fp16 *dst,
+                                                   size_t threads = 0);
+
+}  // namespace LayoutUtils
+
+}  // namespace InferenceEngine
@@ -33,6 +33,8 @@
 #include "config.h"
 #include "ie_plugin_config.hpp"
 #include "ie_common.h"
+#include "mkldnn/omp_manager.h"
+#include <omp.h>
 
 #include <string>
 #include <map>
@@ -43,6 +45,29 @@ namespace MKLDNNPlugin {
 
 using namespace InferenceEngine;
 
+namespace {
+
+// small models stop scaling past a handful of cores, give each stream four
+const int kCoresPerAutoStream = 4;
+
+int numberOfSockets() {
+#if !(defined(__APPLE__) || defined(_WIN32))
+    return cpu::OpenMpManager::getNumberOfSockets();
+#else
+    return 1;
+#endif
+}
+
+int numberOfCores() {
+#if !(defined(__APPLE__) || defined(_WIN32))
+    return cpu::OpenMpManager::getOpenMpThreadNumber();
+#else
+    return omp_get_num_procs();
+#endif
+}
+
+}  // namespace
+
 void Config::readProperties(const std::map<std::string, std::string> &prop) {
     for (auto& kvp : prop) {
         std::string key = kvp.first;
@@ -59,6 +84,42 @@ void Config::readProperties(const std::map<std::string, std::string> &prop) {
             // zero and any negative value will be treated
             // as default batch size
             batchLimit = std::max(val_i, 0);
+        } else if (key == PluginConfigParams::KEY_CPU_THROUGHPUT_STREAMS) {
+            if (val == PluginConfigParams::CPU_THROUGHPUT_NUMA) {
+                throughputStreams = numberOfSockets();
+            } else if (val == PluginConfigParams::CPU_THROUGHPUT_AUTO) {
+                throughputStreams = std::max(numberOfCores() / kCoresPerAutoStream, 1);
+            } else {
+                int val_i;
+                try {
+                    val_i = std::stoi(val);
+                } catch (const std::exception&) {
+                    val_i = 0;
+                }
+                if (val_i < 1)
+                    THROW_IE_EXCEPTION << "Wrong value for property key " << PluginConfigParams::KEY_CPU_THROUGHPUT_STREAMS
+                                       << ". Expected a positive number, CPU_THROUGHPUT_NUMA or CPU_THROUGHPUT_AUTO";
+                throughputStreams = val_i;
+            }
+        } else if (key == PluginConfigParams::KEY_CPU_BATCH_REQUESTS) {
+            if (val == PluginConfigParams::YES) batchRequests = true;
+            else if (val == PluginConfigParams::NO) batchRequests = false;
+            else
+                THROW_IE_EXCEPTION << "Wrong value for property key " << PluginConfigParams::KEY_CPU_BATCH_REQUESTS
+                                   << ". Expected only YES/NO";
+        } else if (key == PluginConfigParams::KEY_CPU_BATCH_TIMEOUT) {
+            int val_i;
+            try {
+                val_i = std::stoi(val);
+            } catch (const std::exception&) {
+                val_i = -1;
+            }
+            if (val_i < 0)
+                THROW_IE_EXCEPTION << "Wrong value for property key " << PluginConfigParams::KEY_CPU_BATCH_TIMEOUT
+                                   << ". Expected a non-negative number of microseconds";
+            batchTimeoutUs = val_i;
+        } else if (key == PluginConfigParams::KEY_CPU_WEIGHTS_CACHE_FILE) {
+            weightsCacheFile = val;
         } else if (key == PluginConfigParams::KEY_PERF_COUNT) {
             if (val == PluginConfigParams::YES) collectPerfCounters = true;
             else if (val == PluginConfigParams::NO) collectPerfCounters = false;
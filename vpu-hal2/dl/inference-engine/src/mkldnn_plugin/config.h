@@ -41,6 +41,10 @@ struct Config {
     bool collectPerfCounters = false;
     bool exclusiveAsyncRequests = false;
     int batchLimit = 0;
+    int throughputStreams = 1;
+    bool batchRequests = false;
+    int batchTimeoutUs = 1000;
+    std::string weightsCacheFile;
 
     void readProperties(const std::map<std::string, std::string> &config);
 };
@@ -31,6 +31,7 @@
 //
 #include "lin_omp_manager.h"
 
+#include <algorithm>
 #include <fstream>
 #include <set>
 #include <string>
@@ -338,6 +339,66 @@ int OpenMpManager::getOpenMpThreadNumber() {
 }
 
 
+int OpenMpManager::getNumberOfSockets() {
+    OpenMpManager &openMpManager = getInstance();
+
+    // ARM cpuinfo has no physical id, all cores then sit on one socket
+    return std::max(openMpManager.collection.getTotalNumberOfSockets(), 1u);
+}
+
+std::vector<std::vector<unsigned>> OpenMpManager::getStreamsCores(int streams) {
+    OpenMpManager &openMpManager = getInstance();
+    unsigned numberOfProcessors = openMpManager.collection.getNumberOfProcessors();
+
+    std::vector<std::pair<unsigned, unsigned>> cores;  // socket, processor
+    for (unsigned processorId = 0; processorId < numberOfProcessors; processorId++) {
+        if (CPU_ISSET(processorId, &openMpManager.currentCoreSet)) {
+            cores.emplace_back(openMpManager.collection.getProcessor(processorId).physicalId, processorId);
+        }
+    }
+    std::sort(cores.begin(), cores.end());
+
+    streams = std::max(streams, 1);
+    std::vector<std::vector<unsigned>> streamsCores(streams);
+    if (cores.empty())
+        return streamsCores;
+
+    if (streams >= static_cast<int>(cores.size())) {
+        // oversubscribed: single core streams sharing the cores round robin
+        for (int s = 0; s < streams; s++)
+            streamsCores[s].push_back(cores[s % cores.size()].second);
+        return streamsCores;
+    }
+
+    size_t begin = 0;
+    for (int s = 0; s < streams; s++) {
+        size_t end = cores.size() * (s + 1) / streams;
+        for (size_t c = begin; c < end; c++)
+            streamsCores[s].push_back(cores[c].second);
+        begin = end;
+    }
+    return streamsCores;
+}
+
+void OpenMpManager::bindOpenMpThreadsToCores(const std::vector<unsigned> &processorIds) {
+    OpenMpManager &openMpManager = getInstance();
+
+    if (processorIds.empty())
+        return;
+
+    omp_set_num_threads(static_cast<int>(processorIds.size()));
+    if (!openMpManager.isThreadsBindAllowed())
+        return;
+
+    #pragma omp parallel
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(processorIds[omp_get_thread_num() % processorIds.size()], &set);
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+}
+
 void OpenMpManager::getOpenMpEnvVars() {
     isAnyOpenMpEnvVarSpecified = false;
     for (unsigned i = 0; i < numberOfOpenMpEnvVars; i++) {
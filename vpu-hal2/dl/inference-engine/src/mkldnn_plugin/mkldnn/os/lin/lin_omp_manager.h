@@ -164,6 +164,17 @@ public:
 
     static bool isMajorThread(int currentThread);
 
+    static int getNumberOfSockets();
+
+    // Splits the cores of the process into `streams` disjoint sets, one
+    // processor per core, walking the cores socket by socket so a set only
+    // straddles sockets when the streams don't divide them
+    static std::vector<std::vector<unsigned>> getStreamsCores(int streams);
+
+    // Sizes the OpenMP team of the calling thread to the given processors
+    // and pins one team thread on each
+    static void bindOpenMpThreadsToCores(const std::vector<unsigned> &processorIds);
+
 private:
     Collection &collection;
 
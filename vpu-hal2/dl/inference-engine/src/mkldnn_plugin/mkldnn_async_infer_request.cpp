@@ -36,8 +36,10 @@
 MKLDNNPlugin::MKLDNNAsyncInferRequest::MKLDNNAsyncInferRequest(const InferenceEngine::IInferRequestInternal::Ptr &inferRequest,
                                                                const InferenceEngine::ITaskExecutor::Ptr &taskExecutor,
                                                                const InferenceEngine::TaskSynchronizer::Ptr &taskSynchronizer,
-                                                               const InferenceEngine::ITaskExecutor::Ptr &callbackExecutor)
-        : InferenceEngine::AsyncInferRequestThreadSafeDefault(inferRequest, taskExecutor, taskSynchronizer, callbackExecutor) {}
+                                                               const InferenceEngine::ITaskExecutor::Ptr &callbackExecutor,
+                                                               const MKLDNNRequestsAggregator::Ptr &aggregator)
+        : InferenceEngine::AsyncInferRequestThreadSafeDefault(inferRequest, taskExecutor, taskSynchronizer, callbackExecutor),
+          aggregator(aggregator) {}
 
 MKLDNNPlugin::MKLDNNAsyncInferRequest::~MKLDNNAsyncInferRequest() {
     waitAllAsyncTasks();
@@ -50,3 +52,14 @@ void MKLDNNPlugin::MKLDNNAsyncInferRequest::Infer() {
     Wait(InferenceEngine::IInferRequest::WaitMode::RESULT_READY);
     _callback = registeredCallback;
 }
+
+void MKLDNNPlugin::MKLDNNAsyncInferRequest::startAsyncTask() {
+    if (!aggregator) {
+        AsyncInferRequestThreadSafeDefault::startAsyncTask();
+        return;
+    }
+    auto request = dynamic_cast<MKLDNNInferRequest *>(_syncRequest.get());
+    if (!request)
+        THROW_IE_EXCEPTION << " Cannot get mkldnn sync request.";
+    if (!aggregator->startTask(request, _currentTask)) THROW_IE_EXCEPTION << REQUEST_BUSY_str;
+}
@@ -36,6 +36,7 @@
 #include <map>
 #include <cpp_interfaces/impl/ie_infer_async_request_thread_safe_default.hpp>
 #include "mkldnn_infer_request.h"
+#include "mkldnn_requests_aggregator.h"
 
 namespace MKLDNNPlugin {
 
@@ -44,11 +45,18 @@ public:
     MKLDNNAsyncInferRequest(const InferenceEngine::IInferRequestInternal::Ptr &inferRequest,
                             const InferenceEngine::ITaskExecutor::Ptr &taskExecutor,
                             const InferenceEngine::TaskSynchronizer::Ptr &taskSynchronizer,
-                            const InferenceEngine::ITaskExecutor::Ptr &callbackExecutor);
+                            const InferenceEngine::ITaskExecutor::Ptr &callbackExecutor,
+                            const MKLDNNRequestsAggregator::Ptr &aggregator = nullptr);
 
     ~MKLDNNAsyncInferRequest() override;
 
     void Infer() override;
+
+protected:
+    void startAsyncTask() override;
+
+private:
+    MKLDNNRequestsAggregator::Ptr aggregator;
 };
 
 }  // namespace MKLDNNPlugin
@@ -0,0 +1,155 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2016 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+//
+#include "mkldnn_eltwise_chain.h"
+#include "nodes/mkldnn_activation_node.h"
+
+#include <ie_layers.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace mkldnn;
+using namespace MKLDNNPlugin;
+using namespace InferenceEngine;
+
+const size_t MKLDNNEltwiseChain::tileSize;
+
+bool MKLDNNEltwiseChain::isSupported(const MKLDNNNodePtr& node) {
+    return node->getType() == Activation || node->getType() == Power;
+}
+
+void MKLDNNEltwiseChain::append(const MKLDNNNodePtr& node) {
+    if (node->getType() == Activation) {
+        auto * activationNode = dynamic_cast<MKLDNNActivationNode *>(node.get());
+        if (activationNode == nullptr)
+            THROW_IE_EXCEPTION << "Cannot convert activation node " << node->getName() << ".";
+        appendActivation(activationNode->getAlgorithm(), activationNode->getAlpha(), activationNode->getBeta());
+    } else if (node->getType() == Power) {
+        auto * powerLayer = dynamic_cast<PowerLayer*>(node->getCnnLayer().get());
+        if (powerLayer == nullptr)
+            THROW_IE_EXCEPTION << "Cannot convert power layer of node " << node->getName() << ".";
+        appendPower(powerLayer->scale, powerLayer->offset, powerLayer->power);
+    } else {
+        THROW_IE_EXCEPTION << "Node " << node->getName() << " is not an elementwise operation.";
+    }
+}
+
+void MKLDNNEltwiseChain::appendActivation(mkldnn::algorithm algorithm, float alpha, float beta) {
+    switch (algorithm) {
+        case eltwise_relu: case eltwise_elu: case eltwise_tanh: case eltwise_logistic:
+        case eltwise_square: case eltwise_abs: case eltwise_sqrt: case eltwise_linear:
+        case eltwise_bounded_relu: case eltwise_soft_relu:
+            break;
+        default:
+            THROW_IE_EXCEPTION << "Unsupported activation in an elementwise chain.";
+    }
+    ops.push_back({algorithm, alpha, beta, 1.0f, false});
+}
+
+void MKLDNNEltwiseChain::appendPower(float scale, float shift, float power) {
+    ops.push_back({eltwise_linear, scale, shift, power, power != 1.0f});
+}
+
+// the same formulas as the MKLDNN reference eltwise
+void MKLDNNEltwiseChain::apply(const Op& op, const float* src, float* dst, size_t count) {
+    const float alpha = op.alpha;
+    const float beta = op.beta;
+
+    if (op.isPower) {
+        for (size_t i = 0; i < count; i++)
+            dst[i] = std::pow(src[i] * alpha + beta, op.power);
+        return;
+    }
+
+    switch (op.algorithm) {
+        case eltwise_relu:
+            for (size_t i = 0; i < count; i++)
+                dst[i] = src[i] > 0 ? src[i] : src[i] * alpha;
+            break;
+        case eltwise_elu:
+            for (size_t i = 0; i < count; i++)
+                dst[i] = src[i] > 0 ? src[i] : alpha * (std::exp(src[i]) - 1.0f);
+            break;
+        case eltwise_tanh:
+            for (size_t i = 0; i < count; i++)
+                dst[i] = std::tanh(src[i]);
+            break;
+        case eltwise_logistic:
+            for (size_t i = 0; i < count; i++) {
+                float v = std::exp(src[i]);
+                dst[i] = v / (v + 1.0f);
+            }
+            break;
+        case eltwise_square:
+            for (size_t i = 0; i < count; i++)
+                dst[i] = src[i] * src[i];
+            break;
+        case eltwise_abs:
+            for (size_t i = 0; i < count; i++)
+                dst[i] = std::fabs(src[i]);
+            break;
+        case eltwise_sqrt:
+            for (size_t i = 0; i < count; i++)
+                dst[i] = src[i] > 0 ? std::sqrt(src[i]) : 0.0f;
+            break;
+        case eltwise_linear:
+            for (size_t i = 0; i < count; i++)
+                dst[i] = src[i] * alpha + beta;
+            break;
+        case eltwise_bounded_relu:
+            for (size_t i = 0; i < count; i++)
+                dst[i] = std::min(std::max(src[i], 0.0f), alpha);
+            break;
+        case eltwise_soft_relu:
+            for (size_t i = 0; i < count; i++)
+                dst[i] = std::log(1.0f + std::exp(src[i]));
+            break;
+        default:
+            break;
+    }
+}
+
+void MKLDNNEltwiseChain::execute(const float* src, float* dst, size_t count) const {
+    const int tiles = static_cast<int>((count + tileSize - 1) / tileSize);
+
+    #pragma omp parallel for
+    for (int t = 0; t < tiles; t++) {
+        const size_t begin = t * tileSize;
+        const size_t size = std::min(tileSize, count - begin);
+        const float* in = src + begin;
+        float* out = dst + begin;
+        for (const auto& op : ops) {
+            apply(op, in, out, size);
+            in = out;
+        }
+    }
+}
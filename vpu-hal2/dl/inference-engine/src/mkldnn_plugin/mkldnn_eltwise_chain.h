@@ -0,0 +1,79 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2016 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+//
+#pragma once
+
+#include "mkldnn_node.h"
+#include <cstddef>
+#include <vector>
+
+namespace MKLDNNPlugin {
+
+/**
+ * The elementwise operations of Activation and Power nodes fused into one
+ * node. They run tile by tile, so a tile stays in cache from the first
+ * operation to the last and the tensor is read and written only once.
+ */
+class MKLDNNEltwiseChain {
+public:
+    // floats per tile, the input and output tiles fit in L1 together
+    static const size_t tileSize = 2048;
+
+    /** True for the Activation and Power nodes append() takes. */
+    static bool isSupported(const MKLDNNNodePtr& node);
+
+    /** Adds the operation of a fused node, read from its CNNLayer, so call it before cleanup(). */
+    void append(const MKLDNNNodePtr& node);
+    void appendActivation(mkldnn::algorithm algorithm, float alpha, float beta);
+    void appendPower(float scale, float shift, float power);
+
+    bool empty() const {
+        return ops.empty();
+    }
+
+    /** Applies the operations in order to count floats, src may be dst. */
+    void execute(const float* src, float* dst, size_t count) const;
+
+private:
+    struct Op {
+        mkldnn::algorithm algorithm;
+        float alpha;
+        float beta;
+        float power;    // a Power node with power != 1, (x * alpha + beta) ^ power
+        bool isPower;
+    };
+
+    static void apply(const Op& op, const float* src, float* dst, size_t count);
+
+    std::vector<Op> ops;
+};
+
+}  // namespace MKLDNNPlugin
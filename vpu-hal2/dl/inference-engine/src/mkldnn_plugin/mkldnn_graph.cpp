@@ -31,6 +31,7 @@
 //
 
 #include <algorithm>
+#include <climits>
 #include <string>
 #include <map>
 #include <vector>
@@ -51,8 +52,13 @@
 #include "ie_algorithm.hpp"
 #include "mkldnn_infer_request.h"
 #include "mkldnn_async_infer_request.h"
+#include "mkldnn_memory_solver.h"
+#include "mkldnn_streams.h"
+#include "mkldnn_requests_aggregator.h"
 // #define DEBUG_DUMP_PATH "/home/user/HDD/gna-mkldnn/"
 // #define DEBUG_DUMP_NEW_FOLDER_PER_INFER
+// #define DEBUG_MEMORY_PLAN
+// #define DEBUG_FUSION_REPORT
 #ifdef DEBUG_DUMP_PATH
 #include "../../thirdparty/mkl-dnn/src/common/memory_desc_wrapper.hpp"
 #include <iomanip>
@@ -88,12 +94,14 @@ void BindThreads(mkldnn::engine eng) {
     }
 }
 
-void MKLDNNGraph::CreateGraph(ICNNNetwork &network, const MKLDNNExtensionManager::Ptr& extMgr) {
+void MKLDNNGraph::CreateGraph(ICNNNetwork &network, const MKLDNNExtensionManager::Ptr& extMgr,
+                              const MKLDNNWeightsSharing::Ptr& w_cache) {
     if (IsReady()) {
         ForgetGraphData();
     }
 
-    if (config.useThreadBinding) BindThreads(eng);
+    // streams pin their own threads, binding all the cores would undo it
+    if (config.useThreadBinding && config.throughputStreams <= 1) BindThreads(eng);
 
     // go over the inputs and create input primitives
     InputsDataMap inputs;
@@ -182,6 +190,12 @@ void MKLDNNGraph::CreateGraph(ICNNNetwork &network, const MKLDNNExtensionManager
 
     MKLDNNGraphOptimizer optimizer;
     optimizer.Optimize(*this);
+#ifdef DEBUG_FUSION_REPORT
+    for (const auto& stats : fusionStats) {
+        std::cout << "Fusion " << stats.rule << ": " << stats.matches << " matches, " << stats.removedNodes
+                  << " nodes removed, " << stats.savedBytes << " bytes saved per inference" << std::endl;
+    }
+#endif
 
     InitNodes();
     SelectOptimalPrimitiveDescriptors();
@@ -192,18 +206,16 @@ void MKLDNNGraph::CreateGraph(ICNNNetwork &network, const MKLDNNExtensionManager
 
     Allocate();
 
+    for (auto &graphNode : graphNodes) {
+        graphNode->setWeightsCache(w_cache);
+    }
     CreatePrimitives();
 
     for (auto &graphNode : graphNodes) {
         graphNode->cleanup();
     }
 
-    mkldnn::stream stream = mkldnn::stream(stream::kind::eager);
-    for (auto &graphNode : graphNodes) {
-        if (!graphNode->isConstant(false))
-            continue;
-        graphNode->execute(stream);
-    }
+    optimizer.FoldConstants(*this);
 
     status = Ready;
 }
@@ -338,6 +350,7 @@ void MKLDNNGraph::Allocate() {
     for (auto& node : graphNodes) {
         node->initEdges();
     }
+    PlanMemory();
     for (auto& edge : graphEdges) {
         edge->allocate();
     }
@@ -349,6 +362,99 @@ void MKLDNNGraph::Allocate() {
     }
 }
 
+void MKLDNNGraph::PlanMemory() {
+    std::map<const MKLDNNNode*, int> execIndex;
+    for (size_t i = 0; i < graphNodes.size(); i++) {
+        execIndex[graphNodes[i].get()] = static_cast<int>(i);
+    }
+
+    // edges resolved to another edge's memory (in place nodes, concat and
+    // split views) extend the lifetime of that edge's buffer
+    std::map<const MKLDNNEdge*, int> bufferIds;
+    std::vector<MKLDNNEdgePtr> buffers;
+    std::vector<MKLDNNMemorySolver::Box> boxes;
+    std::vector<bool> permanent;
+    memoryStats = MemoryStats();
+
+    for (auto& edge : graphEdges) {
+        if (edge->getStatus() == MKLDNNEdge::Status::Uninitialized)
+            continue;
+
+        auto root = edge;
+        while (root->getStatus() == MKLDNNEdge::Status::NotAllocated)
+            root = root->getSharedEdge();
+        if (root->getStatus() != MKLDNNEdge::Status::NeedAllocation)
+            continue;
+
+        auto id = bufferIds.find(root.get());
+        if (id == bufferIds.end()) {
+            auto desc = root->getInputDesc();
+            if (!desc)
+                THROW_IE_EXCEPTION << "Cannot get input descriptor!";
+            auto pd = mkldnn::memory::primitive_desc(desc, eng);
+
+            // padded blocked formats rely on the padding staying zero
+            const auto& data = desc.getDesc().data;
+            bool padded = false;
+            for (int d = 0; d < data.ndims; d++)
+                padded = padded || data.layout_desc.blocking.padding_dims[d] != data.dims[d];
+
+            id = bufferIds.emplace(root.get(), static_cast<int>(buffers.size())).first;
+            buffers.push_back(root);
+            boxes.push_back({INT_MAX, 0, pd.get_size(), id->second});
+            permanent.push_back(padded);
+        }
+        memoryStats.edges++;
+
+        auto parent = edge->getParent();
+        auto child = edge->getChild();
+        auto from = execIndex.find(parent.get());
+        auto to = execIndex.find(child.get());
+
+        // inputs and outputs get swapped for user blobs by pointer, constants
+        // are computed once and memory layers carry state between requests
+        if (from == execIndex.end() || to == execIndex.end() ||
+                parent->getType() == Input || parent->getType() == MemoryInput ||
+                child->getType() == Output || parent->isConstant(false)) {
+            permanent[id->second] = true;
+            continue;
+        }
+
+        auto& box = boxes[id->second];
+        box.start = std::min(box.start, from->second);
+        box.finish = std::max(box.finish, to->second);
+    }
+
+    for (size_t i = 0; i < boxes.size(); i++) {
+        if (permanent[i]) {
+            boxes[i].start = 0;
+            boxes[i].finish = -1;
+        }
+    }
+
+    MKLDNNMemorySolver solver(boxes);
+    size_t arenaSize = solver.solve();
+
+    memoryArena.assign(arenaSize + MKLDNNMemorySolver::alignment, 0);
+    auto base = reinterpret_cast<uintptr_t>(memoryArena.data());
+    base = (base + MKLDNNMemorySolver::alignment - 1) / MKLDNNMemorySolver::alignment * MKLDNNMemorySolver::alignment;
+
+    for (size_t i = 0; i < buffers.size(); i++) {
+        buffers[i]->allocate(reinterpret_cast<uint8_t*>(base) + solver.getOffset(static_cast<int>(i)));
+    }
+
+    memoryStats.buffers = buffers.size();
+    memoryStats.naiveBytes = solver.naiveSize();
+    memoryStats.peakLiveBytes = solver.peakLiveSize();
+    memoryStats.plannedBytes = arenaSize;
+
+#ifdef DEBUG_MEMORY_PLAN
+    std::cout << "Memory plan: " << memoryStats.edges << " edges, " << memoryStats.buffers << " buffers, "
+              << memoryStats.naiveBytes << " bytes naive, " << memoryStats.peakLiveBytes << " bytes peak live, "
+              << memoryStats.plannedBytes << " bytes planned" << std::endl;
+#endif
+}
+
 void MKLDNNGraph::CreatePrimitives() {
     for (auto& node : graphNodes) {
         node->createPrimitive();
@@ -558,11 +664,13 @@ void dump_as_bitmaps(const std::string name, const float* data,
 }
 #endif
 
-void MKLDNNGraph::Infer() {
+void MKLDNNGraph::Infer(int batch) {
     if (!IsReady()) {
         THROW_IE_EXCEPTION << "Wrong state. Topology is not ready.";
     }
 
+    int batchLimit = batch > 0 ? batch : config.batchLimit;
+
     mkldnn::stream stream = mkldnn::stream(stream::kind::eager);
 
 #ifdef DEBUG_DUMP_NEW_FOLDER_PER_INFER
@@ -571,8 +679,8 @@ void MKLDNNGraph::Infer() {
 #endif
     for (int i = 0; i < graphNodes.size(); i++) {
         PERF(graphNodes[i]);
-        graphNodes[i]->setDynamicBatchLim(config.batchLimit);
-        if (!graphNodes[i]->isConstant(true)) {
+        graphNodes[i]->setDynamicBatchLim(batchLimit);
+        {
             IE_PROFILING_AUTO_SCOPE_STRING(graphNodes[i]->name.c_str())
             graphNodes[i]->execute(stream);
         }
@@ -761,6 +869,11 @@ void MKLDNNGraph::GetPerfData(std::map<std::string, InferenceEngine::InferenceEn
     for (int i = 1; i < graphNodes.size(); i++) {
         getPerfMapFor(perfMap, graphNodes[i]);
     }
+
+    // folded at creation, reported as not run
+    for (auto& node : constantNodes) {
+        getPerfMapFor(perfMap, node);
+    }
 }
 
 void MKLDNNGraph::setConfig(const Config &cfg) {
@@ -805,8 +918,36 @@ MKLDNNExecNetwork::CreateInferRequestImpl(InferenceEngine::InputsDataMap network
 MKLDNNExecNetwork::MKLDNNExecNetwork(InferenceEngine::ICNNNetwork &network,
                                      const Config &cfg,
                                      const MKLDNNExtensionManager::Ptr& extMgr) : extensionManager(extMgr) {
+    MKLDNNWeightsSharing::Ptr weightsCache;
+    if (!cfg.weightsCacheFile.empty())
+        weightsCache = std::make_shared<MKLDNNWeightsSharing>(cfg.weightsCacheFile,
+                                                              MKLDNNWeightsSharing::modelIdentity(network));
+
+    // exclusive requests share one executor with the other networks, which leaves a single stream
+    if (cfg.throughputStreams > 1 && !cfg.exclusiveAsyncRequests) {
+        if (!weightsCache)
+            weightsCache = std::make_shared<MKLDNNWeightsSharing>();
+        auto streams = std::make_shared<MKLDNNStreamsExecutor>(cfg.throughputStreams, cfg.useThreadBinding,
+                                                               [&](int stream) {
+            MKLDNNGraph::Ptr replica(new MKLDNNGraph());
+            replica->setConfig(cfg);
+            replica->CreateGraph(network, extensionManager, weightsCache);
+            return replica;
+        });
+        graphs = streams->getGraphs();
+        graph = graphs.front();
+        _taskExecutor = streams;
+        // failing to write the file only costs the next load its conversions
+        weightsCache->save();
+        CreateAggregator(network, cfg);
+        return;
+    }
+
+    Config graphCfg = cfg;
+    graphCfg.throughputStreams = 1;
     graph.reset(new MKLDNNGraph());
-    graph->setConfig(cfg);
+    graph->setConfig(graphCfg);
+    graphs.push_back(graph);
 
     if (graph->getProperty().exclusiveAsyncRequests) {
         ExecutorManager *executorManager = ExecutorManager::getInstance();
@@ -815,25 +956,39 @@ MKLDNNExecNetwork::MKLDNNExecNetwork(InferenceEngine::ICNNNetwork &network,
 
     // initialization in taskExecutor thread
     auto task = std::make_shared<InferenceEngine::Task>([&]() {
-        graph->CreateGraph(network, extensionManager);
+        graph->CreateGraph(network, extensionManager, weightsCache);
     });
 
     _taskExecutor->startTask(task);
     Task::Status sts = task->wait(InferenceEngine::IInferRequest::WaitMode::RESULT_READY);
 
     if (sts == Task::TS_ERROR) task->checkException();
+    if (weightsCache)
+        weightsCache->save();
+    CreateAggregator(network, cfg);
+}
+
+void MKLDNNExecNetwork::CreateAggregator(InferenceEngine::ICNNNetwork &network, const Config &cfg) {
+    if (!cfg.batchRequests)
+        return;
+    // the graphs keep the batch of the network, a batch of requests fills its first samples
+    int maxBatch = static_cast<int>(network.getBatchSize());
+    if (cfg.batchLimit)
+        maxBatch = std::min(maxBatch, cfg.batchLimit);
+    aggregator = std::make_shared<MKLDNNRequestsAggregator>(maxBatch, cfg.batchTimeoutUs,
+                                                            static_cast<int>(graphs.size()), _taskExecutor, graph);
 }
 
 void MKLDNNExecNetwork::setProperty(const std::map<std::string, std::string> &properties) {
-    if (graph)  // TODO: graph field cannot be empty
-        graph->setProperty(properties);
+    for (auto& replica : graphs)
+        replica->setProperty(properties);
 }
 
 void MKLDNNExecNetwork::CreateInferRequest(InferenceEngine::IInferRequest::Ptr &asyncRequest) {
     auto syncRequestImpl = CreateInferRequestImpl(_networkInputs, _networkOutputs);
     syncRequestImpl->setPointerToExecutableNetworkInternal(shared_from_this());
     auto asyncRequestImpl = std::make_shared<MKLDNNAsyncInferRequest>(syncRequestImpl, _taskExecutor,
-                                                                      _taskSynchronizer, _callbackExecutor);
+                                                                      _taskSynchronizer, _callbackExecutor, aggregator);
     asyncRequest.reset(new InferRequestBase<MKLDNNAsyncInferRequest>(asyncRequestImpl),
                        [](IInferRequest *p) { p->Release(); });
 
@@ -843,9 +998,13 @@ void MKLDNNExecNetwork::CreateInferRequest(InferenceEngine::IInferRequest::Ptr &
     if (!mkldnnSyncRequest)
         THROW_IE_EXCEPTION << " Cannot get mkldnn sync request.";
     mkldnnSyncRequest->SetGraph(graph);
+    mkldnnSyncRequest->SetAggregated(aggregator != nullptr);
 }
 
 MKLDNNExecNetwork::~MKLDNNExecNetwork() {
+    // dispatches the last batches while the executor and the graphs are still there
+    aggregator.reset();
+    graphs.clear();
     graph.reset();
     extensionManager.reset();
 }
@@ -45,13 +45,31 @@
 #include "mkldnn_node.h"
 #include "mkldnn_edge.h"
 #include "mkldnn_extension_utils.h"
+#include "mkldnn_weights_cache.h"
 
 namespace MKLDNNPlugin {
 
+class MKLDNNRequestsAggregator;
+
 class MKLDNNGraph {
 public:
     typedef std::shared_ptr<MKLDNNGraph> Ptr;
 
+    struct MemoryStats {
+        size_t edges = 0;
+        size_t buffers = 0;         // edges sharing memory in place count once
+        size_t naiveBytes = 0;      // one allocation per buffer
+        size_t peakLiveBytes = 0;   // bytes alive at the busiest node
+        size_t plannedBytes = 0;    // the arena the buffers were packed into
+    };
+
+    struct FusionStats {
+        std::string rule;
+        size_t matches = 0;
+        size_t removedNodes = 0;
+        size_t savedBytes = 0;      // FP32 tensors no longer written and read back, per inference
+    };
+
     enum Status {
         NotReady = 0,
         Ready = 1,
@@ -74,7 +92,8 @@ public:
     void getInputBlobs(InferenceEngine::BlobMap &in_map);
     void getOutputBlobs(InferenceEngine::BlobMap &out_map);
 
-    void CreateGraph(InferenceEngine::ICNNNetwork &network, const MKLDNNExtensionManager::Ptr& extMgr);
+    void CreateGraph(InferenceEngine::ICNNNetwork &network, const MKLDNNExtensionManager::Ptr& extMgr,
+                     const MKLDNNWeightsSharing::Ptr& w_cache = nullptr);
 
     bool hasMeanImageFor(const std::string& name) {
         return _meanImages.find(name) != _meanImages.end();
@@ -83,7 +102,10 @@ public:
     void PushInputData(const std::string& name, const InferenceEngine::Blob::Ptr &in);
     void PullOutputData(InferenceEngine::BlobMap &out);
 
-    void Infer();
+    /**
+     * @param batch - samples to process when positive, otherwise the configured KEY_DYN_BATCH_LIMIT
+     */
+    void Infer(int batch = -1);
 
     std::vector<MKLDNNNodePtr>& GetNodes() {
         return graphNodes;
@@ -97,12 +119,24 @@ public:
         return outputNodes;
     }
 
+    std::vector<MKLDNNNodePtr>& GetConstantNodes() {
+        return constantNodes;
+    }
+
     mkldnn::engine getEngine() const {
         return eng;
     }
 
     void GetPerfData(std::map<std::string, InferenceEngine::InferenceEngineProfileInfo> &perfMap) const;
 
+    const MemoryStats& GetMemoryStats() const {
+        return memoryStats;
+    }
+
+    const std::vector<FusionStats>& GetFusionStats() const {
+        return fusionStats;
+    }
+
 protected:
     MKLDNNNodePtr ParseNode(const InferenceEngine::CNNLayerPtr& cnnLayer, MKLDNNNodePtr& parent,
                             const MKLDNNExtensionManager::Ptr& extMgr, size_t outIdx);
@@ -118,8 +152,12 @@ protected:
         inputNodes.clear();
         outputNodes.clear();
         graphNodes.clear();
+        constantNodes.clear();
         graphEdges.clear();
         _meanImages.clear();
+        memoryArena.clear();
+        memoryStats = MemoryStats();
+        fusionStats.clear();
     }
     Status status;
     Config config;
@@ -127,19 +165,29 @@ protected:
     std::map<std::string, MKLDNNNodePtr> inputNodes;
     std::vector<MKLDNNNodePtr> outputNodes;
     std::vector<MKLDNNNodePtr> graphNodes;
+    // computed once at creation and taken out of graphNodes, see MKLDNNGraphOptimizer::FoldConstants()
+    std::vector<MKLDNNNodePtr> constantNodes;
     std::vector<MKLDNNEdgePtr> graphEdges;
 
     std::map<std::string, MeanImage> _meanImages;
 
+    // backs every edge memory, see PlanMemory()
+    std::vector<uint8_t> memoryArena;
+    MemoryStats memoryStats;
+    // filled by MKLDNNGraphOptimizer::ApplyFusionRules()
+    std::vector<FusionStats> fusionStats;
+
     mkldnn::engine eng;
 
     void InitNodes();
     void SelectOptimalPrimitiveDescriptors();
     void InitEdges();
     void Allocate();
+    void PlanMemory();
     void CreatePrimitives();
 
     friend class MKLDNNInferRequest;
+    friend class MKLDNNGraphOptimizer;
 };
 
 
@@ -160,7 +208,13 @@ public:
     void setProperty(const std::map<std::string, std::string> &properties);
 
 protected:
+    void CreateAggregator(InferenceEngine::ICNNNetwork &network, const Config &cfg);
+
     MKLDNNGraph::Ptr graph;
+    // every replica in throughput mode, graph is the first of them
+    std::vector<MKLDNNGraph::Ptr> graphs;
+    // batches the requests when KEY_CPU_BATCH_REQUESTS is set
+    std::shared_ptr<MKLDNNRequestsAggregator> aggregator;
     MKLDNNExtensionManager::Ptr extensionManager;
 };
 
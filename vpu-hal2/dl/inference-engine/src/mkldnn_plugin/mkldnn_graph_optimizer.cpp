@@ -29,11 +29,14 @@
 // this notice or any other notice embedded in Materials by Intel or Intel's
 // suppliers or licensors in any way.
 //
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <list>
 #include <memory>
 #include <set>
 #include "mkldnn_graph_optimizer.h"
+#include "mkldnn_eltwise_chain.h"
 #include "nodes/mkldnn_pooling_node.h"
 #include "nodes/mkldnn_eltwise_node.h"
 
@@ -47,11 +50,7 @@ void MKLDNNGraphOptimizer::Optimize(MKLDNNGraph &graph) {
     MergeGroupConvolution(graph);
     RemoveDropped(graph);
 
-    FuseConvolutionAndActivation(graph);
-    RemoveDropped(graph);
-
-    FuseBatchNormWithScale(graph);
-    RemoveDropped(graph);
+    ApplyFusionRules(graph, ConvolutionFusionRules());
 
     RemoveIdentityOperator(graph);
     RemoveDropped(graph);
@@ -59,9 +58,31 @@ void MKLDNNGraphOptimizer::Optimize(MKLDNNGraph &graph) {
     FuseConvolutionSumAndConvolutionSumActivation(graph);
     RemoveDropped(graph);
 
+    // last, so that convolutions first take the activations they run as post ops
+    ApplyFusionRules(graph, EltwiseFusionRules());
+
     RemoveDroppedEdges(graph);
 }
 
+void MKLDNNGraphOptimizer::FoldConstants(MKLDNNGraph &graph) {
+    auto& graphNodes = graph.GetNodes();
+    auto& constantNodes = graph.GetConstantNodes();
+
+    // nodes are sorted, the parents of a constant node have run before it
+    mkldnn::stream stream = mkldnn::stream(stream::kind::eager);
+    for (auto& node : graphNodes) {
+        if (!node->isConstant(false))
+            continue;
+        node->execute(stream);
+        constantNodes.push_back(node);
+    }
+
+    // their outputs stay in the edges, which keep memory of their own, see MKLDNNGraph::PlanMemory()
+    graphNodes.erase(std::remove_if(graphNodes.begin(), graphNodes.end(),
+                                    [](const MKLDNNNodePtr& node) { return node->isConstant(true); }),
+                     graphNodes.end());
+}
+
 void MKLDNNGraphOptimizer::MergeGroupConvolution(MKLDNNGraph &graph) {
     for (auto node : graph.GetNodes()) {
         // Split with at least 2 Convolutions
@@ -116,73 +137,234 @@ void MKLDNNGraphOptimizer::MergeGroupConvolution(MKLDNNGraph &graph) {
     }
 }
 
-void MKLDNNGraphOptimizer::FuseBatchNormWithScale(MKLDNNGraph &graph) {
-    auto &graphNodes = graph.GetNodes();
-
-    for (int i = 0; i < graphNodes.size(); i++) {
-        const auto& bn = graphNodes[i];
-        if (bn->getType() == BatchNormalization) {
-            const auto& outputNodes = graph.GetOutputNodes();
-            const std::string node_name = bn->getName();
-            // Check that the node is not output node
-            if (std::find_if(outputNodes.begin(), outputNodes.end(),
-                            [&node_name](const MKLDNNNodePtr& x) {
-                                return x->getName() == node_name;}) == outputNodes.end()) {
-                if (bn->getChildEdges().size() == 1) {
-                    auto child = bn->getChildEdgeAt(0)->getChild();
-                    if (child->type == ScaleShift) {
-                        bn->fuseWith(child);
-                        DropNode(graph, child);
-                    }
+static bool isFP32(const Blob::Ptr& blob) {
+    return blob == nullptr || blob->precision() == Precision::FP32;
+}
+
+std::vector<MKLDNNGraphOptimizer::FusionRule> MKLDNNGraphOptimizer::ConvolutionFusionRules() {
+    // merged convolutions read the weights of their peers, see MergeGroupConvolution()
+    PatternNode foldableConvolution = {{Convolution}, [](const MKLDNNNodePtr& node) {
+        auto * convLayer = dynamic_cast<ConvolutionLayer*>(node->getCnnLayer().get());
+        return convLayer != nullptr && node->getMergeWith().empty() && convLayer->_weights != nullptr &&
+               isFP32(convLayer->_weights) && isFP32(convLayer->_biases);
+    }};
+    PatternNode reluOrElu = {{Activation}, [](const MKLDNNNodePtr& node) {
+        return node->getCnnLayer() && node->fusedWith.empty() &&
+               (node->getCnnLayer()->type == "ReLU" || node->getCnnLayer()->type == "ELU");
+    }};
+    PatternNode maxPooling = {{Pooling}, [](const MKLDNNNodePtr& node) {
+        auto * poolingLayer = dynamic_cast<PoolingLayer*>(node->getCnnLayer().get());
+        return poolingLayer != nullptr && poolingLayer->_type == PoolingLayer::PoolType::MAX;
+    }};
+    auto fp32Weights = [](const MKLDNNNodePtr& node) {
+        auto * layer = dynamic_cast<WeightableLayer*>(node->getCnnLayer().get());
+        return layer != nullptr && isFP32(layer->_weights) && isFP32(layer->_biases);
+    };
+
+    auto fuse = [this](MKLDNNGraph& graph, std::vector<MKLDNNNodePtr>& nodes) {
+        nodes.front()->fuseWith(nodes.back());
+        DropNode(graph, nodes.back());
+        return true;
+    };
+    auto foldIntoWeights = [this](MKLDNNGraph& graph, std::vector<MKLDNNNodePtr>& nodes) {
+        if (!FoldIntoConvolutionWeights(nodes[0], nodes[1]))
+            return false;
+        DropNode(graph, nodes[1]);
+        return true;
+    };
+    // ReLU commutes with max pooling, so it can run before it as a post op
+    auto fuseActivation = [this](MKLDNNGraph& graph, std::vector<MKLDNNNodePtr>& nodes) {
+        nodes.front()->setType(Convolution_Activation);
+        nodes.front()->fuseWith(nodes.back());
+        DropNode(graph, nodes.back());
+        return true;
+    };
+
+    return {
+        {"BatchNormalization+ScaleShift",
+         {{{BatchNormalization}, [](const MKLDNNNodePtr& node) { return node->fusedWith.empty(); }},
+          {{ScaleShift}, nullptr}}, fuse},
+        {"Convolution+BatchNormalization", {foldableConvolution, {{BatchNormalization}, fp32Weights}}, foldIntoWeights},
+        {"Convolution+ScaleShift", {foldableConvolution, {{ScaleShift}, fp32Weights}}, foldIntoWeights},
+        {"Convolution+Activation", {{{Convolution}, nullptr}, reluOrElu}, fuseActivation},
+        {"Convolution+MaxPooling+Activation", {{{Convolution}, nullptr}, maxPooling, reluOrElu}, fuseActivation},
+    };
+}
+
+std::vector<MKLDNNGraphOptimizer::FusionRule> MKLDNNGraphOptimizer::EltwiseFusionRules() {
+    PatternNode eltwise = {{Activation, Power}, nullptr};
+
+    // the head runs the whole chain in one pass, see MKLDNNEltwiseChain
+    auto fuseEltwise = [this](MKLDNNGraph& graph, std::vector<MKLDNNNodePtr>& nodes) {
+        auto& head = nodes[0];
+        auto& next = nodes[1];
+        head->fuseWith(next);
+        for (auto& node : next->fusedWith)
+            head->fuseWith(node);
+        next->fusedWith.clear();
+        DropNode(graph, next);
+        return true;
+    };
+
+    return {
+        {"FullyConnected+Activation", {{{FullyConnected}, nullptr}, eltwise}, fuseEltwise},
+        {"Eltwise chain", {eltwise, eltwise}, fuseEltwise},
+    };
+}
+
+void MKLDNNGraphOptimizer::ApplyFusionRules(MKLDNNGraph &graph, const std::vector<FusionRule> &rules) {
+    auto& graphNodes = graph.GetNodes();
+
+    auto statsFor = [&graph](const std::string& rule) -> MKLDNNGraph::FusionStats& {
+        for (auto& stats : graph.fusionStats) {
+            if (stats.rule == rule)
+                return stats;
+        }
+        graph.fusionStats.push_back(MKLDNNGraph::FusionStats());
+        graph.fusionStats.back().rule = rule;
+        return graph.fusionStats.back();
+    };
+
+    // a rewrite can put a node after another rule's head, so sweep until nothing matches
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const auto& rule : rules) {
+            for (size_t i = 0; i < graphNodes.size();) {
+                std::vector<MKLDNNNodePtr> matched;
+                if (graphNodes[i]->isDropped() || !MatchPattern(graphNodes[i], rule.pattern, matched)) {
+                    i++;
+                    continue;
+                }
+
+                // the tensor each fused node read, not written and read back any more once it is gone
+                std::vector<size_t> inputBytes(matched.size(), 0);
+                for (size_t j = 1; j < matched.size(); j++)
+                    inputBytes[j] = matched[j]->getParentEdgeAt(0)->getDims().size() * sizeof(float);
+
+                if (!rule.rewrite(graph, matched)) {
+                    i++;
+                    continue;
+                }
+                changed = true;
+
+                auto& stats = statsFor(rule.name);
+                stats.matches++;
+                for (size_t j = 1; j < matched.size(); j++) {
+                    if (!matched[j]->isDropped())
+                        continue;
+                    stats.removedNodes++;
+                    stats.savedBytes += 2 * inputBytes[j];
                 }
+                // the same head may match again with the nodes now after it
             }
         }
     }
-}
 
-void MKLDNNGraphOptimizer::FuseConvolutionAndActivation(MKLDNNGraph &graph) {
-    auto& graphNodes = graph.GetNodes();
+    RemoveDropped(graph);
+}
 
-    auto isFusingSupported = [&](MKLDNNNodePtr node) {
-        if (!node->getCnnLayer())
+bool MKLDNNGraphOptimizer::MatchPattern(const MKLDNNNodePtr& head, const std::vector<PatternNode>& pattern,
+                                        std::vector<MKLDNNNodePtr>& matched) {
+    MKLDNNNodePtr node = head;
+    for (size_t i = 0; i < pattern.size(); i++) {
+        if (i > 0) {
+            if (node->getChildEdges().size() != 1)
+                return false;
+            node = node->getChildEdgeAt(0)->getChild();
+            if (node->getParentEdges().size() != 1)
+                return false;
+        }
+        if (!IsOneOf(node->getType(), pattern[i].types) || (pattern[i].check && !pattern[i].check(node)))
             return false;
+        matched.push_back(node);
+    }
+    return true;
+}
 
-        return node->getType() == Activation &&
-                (node->getCnnLayer()->type == "ReLU" || node->getCnnLayer()->type == "ELU");
+/**
+ * Folds the per channel y = x * scale + shift of a BatchNormalization, with its
+ * fused ScaleShift if any, or of a ScaleShift into the weights and biases of
+ * the convolution before it. The layer is shared with the network and the
+ * other streams, so the convolution gets a copy with new blobs.
+ */
+bool MKLDNNGraphOptimizer::FoldIntoConvolutionWeights(const MKLDNNNodePtr& conv, const MKLDNNNodePtr& node) {
+    auto * convLayer = dynamic_cast<ConvolutionLayer*>(conv->getCnnLayer().get());
+    if (convLayer == nullptr)
+        return false;
+
+    const size_t channels = convLayer->_out_depth;
+    if (channels == 0 || convLayer->_weights->size() % channels != 0 ||
+            (convLayer->_biases != nullptr && convLayer->_biases->size() != channels))
+        return false;
+
+    // a single value applies to all channels
+    auto at = [](const Blob::Ptr& blob, size_t c, float none) {
+        if (blob == nullptr || blob->size() == 0)
+            return none;
+        const float* data = blob->buffer().as<const float*>();
+        return blob->size() == 1 ? data[0] : data[c];
+    };
+    auto fits = [channels](const Blob::Ptr& blob) {
+        return blob == nullptr || blob->size() <= 1 || blob->size() == channels;
     };
 
-    for (int i = 0; i < graphNodes.size(); i++) {
-        if (graphNodes[i]->getType() == Convolution) {
-            auto conv = graphNodes[i];
-
-            auto fuse = [&] (MKLDNNNodePtr relu) {
-                conv->setType(Convolution_Activation);
-                conv->fuseWith(relu);
-                DropNode(graph, relu);
-            };
-
-            if (conv->getChildEdges().size() == 1) {
-                auto ch1 = conv->getChildEdgeAt(0)->getChild();
-
-                if (isFusingSupported(ch1)) {
-                    fuse(ch1);
-                } else {
-                    if (ch1->type == Pooling) {
-                        auto pool = ch1;
-                        bool is_max_pool =
-                                dynamic_cast<PoolingLayer *>(pool->getCnnLayer().get())->_type ==
-                                PoolingLayer::PoolType::MAX;
-
-                        if (is_max_pool && pool->getChildEdges().size() == 1) {
-                            auto ch2 = pool->getChildEdgeAt(0)->getChild();
-                            if (isFusingSupported(ch2))
-                                fuse(ch2);
-                        }
-                    }
-                }
+    std::vector<float> scale(channels, 1.0f);
+    std::vector<float> shift(channels, 0.0f);
+    if (node->getType() == BatchNormalization) {
+        auto * bnLayer = dynamic_cast<BatchNormalizationLayer*>(node->getCnnLayer().get());
+        if (bnLayer == nullptr || bnLayer->_weights == nullptr || bnLayer->_biases == nullptr ||
+                !fits(bnLayer->_weights) || !fits(bnLayer->_biases))
+            return false;
+        for (size_t c = 0; c < channels; c++) {
+            scale[c] = 1.0f / std::sqrt(at(bnLayer->_weights, c, 1.0f) + bnLayer->epsilon);
+            shift[c] = -at(bnLayer->_biases, c, 0.0f) * scale[c];
+        }
+        for (const auto& fused : node->fusedWith) {
+            auto * scshLayer = dynamic_cast<ScaleShiftLayer*>(fused->getCnnLayer().get());
+            if (scshLayer == nullptr || !fits(scshLayer->_weights) || !fits(scshLayer->_biases) ||
+                    !isFP32(scshLayer->_weights) || !isFP32(scshLayer->_biases))
+                return false;
+            for (size_t c = 0; c < channels; c++) {
+                float gamma = at(scshLayer->_weights, c, 1.0f);
+                scale[c] *= gamma;
+                shift[c] = shift[c] * gamma + at(scshLayer->_biases, c, 0.0f);
             }
         }
+    } else {
+        auto * scshLayer = dynamic_cast<ScaleShiftLayer*>(node->getCnnLayer().get());
+        if (scshLayer == nullptr || !fits(scshLayer->_weights) || !fits(scshLayer->_biases))
+            return false;
+        for (size_t c = 0; c < channels; c++) {
+            scale[c] = at(scshLayer->_weights, c, 1.0f);
+            shift[c] = at(scshLayer->_biases, c, 0.0f);
+        }
     }
+
+    auto weights = make_shared_blob<float>(convLayer->_weights->getTensorDesc());
+    weights->allocate();
+    const float* srcWeights = convLayer->_weights->buffer().as<const float*>();
+    float* dstWeights = weights->buffer().as<float*>();
+    const size_t perChannel = weights->size() / channels;
+    for (size_t c = 0; c < channels; c++) {
+        for (size_t i = 0; i < perChannel; i++)
+            dstWeights[c * perChannel + i] = srcWeights[c * perChannel + i] * scale[c];
+    }
+
+    TensorDesc biasesDesc(Precision::FP32, {channels}, Layout::C);
+    auto biases = make_shared_blob<float>(biasesDesc);
+    biases->allocate();
+    float* dstBiases = biases->buffer().as<float*>();
+    for (size_t c = 0; c < channels; c++)
+        dstBiases[c] = at(convLayer->_biases, c, 0.0f) * scale[c] + shift[c];
+
+    auto folded = std::make_shared<ConvolutionLayer>(*convLayer);
+    folded->_weights = weights;
+    folded->_biases = biases;
+    folded->blobs["weights"] = weights;
+    folded->blobs["biases"] = biases;
+    conv->cnnLayer = folded;
+    return true;
 }
 
 /**
@@ -32,6 +32,8 @@
 #pragma once
 
 #include "mkldnn_graph.h"
+#include <functional>
+#include <string>
 #include <vector>
 
 namespace MKLDNNPlugin {
@@ -43,10 +45,31 @@ public:
 public:
     void Optimize(MKLDNNGraph& graph);
 
+    /**
+     * Runs the nodes computing only from constants once, on a graph with its
+     * primitives created, and moves them out of the nodes Infer() executes.
+     */
+    void FoldConstants(MKLDNNGraph& graph);
+
+    /** A node of a fusion pattern: its type is one of types and check, if set, accepts it. */
+    struct PatternNode {
+        std::vector<Type> types;
+        std::function<bool(const MKLDNNNodePtr&)> check;
+    };
+
+    /**
+     * Matches chains of nodes, each the only consumer of the one before it, against
+     * pattern and hands them to rewrite, which returns false to keep a chain as it is.
+     * The nodes it drops are counted in MKLDNNGraph::GetFusionStats().
+     */
+    struct FusionRule {
+        std::string name;
+        std::vector<PatternNode> pattern;
+        std::function<bool(MKLDNNGraph&, std::vector<MKLDNNNodePtr>&)> rewrite;
+    };
+
 private:
     void MergeGroupConvolution(MKLDNNGraph& graph);
-    void FuseConvolutionAndActivation(MKLDNNGraph &graph);
-    void FuseBatchNormWithScale(MKLDNNGraph& graph);
     void FuseConvolutionSumAndConvolutionSumActivation(MKLDNNGraph &graph);
     void RemoveIdentityOperator(MKLDNNGraph& graph);
     void RemoveDropped(MKLDNNGraph& graph);
@@ -54,6 +77,13 @@ private:
 
     void DropNode(MKLDNNGraph& graph, MKLDNNNodePtr& node);
 
+    std::vector<FusionRule> ConvolutionFusionRules();
+    std::vector<FusionRule> EltwiseFusionRules();
+    void ApplyFusionRules(MKLDNNGraph& graph, const std::vector<FusionRule>& rules);
+    bool MatchPattern(const MKLDNNNodePtr& head, const std::vector<PatternNode>& pattern,
+                      std::vector<MKLDNNNodePtr>& matched);
+    bool FoldIntoConvolutionWeights(const MKLDNNNodePtr& conv, const MKLDNNNodePtr& node);
+
     bool IsOneOf(Type type, std::vector<Type> types);
 };
 
@@ -32,6 +32,7 @@
 
 #include "mkldnn_infer_request.h"
 #include "mkldnn_extension_utils.h"
+#include "mkldnn_streams.h"
 #include <vector>
 #include <string>
 #include <map>
@@ -39,6 +40,22 @@
 #include <nodes/mkldnn_concat_node.h>
 #include <nodes/mkldnn_split_node.h>
 
+namespace {
+
+// what a request exposes of a batched graph tensor when the aggregator batches it
+InferenceEngine::TensorDesc sampleDesc(const InferenceEngine::TensorDesc& desc) {
+    InferenceEngine::SizeVector dims = desc.getDims();
+    if (!dims.empty())
+        dims[0] = 1;
+    return InferenceEngine::TensorDesc(desc.getPrecision(), dims, desc.getLayout());
+}
+
+size_t batchOf(const InferenceEngine::TensorDesc& desc) {
+    return desc.getDims().empty() ? 1 : desc.getDims()[0];
+}
+
+}  // namespace
+
 MKLDNNPlugin::MKLDNNInferRequest::MKLDNNInferRequest(InferenceEngine::InputsDataMap networkInputs,
                                                      InferenceEngine::OutputsDataMap networkOutputs)
         : InferRequestInternal(networkInputs, networkOutputs) {}
@@ -61,6 +78,20 @@ template <typename T> void MKLDNNPlugin::MKLDNNInferRequest::pushInput(const std
 void MKLDNNPlugin::MKLDNNInferRequest::Infer() {
     IE_PROFILING_AUTO_SCOPE(MKLDNN_INFER)
 
+    if (aggregated) {
+        // the aggregator has already inferred the request within a batch
+        auto error = batchError;
+        batchError = nullptr;
+        if (error)
+            std::rethrow_exception(error);
+        return;
+    }
+
+    // in throughput mode the stream running the request lends it its replica
+    auto streamGraph = MKLDNNStreamsExecutor::getCurrentGraph();
+    if (streamGraph)
+        graph = streamGraph;
+
     if (!graph || !graph->IsReady()) {
         THROW_IE_EXCEPTION << "Network not loaded.";
     }
@@ -162,11 +193,14 @@ void MKLDNNPlugin::MKLDNNInferRequest::GetBlob(const char *name, InferenceEngine
             desc = _networkInputs[name]->getTensorDesc();
             desc.setPrecision(_networkInputs[name]->getInputPrecision());
         }
+        if (aggregated)
+            desc = sampleDesc(desc);
 
         _inputs[name] = make_blob_with_precision(desc);
         _inputs[name]->allocate();
         if (desc.getPrecision() == InferenceEngine::Precision::FP32 &&
-                graph->_meanImages.find(name) == graph->_meanImages.end() && !graph->getProperty().batchLimit) {
+                graph->_meanImages.find(name) == graph->_meanImages.end() && !graph->getProperty().batchLimit &&
+                !aggregated) {
             externalPtr[name] = _inputs[name]->buffer();
         }
         data = _inputs[name];
@@ -181,10 +215,14 @@ void MKLDNNPlugin::MKLDNNInferRequest::GetBlob(const char *name, InferenceEngine
             return;
         }
 
-        _outputs[name] = make_blob_with_precision(blobs[name]->getTensorDesc());
+        InferenceEngine::TensorDesc desc = blobs[name]->getTensorDesc();
+        if (aggregated)
+            desc = sampleDesc(desc);
+
+        _outputs[name] = make_blob_with_precision(desc);
         _outputs[name]->allocate();
-        if (blobs[name]->getTensorDesc().getPrecision() == InferenceEngine::Precision::FP32 &&
-                !graph->getProperty().batchLimit) {
+        if (desc.getPrecision() == InferenceEngine::Precision::FP32 &&
+                !graph->getProperty().batchLimit && !aggregated) {
             externalPtr[name] = _outputs[name]->buffer();
         }
         data = _outputs[name];
@@ -206,6 +244,8 @@ void MKLDNNPlugin::MKLDNNInferRequest::SetBlob(const char *name, const Inference
     size_t dataSize = data->size();
     if (findInputAndOutputBlobByName(name, foundInput, foundOutput)) {
         size_t inputSize = InferenceEngine::details::product(foundInput->getDims());
+        if (aggregated)
+            inputSize /= batchOf(foundInput->getTensorDesc());
         if (dataSize != inputSize) {
             THROW_IE_EXCEPTION << "Input blob size is not equal network input size ("
                                << dataSize << "!=" << inputSize << ").";
@@ -225,7 +265,8 @@ void MKLDNNPlugin::MKLDNNInferRequest::SetBlob(const char *name, const Inference
         }
 
         if (data->getTensorDesc().getPrecision() == InferenceEngine::Precision::FP32 &&
-                graph->_meanImages.find(name) == graph->_meanImages.end() && !graph->getProperty().batchLimit) {
+                graph->_meanImages.find(name) == graph->_meanImages.end() && !graph->getProperty().batchLimit &&
+                !aggregated) {
             externalPtr[name] = data->buffer();
         } else if (externalPtr.find(name) != externalPtr.end()) {
             externalPtr.erase(name);
@@ -233,6 +274,8 @@ void MKLDNNPlugin::MKLDNNInferRequest::SetBlob(const char *name, const Inference
         _inputs[name] = data;
     } else {
         size_t outputSize = InferenceEngine::details::product(foundOutput->getDims());
+        if (aggregated)
+            outputSize /= batchOf(foundOutput->getTensorDesc());
         if (dataSize != outputSize) {
             THROW_IE_EXCEPTION << "Output blob size is not equal network output size ("
                                << dataSize << "!=" << outputSize << ").";
@@ -242,7 +285,7 @@ void MKLDNNPlugin::MKLDNNInferRequest::SetBlob(const char *name, const Inference
                                << "Failed to set Blob with precision not corresponding user output precision";
         }
         if (data->getTensorDesc().getPrecision() == InferenceEngine::Precision::FP32 &&
-                !graph->getProperty().batchLimit) {
+                !graph->getProperty().batchLimit && !aggregated) {
             externalPtr[name] = data->buffer();
         } else if (externalPtr.find(name) != externalPtr.end()) {
             externalPtr.erase(name);
@@ -355,3 +398,111 @@ void MKLDNNPlugin::MKLDNNInferRequest::changeAllPtrs(void *oldPtr, void *newPtr)
 void MKLDNNPlugin::MKLDNNInferRequest::SetGraph(const MKLDNNPlugin::MKLDNNGraph::Ptr &graph) {
     this->graph = graph;
 }
+
+void MKLDNNPlugin::MKLDNNInferRequest::SetAggregated(bool aggregated) {
+    this->aggregated = aggregated;
+}
+
+void MKLDNNPlugin::MKLDNNInferRequest::SetBatchResult(const std::exception_ptr& error) {
+    batchError = error;
+}
+
+void MKLDNNPlugin::MKLDNNInferRequest::InferBatch(const MKLDNNGraph::Ptr& graph,
+                                                  const std::vector<MKLDNNInferRequest*>& requests) {
+    IE_PROFILING_AUTO_SCOPE(MKLDNN_INFER_BATCH)
+
+    if (!graph || !graph->IsReady()) {
+        THROW_IE_EXCEPTION << "Network not loaded.";
+    }
+
+    for (auto& input : graph->inputNodes) {
+        const std::string& name = input.first;
+        auto edge = input.second->getChildEdgeAt(0);
+        InferenceEngine::SizeVector dims = edge->getDims().ToSizeVector();
+        if (dims.empty() || requests.size() > dims[0])
+            THROW_IE_EXCEPTION << "Cannot batch " << requests.size() << " requests into input " << name;
+
+        // the samples are pushed as one blob of the network batch in the precision of the requests
+        InferenceEngine::Precision precision;
+        bool found = false;
+        for (auto request : requests) {
+            auto blob = request->_inputs.find(name);
+            if (blob == request->_inputs.end())
+                continue;
+            if (found && blob->second->precision() != precision)
+                THROW_IE_EXCEPTION << "Batched requests have different precisions of input " << name;
+            precision = blob->second->precision();
+            found = true;
+        }
+        if (!found)
+            continue;
+
+        // like Infer(), U16 and anything to subtract a mean image from go as FP32
+        bool toFloat = precision == InferenceEngine::Precision::U16 ||
+                (precision != InferenceEngine::Precision::FP32 && graph->hasMeanImageFor(name));
+        InferenceEngine::Precision stacked = precision;
+        if (toFloat)
+            stacked = InferenceEngine::Precision::FP32;
+        InferenceEngine::TensorDesc desc(stacked, dims, InferenceEngine::TensorDesc::getLayoutByDims(dims));
+
+        // samples of FP32 go straight to their place in a plain input edge
+        const MKLDNNMemory& memory = edge->getMemory();
+        InferenceEngine::Blob::Ptr batched;
+        if (desc.getPrecision() == InferenceEngine::Precision::FP32 &&
+                memory.GetDataType() == mkldnn::memory::data_type::f32 &&
+                memory.GetFormat() == MKLDNNMemory::GetPlainFormat(memory.GetDims())) {
+            batched = InferenceEngine::make_shared_blob<float>(desc, reinterpret_cast<float *>(memory.GetData()));
+        } else {
+            batched = make_blob_with_precision(desc);
+            batched->allocate();
+        }
+
+        size_t sampleBytes = batched->byteSize() / dims[0];
+        uint8_t *dst = batched->buffer().as<uint8_t *>();
+        for (size_t i = 0; i < requests.size(); i++) {
+            auto it = requests[i]->_inputs.find(name);
+            if (it == requests[i]->_inputs.end())
+                continue;
+            InferenceEngine::Blob::Ptr& sample = it->second;
+            if (sample->size() * desc.getPrecision().size() != sampleBytes)
+                THROW_IE_EXCEPTION << "Input blob size is not equal network input sample size ("
+                                   << sample->size() << "!=" << sampleBytes / desc.getPrecision().size() << ").";
+
+            float *dst_f = reinterpret_cast<float *>(dst + i * sampleBytes);
+            if (!toFloat) {
+                memcpy(dst + i * sampleBytes, sample->cbuffer().as<const uint8_t *>(), sampleBytes);
+            } else if (precision == InferenceEngine::Precision::U16) {
+                InferenceEngine::copyToFloat<uint16_t>(dst_f, sample.get());
+            } else if (precision == InferenceEngine::Precision::I16) {
+                InferenceEngine::copyToFloat<int16_t>(dst_f, sample.get());
+            } else if (precision == InferenceEngine::Precision::U8) {
+                InferenceEngine::copyToFloat<uint8_t>(dst_f, sample.get());
+            } else {
+                THROW_IE_EXCEPTION << "Unsupported input precision " << precision;
+            }
+        }
+        // a stacked in place blob isn't copied again, only has the mean image subtracted
+        graph->PushInputData(name, batched);
+    }
+
+    graph->Infer(static_cast<int>(requests.size()));
+
+    for (auto& output : graph->outputNodes) {
+        // remove out_ from node name
+        std::string name = output->getName().substr(4);
+        const MKLDNNMemory& memory = output->getParentEdgeAt(0)->getMemory();
+        if (memory.GetFormat() != MKLDNNMemory::GetPlainFormat(memory.GetDims()))
+            THROW_IE_EXCEPTION << "Cannot scatter output " << name << " of a blocked layout";
+
+        size_t sampleBytes = memory.GetSize() / memory.GetDims()[0];
+        const uint8_t *src = reinterpret_cast<const uint8_t *>(memory.GetData());
+        for (size_t i = 0; i < requests.size(); i++) {
+            InferenceEngine::Blob::Ptr sample;
+            requests[i]->GetBlob(name.c_str(), sample);
+            if (sample->byteSize() != sampleBytes)
+                THROW_IE_EXCEPTION << "Output blob size is not equal network output sample size ("
+                                   << sample->size() << "!=" << sampleBytes / sizeof(float) << ").";
+            memcpy(sample->buffer(), src + i * sampleBytes, sampleBytes);
+        }
+    }
+}
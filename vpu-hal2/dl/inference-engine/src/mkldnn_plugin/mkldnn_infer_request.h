@@ -36,6 +36,7 @@
 #include <memory>
 #include <string>
 #include <map>
+#include <vector>
 #include <cpp_interfaces/impl/ie_infer_request_internal.hpp>
 
 namespace MKLDNNPlugin {
@@ -66,6 +67,19 @@ public:
 
     void SetGraph(const MKLDNNGraph::Ptr& graph);
 
+    /**
+     * @brief Makes the request one sample of the batches the aggregator forms: its blobs hold a
+     * single sample and Infer() only reports how the batch it went into ended.
+     */
+    void SetAggregated(bool aggregated);
+
+    void SetBatchResult(const std::exception_ptr& error);
+
+    /**
+     * @brief Infers the requests as one batch, each in the sample of the graph at its position.
+     */
+    static void InferBatch(const MKLDNNGraph::Ptr& graph, const std::vector<MKLDNNInferRequest*>& requests);
+
 private:
     template <typename T> void pushInput(const std::string& inputName, InferenceEngine::Blob::Ptr& inputBlob);
 
@@ -75,5 +89,7 @@ private:
     MKLDNNGraph::Ptr graph;
     std::map<std::string, void*> externalPtr;
     std::map<std::string, void*> defaultPtr;
+    bool aggregated = false;
+    std::exception_ptr batchError;
 };
 }  // namespace MKLDNNPlugin
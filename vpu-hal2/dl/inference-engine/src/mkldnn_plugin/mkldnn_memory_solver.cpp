@@ -0,0 +1,146 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2016 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+//
+#include "mkldnn_memory_solver.h"
+
+#include <details/ie_exception.hpp>
+
+#include <algorithm>
+#include <climits>
+
+using namespace MKLDNNPlugin;
+
+namespace {
+
+inline size_t alignUp(size_t size, size_t align) {
+    return (size + align - 1) / align * align;
+}
+
+inline int lastUse(const MKLDNNMemorySolver::Box& box) {
+    return box.finish == -1 ? INT_MAX : box.finish;
+}
+
+inline bool liveTogether(const MKLDNNMemorySolver::Box& a, const MKLDNNMemorySolver::Box& b) {
+    return a.start <= lastUse(b) && b.start <= lastUse(a);
+}
+
+}  // namespace
+
+const size_t MKLDNNMemorySolver::alignment;
+
+MKLDNNMemorySolver::MKLDNNMemorySolver(const std::vector<Box>& boxes): _boxes(boxes) {
+    for (auto& box : _boxes) {
+        _naive += box.size;
+        box.size = sizeClass(box.size);
+    }
+}
+
+size_t MKLDNNMemorySolver::sizeClass(size_t size) {
+    const size_t small = 4096;
+    if (size <= small)
+        return alignUp(std::max(size, alignment), alignment);
+
+    size_t pow2 = small;
+    while (pow2 * 2 < size)
+        pow2 *= 2;
+    // pow2 < size <= 2 * pow2, split that range into 8 classes
+    return alignUp(alignUp(size, pow2 / 8), alignment);
+}
+
+size_t MKLDNNMemorySolver::solve() {
+    // greedy by size: big buffers placed first leave holes the small ones fill
+    std::vector<size_t> order(_boxes.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this](size_t l, size_t r) {
+        if (_boxes[l].size != _boxes[r].size)
+            return _boxes[l].size > _boxes[r].size;
+        return _boxes[l].start < _boxes[r].start;
+    });
+
+    _offsets.clear();
+    _total = 0;
+
+    std::vector<size_t> placed;
+    std::vector<std::pair<size_t, size_t>> busy;
+    for (auto i : order) {
+        const Box& box = _boxes[i];
+
+        busy.clear();
+        for (auto j : placed) {
+            if (liveTogether(box, _boxes[j]))
+                busy.emplace_back(_offsets[_boxes[j].id], _boxes[j].size);
+        }
+        std::sort(busy.begin(), busy.end());
+
+        // lowest gap that fits
+        size_t offset = 0;
+        for (const auto& range : busy) {
+            if (offset + box.size <= range.first)
+                break;
+            offset = std::max(offset, range.first + range.second);
+        }
+
+        _offsets[box.id] = offset;
+        _total = std::max(_total, offset + box.size);
+        placed.push_back(i);
+    }
+
+    return _total;
+}
+
+size_t MKLDNNMemorySolver::getOffset(int id) const {
+    auto it = _offsets.find(id);
+    if (it == _offsets.end())
+        THROW_IE_EXCEPTION << "No memory was planned for box " << id;
+    return it->second;
+}
+
+size_t MKLDNNMemorySolver::naiveSize() const {
+    return _naive;
+}
+
+size_t MKLDNNMemorySolver::peakLiveSize() const {
+    int lastStep = 0;
+    for (const auto& box : _boxes)
+        lastStep = std::max(lastStep, std::max(box.start, box.finish));
+
+    size_t peak = 0;
+    for (int step = 0; step <= lastStep; step++) {
+        size_t live = 0;
+        for (const auto& box : _boxes) {
+            if (box.start <= step && step <= lastUse(box))
+                live += box.size;
+        }
+        peak = std::max(peak, live);
+    }
+    return peak;
+}
@@ -0,0 +1,81 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2016 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+//
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace MKLDNNPlugin {
+
+/**
+ * Packs buffers with known lifetimes into one arena. A box lives from the
+ * execution index of its first producer to the one of its last consumer,
+ * both inclusive; boxes whose lifetimes intersect never share bytes.
+ */
+class MKLDNNMemorySolver {
+public:
+    struct Box {
+        int start;
+        int finish;     // -1 keeps the box alive for the whole graph
+        size_t size;
+        int id;
+    };
+
+    // offsets and sizes are kept multiples of this, the widest vector
+    // load MKLDNN issues and a cache line
+    static const size_t alignment = 64;
+
+    explicit MKLDNNMemorySolver(const std::vector<Box>& boxes);
+
+    /** Assigns offsets and returns the arena size in bytes. */
+    size_t solve();
+
+    size_t getOffset(int id) const;
+
+    /** Sum of box sizes, what one allocation per box would take. */
+    size_t naiveSize() const;
+
+    /** Bytes alive at the busiest execution index, a lower bound for solve(). */
+    size_t peakLiveSize() const;
+
+    /** Rounds a size up to its class: 64 byte steps up to 4K, then 8 steps per power of two. */
+    static size_t sizeClass(size_t size);
+
+private:
+    std::vector<Box> _boxes;
+    std::map<int, size_t> _offsets;
+    size_t _naive = 0;
+    size_t _total = 0;
+};
+
+}  // namespace MKLDNNPlugin
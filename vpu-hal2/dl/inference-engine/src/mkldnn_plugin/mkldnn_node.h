@@ -45,6 +45,7 @@
 #include "mkldnn_descriptor.h"
 #include "mkldnn/iml_type_mapper.h"
 #include "mkldnn_extension_mngr.h"
+#include "mkldnn_weights_cache.h"
 
 namespace MKLDNNPlugin {
 
@@ -315,6 +316,10 @@ public:
         dynBatchLim = lim;
     }
 
+    void setWeightsCache(const MKLDNNWeightsSharing::Ptr& cache) {
+        weightCache = cache;
+    }
+
     virtual void resolveNotAllocatedEdges();
     virtual void execute(mkldnn::stream strm);
     virtual void initSupportedPrimitiveDescriptors(const mkldnn::engine &engine);
@@ -467,6 +472,7 @@ protected:
     bool constant;
     std::vector<InferenceEngine::Blob::Ptr> internalBlobs;
     std::vector<MKLDNNMemoryPtr> internalBlobMemory;
+    MKLDNNWeightsSharing::Ptr weightCache;
     std::vector<MKLDNNPrimitiveDescInfo> supportedPrimitiveDescriptors;
     std::shared_ptr<mkldnn::primitive> prim;
     std::vector<MKLDNNDescriptor> descs;
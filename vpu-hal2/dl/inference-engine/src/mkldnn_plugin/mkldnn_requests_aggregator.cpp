@@ -0,0 +1,125 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2016 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+//
+#include "mkldnn_requests_aggregator.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "mkldnn_streams.h"
+
+using namespace MKLDNNPlugin;
+using namespace InferenceEngine;
+
+MKLDNNRequestsAggregator::MKLDNNRequestsAggregator(int maxBatch, int timeoutUs, int parallelBatches,
+                                                   const ITaskExecutor::Ptr& executor, const MKLDNNGraph::Ptr& graph)
+        : maxBatch(static_cast<size_t>(std::max(maxBatch, 1))),
+          timeout(std::chrono::duration_cast<Clock::duration>(std::chrono::microseconds(timeoutUs))),
+          parallelBatches(std::max(parallelBatches, 1)),
+          executor(executor),
+          graph(graph) {
+    collector = std::thread(&MKLDNNRequestsAggregator::collectorMain, this);
+}
+
+MKLDNNRequestsAggregator::~MKLDNNRequestsAggregator() {
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        isStopped = true;
+        queueCondVar.notify_all();
+    }
+    // the collector dispatches whatever is still queued before it leaves
+    if (collector.joinable())
+        collector.join();
+
+    std::unique_lock<std::mutex> lock(queueMutex);
+    queueCondVar.wait(lock, [this] { return batchesInFlight == 0; });
+}
+
+bool MKLDNNRequestsAggregator::startTask(MKLDNNInferRequest* request, const Task::Ptr& task) {
+    if (!task->occupy()) return false;
+    std::unique_lock<std::mutex> lock(queueMutex);
+    pending.push_back({request, task, Clock::now()});
+    queueCondVar.notify_all();
+    return true;
+}
+
+void MKLDNNRequestsAggregator::collectorMain() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while (true) {
+        // while every replica is busy the queue keeps growing, so batches get larger under load
+        queueCondVar.wait(lock, [this] {
+            return isStopped || (!pending.empty() && batchesInFlight < parallelBatches);
+        });
+        if (pending.empty())
+            break;
+
+        auto deadline = pending.front().arrival + timeout;
+        queueCondVar.wait_until(lock, deadline, [this] { return isStopped || pending.size() >= maxBatch; });
+
+        size_t size = std::min(pending.size(), maxBatch);
+        std::vector<Pending> batch(pending.begin(), pending.begin() + size);
+        pending.erase(pending.begin(), pending.begin() + size);
+        batchesInFlight++;
+
+        lock.unlock();
+        auto task = std::make_shared<Task>([this, batch]() { runBatch(batch); });
+        executor->startTask(task);
+        lock.lock();
+    }
+}
+
+void MKLDNNRequestsAggregator::runBatch(const std::vector<Pending>& batch) {
+    // in throughput mode the stream running the batch lends it its replica
+    auto batchGraph = MKLDNNStreamsExecutor::getCurrentGraph();
+    if (!batchGraph)
+        batchGraph = graph;
+
+    std::vector<MKLDNNInferRequest*> requests;
+    for (auto& entry : batch)
+        requests.push_back(entry.request);
+
+    std::exception_ptr error;
+    try {
+        MKLDNNInferRequest::InferBatch(batchGraph, requests);
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    // the tasks see the outcome of the batch in Infer() and go on to the callbacks
+    for (auto& entry : batch) {
+        entry.request->SetBatchResult(error);
+        entry.task->runNoThrowNoBusyCheck();
+    }
+
+    std::unique_lock<std::mutex> lock(queueMutex);
+    batchesInFlight--;
+    queueCondVar.notify_all();
+}
@@ -0,0 +1,98 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2016 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+//
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cpp_interfaces/ie_itask_executor.hpp>
+
+#include "mkldnn_graph.h"
+#include "mkldnn_infer_request.h"
+
+namespace MKLDNNPlugin {
+
+/**
+ * Front-end of the batching mode. Concurrent single-sample requests queue
+ * here and a collector thread groups them until a batch is full or its
+ * first request has waited the timeout. A batch then infers once on the
+ * network's executor, which in throughput mode is a stream with its own
+ * replica, and completes the async task of every request in it.
+ */
+class MKLDNNRequestsAggregator {
+public:
+    typedef std::shared_ptr<MKLDNNRequestsAggregator> Ptr;
+
+    /**
+     * @param maxBatch - the most requests to infer at once, at most the batch of the graph
+     * @param timeoutUs - how long a batch waits for more requests after its first one
+     * @param parallelBatches - batches inferring at the same time, one per graph replica
+     */
+    MKLDNNRequestsAggregator(int maxBatch, int timeoutUs, int parallelBatches,
+                             const InferenceEngine::ITaskExecutor::Ptr& executor, const MKLDNNGraph::Ptr& graph);
+    ~MKLDNNRequestsAggregator();
+
+    /** Queues the async task of a request, false if the task is already running. */
+    bool startTask(MKLDNNInferRequest* request, const InferenceEngine::Task::Ptr& task);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Pending {
+        MKLDNNInferRequest* request;
+        InferenceEngine::Task::Ptr task;
+        Clock::time_point arrival;
+    };
+
+    void collectorMain();
+    void runBatch(const std::vector<Pending>& batch);
+
+    const size_t maxBatch;
+    const Clock::duration timeout;
+    const int parallelBatches;
+    InferenceEngine::ITaskExecutor::Ptr executor;
+    MKLDNNGraph::Ptr graph;
+
+    std::mutex queueMutex;
+    std::condition_variable queueCondVar;
+    std::deque<Pending> pending;
+    int batchesInFlight = 0;
+    bool isStopped = false;
+    std::thread collector;
+};
+
+}  // namespace MKLDNNPlugin
@@ -0,0 +1,165 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2016 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+//
+#include "mkldnn_streams.h"
+
+#include <omp.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "mkldnn/omp_manager.h"
+
+using namespace MKLDNNPlugin;
+using namespace InferenceEngine;
+
+namespace {
+
+thread_local MKLDNNGraph::Ptr streamGraph;
+
+std::vector<std::vector<unsigned>> streamsCores(int streams) {
+#if !(defined(__APPLE__) || defined(_WIN32))
+    return cpu::OpenMpManager::getStreamsCores(streams);
+#else
+    // no topology here, only the number of cores matters
+    std::vector<std::vector<unsigned>> cores(streams);
+    int perStream = std::max(omp_get_num_procs() / streams, 1);
+    for (int s = 0; s < streams; s++)
+        for (int c = 0; c < perStream; c++)
+            cores[s].push_back(static_cast<unsigned>(s * perStream + c));
+    return cores;
+#endif
+}
+
+void pinStream(const std::vector<unsigned>& cores, bool bindThreads) {
+#if !(defined(__APPLE__) || defined(_WIN32))
+    if (bindThreads) {
+        cpu::OpenMpManager::bindOpenMpThreadsToCores(cores);
+        return;
+    }
+#endif
+    omp_set_num_threads(std::max(static_cast<int>(cores.size()), 1));
+}
+
+}  // namespace
+
+MKLDNNStreamsExecutor::MKLDNNStreamsExecutor(int streams, bool bindThreads, const GraphFactory& createGraph) {
+    auto cores = streamsCores(streams);
+    graphs.resize(cores.size());
+
+    for (int s = 0; s < static_cast<int>(cores.size()); s++) {
+        threads.emplace_back(&MKLDNNStreamsExecutor::streamMain, this, s, cores[s], bindThreads, std::cref(createGraph));
+
+        std::unique_lock<std::mutex> lock(queueMutex);
+        queueCondVar.wait(lock, [&] { return startedStreams > s; });
+        if (startError) {
+            lock.unlock();
+            stop();
+            std::rethrow_exception(startError);
+        }
+    }
+}
+
+MKLDNNStreamsExecutor::~MKLDNNStreamsExecutor() {
+    stop();
+}
+
+void MKLDNNStreamsExecutor::stop() {
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        queueCondVar.wait(lock, [this] { return taskQueue.empty() && runningTasks == 0; });
+        isStopped = true;
+        queueCondVar.notify_all();
+    }
+    for (auto& thread : threads) {
+        if (thread.joinable())
+            thread.join();
+    }
+    threads.clear();
+}
+
+void MKLDNNStreamsExecutor::streamMain(int stream, const std::vector<unsigned>& cores, bool bindThreads,
+                                       const GraphFactory& createGraph) {
+    pinStream(cores, bindThreads);
+
+    {
+        MKLDNNGraph::Ptr graph;
+        std::exception_ptr error;
+        try {
+            graph = createGraph(stream);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        std::unique_lock<std::mutex> lock(queueMutex);
+        graphs[stream] = graph;
+        startError = error;
+        startedStreams++;
+        queueCondVar.notify_all();
+        if (error)
+            return;
+        streamGraph = graph;
+    }
+
+    while (true) {
+        Task::Ptr task;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondVar.wait(lock, [this] { return !taskQueue.empty() || isStopped; });
+            if (taskQueue.empty())
+                break;
+            task = taskQueue.front();
+            taskQueue.pop();
+            runningTasks++;
+        }
+
+        task->runNoThrowNoBusyCheck();
+
+        std::unique_lock<std::mutex> lock(queueMutex);
+        runningTasks--;
+        // the destructor waits for the last task
+        queueCondVar.notify_all();
+    }
+
+    streamGraph.reset();
+}
+
+bool MKLDNNStreamsExecutor::startTask(Task::Ptr task) {
+    if (!task->occupy()) return false;
+    std::unique_lock<std::mutex> lock(queueMutex);
+    taskQueue.push(task);
+    queueCondVar.notify_all();
+    return true;
+}
+
+MKLDNNGraph::Ptr MKLDNNStreamsExecutor::getCurrentGraph() {
+    return streamGraph;
+}
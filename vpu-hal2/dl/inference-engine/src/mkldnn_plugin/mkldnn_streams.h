@@ -0,0 +1,93 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2016 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+//
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include <cpp_interfaces/ie_itask_executor.hpp>
+
+#include "mkldnn_graph.h"
+
+namespace MKLDNNPlugin {
+
+/**
+ * Executor of the throughput mode. Every stream is a thread with its own
+ * replica of the graph and an OpenMP team pinned to a disjoint subset of
+ * the cores; a request goes to whichever stream frees up first and infers
+ * on that stream's replica.
+ */
+class MKLDNNStreamsExecutor : public InferenceEngine::ITaskExecutor {
+public:
+    typedef std::shared_ptr<MKLDNNStreamsExecutor> Ptr;
+    typedef std::function<MKLDNNGraph::Ptr(int stream)> GraphFactory;
+
+    /**
+     * Starts the streams one after another, each building its graph on its
+     * own thread once pinned, so the graph allocates on the stream's socket
+     * and later replicas find the weights already converted.
+     */
+    MKLDNNStreamsExecutor(int streams, bool bindThreads, const GraphFactory& createGraph);
+    ~MKLDNNStreamsExecutor();
+
+    bool startTask(InferenceEngine::Task::Ptr task) override;
+
+    const std::vector<MKLDNNGraph::Ptr>& getGraphs() const {
+        return graphs;
+    }
+
+    /** The replica of the stream running the calling thread, null elsewhere. */
+    static MKLDNNGraph::Ptr getCurrentGraph();
+
+private:
+    void streamMain(int stream, const std::vector<unsigned>& cores, bool bindThreads, const GraphFactory& createGraph);
+    void stop();
+
+    std::vector<std::thread> threads;
+    std::vector<MKLDNNGraph::Ptr> graphs;
+
+    std::mutex queueMutex;
+    std::condition_variable queueCondVar;
+    std::queue<InferenceEngine::Task::Ptr> taskQueue;
+    int runningTasks = 0;
+    bool isStopped = false;
+
+    // hand over of a stream's graph to the constructor
+    int startedStreams = 0;
+    std::exception_ptr startError;
+};
+
+}  // namespace MKLDNNPlugin
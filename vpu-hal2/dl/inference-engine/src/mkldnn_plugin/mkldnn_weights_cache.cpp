@@ -0,0 +1,330 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2016 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+//
+#include "mkldnn_weights_cache.h"
+
+#include <graph_tools.hpp>
+#include <fnv1a_hash.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+
+using namespace MKLDNNPlugin;
+
+namespace {
+
+// "MKLDNNWC", a version, the number of entries, then per entry the length
+// of its key, the key, and the offset and size of its data in the file.
+// The data follows, and last the FNV-1a hash of everything before it
+const char kMagic[8] = {'M', 'K', 'L', 'D', 'N', 'N', 'W', 'C'};
+const uint32_t kVersion = 2;
+// where every entry starts, as the primitives expect of their weights
+const size_t kDataAlignment = 64;
+
+size_t alignUp(size_t offset) {
+    return (offset + kDataAlignment - 1) / kDataAlignment * kDataAlignment;
+}
+
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+    template <typename T> bool read(T& value) {
+        if (size - pos < sizeof(T)) return false;
+        memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool read(std::string& value, size_t length) {
+        if (size - pos < length) return false;
+        value.assign(reinterpret_cast<const char*>(data + pos), length);
+        pos += length;
+        return true;
+    }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t pos = 0;
+};
+
+class Writer {
+public:
+    explicit Writer(FILE* file) : file(file) {}
+
+    void write(const void* data, size_t size) {
+        if (size != 0 && fwrite(data, 1, size, file) != size)
+            failed = true;
+        checksum = InferenceEngine::fnv1a(checksum, data, size);
+        written += size;
+    }
+
+    template <typename T> void write(const T& value) {
+        write(&value, sizeof(T));
+    }
+
+    size_t tell() const {
+        return written;
+    }
+
+    // appends the checksum and gets everything to the disk, a crash after the
+    // rename must not leave the new name on a file whose data never landed
+    bool finish() {
+        uint64_t sum = checksum;
+        write(sum);
+        if (failed || fflush(file) != 0)
+            return false;
+#ifndef _WIN32
+        return fsync(fileno(file)) == 0;
+#else
+        return _commit(_fileno(file)) == 0;
+#endif
+    }
+
+private:
+    FILE* file;
+    uint64_t checksum = InferenceEngine::kFnv1aOffset;
+    size_t written = 0;
+    bool failed = false;
+};
+
+}  // namespace
+
+MKLDNNWeightsSharing::MKLDNNWeightsSharing(const std::string& path, const std::string& model)
+        : path(path), model(model) {
+    map();
+}
+
+MKLDNNWeightsSharing::~MKLDNNWeightsSharing() {
+    sharedWeights.clear();
+    unmap();
+}
+
+void MKLDNNWeightsSharing::map() {
+    const uint8_t* base = nullptr;
+    size_t size = 0;
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        // private and writable, so a primitive touching its weights can't reach the file
+        void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            mapping = data;
+            mappingSize = static_cast<size_t>(st.st_size);
+            base = static_cast<const uint8_t*>(data);
+            size = mappingSize;
+        }
+    }
+    close(fd);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return;
+    fileData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    base = fileData.data();
+    size = fileData.size();
+#endif
+    if (!base)
+        return;
+
+    // a torn or corrupted file would hand garbage to the primitives as weights
+    uint64_t checksum = 0;
+    bool valid = size >= sizeof(checksum);
+    if (valid) {
+        size -= sizeof(checksum);
+        memcpy(&checksum, base + size, sizeof(checksum));
+        valid = checksum == InferenceEngine::fnv1a(InferenceEngine::kFnv1aOffset, base, size);
+    }
+
+    Reader reader(base, size);
+    char magic[sizeof(kMagic)];
+    uint32_t version = 0, count = 0;
+    valid = valid && reader.read(magic) && !memcmp(magic, kMagic, sizeof(kMagic)) &&
+            reader.read(version) && version == kVersion && reader.read(count);
+    for (uint32_t i = 0; valid && i < count; i++) {
+        uint32_t keyLength = 0;
+        uint64_t offset = 0, length = 0;
+        std::string key;
+        valid = reader.read(keyLength) && reader.read(key, keyLength) && reader.read(offset) && reader.read(length) &&
+                offset <= size && length <= size - offset;
+        if (valid)
+            stored[key] = {base + offset, static_cast<size_t>(length)};
+    }
+    if (!valid) {
+        stored.clear();
+        unmap();
+    }
+}
+
+void MKLDNNWeightsSharing::unmap() {
+#ifndef _WIN32
+    if (mapping)
+        munmap(mapping, mappingSize);
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    fileData.clear();
+}
+
+MKLDNNMemoryPtr MKLDNNWeightsSharing::findOrCreate(const std::string& key,
+                                                   const std::function<MKLDNNMemoryPtr()>& create,
+                                                   const Wrap& wrap) {
+    // weights are converted once per network, holding the lock through the
+    // conversion keeps a second replica from doing the same work
+    std::lock_guard<std::mutex> lock(guard);
+
+    // a file written for another model has none of the keys of this one
+    const std::string modelKey = model.empty() ? key : model + "/" + key;
+    auto found = sharedWeights.find(modelKey);
+    if (found != sharedWeights.end())
+        return found->second;
+
+    MKLDNNMemoryPtr memory;
+    auto packed = stored.find(modelKey);
+    if (wrap && packed != stored.end()) {
+        memory = wrap(packed->second.data);
+        if (memory && memory->GetSize() != packed->second.size)
+            memory.reset();
+    }
+    if (!memory) {
+        memory = create();
+        missed = true;
+    }
+    sharedWeights[modelKey] = memory;
+    return memory;
+}
+
+bool MKLDNNWeightsSharing::save() {
+    std::lock_guard<std::mutex> lock(guard);
+    if (path.empty() || !missed)
+        return true;
+
+    size_t offset = sizeof(kMagic) + 2 * sizeof(uint32_t);
+    for (auto& weights : sharedWeights)
+        offset += sizeof(uint32_t) + weights.first.size() + 2 * sizeof(uint64_t);
+
+    std::vector<uint64_t> offsets;
+    for (auto& weights : sharedWeights) {
+        offset = alignUp(offset);
+        offsets.push_back(offset);
+        offset += weights.second->GetSize();
+    }
+
+    // written aside and renamed over, a graph may still use the mapping of the old file
+    std::string temporary = path + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (!file)
+        return false;
+    Writer writer(file);
+    uint32_t count = static_cast<uint32_t>(sharedWeights.size());
+    writer.write(kMagic);
+    writer.write(kVersion);
+    writer.write(count);
+    size_t i = 0;
+    for (auto& weights : sharedWeights) {
+        uint32_t keyLength = static_cast<uint32_t>(weights.first.size());
+        uint64_t length = weights.second->GetSize();
+        writer.write(keyLength);
+        writer.write(weights.first.data(), keyLength);
+        writer.write(offsets[i++]);
+        writer.write(length);
+    }
+    const char zeros[kDataAlignment] = {};
+    i = 0;
+    for (auto& weights : sharedWeights) {
+        writer.write(zeros, offsets[i++] - writer.tell());
+        writer.write(weights.second->GetData(), weights.second->GetSize());
+    }
+    bool written = writer.finish();
+    written = fclose(file) == 0 && written;
+
+    if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    missed = false;
+    return true;
+}
+
+size_t MKLDNNWeightsSharing::size() const {
+    std::lock_guard<std::mutex> lock(guard);
+    return sharedWeights.size();
+}
+
+uint64_t MKLDNNWeightsSharing::fingerprint(const void* data, size_t size) {
+    // all of it: a sample would let retrained weights of the same shapes hit stale entries
+    return InferenceEngine::fnv1aSized(InferenceEngine::kFnv1aOffset, data, size);
+}
+
+uint64_t MKLDNNWeightsSharing::fingerprint(const std::string& source, const void* data, size_t size) {
+    std::lock_guard<std::mutex> lock(guard);
+    auto found = fingerprints.find(source);
+    if (found == fingerprints.end())
+        found = fingerprints.emplace(source, fingerprint(data, size)).first;
+    return found->second;
+}
+
+std::string MKLDNNWeightsSharing::modelIdentity(InferenceEngine::ICNNNetwork& network) {
+    char name[256] = {};
+    network.getName(name, sizeof(name));
+    using InferenceEngine::fnv1aString;
+    uint64_t hash = fnv1aString(InferenceEngine::kFnv1aOffset, name);
+    for (const auto& layer : InferenceEngine::CNNNetSortTopologically(network)) {
+        hash = fnv1aString(hash, layer->name);
+        hash = fnv1aString(hash, layer->type);
+        for (const auto& param : layer->params) {
+            hash = fnv1aString(hash, param.first);
+            hash = fnv1aString(hash, param.second);
+        }
+        // hashing the content here too would read every weight twice per load
+        for (const auto& blob : layer->blobs) {
+            hash = fnv1aString(hash, blob.first);
+            if (blob.second)
+                hash = InferenceEngine::fnv1aValue(hash, static_cast<uint64_t>(blob.second->byteSize()));
+        }
+    }
+    return std::to_string(hash);
+}
@@ -0,0 +1,122 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2016 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+//
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "mkldnn_memory.h"
+#include <ie_icnn_network.hpp>
+
+namespace MKLDNNPlugin {
+
+/**
+ * Weights converted to the layout a primitive wants, shared by every graph
+ * built from the same network. The memory is read-only once created, so the
+ * replicas of a network running in parallel streams all point at one copy.
+ *
+ * Given a file, the converted weights also outlive the network: a load maps
+ * the file written by the previous one and only converts what it misses.
+ */
+class MKLDNNWeightsSharing {
+public:
+    typedef std::shared_ptr<MKLDNNWeightsSharing> Ptr;
+    /** Builds the memory of a key over weights converted by an earlier load. */
+    typedef std::function<MKLDNNMemoryPtr(const void* data)> Wrap;
+
+    MKLDNNWeightsSharing() = default;
+    /**
+     * Maps the weights stored in path, a missing or stale file is only a cold cache.
+     * Keys are looked up for model, see modelIdentity().
+     */
+    MKLDNNWeightsSharing(const std::string& path, const std::string& model);
+    ~MKLDNNWeightsSharing();
+
+    /**
+     * Returns the memory stored under key, calling create for it the first
+     * time unless the file has the key, which wrap then builds the memory
+     * over. Concurrent callers for the same key wait for the first one.
+     */
+    MKLDNNMemoryPtr findOrCreate(const std::string& key, const std::function<MKLDNNMemoryPtr()>& create,
+                                 const Wrap& wrap = nullptr);
+
+    /**
+     * Rewrites the file with the weights of this load if any of them had to
+     * be converted. Returns false when the file cannot be written.
+     */
+    bool save();
+
+    size_t size() const;
+
+    /** Identifies the content of source weights. */
+    static uint64_t fingerprint(const void* data, size_t size);
+
+    /**
+     * fingerprint() of the source weights named source, hashed by the first
+     * replica that asks and looked up by the others.
+     */
+    uint64_t fingerprint(const std::string& source, const void* data, size_t size);
+
+    /**
+     * Identifies a network by its layers, their parameters and the sizes of
+     * their blobs. The content is left to the fingerprint in every key.
+     */
+    static std::string modelIdentity(InferenceEngine::ICNNNetwork& network);
+
+private:
+    struct Stored {
+        const uint8_t* data;
+        size_t size;
+    };
+
+    void map();
+    void unmap();
+
+    mutable std::mutex guard;
+    std::map<std::string, MKLDNNMemoryPtr> sharedWeights;
+    std::map<std::string, uint64_t> fingerprints;
+
+    std::string path;
+    std::string model;
+    std::map<std::string, Stored> stored;
+    bool missed = false;
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    std::vector<uint8_t> fileData;   // where the file can't be mapped
+};
+
+}  // namespace MKLDNNPlugin
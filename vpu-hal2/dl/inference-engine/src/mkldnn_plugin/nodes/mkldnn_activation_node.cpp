@@ -120,15 +120,40 @@ void MKLDNNActivationNode::createDescriptor(mkldnn::memory::data_type inputDataT
 }
 
 void MKLDNNActivationNode::createPrimitive() {
-    if (prim)
+    if (prim || !chain.empty())
         return;
 
+    if (!fusedWith.empty()) {
+        chain.appendActivation(getAlgorithm(), getAlpha(), getBeta());
+        for (auto &node : fusedWith)
+            chain.append(node);
+        return;
+    }
+
     auto prim_desc = createPrimitiveDescriptor<relu_forward::primitive_desc, relu_forward::desc>();
 
     prim.reset(new relu_forward(prim_desc, getParentEdgeAt(0)->getMemory().GetPrimitive(),
                                 getChildEdgeAt(0)->getMemory().GetPrimitive()));
 }
 
+void MKLDNNActivationNode::execute(mkldnn::stream strm) {
+    if (chain.empty()) {
+        MKLDNNNode::execute(strm);
+        return;
+    }
+
+    auto& srcMemory = getParentEdgeAt(0)->getMemory();
+    auto& dstMemory = getChildEdgeAt(0)->getMemory();
+    const size_t data_size = srcMemory.GetSize() / sizeof(float);
+
+    const auto *src_ptr = reinterpret_cast<const float*>(srcMemory.GetData()) +
+            srcMemory.GetDescriptor().data.layout_desc.blocking.offset_padding;
+    float *dst_ptr = reinterpret_cast<float*>(dstMemory.GetData()) +
+            dstMemory.GetDescriptor().data.layout_desc.blocking.offset_padding;
+
+    chain.execute(src_ptr, dst_ptr, data_size);
+}
+
 bool MKLDNNActivationNode::created() {
     return getType() == Activation;
 }
@@ -33,6 +33,7 @@
 
 #include <ie_common.h>
 #include <mkldnn_node.h>
+#include <mkldnn_eltwise_chain.h>
 #include <caseless.hpp>
 #include <string>
 #include <memory>
@@ -47,6 +48,7 @@ public:
 
     void createDescriptor(mkldnn::memory::data_type inputDataType, mkldnn::memory::data_type outputDataType) override;
     void createPrimitive() override;
+    void execute(mkldnn::stream strm) override;
     bool created() override;
 
     mkldnn::algorithm getAlgorithm() {
@@ -76,6 +78,8 @@ private:
     static caseless_map<std::string,
             std::function<void(InferenceEngine::GenericLayer*, mkldnn::algorithm&, float&, float&)>> initializers;
     mkldnn::algorithm algorithm;
+    // this activation and the nodes fused after it, see MKLDNNGraphOptimizer
+    MKLDNNEltwiseChain chain;
 };
 
 }  // namespace MKLDNNPlugin
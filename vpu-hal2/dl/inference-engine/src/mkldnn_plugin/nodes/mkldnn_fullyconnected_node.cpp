@@ -147,6 +147,20 @@ void MKLDNNFullyConnectedNode::createPrimitive() {
                                              internalBlobMemory[0]->GetPrimitive(),
                                              getChildEdgeAt(0)->getMemory().GetPrimitive()));
     }
+
+    for (auto &node : fusedWith)
+        chain.append(node);
+}
+
+void MKLDNNFullyConnectedNode::execute(mkldnn::stream strm) {
+    MKLDNNNode::execute(strm);
+    if (chain.empty())
+        return;
+
+    auto& dstMemory = getChildEdgeAt(0)->getMemory();
+    float *dst_ptr = reinterpret_cast<float*>(dstMemory.GetData()) +
+            dstMemory.GetDescriptor().data.layout_desc.blocking.offset_padding;
+    chain.execute(dst_ptr, dst_ptr, dstMemory.GetSize() / sizeof(float));
 }
 
 bool MKLDNNFullyConnectedNode::created() {
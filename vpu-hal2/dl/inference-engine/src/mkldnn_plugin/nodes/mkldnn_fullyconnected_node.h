@@ -33,6 +33,7 @@
 
 #include <ie_common.h>
 #include <mkldnn_node.h>
+#include <mkldnn_eltwise_chain.h>
 #include <memory>
 #include <string>
 
@@ -46,6 +47,7 @@ public:
 
     void createDescriptor(mkldnn::memory::data_type inputDataType, mkldnn::memory::data_type outputDataType) override;
     void createPrimitive() override;
+    void execute(mkldnn::stream strm) override;
     bool created() override;
     void selectOptimalPrimitiveDescriptor() override;
     bool initAsInPlace() override {
@@ -54,6 +56,8 @@ public:
 
 private:
     static Register<MKLDNNFullyConnectedNode> reg;
+    // the activations fused after the inner product, applied in place on its output
+    MKLDNNEltwiseChain chain;
 
     mkldnn::memory::format weightsFormatForSrcFormat(mkldnn::memory::format sourceFormat);
 };
@@ -82,6 +82,12 @@ void MKLDNNPowerNode::createPrimitive() {
         THROW_IE_EXCEPTION << "Input memory didn't allocate.";
     if (getSelectedPrimitiveDescriptor() == nullptr)
         THROW_IE_EXCEPTION << "Preferable primitive descriptor does not set.";
+
+    if (!fusedWith.empty() && chain.empty()) {
+        chain.appendPower(scale, shift, power);
+        for (auto &node : fusedWith)
+            chain.append(node);
+    }
 }
 
 void MKLDNNPowerNode::execute(mkldnn::stream strm) {
@@ -94,7 +100,9 @@ void MKLDNNPowerNode::execute(mkldnn::stream strm) {
     float *dst_ptr = reinterpret_cast<float*>(dstMemory.GetData()) +
             dstMemory.GetDescriptor().data.layout_desc.blocking.offset_padding;
 
-    if (power == 1.0f) {
+    if (!chain.empty()) {
+        chain.execute(src_ptr, dst_ptr, data_size);
+    } else if (power == 1.0f) {
         #pragma omp parallel for
         for (int i = 0; i < data_size; i++)
             dst_ptr[i] = src_ptr[i] * scale + shift;
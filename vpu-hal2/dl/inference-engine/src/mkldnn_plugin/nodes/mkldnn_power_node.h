@@ -33,6 +33,7 @@
 
 #include <ie_common.h>
 #include <mkldnn_node.h>
+#include <mkldnn_eltwise_chain.h>
 #include <string>
 
 namespace MKLDNNPlugin {
@@ -54,6 +55,8 @@ private:
     float scale;
     float shift;
     float power;
+    // this power and the nodes fused after it, see MKLDNNGraphOptimizer
+    MKLDNNEltwiseChain chain;
 };
 
 }  // namespace MKLDNNPlugin
@@ -68,7 +68,8 @@ void GetPerformanceCounts(const std::vector<BlobMetaData> &blobMetaData,
             timeMS = graphInfo->info()[timeIndex];
             timeIndex++;
         }
-        pc.cpu_uSec = pc.realTime_uSec = static_cast<long long int>(timeMS * 1000);
+        // stages of one layer, as those of every image of a batch, add up
+        pc.cpu_uSec = pc.realTime_uSec = pc.realTime_uSec + static_cast<long long int>(timeMS * 1000);
         currentMetaData->exec_type.copy(pc.exec_type, sizeof(pc.exec_type) / sizeof(pc.exec_type[0]), 0);
         currentMetaData->layer_type.copy(pc.layer_type, sizeof(pc.layer_type) / sizeof(pc.layer_type[0]), 0);
         pc.status = currentMetaData->status;
@@ -90,51 +91,26 @@ void GetPerformanceCounts(const std::vector<BlobMetaData> &blobMetaData,
     }
 }
 
+// Whether data of these dims is laid out the same in NCHW and NHWC.
+inline bool SameInNCHWAndNHWC(const InferenceEngine::SizeVector& dims) {
+    return dims.size() == 4 && (dims[1] == 1 || dims[2] * dims[3] == 1);
+}
+
+// Copies src into dst, which has the same precision and dims in another layout.
+template<typename T>
+void CopyBlobToLayout(const InferenceEngine::Blob::Ptr& src, const InferenceEngine::Blob::Ptr& dst) {
+    // ConvertLayout expects dimensions in reversed order,
+    // so we use deperecated Blob::dims() method.
+    InferenceEngine::ConvertLayout<T>(src->layout(), dst->layout(), src->cbuffer().as<const T*>(),
+                                      dst->buffer().as<T*>(), src->dims());
+}
+
 template<typename T>
 void ConvertBlobToLayout(InferenceEngine::Layout layout, InferenceEngine::Blob::Ptr &blob) {
     InferenceEngine::Blob::Ptr convertedBlobPtr =
             InferenceEngine::make_shared_blob<T>(blob->precision(), layout, blob->dims());
     convertedBlobPtr->allocate();
-
-    {
-        auto srcPtr = blob->cbuffer().as<const T*>();
-        auto dstPtr = convertedBlobPtr->buffer().as<T*>();
-        const auto& newDims = blob->getTensorDesc().getDims();
-        auto C = newDims[1];
-        auto H = newDims[2];
-        auto W = newDims[3];
-        if (layout == InferenceEngine::NHWC) {
-            if (blob->layout() != InferenceEngine::Layout::NCHW || newDims.size() != 4 || newDims[0] != 1) {
-                // ConvertLayout expects dimensions in reversed order,
-                // so we use deperecated Blob::dims() method.
-                InferenceEngine::ConvertLayout<T>(blob->layout(), InferenceEngine::NHWC, srcPtr, dstPtr, blob->dims());
-            } else {
-                for (int c = 0; c < C; ++c) {
-                    for (int h = 0; h < H; ++h) {
-                        for (int w = 0; w < W; ++w) {
-                            auto dstInd = c + w * C + h * C * W;
-                            dstPtr[dstInd] = *srcPtr++;
-                        }
-                    }
-                }
-            }
-        } else if (layout == InferenceEngine::NCHW) {
-            if (blob->layout() != InferenceEngine::Layout::NHWC || newDims.size() != 4 || newDims[0] != 1) {
-                InferenceEngine::ConvertLayout<T>(blob->layout(), InferenceEngine::NCHW, srcPtr, dstPtr, blob->dims());
-            } else {
-                for (int c = 0; c < C; ++c) {
-                    for (int h = 0; h < H; ++h) {
-                        int offs = h * C * W + c;
-                        for (int w = 0; w < W; ++w) {
-                            auto srcInd = w * C + offs;
-                            *dstPtr = srcPtr[srcInd];
-                            ++dstPtr;
-                        }
-                    }
-                }
-            }
-        }
-    }
+    CopyBlobToLayout<T>(blob, convertedBlobPtr);
     blob.swap(convertedBlobPtr);
 }
 
@@ -32,6 +32,8 @@
 
 #include "parsed_config.h"
 #include <cpp_interfaces/exception2status.hpp>
+#include <fstream>
+#include <sstream>
 #include <vector>
 
 using namespace InferenceEngine;
@@ -57,6 +59,77 @@ void parseStringList(const std::string &str, std::vector<std::string> &vec) {
 
 }  // namespace
 
+VPU::MemoryPlanner ParsedConfig::parseMemoryPlanner(const std::string &option) {
+    if (option.compare("FIRST_FIT") == 0) {
+        return MemoryPlanner::FirstFit;
+    } else if (option.compare("BEST_FIT") == 0) {
+        return MemoryPlanner::BestFit;
+    } else if (option.compare("CONFLICT_GRAPH") == 0) {
+        return MemoryPlanner::ConflictGraph;
+    } else if (option.compare("AUTO") == 0) {
+        return MemoryPlanner::Auto;
+    }
+    THROW_IE_EXCEPTION << "Incorrect value for KEY_VPU_MEMORY_PLANNER option";
+}
+
+VPU::HwStageSelection ParsedConfig::parseHwStageSelection(const std::string &option) {
+    if (option.compare("HEURISTIC") == 0) {
+        return HwStageSelection::Heuristic;
+    } else if (option.compare("COST_MODEL") == 0) {
+        return HwStageSelection::CostModel;
+    }
+    THROW_IE_EXCEPTION << "Incorrect value for KEY_VPU_HW_STAGE_SELECTION option";
+}
+
+VPU::HwCostModel ParsedConfig::parseHwCostModel(const std::string &path) {
+    HwCostModel model;
+    if (path.empty())
+        return model;
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        THROW_IE_EXCEPTION << "Cannot open HW cost model " << path;
+    }
+
+    std::map<std::string, float*> params = {
+        {"hw_macs_per_us",    &model.hwMacsPerUs},
+        {"hw_bytes_per_us",   &model.hwBytesPerUs},
+        {"hw_descriptor_us",  &model.hwDescriptorUs},
+        {"hw_stage_us",       &model.hwStageUs},
+        {"shave_macs_per_us", &model.shaveMacsPerUs},
+        {"shave_bytes_per_us", &model.shaveBytesPerUs},
+        {"im2col_efficiency", &model.im2colEfficiency},
+        {"sw_stage_us",       &model.swStageUs},
+        {"sw_margin",         &model.swMargin}
+    };
+
+    std::string line;
+    for (int lineNo = 1; std::getline(file, line); lineNo++) {
+        auto comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        auto eq = line.find('=');
+        std::istringstream nameStr(line.substr(0, eq));
+        std::string name;
+        if (!(nameStr >> name) && eq == std::string::npos)
+            continue;
+
+        std::istringstream valueStr(eq != std::string::npos ? line.substr(eq + 1) : "");
+        float value = 0.f;
+        // throughputs must be positive, times and the margin may be zero
+        bool isRate = name.find("_per_us") != std::string::npos || name == "im2col_efficiency";
+        auto param = params.find(name);
+        if (param == params.end() || !(nameStr >> std::ws).eof() ||
+            !(valueStr >> value) || !(valueStr >> std::ws).eof() ||
+            !(value >= 0.f) || (isRate && value == 0.f)) {
+            THROW_IE_EXCEPTION << "Incorrect HW cost model " << path << ":" << lineNo << ": " << line;
+        }
+        *param->second = value;
+    }
+    return model;
+}
+
 LogLevel ParsedConfig::parseLogLevel(const std::string &option) {
     LogLevel logLevel = eLOGNONE;
 
@@ -97,11 +170,15 @@ ParsedConfig::ParsedConfig(const int platform, const std::map<std::string, std::
     blobConfig.copyOptimization = parseOptimizationOption(config[VPU_CONFIG_KEY(COPY_OPTIMIZATION)]);
     blobConfig.reshapeOptimization = parseOptimizationOption(config[VPU_CONFIG_KEY(RESHAPE_OPTIMIZATION)]);
     blobConfig.memoryOptimization = parseOptimizationOption(config[VPU_CONFIG_KEY(MEMORY_OPTIMIZATION)]);
+    blobConfig.memoryPlanner = parseMemoryPlanner(config[VPU_CONFIG_KEY(MEMORY_PLANNER)]);
     blobConfig.ignoreUnknownLayers = parseOptimizationOption(config[VPU_CONFIG_KEY(IGNORE_UNKNOWN_LAYERS)]);
     blobConfig.hwOptimization = parseOptimizationOption(config[VPU_CONFIG_KEY(HW_STAGES_OPTIMIZATION)]);
+    blobConfig.hwStageSelection = parseHwStageSelection(config[VPU_CONFIG_KEY(HW_STAGE_SELECTION)]);
+    blobConfig.hwCostModel = parseHwCostModel(config[VPU_CONFIG_KEY(HW_COST_MODEL)]);
     blobConfig.useCmxBuffers = parseOptimizationOption(config[VPU_CONFIG_KEY(USE_CMX_BUFFERS)]);
     exclusiveAsyncRequests = parseOptimizationOption(config[CONFIG_KEY(EXCLUSIVE_ASYNC_REQUESTS)]);
     printReceiveTensorTime = parseOptimizationOption(config[VPU_CONFIG_KEY(PRINT_RECEIVE_TENSOR_TIME)]);
+    multiDevice = parseOptimizationOption(config[VPU_CONFIG_KEY(MULTI_DEVICE)]);
 
     blobConfig.cmxBufferStart = stoi(config[VPU_CONFIG_KEY(CMX_BUFFER_START)]);
     blobConfig.cmxBufferSize = stoi(config[VPU_CONFIG_KEY(CMX_BUFFER_SIZE)]);
@@ -110,6 +187,14 @@ ParsedConfig::ParsedConfig(const int platform, const std::map<std::string, std::
     parseStringList(config[VPU_CONFIG_KEY(HW_WHITE_LIST)], blobConfig.hwWhiteList);
     parseStringList(config[VPU_CONFIG_KEY(HW_BLACK_LIST)], blobConfig.hwBlackList);
 
+    blobCacheDir = config[VPU_CONFIG_KEY(BLOB_CACHE_DIR)];
+    blobCacheKey = config[VPU_CONFIG_KEY(BLOB_CACHE_KEY)];
+    blobCachePrebuiltDir = config[VPU_CONFIG_KEY(BLOB_CACHE_PREBUILT_DIR)];
+    blobCacheSize = stoul(config[VPU_CONFIG_KEY(BLOB_CACHE_SIZE)]);
+
+    graphExecutors = stoul(config[VPU_CONFIG_KEY(GRAPH_EXECUTORS)]);
+    fifoDepth = stoul(config[VPU_CONFIG_KEY(FIFO_DEPTH)]);
+
     float norm = stof(config[VPU_CONFIG_KEY(INPUT_NORM)]);
     blobConfig.inputScale = 1.f / norm;
     blobConfig.inputBias = stof(config[VPU_CONFIG_KEY(INPUT_BIAS)]);
@@ -167,7 +252,8 @@ void ParsedConfig::validate(const std::map<std::string, std::string> &_config, c
             !isOptimizationOption(config[VPU_CONFIG_KEY(HW_STAGES_OPTIMIZATION)]) ||
             !isOptimizationOption(config[VPU_CONFIG_KEY(USE_CMX_BUFFERS)]) ||
             !isOptimizationOption(config[CONFIG_KEY(PERF_COUNT)]) ||
-            !isOptimizationOption(config[CONFIG_KEY(EXCLUSIVE_ASYNC_REQUESTS)])) {
+            !isOptimizationOption(config[CONFIG_KEY(EXCLUSIVE_ASYNC_REQUESTS)]) ||
+            !isOptimizationOption(config[VPU_CONFIG_KEY(MULTI_DEVICE)])) {
             THROW_IE_EXCEPTION << "Incorrect value for optimization option";
         }
     } else {  // MYRIAD_2 or UNKNOWN
@@ -176,11 +262,19 @@ void ParsedConfig::validate(const std::map<std::string, std::string> &_config, c
             !isOptimizationOption(config[VPU_CONFIG_KEY(MEMORY_OPTIMIZATION)]) ||
             !isOptimizationOption(config[VPU_CONFIG_KEY(IGNORE_UNKNOWN_LAYERS)]) ||
             !isOptimizationOption(config[CONFIG_KEY(PERF_COUNT)]) ||
-            !isOptimizationOption(config[CONFIG_KEY(EXCLUSIVE_ASYNC_REQUESTS)])) {
+            !isOptimizationOption(config[CONFIG_KEY(EXCLUSIVE_ASYNC_REQUESTS)]) ||
+            !isOptimizationOption(config[VPU_CONFIG_KEY(MULTI_DEVICE)])) {
            THROW_IE_EXCEPTION << "Incorrect value for optimization option";
        }
     }
 
+    parseMemoryPlanner(config[VPU_CONFIG_KEY(MEMORY_PLANNER)]);
+
+    if (platform == MYRIAD_X || platform == MYRIAD_2) {
+        parseHwStageSelection(config[VPU_CONFIG_KEY(HW_STAGE_SELECTION)]);
+        parseHwCostModel(config[VPU_CONFIG_KEY(HW_COST_MODEL)]);
+    }
+
     if (platform == MYRIAD_X) {
         uint32_t cmxBufferStart = stoi(config[VPU_CONFIG_KEY(CMX_BUFFER_START)]);
         uint32_t cmxBufferSize = stoi(config[VPU_CONFIG_KEY(CMX_BUFFER_SIZE)]);
@@ -194,6 +288,22 @@ void ParsedConfig::validate(const std::map<std::string, std::string> &_config, c
     if (norm == 0.0f) {
         THROW_IE_EXCEPTION << "Incorrect zero value for KEY_VPU_INPUT_NORM option";
     }
+
+    auto blobCacheSize = config[VPU_CONFIG_KEY(BLOB_CACHE_SIZE)];
+    if (blobCacheSize.empty() || blobCacheSize.find_first_not_of("0123456789") != std::string::npos) {
+        THROW_IE_EXCEPTION << "Incorrect value for KEY_VPU_BLOB_CACHE_SIZE option";
+    }
+
+    auto graphExecutors = config[VPU_CONFIG_KEY(GRAPH_EXECUTORS)];
+    if (graphExecutors.empty() || graphExecutors.find_first_not_of("0123456789") != std::string::npos) {
+        THROW_IE_EXCEPTION << "Incorrect value for KEY_VPU_GRAPH_EXECUTORS option";
+    }
+
+    auto fifoDepth = config[VPU_CONFIG_KEY(FIFO_DEPTH)];
+    if (fifoDepth.empty() || fifoDepth.find_first_not_of("0123456789") != std::string::npos
+        || stoul(fifoDepth) == 0 || stoul(fifoDepth) > 64) {
+        THROW_IE_EXCEPTION << "Incorrect value for KEY_VPU_FIFO_DEPTH option";
+    }
 }
 
 std::map<std::string, std::string> ParsedConfig::getDefaultConfig(const int platform) {
@@ -202,6 +312,7 @@ std::map<std::string, std::string> ParsedConfig::getDefaultConfig(const int plat
                 {VPU_CONFIG_KEY(LAST_SHAVE),       "7"},
                 {CONFIG_KEY(EXCLUSIVE_ASYNC_REQUESTS),   CONFIG_VALUE(NO)},
                 {VPU_CONFIG_KEY(MEMORY_OPTIMIZATION),    CONFIG_VALUE(YES)},
+                {VPU_CONFIG_KEY(MEMORY_PLANNER),   "AUTO"},
                 {VPU_CONFIG_KEY(COPY_OPTIMIZATION),      CONFIG_VALUE(YES)},
                 {VPU_CONFIG_KEY(RESHAPE_OPTIMIZATION),   CONFIG_VALUE(YES)},
                 {CONFIG_KEY(LOG_LEVEL),                  CONFIG_VALUE(LOG_NONE)},
@@ -217,15 +328,25 @@ std::map<std::string, std::string> ParsedConfig::getDefaultConfig(const int plat
                 {VPU_CONFIG_KEY(USE_CMX_BUFFERS),        CONFIG_VALUE(YES)},
                 {VPU_CONFIG_KEY(HW_WHITE_LIST),    ""},
                 {VPU_CONFIG_KEY(HW_BLACK_LIST),    ""},
+                {VPU_CONFIG_KEY(HW_STAGE_SELECTION), "HEURISTIC"},
+                {VPU_CONFIG_KEY(HW_COST_MODEL),    ""},
                 {VPU_CONFIG_KEY(CMX_BUFFER_START), "0"},
                 {VPU_CONFIG_KEY(CMX_BUFFER_SIZE),  "1048576"},
-                {VPU_CONFIG_KEY(PRINT_RECEIVE_TENSOR_TIME),    CONFIG_VALUE(NO)}
+                {VPU_CONFIG_KEY(PRINT_RECEIVE_TENSOR_TIME),    CONFIG_VALUE(NO)},
+                {VPU_CONFIG_KEY(BLOB_CACHE_DIR),   ""},
+                {VPU_CONFIG_KEY(BLOB_CACHE_SIZE),  "64"},
+                {VPU_CONFIG_KEY(BLOB_CACHE_KEY),   ""},
+                {VPU_CONFIG_KEY(BLOB_CACHE_PREBUILT_DIR), ""},
+                {VPU_CONFIG_KEY(GRAPH_EXECUTORS),  "0"},
+                {VPU_CONFIG_KEY(FIFO_DEPTH),       "4"},
+                {VPU_CONFIG_KEY(MULTI_DEVICE),     CONFIG_VALUE(NO)}
         };
     } else if (platform == MYRIAD_2) {
         return {{VPU_CONFIG_KEY(FIRST_SHAVE),      "0"},
                 {VPU_CONFIG_KEY(LAST_SHAVE),       "11"},
                 {CONFIG_KEY(EXCLUSIVE_ASYNC_REQUESTS),   CONFIG_VALUE(NO)},
                 {VPU_CONFIG_KEY(MEMORY_OPTIMIZATION),    CONFIG_VALUE(YES)},
+                {VPU_CONFIG_KEY(MEMORY_PLANNER),   "AUTO"},
                 {VPU_CONFIG_KEY(COPY_OPTIMIZATION),      CONFIG_VALUE(YES)},
                 {VPU_CONFIG_KEY(RESHAPE_OPTIMIZATION),   CONFIG_VALUE(YES)},
                 {CONFIG_KEY(LOG_LEVEL),                  CONFIG_VALUE(LOG_NONE)},
@@ -241,13 +362,23 @@ std::map<std::string, std::string> ParsedConfig::getDefaultConfig(const int plat
                 {VPU_CONFIG_KEY(USE_CMX_BUFFERS),        CONFIG_VALUE(NO)},
                 {VPU_CONFIG_KEY(HW_WHITE_LIST),    ""},
                 {VPU_CONFIG_KEY(HW_BLACK_LIST),    ""},
+                {VPU_CONFIG_KEY(HW_STAGE_SELECTION), "HEURISTIC"},
+                {VPU_CONFIG_KEY(HW_COST_MODEL),    ""},
                 {VPU_CONFIG_KEY(CMX_BUFFER_START), "0"},
                 {VPU_CONFIG_KEY(CMX_BUFFER_SIZE),  "0"},
-                {VPU_CONFIG_KEY(PRINT_RECEIVE_TENSOR_TIME),    CONFIG_VALUE(NO)}
+                {VPU_CONFIG_KEY(PRINT_RECEIVE_TENSOR_TIME),    CONFIG_VALUE(NO)},
+                {VPU_CONFIG_KEY(BLOB_CACHE_DIR),   ""},
+                {VPU_CONFIG_KEY(BLOB_CACHE_SIZE),  "64"},
+                {VPU_CONFIG_KEY(BLOB_CACHE_KEY),   ""},
+                {VPU_CONFIG_KEY(BLOB_CACHE_PREBUILT_DIR), ""},
+                {VPU_CONFIG_KEY(GRAPH_EXECUTORS),  "0"},
+                {VPU_CONFIG_KEY(FIFO_DEPTH),       "4"},
+                {VPU_CONFIG_KEY(MULTI_DEVICE),     CONFIG_VALUE(NO)}
         };
     } else {
         return {{CONFIG_KEY(EXCLUSIVE_ASYNC_REQUESTS),   CONFIG_VALUE(NO)},
                 {VPU_CONFIG_KEY(MEMORY_OPTIMIZATION),    CONFIG_VALUE(YES)},
+                {VPU_CONFIG_KEY(MEMORY_PLANNER),   "AUTO"},
                 {VPU_CONFIG_KEY(COPY_OPTIMIZATION),      CONFIG_VALUE(YES)},
                 {VPU_CONFIG_KEY(RESHAPE_OPTIMIZATION),   CONFIG_VALUE(YES)},
                 {CONFIG_KEY(LOG_LEVEL),                  CONFIG_VALUE(LOG_NONE)},
@@ -259,7 +390,14 @@ std::map<std::string, std::string> ParsedConfig::getDefaultConfig(const int plat
                 {VPU_CONFIG_KEY(INPUT_BIAS),       "0.0"},
                 {VPU_CONFIG_KEY(IGNORE_UNKNOWN_LAYERS),  CONFIG_VALUE(NO)},
                 {VPU_CONFIG_KEY(NONE_LAYERS),      ""},
-                {VPU_CONFIG_KEY(PRINT_RECEIVE_TENSOR_TIME),    CONFIG_VALUE(NO)}
+                {VPU_CONFIG_KEY(PRINT_RECEIVE_TENSOR_TIME),    CONFIG_VALUE(NO)},
+                {VPU_CONFIG_KEY(BLOB_CACHE_DIR),   ""},
+                {VPU_CONFIG_KEY(BLOB_CACHE_SIZE),  "64"},
+                {VPU_CONFIG_KEY(BLOB_CACHE_KEY),   ""},
+                {VPU_CONFIG_KEY(BLOB_CACHE_PREBUILT_DIR), ""},
+                {VPU_CONFIG_KEY(GRAPH_EXECUTORS),  "0"},
+                {VPU_CONFIG_KEY(FIFO_DEPTH),       "4"},
+                {VPU_CONFIG_KEY(MULTI_DEVICE),     CONFIG_VALUE(NO)}
         };
     }
 }
@@ -52,8 +52,22 @@ struct ParsedConfig {
 
     bool printReceiveTensorTime = false;
     bool exclusiveAsyncRequests = false;
+    bool multiDevice = false;
+
+    std::string blobCacheDir;
+    std::string blobCacheKey;
+    std::string blobCachePrebuiltDir;
+    uint32_t blobCacheSize = 0;
+
+    // 0 lets the executor pick the platform default
+    uint32_t graphExecutors = 0;
+    uint32_t fifoDepth = 4;
 
     static LogLevel parseLogLevel(const std::string &option);
+    static MemoryPlanner parseMemoryPlanner(const std::string &option);
+    static HwStageSelection parseHwStageSelection(const std::string &option);
+    // empty path gives the defaults
+    static HwCostModel parseHwCostModel(const std::string &path);
 
     // throw exception in the case of error
     static void validate(const std::map<std::string, std::string> &_config, const int platform = UNKNOWN_DEVICE);
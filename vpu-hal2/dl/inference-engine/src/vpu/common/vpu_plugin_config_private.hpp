@@ -25,6 +25,13 @@ DECLARE_VPU_CONFIG_KEY(LAST_SHAVE);
 
 DECLARE_VPU_CONFIG_KEY(MEMORY_OPTIMIZATION);
 
+/**
+* @brief Strategy packMemory places the intermediate data with:
+* FIRST_FIT, BEST_FIT, CONFLICT_GRAPH or AUTO (default, the better of the last two).
+* Only used with MEMORY_OPTIMIZATION, without it data is placed first fit.
+*/
+DECLARE_VPU_CONFIG_KEY(MEMORY_PLANNER);
+
 DECLARE_VPU_CONFIG_KEY(COPY_OPTIMIZATION);
 
 DECLARE_VPU_CONFIG_KEY(RESHAPE_OPTIMIZATION);
@@ -41,5 +48,18 @@ DECLARE_VPU_CONFIG_KEY(CMX_BUFFER_SIZE);
 DECLARE_VPU_CONFIG_KEY(HW_WHITE_LIST);
 DECLARE_VPU_CONFIG_KEY(HW_BLACK_LIST);
 
+/**
+* @brief Which convolutions HW_STAGES_OPTIMIZATION puts on the NCE: HEURISTIC (default), every
+* one it can take, or COST_MODEL, the ones estimated faster there than on the SHAVEs, converts
+* between the two orders included. The built-in figures of COST_MODEL are not calibrated,
+* give it an HW_COST_MODEL file measured on the device.
+*/
+DECLARE_VPU_CONFIG_KEY(HW_STAGE_SELECTION);
+
+/**
+* @brief Calibration file of the COST_MODEL stage selection, built-in MYRIAD_X figures if empty.
+*/
+DECLARE_VPU_CONFIG_KEY(HW_COST_MODEL);
+
 }  // namespace VPUConfigParams
 }  // namespace InferenceEngine
@@ -0,0 +1,120 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2017-2018 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+//
+
+
+#include "graph_transformer.hpp"
+#include <cmath>
+#include <string>
+#include <ostream>
+
+namespace VPU {
+
+namespace {
+
+void writeString(std::ostream& out, const std::string& str) {
+    out << '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+}  // namespace
+
+void CompileProfile::writeJson(std::ostream& out) const {
+    out << "{\"network\": ";
+    writeString(out, network);
+    out << ", \"batch\": " << batchSize
+        << ", \"totalMs\": " << totalUs / 1000.
+        << ", \"ddrBytes\": " << ddrBytes
+        << ", \"cmxBytes\": " << cmxBytes
+        << ", \"ddrTempBytes\": " << ddrTempBytes
+        << ", \"ddrLowerBound\": " << ddrLowerBound
+        << ", \"cmxLowerBound\": " << cmxLowerBound
+        << ", \"memoryPlanner\": ";
+    writeString(out, memoryPlanner);
+    out << ", \"weightsBytes\": " << weightsBytes
+        << ", \"blobBytes\": " << blobBytes
+        << ", \"finalizePeakBytes\": " << finalizePeakBytes
+        << ", \"passes\": [";
+    for (size_t i = 0; i < passes.size(); i++) {
+        const auto& pass = passes[i];
+        out << (i ? ", " : "") << "{\"name\": ";
+        writeString(out, pass.name);
+        out << ", \"ms\": " << pass.durationUs / 1000.
+            << ", \"stages\": " << pass.numStages
+            << ", \"datas\": " << pass.numDatas
+            << ", \"peakRssKb\": " << pass.peakRssKb << "}";
+    }
+    out << "], \"defaultPlanUs\": " << defaultPlanUs
+        << ", \"chosenPlanUs\": " << chosenPlanUs
+        << ", \"hwStages\": [";
+    for (size_t i = 0; i < hwStages.size(); i++) {
+        const auto& choice = hwStages[i];
+        out << (i ? ", " : "") << "{\"name\": ";
+        writeString(out, choice.stage);
+        out << ", \"defaultHw\": " << (choice.defaultHw ? "true" : "false")
+            << ", \"chosenHw\": " << (choice.chosenHw ? "true" : "false")
+            << ", \"hwUs\": ";
+        // infinite where the HW can't take it
+        if (std::isfinite(choice.hwUs))
+            out << choice.hwUs;
+        else
+            out << "null";
+        out << ", \"swUs\": " << choice.swUs << "}";
+    }
+    out << "]}";
+}
+
+void CompileProfile::writeTraceEvents(std::ostream& out, int pid, int tid) const {
+    for (size_t i = 0; i < passes.size(); i++) {
+        const auto& pass = passes[i];
+        out << (i ? ",\n" : "") << "{\"name\": ";
+        writeString(out, pass.name);
+        out << ", \"cat\": ";
+        writeString(out, network);
+        out << ", \"ph\": \"X\", \"ts\": " << pass.startUs
+            << ", \"dur\": " << pass.durationUs
+            << ", \"pid\": " << pid << ", \"tid\": " << tid
+            << ", \"args\": {\"stages\": " << pass.numStages
+            << ", \"datas\": " << pass.numDatas
+            << ", \"peakRssKb\": " << pass.peakRssKb << "}}";
+    }
+}
+
+}  // namespace VPU
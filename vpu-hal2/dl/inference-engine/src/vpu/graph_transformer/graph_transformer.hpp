@@ -36,6 +36,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <ostream>
 #include <ie_icnn_network.hpp>
 #include <vpu_logger.h>
 
@@ -48,26 +49,164 @@ struct BlobMetaData {
     InferenceEngine::InferenceEngineProfileInfo::LayerStatus status;
 };
 
+// How packMemory places the intermediate data in DDR and CMX, see
+// optimizations/memory_planner.hpp.
+enum class MemoryPlanner {
+    FirstFit,       // allocate and free in stage order, as the graph is walked
+    BestFit,        // largest first, into the tightest gap free over its lifetime
+    ConflictGraph,  // most contended first, at the lowest offset free over its lifetime
+    Auto            // the better of BestFit and ConflictGraph
+};
+
+// Which convolutions addHWStages runs on the NCE, see hw/stage_selection.cpp.
+enum class HwStageSelection {
+    Heuristic,  // every convolution the HW can take
+    CostModel   // the cheapest HW/SW assignment by HwCostModel
+};
+
+// Throughputs HW/SW stage selection estimates stage times with. The
+// defaults are rough MYRIAD_X figures for FP16, not measured, which is why
+// CostModel is opt-in; KEY_VPU_HW_COST_MODEL names a calibration file that
+// overrides them, one "name = value" per line:
+//
+//   # measured on ...
+//   hw_macs_per_us = 180000
+//   sw_stage_us = 12
+struct HwCostModel {
+    float hwMacsPerUs = 150000.f;    // NCE multiply-accumulates
+    float hwBytesPerUs = 4000.f;     // DDR traffic of an NCE descriptor
+    float hwDescriptorUs = 1.f;      // setup of one descriptor
+    float hwStageUs = 5.f;           // dispatch of one HW stage
+    float shaveMacsPerUs = 4000.f;   // per SHAVE, for the 1x1/3x3 kernels
+    float shaveBytesPerUs = 2500.f;  // all SHAVEs, for copies, converts, sums
+    float im2colEfficiency = 0.5f;   // of the im2col kernel against the others
+    float swStageUs = 10.f;          // dispatch of one SHAVE stage
+    float swMargin = 0.1f;           // how much cheaper SW must be to be picked
+};
+
 struct BlobConfig {
     uint16_t firstShave, lastShave;
     bool memoryOptimization, hwOptimization, useCmxBuffers;
     bool copyOptimization, reshapeOptimization;
+    MemoryPlanner memoryPlanner;
     uint32_t cmxBufferStart, cmxBufferSize;
     float inputScale, inputBias;
     std::vector<std::string> NoneLayers;
     std::vector<std::string> hwWhiteList;
     std::vector<std::string> hwBlackList;
+    HwStageSelection hwStageSelection;
+    HwCostModel hwCostModel;
     bool ignoreUnknownLayers;
 };
 
+// The layout a compiled graph keeps a network input or output in. NCHW and
+// NHWC data stay as the network declares them, so the plugin passes them
+// through and any reorder runs on the device next to the stages that need
+// it; data of other layouts is in the order the first stages work in.
+inline InferenceEngine::Layout deviceLayout(InferenceEngine::Layout declared, bool hwOptimization) {
+    if (declared == InferenceEngine::NCHW || declared == InferenceEngine::NHWC)
+        return declared;
+    return hwOptimization ? InferenceEngine::NCHW : InferenceEngine::NHWC;
+}
+
+// One pass of GraphTransformer::generate and the graph it left behind.
+struct PassProfile {
+    std::string name;
+    uint64_t startUs;       // steady clock
+    uint64_t durationUs;
+    size_t numStages;       // stages not optimized out
+    size_t numDatas;
+    size_t peakRssKb;       // high water mark of the whole process
+};
+
+// Where a convolution runs, by the cost model and by the heuristic.
+struct HwStageChoice {
+    std::string stage;
+    bool defaultHw;
+    bool chosenHw;
+    float hwUs;     // estimated, the converts around it not included
+    float swUs;
+};
+
+// What generate spent compiling one network, and the memory the result
+// needs on the device.
+struct CompileProfile {
+    std::string network;
+    uint32_t batchSize = 1;     // images the blob infers at once
+    std::vector<PassProfile> passes;
+    uint64_t totalUs = 0;
+    uint32_t ddrBytes = 0;
+    uint32_t cmxBytes = 0;
+    // of ddrBytes, the stage scratch buffer after the planned data
+    uint32_t ddrTempBytes = 0;
+    // peak of the planned data live at the same time, no placement can use less
+    uint32_t ddrLowerBound = 0;
+    uint32_t cmxLowerBound = 0;
+    std::string memoryPlanner;
+    uint32_t weightsBytes = 0;
+    size_t blobBytes = 0;
+    // most finalize held besides what the sink keeps: the stage and
+    // relocation sections and the largest weights being written
+    size_t finalizePeakBytes = 0;
+    // convolutions HW/SW stage selection looked at, with the estimated time
+    // of the chains they are in under the heuristic and the chosen plan
+    std::vector<HwStageChoice> hwStages;
+    float defaultPlanUs = 0.f;
+    float chosenPlanUs = 0.f;
+    // a hash per stage of the blob, of all it holds but where its data is,
+    // so the stages of each image of a batch match those of batch 1
+    std::vector<uint64_t> stageSignatures;
+
+    // {"network": ..., "totalMs": ..., "passes": [{"name": ..., "ms": ...}, ...]}
+    void writeJson(std::ostream& out) const;
+    // Complete events of the Chrome trace event format, without the
+    // enclosing array, so the compiles of several networks go in one trace.
+    void writeTraceEvents(std::ostream& out, int pid, int tid) const;
+};
+
+// Takes the blob generate produces front to back, so it never has to be
+// whole in memory. start comes first, with the size of the blob.
+class BlobSink {
+public:
+    virtual ~BlobSink() = default;
+
+    virtual void start(size_t blobSize) = 0;
+    virtual void write(const void* data, size_t size) = 0;
+};
+
+// Collects the blob in a vector, allocated once.
+class VectorBlobSink : public BlobSink {
+public:
+    explicit VectorBlobSink(std::vector<char>& blob) : _blob(blob) {}
+
+    void start(size_t blobSize) override;
+    void write(const void* data, size_t size) override;
+
+private:
+    std::vector<char>& _blob;
+};
+
 class IGraphTransformer {
 public:
     virtual ~IGraphTransformer() = default;
 
+    // Writes the blob to the sink as finalize produces it. The weights go
+    // out one at a time and are released once written.
     virtual void generate(InferenceEngine::ICNNNetwork& network,
-                          std::vector<char>& blob,
+                          BlobSink& blob,
                           std::vector<BlobMetaData>& metadata,
                           size_t& numStages) = 0;
+
+    void generate(InferenceEngine::ICNNNetwork& network,
+                  std::vector<char>& blob,
+                  std::vector<BlobMetaData>& metadata,
+                  size_t& numStages) {
+        VectorBlobSink sink(blob);
+        generate(network, sink, metadata, numStages);
+    }
+
+    // Filled in by the last generate call.
+    virtual const CompileProfile& profile() const = 0;
 };
 
 std::shared_ptr<IGraphTransformer> createGraphTransformer(const BlobConfig& blobConfig,
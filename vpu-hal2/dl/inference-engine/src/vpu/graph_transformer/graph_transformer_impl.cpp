@@ -45,6 +45,8 @@
 #include <algorithm>
 #include <precision_utils.h>
 #include <caseless.hpp>
+#include <fnv1a_hash.h>
+#include <sys/resource.h>
 
 #ifdef NNLOG
 #include <android/log.h>
@@ -372,7 +374,12 @@ void VpuData::dumpToBlob(BlobWriter& writer) {
         break;
     }
 
-    uint32_t reloc = (index == IndexBlob || index == IndexBSS || index == IndexCMX ? writer.dataMap[this] : offset);
+    uint32_t reloc = 0;
+    uint32_t location = 0;
+    if (!writer.maskPlacement) {
+        reloc = (index == IndexBlob || index == IndexBSS || index == IndexCMX ? writer.dataMap[this] : offset);
+        location = index;
+    }
 
     writer.write(static_cast<uint32_t>(dims[Dim::X]));
     writer.write(static_cast<uint32_t>(dims[Dim::Y]));
@@ -381,7 +388,7 @@ void VpuData::dumpToBlob(BlobWriter& writer) {
     writer.write(static_cast<uint32_t>(strides[Dim::Y]));
     writer.write(static_cast<uint32_t>(strides[Dim::Z]));
     writer.write(static_cast<uint32_t>(reloc));
-    writer.write(static_cast<uint32_t>(index));
+    writer.write(static_cast<uint32_t>(location));
     writer.write(static_cast<uint32_t>(data_type));
     writer.write(static_cast<uint32_t>(order));
 }
@@ -534,10 +541,74 @@ private:
 };
 #endif
 
+#ifndef NDEBUG
+// Also writes the blob to a file as it goes by.
+class DumpingBlobSink : public BlobSink {
+public:
+    DumpingBlobSink(BlobSink& blob, const char* fileName)
+        : _blob(blob), _file(fileName, std::ios_base::out | std::ios_base::binary) {
+        if (!_file.is_open()) {
+            THROW_IE_EXCEPTION << "[VPU] Cannot open file " << fileName << " for writing";
+        }
+    }
+
+    void start(size_t blobSize) override {
+        _blob.start(blobSize);
+    }
+
+    void write(const void* data, size_t size) override {
+        _blob.write(data, size);
+        _file.write(static_cast<const char*>(data), size);
+    }
+
+private:
+    BlobSink& _blob;
+    std::ofstream _file;
+};
+#endif
+
+// The network data at batch 1 while the stages of one image are generated,
+// back at the batch of the network when they are. parseNetwork checked the
+// batch is the outer dimension of all of them.
+class BatchTiling {
+public:
+    BatchTiling(const InputsDataMap& inputs, const std::list<CNNLayerPtr>& layers, size_t batchSize)
+        : _batchSize(batchSize) {
+        if (_batchSize == 1)
+            return;
+
+        for (const auto& input : inputs) {
+            _datas.push_back(input.second->getInputData());
+        }
+        for (const auto& layer : layers) {
+            _datas.insert(_datas.end(), layer->outData.begin(), layer->outData.end());
+        }
+        for (const auto& data : _datas) {
+            setBatch(data, 1);
+        }
+    }
+
+    ~BatchTiling() {
+        for (const auto& data : _datas) {
+            setBatch(data, _batchSize);
+        }
+    }
+
+private:
+    static void setBatch(const DataPtr& data, size_t batchSize) {
+        auto dims = data->getTensorDesc().getDims();
+        dims[0] = batchSize;
+        data->setDims(dims);
+    }
+
+    size_t _batchSize;
+    std::vector<DataPtr> _datas;
+};
+
 }  // namespace
 
 void GraphTransformerImpl::generate(ICNNNetwork& network,
-                                    std::vector<char>& blob,
+                                    BlobSink& blob,
                                     std::vector<BlobMetaData>& metaData,
                                     size_t& numStages) {
 #ifndef NDEBUG
@@ -545,48 +616,69 @@ void GraphTransformerImpl::generate(ICNNNetwork& network,
     (void)autoDumper;
 #endif
 
+    startProfile();
+
     parseNetwork(network);
+    endPass("parseNetwork");
+
+    {
+        BatchTiling tiling(_networkInputs, _orderedLayers, _batchSize);
+        (void)tiling;
 
-    parseInputAndOutputData();
-    addInputConvertStages();
-    addPreProcessStages();
+        parseInputAndOutputData();
+        endPass("parseInputAndOutputData");
+        forEachBatch(&GraphTransformerImpl::addInputConvertStages);
+        endPass("addInputConvertStages");
+        forEachBatch(&GraphTransformerImpl::addPreProcessStages);
+        endPass("addPreProcessStages");
 
-    generateStages();
+        forEachBatch(&GraphTransformerImpl::generateStages);
+        endPass("generateStages");
 
-    addOutputConvertStages();
+        forEachBatch(&GraphTransformerImpl::addOutputConvertStages);
+        endPass("addOutputConvertStages");
+    }
 
     packPostOps();
+    endPass("packPostOps");
     // this optimization must be before addConvertOrderStages();
     // because it can wrap reshape with additional convert order stages
     if (_blobConfig.reshapeOptimization) {
         eliminateReshapeStages();
+        endPass("eliminateReshapeStages");
     }
     if (_blobConfig.hwOptimization) {
         addHWStages();
+        endPass("addHWStages");
         if (_blobConfig.copyOptimization) {
             packHWConcat();
+            endPass("packHWConcat");
         }
     }
     addConvertOrderStages();
+    endPass("addConvertOrderStages");
     if (_blobConfig.copyOptimization) {
         eliminateCopyStages();
+        endPass("eliminateCopyStages");
     }
     if (_blobConfig.hwOptimization) {
         fillHWDescriptors();
+        endPass("fillHWDescriptors");
     }
     packMemory();
-
-    finalize(blob);
+    endPass("packMemory");
 
 #ifndef NDEBUG
     if (auto dumpFileName = std::getenv("IE_VPU_DUMP_BLOB_FILE_NAME")) {
-        std::ofstream file(dumpFileName, std::ios_base::out | std::ios_base::binary);
-        if (!file.is_open()) {
-            THROW_IE_EXCEPTION << "[VPU] Cannot open file " << dumpFileName << " for writing";
-        }
-        file.write(blob.data(), blob.size());
+        DumpingBlobSink dumpSink(blob, dumpFileName);
+        finalize(dumpSink);
+    } else {
+        finalize(blob);
     }
+#else
+    finalize(blob);
 #endif
+    endPass("finalize");
 
 
     getMetaData(metaData);
@@ -596,6 +688,52 @@ void GraphTransformerImpl::generate(ICNNNetwork& network,
         if (!stage->optimized)
             ++numStages;
     }
+    endPass("getMetaData");
+
+    _profile.batchSize = static_cast<uint32_t>(_batchSize);
+    _profile.ddrBytes = _bssMemSize;
+    _profile.cmxBytes = _cmxMemSize;
+    _profile.weightsBytes = _blobTotalDataSize;
+
+    auto slowest = std::max_element(_profile.passes.begin(), _profile.passes.end(),
+                                    [](const PassProfile& a, const PassProfile& b) {
+                                        return a.durationUs < b.durationUs;
+                                    });
+    LOG_INFO("[VPU] GraphTransformer : %s compiled in %.3f ms, slowest pass %s %.3f ms, %u stages, batch %u",
+             _networkName.c_str(), _profile.totalUs / 1000.,
+             slowest->name.c_str(), slowest->durationUs / 1000.,
+             static_cast<uint32_t>(numStages), _profile.batchSize);
+}
+
+void GraphTransformerImpl::startProfile() {
+    _profile = CompileProfile();
+    _passStart = std::chrono::steady_clock::now();
+}
+
+void GraphTransformerImpl::endPass(const char* name) {
+    auto now = std::chrono::steady_clock::now();
+
+    PassProfile pass;
+    pass.name = name;
+    pass.startUs = std::chrono::duration_cast<std::chrono::microseconds>(_passStart.time_since_epoch()).count();
+    pass.durationUs = std::chrono::duration_cast<std::chrono::microseconds>(now - _passStart).count();
+    pass.numStages = 0;
+    for (const auto& stage : _stages) {
+        if (!stage->optimized)
+            ++pass.numStages;
+    }
+    pass.numDatas = _datas.size();
+
+    struct rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    pass.peakRssKb = static_cast<size_t>(usage.ru_maxrss);
+
+    _profile.network = _networkName;
+    _profile.totalUs += pass.durationUs;
+    _profile.passes.push_back(pass);
+
+    // the bookkeeping above is not charged to the next pass
+    _passStart = std::chrono::steady_clock::now();
 }
 
 void GraphTransformerImpl::generateStages() {
@@ -790,7 +928,7 @@ void GraphTransformerImpl::dumpInternalGraphToDot(const std::string& fileName) c
 }
 #endif
 
-void GraphTransformerImpl::finalize(std::vector<char>& blob) {
+void GraphTransformerImpl::finalize(BlobSink& blob) {
     ElfN_Ehdr elfHdr = {};
     // TODO : what do this numbers mean?
     elfHdr.e_type = 1;
@@ -903,6 +1041,13 @@ void GraphTransformerImpl::finalize(std::vector<char>& blob) {
         auto stageHdrPtr = reinterpret_cast<mv_stage_header*>(&stagesWriter.stagesData[curSize]);
         stageHdrPtr->next_stage = stageIdx == numStages - 1 ? 0 : stagesWriter.stagesData.size() + sizeof(stageSecHdr);
 
+        BlobWriter signatureWriter;
+        signatureWriter.maskPlacement = true;
+        signatureWriter.write(stageHdr);
+        stage->dumpToBlob(signatureWriter);
+        _profile.stageSignatures.push_back(fnv1a(kFnv1aOffset, signatureWriter.stagesData.data(),
+                                                 signatureWriter.stagesData.size()));
+
         ++stageIdx;
     }
 
@@ -913,51 +1058,66 @@ void GraphTransformerImpl::finalize(std::vector<char>& blob) {
     blobHdr.relocation_section_offset = relocSecOffset;
     blobHdr.file_size = stageSecOffset + stageSecHdr.stage_section_size;
 
-    blob.clear();
-    blob.resize(blobHdr.file_size, 0);
-
-    size_t curBlobOffset = 0;
-
-    std::copy_n(&elfHdr, 1, reinterpret_cast<ElfN_Ehdr*>(&blob[curBlobOffset]));
-    curBlobOffset += sizeof(elfHdr);
+    blob.start(blobHdr.file_size);
 
-    std::copy_n(&blobHdr, 1, reinterpret_cast<mv_blob_header*>(&blob[curBlobOffset]));
-    curBlobOffset += sizeof(blobHdr);
+    blob.write(&elfHdr, sizeof(elfHdr));
+    blob.write(&blobHdr, sizeof(blobHdr));
 
-    curBlobOffset += dataSecPreFill;
+    const std::vector<char> zeros(WEIGHTS_ALIGNMENT, 0);
+    auto fill = [&blob, &zeros](size_t size) {
+        while (size > 0) {
+            auto chunk = std::min(size, zeros.size());
+            blob.write(zeros.data(), chunk);
+            size -= chunk;
+        }
+    };
+    fill(dataSecPreFill);
 
-    std::copy_n(&bufSecHdr, 1, reinterpret_cast<mv_buffer_section_header*>(&blob[curBlobOffset]));
-    curBlobOffset += sizeof(bufSecHdr);
+    blob.write(&bufSecHdr, sizeof(bufSecHdr));
 
+    // packMemory lays the weights out in _datas order, each goes through
+    // the scratch buffer and its writer, with the blob it converts from, is
+    // dropped once written
+    std::vector<char> scratch;
+    size_t weightsOffset = 0;
     for (const auto& data : _datas) {
         assert(data != nullptr);
 
-        if (data->index == IndexBlob) {
-            if (data->writer != nullptr) {
-                data->writer->write(&blob[curBlobOffset] + data->offset);
-            }
+        if (data->index != IndexBlob || data->writer == nullptr)
+            continue;
+
+        if (data->offset < weightsOffset) {
+            THROW_IE_EXCEPTION << "[VPU] in function " << __PRETTY_FUNCTION__
+                               << ": blob data " << data->name << " overlaps the previous one.";
         }
-    }
-    curBlobOffset += _blobTotalDataSize;
+        fill(data->offset - weightsOffset);
 
-    std::copy_n(&mvRelocSecHdr, 1, reinterpret_cast<mv_relocation_section_header*>(&blob[curBlobOffset]));
-    curBlobOffset += sizeof(mvRelocSecHdr);
+        // writers leave the padding they add alone
+        auto size = data->writer->byteSize();
+        scratch.assign(size, 0);
+        data->writer->write(scratch.data());
+        blob.write(scratch.data(), size);
+        weightsOffset = data->offset + size;
 
-    std::copy(blobBufRelocInfo.begin(), blobBufRelocInfo.end(), reinterpret_cast<mv_reloc_info*>(&blob[curBlobOffset]));
-    curBlobOffset += blobBufRelocInfo.size() * sizeof(mv_reloc_info);
+        data->writer = nullptr;
+    }
+    fill(_blobTotalDataSize - weightsOffset);
 
-    std::copy(blobWorkRelocInfo.begin(), blobWorkRelocInfo.end(), reinterpret_cast<mv_reloc_info*>(&blob[curBlobOffset]));
-    curBlobOffset += blobWorkRelocInfo.size() * sizeof(mv_reloc_info);
+    blob.write(&mvRelocSecHdr, sizeof(mvRelocSecHdr));
+    blob.write(blobBufRelocInfo.data(), blobBufRelocInfo.size() * sizeof(mv_reloc_info));
+    blob.write(blobWorkRelocInfo.data(), blobWorkRelocInfo.size() * sizeof(mv_reloc_info));
 
-    std::copy_n(&stageSecHdr, 1, reinterpret_cast<mv_stage_section_header*>(&blob[curBlobOffset]));
-    curBlobOffset += sizeof(stageSecHdr);
+    blob.write(&stageSecHdr, sizeof(stageSecHdr));
+    blob.write(stagesWriter.stagesData.data(), stagesWriter.stagesData.size());
 
-    std::copy(stagesWriter.stagesData.begin(), stagesWriter.stagesData.end(), &blob[curBlobOffset]);
-    curBlobOffset += stagesWriter.stagesData.size();
+    _profile.blobBytes = blobHdr.file_size;
+    _profile.finalizePeakBytes = scratch.capacity() + stagesWriter.stagesData.capacity()
+                               + (blobBufRelocInfo.capacity() + blobWorkRelocInfo.capacity()) * sizeof(mv_reloc_info);
 
-    LOG_INFO("[VPU] GraphTransformer : blobSize=%u", static_cast<uint32_t>(sizeof(char) * blob.size()));
+    LOG_INFO("[VPU] GraphTransformer : blobSize=%u, finalize held at most %u bytes",
+             static_cast<uint32_t>(blobHdr.file_size), static_cast<uint32_t>(_profile.finalizePeakBytes));
     #ifdef NNLOG
-    ALOGI("[VPU] GraphTransformer : blobSize=%u", static_cast<uint32_t>(sizeof(char) * blob.size()));
+    ALOGI("[VPU] GraphTransformer : blobSize=%u", static_cast<uint32_t>(blobHdr.file_size));
     #endif
 }
 
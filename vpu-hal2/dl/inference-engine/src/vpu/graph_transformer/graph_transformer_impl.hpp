@@ -34,6 +34,7 @@
 
 #include <cassert>
 #include <algorithm>
+#include <chrono>
 #include <memory>
 #include <vector>
 #include <list>
@@ -337,6 +338,9 @@ using VpuStageHandleHash = HandleHash<VpuStage>;
 struct BlobWriter {
     std::vector<char> stagesData;
     std::unordered_map<VpuData*, uint32_t> dataMap;
+    // write 0 for where the data is, which is all that may differ between
+    // the stages of two images
+    bool maskPlacement = false;
 
     template <typename T>
     void write(const T& params) {
@@ -798,11 +802,15 @@ public:
     GraphTransformerImpl(const BlobConfig& blobConfig,
                          const Common::LoggerPtr& log);
 
+    using IGraphTransformer::generate;
+
     void generate(ICNNNetwork& network,
-                  std::vector<char>& blob,
+                  BlobSink& blob,
                   std::vector<BlobMetaData>& metaData,
                   size_t& numStages) override;
 
+    const CompileProfile& profile() const override { return _profile; }
+
 public:
     void parseConvolution(const CNNLayerPtr& layer, const std::vector<VpuDataHandle>& inputs, const std::vector<VpuDataHandle>& outputs);
     void parsePooling(const CNNLayerPtr& layer, const std::vector<VpuDataHandle>& inputs, const std::vector<VpuDataHandle>& outputs);
@@ -857,6 +865,11 @@ private:
 
     void addOutputConvertStages();
 
+    // Runs a pass that adds the stages of one image once per image of the
+    // batch, each time with the data of that image, see selectBatch.
+    void forEachBatch(void (GraphTransformerImpl::*pass)());
+    void selectBatch(size_t batch);
+
     void packPostOps();
     void addHWStages();
     void packHWConcat();
@@ -866,10 +879,13 @@ private:
     void fillHWDescriptors();
     void packMemory();
 
-    void finalize(std::vector<char>& blob);
+    void finalize(BlobSink& blob);
 
     void getMetaData(std::vector<BlobMetaData>& metaData);
 
+    void startProfile();
+    void endPass(const char* name);
+
 private:
     using DataId = const void*;
 
@@ -917,6 +933,16 @@ private:
                      bool isYoloNetwork,
                      bool isOriginalYolo);
 
+    // Estimated time of a convolution run as processHWConv would make it,
+    // infinite if it can't, and on the SHAVEs.
+    float estimateHWConvTime(const VpuStagePtr& stage, uint32_t cmxLimit, bool isYoloNetwork);
+    float estimateSWConvTime(const VpuStagePtr& stage);
+    // The convolutions of candidates the cost model keeps on the SHAVEs.
+    std::unordered_set<VpuStageHandle, VpuStageHandleHash> selectSWConvStages(
+            const std::vector<VpuStagePtr>& candidates,
+            uint32_t cmxLimit,
+            bool isYoloNetwork);
+
     Handle<VpuCopyStage> addCopyStage(const std::string& name,
                                       const CNNLayerPtr& layer,
                                       const VpuDataHandle& inputs,
@@ -966,8 +992,23 @@ private:
     std::unordered_map<DataPtr, DataId> _fp16Ids;
     std::list<std::unique_ptr<char>> _dataIds;
 
+    // Batch > 1 is compiled for one image and the stages repeated for each
+    // image of the batch. The network data of the images not selected are
+    // kept here, _vpuDatasById and _fp16Ids hold those of _curBatch.
+    struct BatchDatas {
+        std::unordered_map<DataId, VpuDataHandle> datasById;
+        std::unordered_map<DataPtr, DataId> fp16Ids;
+    };
+    size_t _batchSize = 1;
+    size_t _curBatch = 0;
+    std::vector<BatchDatas> _batchDatas;
+
     uint32_t _blobTotalDataSize = 0;
     uint32_t _bssMemSize = 0;
+    uint32_t _cmxMemSize = 0;
+
+    CompileProfile _profile;
+    std::chrono::steady_clock::time_point _passStart;
 };
 
 typedef void (GraphTransformerImpl::*parser_t)(const CNNLayerPtr& layer,
@@ -37,6 +37,7 @@
 #include <limits>
 #include <string>
 #include <utility>
+#include <unordered_set>
 
 HwPaddingInfo getPadding(const VpuDims& inDims, const VpuDims& outDims,
                          uint32_t kernelDimX, uint32_t kernelDimY,
@@ -373,6 +374,10 @@ uint32_t estimateHwBufferSize(const VpuDims& dims) {
     return dims[Dim::Z] * strides[Dim::Z];
 }
 
+float estimateSwStreamTime(const HwCostModel& model, uint64_t bytes) {
+    return bytes / model.shaveBytesPerUs;
+}
+
 namespace {
 
 bool isStageNameInList(const std::vector<std::string>& vec, const std::string& name) {
@@ -409,6 +414,32 @@ void GraphTransformerImpl::addHWStages() {
         }
     }
 
+    auto isAllowedOnHW = [this](const VpuStagePtr& stage) {
+        if (!_blobConfig.hwWhiteList.empty()) {
+            if (!isStageNameInList(_blobConfig.hwWhiteList, stage->name))
+                return false;
+        }
+        if (!_blobConfig.hwBlackList.empty()) {
+            if (isStageNameInList(_blobConfig.hwBlackList, stage->name))
+                return false;
+        }
+        return true;
+    };
+
+    // Convolutions estimated faster on the SHAVEs, converts included
+
+    std::unordered_set<VpuStageHandle, VpuStageHandleHash> swConvStages;
+    if (_blobConfig.hwStageSelection == HwStageSelection::CostModel) {
+        std::vector<VpuStagePtr> candidates;
+        for (const auto& stage : _stages) {
+            if (!stage->optimized && isAllowedOnHW(stage) &&
+                (stage->type == kConv || stage->type == kIm2ColConvolution)) {
+                candidates.push_back(stage);
+            }
+        }
+        swConvStages = selectSWConvStages(candidates, cmxLimit, isYoloNetwork);
+    }
+
     for (auto stageIt = _stages.begin(); stageIt != _stages.end(); ++stageIt) {
         auto stage = *stageIt;
         assert(stage != nullptr);
@@ -416,16 +447,12 @@ void GraphTransformerImpl::addHWStages() {
         if (stage->optimized)
             continue;
 
-        if (!_blobConfig.hwWhiteList.empty()) {
-            if (!isStageNameInList(_blobConfig.hwWhiteList, stage->name))
-                continue;
-        }
-        if (!_blobConfig.hwBlackList.empty()) {
-            if (isStageNameInList(_blobConfig.hwBlackList, stage->name))
-                continue;
-        }
+        if (!isAllowedOnHW(stage))
+            continue;
 
         if ((stage->type == kConv) || (stage->type == kIm2ColConvolution)) {
+            if (swConvStages.find(stage) != swConvStages.end())
+                continue;
             processHWConv(stageIt, cmxLimit, isYoloNetwork, isOriginalYolo);
         } else if (stage->type == kFC) {
             processHWFC(stageIt, isYoloNetwork, isOriginalYolo);
@@ -56,6 +56,10 @@ std::vector<TileSoH> heightSolutionWithPooling(int inputSize, int kernelSize, in
 //                     \ a1*x, if x >= t0
 bool isReluPostOp(const VpuStageHandle& postOp);
 
+// The 2x2s2 max pooling a 3x3s1p1 HW convolution can do on the fly, if the
+// convolution output goes only there.
+Handle<VpuPoolStage> findFusedPool(const VpuStagePtr& stage, const std::shared_ptr<VpuConvStage>& swStage);
+
 class HwWeightsWriter : public DataWriter {
 public:
     HwWeightsWriter(const Blob::Ptr& blob,
@@ -102,3 +106,7 @@ private:
 };
 
 uint32_t estimateHwBufferSize(const VpuDims& dims);
+
+// Time the SHAVEs take to move bytes through DDR, in the copy, convert and
+// eltwise stages, without the stage dispatch.
+float estimateSwStreamTime(const HwCostModel& model, uint64_t bytes);
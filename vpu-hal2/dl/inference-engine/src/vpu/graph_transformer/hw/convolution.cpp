@@ -249,8 +249,182 @@ std::tuple<uint32_t, uint32_t, VpuMyriadXHwConvolutionStage::Tiles> splitConvolu
     return std::make_tuple(0, 0, VpuMyriadXHwConvolutionStage::Tiles());
 }
 
+bool isHWConvSupported(const std::shared_ptr<VpuConvStage>& swStage, const std::shared_ptr<ConvolutionLayer>& convLayer) {
+    // HW doesn't support dilation
+    if (swStage->dilationX != 1 || swStage->dilationY != 1)
+        return false;
+
+    // HW supports only same strides for X and Y
+    if (swStage->strideX != swStage->strideY)
+        return false;
+
+    // TODO : what to do with grouped convolution?
+    if (convLayer->_group != 1)
+        return false;
+
+    return true;
+}
+
+// How processHWConv splits the convolution over the output height, none or
+// a single piece if it keeps it whole.
+std::vector<TileSoH> splitHWConvOverHeight(const VpuStagePtr& stage,
+                                           const std::shared_ptr<VpuConvStage>& swStage,
+                                           const VpuDataHandle& actualOutput,
+                                           const VpuMyriadXHwConvolutionStage::Tiles& tiles,
+                                           bool withPool,
+                                           uint32_t cmxLimit,
+                                           bool isYoloNetwork) {
+    auto input = stage->inputs[0];
+    auto output = stage->outputs[0];
+
+    bool splitOverHeight = input->dims[Dim::X] * input->dims[Dim::Y] / 1024.0 > 128;
+
+    if (!splitOverHeight) {
+        auto outBufSize = estimateHwBufferSize(actualOutput->dims);
+        if (outBufSize > cmxLimit)
+            splitOverHeight = true;
+    }
+
+    // HACK : enable split-over-height for YOLO convolutions (conv1, conv2, conv3)
+
+    if (isYoloNetwork &&
+        (stage->name == "conv1" || stage->name == "conv2" || stage->name == "conv3")) {
+        splitOverHeight = true;
+    }
+
+    std::vector<TileSoH> heightSplits;
+
+    if (!splitOverHeight)
+        return heightSplits;
+
+    auto maxOutputLines = output->dims[Dim::Y];
+    if (!tiles.empty()) {
+        auto maxOutputChannelsInDescr = std::numeric_limits<uint32_t>::min();
+        for (const auto& t : tiles) {
+            maxOutputChannelsInDescr = std::max(maxOutputChannelsInDescr, std::get<0>(t));
+        }
+
+        uint32_t bytesPerFullDepthSlice = sizeof(ie_fp16) * maxOutputChannelsInDescr * alignVal(output->dims[Dim::X], 8u);
+
+        maxOutputLines = cmxLimit / bytesPerFullDepthSlice;
+    }
+
+    if (withPool) {
+        // For conv3x3s1p1 and fused 2x2s2 pooling, we need 4 extra lines
+        // Also, for this specific case, the maxOutputLines is doubled, because the output is reduced by a factor of 2
+        heightSplits = heightSolutionWithPooling(
+            input->dims[Dim::Y],
+            swStage->radixY,
+            swStage->strideY,
+            swStage->padY,
+            maxOutputLines);
+    } else {
+        // For convolution without fused pooling
+        // The following is not correct for convolution. We cannot have selective zero padding
+        // pad = (stage.radixY // 2 if pad_top > 0 else 0, stage.radixY // 2 if pad_bottom > 0 else 0)
+
+        if ((swStage->padY == swStage->padX) &&
+            (swStage->padY == 0 || swStage->padY == (swStage->radixY / 2))) {
+            heightSplits = heightSolution(
+                input->dims[Dim::Y],
+                swStage->radixY,
+                swStage->strideY,
+                std::make_tuple(swStage->padY, swStage->padX),
+                maxOutputLines);
+        }
+    }
+
+    return heightSplits;
+}
+
+// Time of the HW stages addHWConv makes for one piece of a convolution,
+// infinite if it can't split it. poolFactor is 2 when the piece pools its
+// output on the fly, the NCE still convolves at the full resolution.
+float estimateHWConvPieceTime(const HwCostModel& model,
+                              uint32_t iX, uint32_t iY, uint32_t iZ,
+                              uint32_t oX, uint32_t oY, uint32_t oZ,
+                              uint32_t kX, uint32_t kY, uint32_t kS,
+                              uint32_t poolFactor) {
+    uint32_t newInputDimZ = 0, newOutputDimZ = 0;
+    VpuMyriadXHwConvolutionStage::Tiles tiles;
+    std::tie(newInputDimZ, newOutputDimZ, tiles)
+            = splitConvolution(iX, iY, iZ, oX, oY, oZ, kX, kY, kS, MODE_FP16, FP16_COEFF);
+
+    uint32_t numInputTiles = 1;
+    if (tiles.empty()) {
+        if (poolFactor != 1)
+            return std::numeric_limits<float>::infinity();
+
+        std::array<uint32_t, 8> TILE_SIZE_CANDIDATES{{512u, 256u, 128u, 64u, 32u, 16u, 8u, 4u}};
+        for (auto curTileSize : TILE_SIZE_CANDIDATES) {
+            if (iZ > curTileSize && iZ % curTileSize == 0) {
+                std::tie(newInputDimZ, newOutputDimZ, tiles)
+                        = splitConvolution(iX, iY, curTileSize, oX, oY, oZ, kX, kY, kS, MODE_FP16, FP16_COEFF);
+                if (newInputDimZ == curTileSize && !tiles.empty()) {
+                    numInputTiles = iZ / curTileSize;
+                    break;
+                }
+                tiles.clear();
+            }
+        }
+        if (tiles.empty())
+            return std::numeric_limits<float>::infinity();
+    }
+
+    // every descriptor reads the whole (Z padded) input and its share of
+    // the weights, and writes its output channels
+    float time = 0.f;
+    uint64_t convOutPixels = static_cast<uint64_t>(oX) * oY * poolFactor * poolFactor;
+    for (const auto& tile : tiles) {
+        uint64_t outChans = std::get<0>(tile);
+        uint64_t macs = convOutPixels * kX * kY * newInputDimZ * outChans;
+        uint64_t bytes = sizeof(ie_fp16) * (static_cast<uint64_t>(iX) * iY * newInputDimZ +
+                                            static_cast<uint64_t>(kX) * kY * newInputDimZ * outChans +
+                                            static_cast<uint64_t>(oX) * oY * outChans);
+        time += std::max(macs / model.hwMacsPerUs, bytes / model.hwBytesPerUs) + model.hwDescriptorUs;
+    }
+    time = numInputTiles * (time + model.hwStageUs);
+
+    // partial sums of the input tiles are added on the SHAVEs
+    uint64_t outBytes = sizeof(ie_fp16) * static_cast<uint64_t>(oX) * oY * oZ;
+    time += (numInputTiles - 1) * (estimateSwStreamTime(model, 3 * outBytes) + model.swStageUs);
+
+    return time;
+}
+
 }  // namespace
 
+// TODO : check which convolution and pooling parameters are supported
+Handle<VpuPoolStage> findFusedPool(const VpuStagePtr& stage, const std::shared_ptr<VpuConvStage>& swStage) {
+    if (swStage->radixX != 3 || swStage->radixY != 3 ||
+        swStage->strideX != 1 || swStage->strideY != 1 ||
+        swStage->padX != 1 || swStage->padY != 1) {
+        return nullptr;
+    }
+
+    auto outputConsumers = stage->outputs[0]->consumers;
+    if (stage->postOp != nullptr)
+        outputConsumers.erase(stage->postOp);
+
+    if (outputConsumers.size() != 1)
+        return nullptr;
+
+    auto nextStage = *outputConsumers.begin();
+    if (nextStage->type != kMaxPool)
+        return nullptr;
+
+    auto postPoolStage = nextStage.dynamicCast<VpuPoolStage>();
+    assert(postPoolStage != nullptr);
+
+    if (postPoolStage->radixX == 2 && postPoolStage->radixY == 2 &&
+        postPoolStage->strideX == 2 && postPoolStage->strideY == 2 &&
+        postPoolStage->padX == 0 && postPoolStage->padY == 0) {
+        return postPoolStage;
+    }
+
+    return nullptr;
+}
+
 void GraphTransformerImpl::addHWConv(const std::list<VpuStagePtr>::iterator& stageIt,
                                      VpuDataHandle input,
                                      VpuDataHandle output,
@@ -693,16 +867,7 @@ void GraphTransformerImpl::processHWConv(
     auto convLayer = std::dynamic_pointer_cast<ConvolutionLayer>(stage->layer);
     assert(convLayer != nullptr);
 
-    // HW doesn't support dilation
-    if (swStage->dilationX != 1 || swStage->dilationY != 1)
-        return;
-
-    // HW supports only same strides for X and Y
-    if (swStage->strideX != swStage->strideY)
-        return;
-
-    // TODO : what to do with grouped convolution?
-    if (convLayer->_group != 1)
+    if (!isHWConvSupported(swStage, convLayer))
         return;
 
     auto input = stage->inputs[0];
@@ -715,34 +880,9 @@ void GraphTransformerImpl::processHWConv(
     std::tie(postOp, biases, hwStageNameSuffix) = getPostOpInfoForHW(stage);
 
     // Try to merge convolution with max pooling
-    // TODO : check which convolution and pooling parameters are supported
 
-    Handle<VpuPoolStage> postPoolStage;
-    auto actualOutput = output;
-    if (swStage->radixX == 3 && swStage->radixY == 3 &&
-        swStage->strideX == 1 && swStage->strideY == 1 &&
-        swStage->padX == 1 && swStage->padY == 1) {
-        auto outputConsumers = output->consumers;
-        if (stage->postOp != nullptr)
-            outputConsumers.erase(stage->postOp);
-
-        if (outputConsumers.size() == 1) {
-            auto nextStage = *outputConsumers.begin();
-
-            if (nextStage->type == kMaxPool) {
-                postPoolStage = nextStage.dynamicCast<VpuPoolStage>();
-                assert(postPoolStage != nullptr);
-
-                if (postPoolStage->radixX == 2 && postPoolStage->radixY == 2 &&
-                    postPoolStage->strideX == 2 && postPoolStage->strideY == 2 &&
-                    postPoolStage->padX == 0 && postPoolStage->padY == 0) {
-                    actualOutput = postPoolStage->outputs[0];
-                } else {
-                    postPoolStage = nullptr;
-                }
-            }
-        }
-    }
+    auto postPoolStage = findFusedPool(stage, swStage);
+    auto actualOutput = postPoolStage != nullptr ? postPoolStage->outputs[0] : output;
 
     uint32_t newInputDimZ = 0, newOutputDimZ = 0;
     VpuMyriadXHwConvolutionStage::Tiles tiles;
@@ -757,21 +897,6 @@ void GraphTransformerImpl::processHWConv(
         actualOutput = output;
     }
 
-    bool splitOverHeight = input->dims[Dim::X] * input->dims[Dim::Y] / 1024.0 > 128;
-
-    if (!splitOverHeight) {
-        auto outBufSize = estimateHwBufferSize(actualOutput->dims);
-        if (outBufSize > cmxLimit)
-            splitOverHeight = true;
-    }
-
-    // HACK : enable split-over-height for YOLO convolutions (conv1, conv2, conv3)
-
-    if (isYoloNetwork &&
-        (stage->name == "conv1" || stage->name == "conv2" || stage->name == "conv3")) {
-        splitOverHeight = true;
-    }
-
     // HACK : scale too small weights in YOLO convolutions (conv8) to avoid FP16 precision errors
 
     auto scale = 1.0f;
@@ -780,185 +905,145 @@ void GraphTransformerImpl::processHWConv(
         scale = 16.0f;
     }
 
-    if (!splitOverHeight) {
+    auto heightSplits = splitHWConvOverHeight(stage, swStage, actualOutput, tiles,
+                                              postPoolStage != nullptr, cmxLimit, isYoloNetwork);
+
+    if (heightSplits.size() <= 1) {
         addHWConv(stageIt, input, actualOutput, scale, postPoolStage);
     } else {
-        auto maxOutputLines = output->dims[Dim::Y];
-        if (!tiles.empty()) {
-            auto maxOutputChannelsInDescr = std::numeric_limits<uint32_t>::min();
-            for (const auto& t : tiles) {
-                maxOutputChannelsInDescr = std::max(maxOutputChannelsInDescr, std::get<0>(t));
-            }
-
-            uint32_t bytesPerFullDepthSlice = sizeof(ie_fp16) * maxOutputChannelsInDescr * alignVal(output->dims[Dim::X], 8u);
-
-            maxOutputLines = cmxLimit / bytesPerFullDepthSlice;
-        }
-
-        std::vector<TileSoH> heightSplits;
+        actualOutput->producer = nullptr;
+        actualOutput->producerOutInd = -1;
+
+        std::vector<VpuDataHandle> copyInputs;
+        std::vector<VpuDataHandle> copyOutputs;
+
+        int tileInd = 0;
+        for (const auto& heightSplitSol : heightSplits) {
+            int inputWithJunk, outputWithJunk;
+            int outputJunkBefore, outputJunkAfter;
+            int inputStartIndex, inputEndIndex;
+            int outputStartIndex, outputEndIndex;
+            std::tie(inputWithJunk, outputWithJunk,
+                     outputJunkBefore, outputJunkAfter,
+                     inputStartIndex, inputEndIndex,
+                     outputStartIndex, outputEndIndex) =
+                heightSplitSol;
 
-        if (postPoolStage != nullptr) {
-            // For conv3x3s1p1 and fused 2x2s2 pooling, we need 4 extra lines
-            // Also, for this specific case, the maxOutputLines is doubled, because the output is reduced by a factor of 2
-            heightSplits = heightSolutionWithPooling(
-                input->dims[Dim::Y],
-                swStage->radixY,
-                swStage->strideY,
-                swStage->padY,
-                maxOutputLines);
-        } else {
-            // For convolution without fused pooling
-            // The following is not correct for convolution. We cannot have selective zero padding
-            // pad = (stage.radixY // 2 if pad_top > 0 else 0, stage.radixY // 2 if pad_bottom > 0 else 0)
-
-            if ((swStage->padY == swStage->padX) &&
-                (swStage->padY == 0 || swStage->padY == (swStage->radixY / 2))) {
-                heightSplits = heightSolution(
-                    input->dims[Dim::Y],
-                    swStage->radixY,
-                    swStage->strideY,
-                    std::make_tuple(swStage->padY, swStage->padX),
-                    maxOutputLines);
-            }
-        }
+            auto subInput = addNewData(
+                newDataId(),
+                [input, inputWithJunk, inputStartIndex, tileInd](VpuData* data) {
+                    data->name = input->name + "@sub" + std::to_string(tileInd);
+                    data->index = input->index;
+                    data->type = input->type;
+                    data->order = input->order;
+                    data->dims = VpuDims({input->dims[Dim::X], static_cast<uint32_t>(inputWithJunk), input->dims[Dim::Z]});
+                    data->strides = input->strides;
+                    data->offsetFromParent = VpuDims({0u, static_cast<uint32_t>(inputStartIndex), 0u});
+                },
+                input);
 
-        if (heightSplits.empty() || heightSplits.size() == 1) {
-            addHWConv(stageIt, input, actualOutput, scale, postPoolStage);
-        } else {
-            actualOutput->producer = nullptr;
-            actualOutput->producerOutInd = -1;
-
-            std::vector<VpuDataHandle> copyInputs;
-            std::vector<VpuDataHandle> copyOutputs;
-
-            int tileInd = 0;
-            for (const auto& heightSplitSol : heightSplits) {
-                int inputWithJunk, outputWithJunk;
-                int outputJunkBefore, outputJunkAfter;
-                int inputStartIndex, inputEndIndex;
-                int outputStartIndex, outputEndIndex;
-                std::tie(inputWithJunk, outputWithJunk,
-                         outputJunkBefore, outputJunkAfter,
-                         inputStartIndex, inputEndIndex,
-                         outputStartIndex, outputEndIndex) =
-                    heightSplitSol;
-
-                auto subInput = addNewData(
+            if (outputJunkBefore == 0 && outputJunkAfter == 0) {
+                auto subOutput = addNewData(
                     newDataId(),
-                    [input, inputWithJunk, inputStartIndex, tileInd](VpuData* data) {
-                        data->name = input->name + "@sub" + std::to_string(tileInd);
-                        data->index = input->index;
-                        data->type = input->type;
-                        data->order = input->order;
-                        data->dims = VpuDims({input->dims[Dim::X], static_cast<uint32_t>(inputWithJunk), input->dims[Dim::Z]});
-                        data->strides = input->strides;
-                        data->offsetFromParent = VpuDims({0u, static_cast<uint32_t>(inputStartIndex), 0u});
+                    [actualOutput, outputWithJunk, outputStartIndex, tileInd](VpuData* data) {
+                        data->name = actualOutput->name + "@sub" + std::to_string(tileInd);
+                        data->index = actualOutput->index;
+                        data->type = actualOutput->type;
+                        data->order = actualOutput->order;
+                        data->dims = VpuDims({actualOutput->dims[Dim::X], static_cast<uint32_t>(outputWithJunk), actualOutput->dims[Dim::Z]});
+                        data->strides = actualOutput->strides;
+                        data->offsetFromParent = VpuDims({0u, static_cast<uint32_t>(outputStartIndex), 0u});
                     },
-                    input);
-
-                if (outputJunkBefore == 0 && outputJunkAfter == 0) {
-                    auto subOutput = addNewData(
-                        newDataId(),
-                        [actualOutput, outputWithJunk, outputStartIndex, tileInd](VpuData* data) {
-                            data->name = actualOutput->name + "@sub" + std::to_string(tileInd);
-                            data->index = actualOutput->index;
-                            data->type = actualOutput->type;
-                            data->order = actualOutput->order;
-                            data->dims = VpuDims({actualOutput->dims[Dim::X], static_cast<uint32_t>(outputWithJunk), actualOutput->dims[Dim::Z]});
-                            data->strides = actualOutput->strides;
-                            data->offsetFromParent = VpuDims({0u, static_cast<uint32_t>(outputStartIndex), 0u});
-                        },
-                        actualOutput);
-
-                    if (copyInputs.empty() || copyInputs.back() == nullptr) {
-                        addHWConv(stageIt, subInput, subOutput, scale, postPoolStage,
-                                  tileInd == heightSplits.size() - 1u,
-                                  "@soh" + std::to_string(tileInd),
-                                  nullptr, nullptr);
-                    } else {
-                        addHWConv(stageIt, subInput, subOutput, scale, postPoolStage,
-                                  tileInd == heightSplits.size() - 1u,
-                                  "@soh" + std::to_string(tileInd),
-                                  copyInputs.back(), copyOutputs.back());
-                    }
+                    actualOutput);
 
-                    copyInputs.push_back(nullptr);
-                    copyOutputs.push_back(nullptr);
+                if (copyInputs.empty() || copyInputs.back() == nullptr) {
+                    addHWConv(stageIt, subInput, subOutput, scale, postPoolStage,
+                              tileInd == heightSplits.size() - 1u,
+                              "@soh" + std::to_string(tileInd),
+                              nullptr, nullptr);
                 } else {
-                    auto subConvOutput = addNewData(
-                        newDataId(),
-                        [actualOutput, outputWithJunk, tileInd](VpuData* data) {
-                            data->name = actualOutput->name + "@subConv" + std::to_string(tileInd);
-                            data->index = IndexBSS;
-                            data->type = actualOutput->type;
-                            data->order = orderZYX;
-                            data->dims = VpuDims({actualOutput->dims[Dim::X], static_cast<uint32_t>(outputWithJunk), actualOutput->dims[Dim::Z]});
-                            data->strides = calcStrides(data->dims, data->type, data->order, 16u);
-                        });
+                    addHWConv(stageIt, subInput, subOutput, scale, postPoolStage,
+                              tileInd == heightSplits.size() - 1u,
+                              "@soh" + std::to_string(tileInd),
+                              copyInputs.back(), copyOutputs.back());
+                }
 
-                    auto subConvOutputInner = addNewData(
-                        newDataId(),
-                        [subConvOutput, outputJunkBefore, outputStartIndex, outputEndIndex](VpuData* data) {
-                            data->name = subConvOutput->name + "@inner";
-                            data->index = subConvOutput->index;
-                            data->type = subConvOutput->type;
-                            data->order = subConvOutput->order;
-                            uint32_t outTileHeight = outputEndIndex - outputStartIndex;
-                            data->dims = VpuDims({subConvOutput->dims[Dim::X], outTileHeight, subConvOutput->dims[Dim::Z]});
-                            data->strides = subConvOutput->strides;
-                            data->offsetFromParent = VpuDims({0u, static_cast<uint32_t>(outputJunkBefore), 0u});
-                        },
-                        subConvOutput);
+                copyInputs.push_back(nullptr);
+                copyOutputs.push_back(nullptr);
+            } else {
+                auto subConvOutput = addNewData(
+                    newDataId(),
+                    [actualOutput, outputWithJunk, tileInd](VpuData* data) {
+                        data->name = actualOutput->name + "@subConv" + std::to_string(tileInd);
+                        data->index = IndexBSS;
+                        data->type = actualOutput->type;
+                        data->order = orderZYX;
+                        data->dims = VpuDims({actualOutput->dims[Dim::X], static_cast<uint32_t>(outputWithJunk), actualOutput->dims[Dim::Z]});
+                        data->strides = calcStrides(data->dims, data->type, data->order, 16u);
+                    });
+
+                auto subConvOutputInner = addNewData(
+                    newDataId(),
+                    [subConvOutput, outputJunkBefore, outputStartIndex, outputEndIndex](VpuData* data) {
+                        data->name = subConvOutput->name + "@inner";
+                        data->index = subConvOutput->index;
+                        data->type = subConvOutput->type;
+                        data->order = subConvOutput->order;
+                        uint32_t outTileHeight = outputEndIndex - outputStartIndex;
+                        data->dims = VpuDims({subConvOutput->dims[Dim::X], outTileHeight, subConvOutput->dims[Dim::Z]});
+                        data->strides = subConvOutput->strides;
+                        data->offsetFromParent = VpuDims({0u, static_cast<uint32_t>(outputJunkBefore), 0u});
+                    },
+                    subConvOutput);
 
-                    auto subOutput = addNewData(
-                        newDataId(),
-                        [actualOutput, subConvOutputInner, outputStartIndex, tileInd](VpuData* data) {
-                            data->name = actualOutput->name + "@sub" + std::to_string(tileInd);
-                            data->index = actualOutput->index;
-                            data->type = actualOutput->type;
-                            data->order = actualOutput->order;
-                            data->dims = VpuDims({actualOutput->dims[Dim::X], subConvOutputInner->dims[Dim::Y], actualOutput->dims[Dim::Z]});
-                            data->strides = actualOutput->strides;
-                            data->offsetFromParent = VpuDims({0u, static_cast<uint32_t>(outputStartIndex), 0u});
-                        },
-                        actualOutput);
-
-                    if (copyInputs.empty() || copyInputs.back() == nullptr) {
-                        addHWConv(stageIt, subInput, subConvOutput, scale, postPoolStage,
-                                  tileInd == heightSplits.size() - 1u,
-                                  "@soh" + std::to_string(tileInd),
-                                  nullptr, nullptr);
-                    } else {
-                        addHWConv(stageIt, subInput, subConvOutput, scale, postPoolStage,
-                                  tileInd == heightSplits.size() - 1u,
-                                  "@soh" + std::to_string(tileInd),
-                                  copyInputs.back(), copyOutputs.back());
-                    }
+                auto subOutput = addNewData(
+                    newDataId(),
+                    [actualOutput, subConvOutputInner, outputStartIndex, tileInd](VpuData* data) {
+                        data->name = actualOutput->name + "@sub" + std::to_string(tileInd);
+                        data->index = actualOutput->index;
+                        data->type = actualOutput->type;
+                        data->order = actualOutput->order;
+                        data->dims = VpuDims({actualOutput->dims[Dim::X], subConvOutputInner->dims[Dim::Y], actualOutput->dims[Dim::Z]});
+                        data->strides = actualOutput->strides;
+                        data->offsetFromParent = VpuDims({0u, static_cast<uint32_t>(outputStartIndex), 0u});
+                    },
+                    actualOutput);
 
-                    copyInputs.push_back(subConvOutputInner);
-                    copyOutputs.push_back(subOutput);
+                if (copyInputs.empty() || copyInputs.back() == nullptr) {
+                    addHWConv(stageIt, subInput, subConvOutput, scale, postPoolStage,
+                              tileInd == heightSplits.size() - 1u,
+                              "@soh" + std::to_string(tileInd),
+                              nullptr, nullptr);
+                } else {
+                    addHWConv(stageIt, subInput, subConvOutput, scale, postPoolStage,
+                              tileInd == heightSplits.size() - 1u,
+                              "@soh" + std::to_string(tileInd),
+                              copyInputs.back(), copyOutputs.back());
                 }
 
-                ++tileInd;
+                copyInputs.push_back(subConvOutputInner);
+                copyOutputs.push_back(subOutput);
             }
 
-            if (!copyInputs.empty() && copyInputs.back() != nullptr) {
-                addNewStage<VpuCopyStage>(
-                    stage->name + "@copy",
-                    kCopyMakeBorderCHW,
-                    stage->layer,
-                    [](VpuCopyStage* stage) {
-                        stage->requiredInputOrder[0] = orderZYX;
-                        stage->requiredInputAlignment[0] = 16u;
+            ++tileInd;
+        }
 
-                        stage->requiredOutputOrder[0] = orderZYX;
-                        stage->requiredOutputAlignment[0] = 16u;
-                    },
-                    {copyInputs.back()},
-                    {copyOutputs.back()},
-                    nullptr,
-                    &stageIt);
-            }
+        if (!copyInputs.empty() && copyInputs.back() != nullptr) {
+            addNewStage<VpuCopyStage>(
+                stage->name + "@copy",
+                kCopyMakeBorderCHW,
+                stage->layer,
+                [](VpuCopyStage* stage) {
+                    stage->requiredInputOrder[0] = orderZYX;
+                    stage->requiredInputAlignment[0] = 16u;
+
+                    stage->requiredOutputOrder[0] = orderZYX;
+                    stage->requiredOutputAlignment[0] = 16u;
+                },
+                {copyInputs.back()},
+                {copyOutputs.back()},
+                nullptr,
+                &stageIt);
         }
     }
 
@@ -974,3 +1059,125 @@ void GraphTransformerImpl::processHWConv(
         postPoolStage->optimized = true;
     }
 }
+
+float GraphTransformerImpl::estimateHWConvTime(const VpuStagePtr& stage, uint32_t cmxLimit, bool isYoloNetwork) {
+    auto swStage = std::dynamic_pointer_cast<VpuConvStage>(stage);
+    assert(swStage != nullptr);
+
+    auto convLayer = std::dynamic_pointer_cast<ConvolutionLayer>(stage->layer);
+    assert(convLayer != nullptr);
+
+    if (!isHWConvSupported(swStage, convLayer))
+        return std::numeric_limits<float>::infinity();
+
+    const auto& model = _blobConfig.hwCostModel;
+    auto input = stage->inputs[0];
+    auto output = stage->outputs[0];
+
+    // the pieces processHWConv would make
+
+    auto postPoolStage = findFusedPool(stage, swStage);
+    auto actualOutput = postPoolStage != nullptr ? postPoolStage->outputs[0] : output;
+
+    uint32_t newInputDimZ = 0, newOutputDimZ = 0;
+    VpuMyriadXHwConvolutionStage::Tiles tiles;
+    std::tie(newInputDimZ, newOutputDimZ, tiles)
+            = splitConvolution(input->dims[Dim::X], input->dims[Dim::Y], input->dims[Dim::Z],
+                               actualOutput->dims[Dim::X], actualOutput->dims[Dim::Y], actualOutput->dims[Dim::Z],
+                               swStage->radixX, swStage->radixY, swStage->strideX,
+                               MODE_FP16, FP16_COEFF);
+
+    if (tiles.empty()) {
+        postPoolStage = nullptr;
+        actualOutput = output;
+    }
+
+    auto heightSplits = splitHWConvOverHeight(stage, swStage, actualOutput, tiles,
+                                              postPoolStage != nullptr, cmxLimit, isYoloNetwork);
+    if (heightSplits.size() <= 1) {
+        heightSplits.assign(1, std::make_tuple(static_cast<int>(input->dims[Dim::Y]),
+                                               static_cast<int>(actualOutput->dims[Dim::Y]),
+                                               0, 0, 0, 0, 0, 0));
+    }
+
+    // 1x1s1 with padding gets its input padded by a copy first
+    bool padsWithCopy = swStage->radixX == 1 && swStage->radixY == 1 &&
+                        swStage->strideX == 1 && swStage->strideY == 1 &&
+                        (swStage->padX != 0 || swStage->padY != 0);
+
+    float time = 0.f;
+    bool hasJunk = false;
+    for (const auto& split : heightSplits) {
+        int inputWithJunk, outputWithJunk, outputJunkBefore, outputJunkAfter;
+        std::tie(inputWithJunk, outputWithJunk, outputJunkBefore, outputJunkAfter,
+                 std::ignore, std::ignore, std::ignore, std::ignore) = split;
+
+        uint32_t iX = input->dims[Dim::X];
+        uint32_t iY = inputWithJunk;
+        if (padsWithCopy) {
+            iX = output->dims[Dim::X];
+            time += estimateSwStreamTime(model, 2 * sizeof(ie_fp16) * iX * iY * input->dims[Dim::Z]) + model.swStageUs;
+        }
+
+        time += estimateHWConvPieceTime(model,
+                                        iX, iY, input->dims[Dim::Z],
+                                        actualOutput->dims[Dim::X], outputWithJunk, actualOutput->dims[Dim::Z],
+                                        swStage->radixX, swStage->radixY, swStage->strideX,
+                                        postPoolStage != nullptr ? 2 : 1);
+        hasJunk = hasJunk || outputJunkBefore != 0 || outputJunkAfter != 0;
+    }
+
+    // the junk lines are cut off by copies, all but the last one run along
+    // the next HW stage
+    if (hasJunk) {
+        uint64_t outBytes = sizeof(ie_fp16) * static_cast<uint64_t>(actualOutput->dims[Dim::X]) *
+                            actualOutput->dims[Dim::Y] * actualOutput->dims[Dim::Z];
+        time += estimateSwStreamTime(model, 2 * outBytes) + model.swStageUs;
+    }
+
+    return time;
+}
+
+float GraphTransformerImpl::estimateSWConvTime(const VpuStagePtr& stage) {
+    auto swStage = std::dynamic_pointer_cast<VpuConvStage>(stage);
+    assert(swStage != nullptr);
+
+    auto convLayer = std::dynamic_pointer_cast<ConvolutionLayer>(stage->layer);
+    assert(convLayer != nullptr);
+
+    const auto& model = _blobConfig.hwCostModel;
+    auto input = stage->inputs[0];
+    auto output = stage->outputs[0];
+
+    uint64_t group = convLayer->_group;
+    uint64_t inSize = static_cast<uint64_t>(input->dims[Dim::X]) * input->dims[Dim::Y] * input->dims[Dim::Z];
+    uint64_t outPixels = static_cast<uint64_t>(output->dims[Dim::X]) * output->dims[Dim::Y];
+    uint64_t outSize = outPixels * output->dims[Dim::Z];
+    uint64_t kernelSize = static_cast<uint64_t>(swStage->radixX) * swStage->radixY * input->dims[Dim::Z] / group;
+
+    uint64_t macs = outSize * kernelSize;
+    uint64_t bytes = sizeof(ie_fp16) * (inSize + outSize + kernelSize * output->dims[Dim::Z]);
+
+    float macsPerUs = model.shaveMacsPerUs * (_blobConfig.lastShave - _blobConfig.firstShave + 1);
+    if (stage->type == kIm2ColConvolution) {
+        // the im2col buffer is written and read back
+        bytes += 2 * sizeof(ie_fp16) * outPixels * kernelSize * group;
+        macsPerUs *= model.im2colEfficiency;
+    }
+
+    float time = std::max(macs / macsPerUs, bytes / model.shaveBytesPerUs) + model.swStageUs;
+
+    // the post-op is one more pass over the output
+    if (stage->postOp != nullptr)
+        time += estimateSwStreamTime(model, 2 * sizeof(ie_fp16) * outSize);
+
+    // and the pooling the HW would do on the fly a stage of its own
+    auto postPoolStage = findFusedPool(stage, swStage);
+    if (postPoolStage != nullptr) {
+        auto pooled = postPoolStage->outputs[0];
+        uint64_t pooledSize = static_cast<uint64_t>(pooled->dims[Dim::X]) * pooled->dims[Dim::Y] * pooled->dims[Dim::Z];
+        time += estimateSwStreamTime(model, sizeof(ie_fp16) * (outSize + pooledSize)) + model.swStageUs;
+    }
+
+    return time;
+}
@@ -0,0 +1,245 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2018 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+//
+
+#include "common.hpp"
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+// Convolutions each feeding only the next one. The HW works in ZYX order
+// and the SHAVE kernels in YXZ, so every link between the two, the chain
+// input and its output included, costs a convert of the data.
+struct ConvChain {
+    std::vector<VpuStageHandle> stages;
+    std::vector<float> hwUs;
+    std::vector<float> swUs;
+    std::vector<float> inputConvertUs;  // of the data into each convolution
+    bool inputIsZYX = false;
+    float outputConvertUs = 0.f;
+    bool outputToZYX = false;           // some consumer of the chain output wants ZYX
+    bool outputToYXZ = false;           // some wants YXZ
+};
+
+float nodeTime(const ConvChain& chain, size_t i, bool hw, float swMargin) {
+    return hw ? chain.hwUs[i] : chain.swUs[i] * (1.f + swMargin);
+}
+
+float chainTime(const ConvChain& chain, const std::vector<bool>& hw) {
+    float time = 0.f;
+    for (size_t i = 0; i < chain.stages.size(); i++) {
+        bool prevZYX = i == 0 ? chain.inputIsZYX : hw[i - 1];
+        time += nodeTime(chain, i, hw[i], 0.f) + (prevZYX != hw[i] ? chain.inputConvertUs[i] : 0.f);
+    }
+    bool lastHw = hw.back();
+    if ((lastHw && chain.outputToYXZ) || (!lastHw && chain.outputToZYX))
+        time += chain.outputConvertUs;
+    return time;
+}
+
+// The cheapest HW/SW assignment of the chain, by dynamic programming over
+// the two orders the data between consecutive convolutions can be in.
+std::vector<bool> cheapestAssignment(const ConvChain& chain, float swMargin) {
+    auto n = chain.stages.size();
+    std::vector<std::array<float, 2>> cost(n);
+    std::vector<std::array<bool, 2>> fromHw(n);
+
+    for (size_t i = 0; i < n; i++) {
+        for (int hw = 0; hw < 2; hw++) {
+            float best;
+            if (i == 0) {
+                best = chain.inputIsZYX != static_cast<bool>(hw) ? chain.inputConvertUs[0] : 0.f;
+                fromHw[i][hw] = chain.inputIsZYX;
+            } else {
+                float viaSw = cost[i - 1][0] + (hw ? chain.inputConvertUs[i] : 0.f);
+                float viaHw = cost[i - 1][1] + (hw ? 0.f : chain.inputConvertUs[i]);
+                best = std::min(viaSw, viaHw);
+                fromHw[i][hw] = viaHw < viaSw;
+            }
+            cost[i][hw] = best + nodeTime(chain, i, hw, swMargin);
+        }
+    }
+
+    float endSw = cost[n - 1][0] + (chain.outputToZYX ? chain.outputConvertUs : 0.f);
+    float endHw = cost[n - 1][1] + (chain.outputToYXZ ? chain.outputConvertUs : 0.f);
+
+    std::vector<bool> hw(n);
+    hw[n - 1] = endHw < endSw;
+    for (size_t i = n - 1; i > 0; i--) {
+        hw[i - 1] = fromHw[i][hw[i]];
+    }
+    return hw;
+}
+
+float convertTime(const HwCostModel& model, const VpuDataHandle& data) {
+    uint64_t bytes = sizeof(ie_fp16) * static_cast<uint64_t>(data->dims[Dim::X]) * data->dims[Dim::Y] * data->dims[Dim::Z];
+    return estimateSwStreamTime(model, 2 * bytes) + model.swStageUs;
+}
+
+// Pools and fully connected layers go to the HW along with the convolutions.
+bool isHwCapableStage(const VpuStageHandle& stage) {
+    return stage->type == kMaxPool || stage->type == kAvgPool || stage->type == kFC;
+}
+
+}  // namespace
+
+std::unordered_set<VpuStageHandle, VpuStageHandleHash> GraphTransformerImpl::selectSWConvStages(
+        const std::vector<VpuStagePtr>& candidates,
+        uint32_t cmxLimit,
+        bool isYoloNetwork) {
+    const auto& model = _blobConfig.hwCostModel;
+
+    std::unordered_map<VpuStageHandle, size_t, VpuStageHandleHash> indexOf;
+    std::vector<VpuDataHandle> outputs(candidates.size());
+    std::vector<float> hwUs(candidates.size()), swUs(candidates.size());
+    for (size_t i = 0; i < candidates.size(); i++) {
+        const auto& stage = candidates[i];
+        indexOf[stage] = i;
+        hwUs[i] = estimateHWConvTime(stage, cmxLimit, isYoloNetwork);
+        swUs[i] = estimateSWConvTime(stage);
+
+        // the result of the pooling the HW takes along
+        auto postPoolStage = findFusedPool(stage, std::dynamic_pointer_cast<VpuConvStage>(stage));
+        outputs[i] = postPoolStage != nullptr ? postPoolStage->outputs[0] : stage->outputs[0];
+    }
+
+    // -1 undecided, the heuristic is assumed for those
+    std::vector<int> decided(candidates.size(), -1);
+    auto runsOnHw = [&](const VpuStageHandle& stage) {
+        auto it = indexOf.find(stage);
+        if (it != indexOf.end()) {
+            if (decided[it->second] >= 0)
+                return decided[it->second] == 1;
+            return hwUs[it->second] < std::numeric_limits<float>::infinity();
+        }
+        return isHwCapableStage(stage);
+    };
+
+    // the stages reading data, its post-ops aside, which run in its producer
+    auto consumersOf = [](const VpuDataHandle& data) {
+        std::vector<VpuStageHandle> consumers;
+        auto parent = getDataTopParent(data);
+        auto add = [&consumers](const VpuDataHandle& d) {
+            for (const auto& consumer : d->consumers) {
+                if (!consumer->optimized && consumer->parentOp == nullptr)
+                    consumers.push_back(consumer);
+            }
+        };
+        add(parent);
+        loopOverSubData(parent, add);
+        return consumers;
+    };
+
+    std::vector<int> next(candidates.size(), -1);
+    std::vector<bool> hasPrev(candidates.size(), false);
+    for (size_t i = 0; i < candidates.size(); i++) {
+        if (outputs[i]->parent != nullptr || outputs[i]->index == IndexOutput)
+            continue;
+        auto consumers = consumersOf(outputs[i]);
+        if (consumers.size() != 1)
+            continue;
+        auto it = indexOf.find(consumers[0]);
+        if (it != indexOf.end() && candidates[it->second]->inputs[0] == outputs[i]) {
+            next[i] = it->second;
+            hasPrev[it->second] = true;
+        }
+    }
+
+    std::unordered_set<VpuStageHandle, VpuStageHandleHash> swStages;
+    _profile.hwStages.clear();
+    _profile.defaultPlanUs = 0.f;
+    _profile.chosenPlanUs = 0.f;
+
+    for (size_t head = 0; head < candidates.size(); head++) {
+        if (hasPrev[head])
+            continue;
+
+        ConvChain chain;
+        std::vector<size_t> members;
+        for (int i = static_cast<int>(head); i >= 0; i = next[i]) {
+            members.push_back(i);
+            chain.stages.push_back(candidates[i]);
+            chain.hwUs.push_back(hwUs[i]);
+            chain.swUs.push_back(swUs[i]);
+            chain.inputConvertUs.push_back(convertTime(model, candidates[i]->inputs[0]));
+        }
+
+        auto input = candidates[head]->inputs[0];
+        auto producer = input->producer;
+        if (producer != nullptr && producer->parentOp != nullptr)
+            producer = producer->parentOp;
+        chain.inputIsZYX = producer != nullptr ? runsOnHw(producer) : input->order == orderZYX;
+
+        auto output = outputs[members.back()];
+        chain.outputConvertUs = convertTime(model, output);
+        for (const auto& consumer : consumersOf(output)) {
+            (runsOnHw(consumer) ? chain.outputToZYX : chain.outputToYXZ) = true;
+        }
+        if (output->index == IndexOutput) {
+            (output->order == orderZYX ? chain.outputToZYX : chain.outputToYXZ) = true;
+        }
+
+        std::vector<bool> defaultHw(members.size());
+        for (size_t k = 0; k < members.size(); k++) {
+            defaultHw[k] = hwUs[members[k]] < std::numeric_limits<float>::infinity();
+        }
+        auto chosenHw = cheapestAssignment(chain, model.swMargin);
+
+        _profile.defaultPlanUs += chainTime(chain, defaultHw);
+        _profile.chosenPlanUs += chainTime(chain, chosenHw);
+
+        for (size_t k = 0; k < members.size(); k++) {
+            auto i = members[k];
+            decided[i] = chosenHw[k];
+            if (!chosenHw[k])
+                swStages.insert(candidates[i]);
+
+            _profile.hwStages.push_back({candidates[i]->name, defaultHw[k], chosenHw[k], hwUs[i], swUs[i]});
+
+            if (chosenHw[k] != defaultHw[k]) {
+                LOG_INFO("[VPU] GraphTransformer : %s stays on SHAVEs, estimated %.1f us against %.1f us on HW",
+                         candidates[i]->name.c_str(), swUs[i], hwUs[i]);
+            }
+        }
+    }
+
+    LOG_INFO("[VPU] GraphTransformer : %u of %u convolutions on HW, estimated %.1f us, %.1f us with the heuristic",
+             static_cast<uint32_t>(candidates.size() - swStages.size()), static_cast<uint32_t>(candidates.size()),
+             _profile.chosenPlanUs, _profile.defaultPlanUs);
+
+    return swStages;
+}
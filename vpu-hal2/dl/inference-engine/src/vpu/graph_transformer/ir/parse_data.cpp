@@ -32,33 +32,50 @@
 
 #include "graph_transformer_impl.hpp"
 
+namespace {
+
+// the data of the other images of a batch get their index in the name
+std::string batchDataName(const std::string& name, size_t batch) {
+    return batch == 0 ? name : name + "@batch" + std::to_string(batch);
+}
+
+t_MvTensorStorageOrder ioOrder(Layout layout, bool hwOptimization) {
+    return deviceLayout(layout, hwOptimization) == NCHW ? orderZYX : orderYXZ;
+}
+
+}  // namespace
+
+// With batch > 1 the network inputs and outputs are one data per image, one
+// after the other, as the images are in the blob the plugin sends. Each is
+// in the order of its deviceLayout, addConvertOrderStages reorders it on the
+// device where the stages want the other one.
 void GraphTransformerImpl::parseInputAndOutputData() {
     uint32_t inputOffset = 0;
     for (const auto& inputInfo : _networkInputs) {
         auto netInput = inputInfo.second;
         assert(netInput != nullptr);
 
-        auto input = addNewData(
-            dataId(netInput->getInputData()),
-            [netInput, inputOffset, this](VpuData* data) {
-                data->name = netInput->name();
-                data->index = IndexInput;
-                data->type = iePrecisionToVpu(netInput->getInputPrecision());
-                data->dims = ieDimsToVpu(netInput->getTensorDesc().getDims());
-                data->offset = inputOffset;
-                if (_blobConfig.hwOptimization) {
-                    data->order = orderZYX;
-                } else {
-                    data->order = orderYXZ;
-                }
-                data->strides = calcStrides(data->dims, data->type, data->order);
-            });
-
-        if (input == nullptr) {
-            THROW_IE_EXCEPTION << "GraphTransformerV2::parseInputAndOutputData(). Could not add new data";
-        }
+        for (size_t batch = 0; batch < _batchSize; batch++) {
+            selectBatch(batch);
+
+            auto input = addNewData(
+                dataId(netInput->getInputData()),
+                [netInput, inputOffset, batch, this](VpuData* data) {
+                    data->name = batchDataName(netInput->name(), batch);
+                    data->index = IndexInput;
+                    data->type = iePrecisionToVpu(netInput->getInputPrecision());
+                    data->dims = ieDimsToVpu(netInput->getTensorDesc().getDims());
+                    data->offset = inputOffset;
+                    data->order = ioOrder(netInput->getTensorDesc().getLayout(), _blobConfig.hwOptimization);
+                    data->strides = calcStrides(data->dims, data->type, data->order);
+                });
+
+            if (input == nullptr) {
+                THROW_IE_EXCEPTION << "GraphTransformerV2::parseInputAndOutputData(). Could not add new data";
+            }
 
-        inputOffset += input->dims.totalSize() * getDataTypeSize(input->type);
+            inputOffset += input->dims.totalSize() * getDataTypeSize(input->type);
+        }
     }
 
     uint32_t outputOffset = 0;
@@ -66,22 +83,48 @@ void GraphTransformerImpl::parseInputAndOutputData() {
         auto netOutput = outputInfo.second;
         assert(netOutput != nullptr);
 
-        auto output = addNewData(
-            dataId(netOutput),
-            [netOutput, outputOffset, this](VpuData* data) {
-                data->name = netOutput->getName();
-                data->index = IndexOutput;
-                data->type = iePrecisionToVpu(netOutput->getPrecision());
-                data->dims = ieDimsToVpu(netOutput->getDims());
-                if (_blobConfig.hwOptimization) {
-                    data->order = orderZYX;
-                } else {
-                    data->order = orderYXZ;
-                }
-                data->strides = calcStrides(data->dims, data->type, data->order);
-                data->offset = outputOffset;
-            });
-
-        outputOffset += output->dims.totalSize() * getDataTypeSize(output->type);
+        for (size_t batch = 0; batch < _batchSize; batch++) {
+            selectBatch(batch);
+
+            auto output = addNewData(
+                dataId(netOutput),
+                [netOutput, outputOffset, batch, this](VpuData* data) {
+                    data->name = batchDataName(netOutput->getName(), batch);
+                    data->index = IndexOutput;
+                    data->type = iePrecisionToVpu(netOutput->getPrecision());
+                    data->dims = ieDimsToVpu(netOutput->getDims());
+                    data->order = ioOrder(netOutput->getLayout(), _blobConfig.hwOptimization);
+                    data->strides = calcStrides(data->dims, data->type, data->order);
+                    data->offset = outputOffset;
+                });
+
+            outputOffset += output->dims.totalSize() * getDataTypeSize(output->type);
+        }
+    }
+    selectBatch(0);
+}
+
+void GraphTransformerImpl::forEachBatch(void (GraphTransformerImpl::*pass)()) {
+    for (size_t batch = 0; batch < _batchSize; batch++) {
+        selectBatch(batch);
+        (this->*pass)();
     }
+    selectBatch(0);
+}
+
+void GraphTransformerImpl::selectBatch(size_t batch) {
+    if (batch == _curBatch)
+        return;
+
+    assert(batch < _batchDatas.size());
+
+    auto& prev = _batchDatas[_curBatch];
+    prev.datasById = std::move(_vpuDatasById);
+    prev.fp16Ids = std::move(_fp16Ids);
+
+    auto& next = _batchDatas[batch];
+    _vpuDatasById = std::move(next.datasById);
+    _fp16Ids = std::move(next.fp16Ids);
+
+    _curBatch = batch;
 }
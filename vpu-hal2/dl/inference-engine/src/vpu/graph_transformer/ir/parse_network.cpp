@@ -54,6 +54,10 @@ void GraphTransformerImpl::parseNetwork(ICNNNetwork& network) {
     network.getInputsInfo(_networkInputs);
     network.getOutputsInfo(_networkOutputs);
 
+    _batchSize = 1;
+    _curBatch = 0;
+    _batchDatas.clear();
+
     // Check inputs
 
     if (_networkInputs.empty()) {
@@ -72,12 +76,18 @@ void GraphTransformerImpl::parseNetwork(ICNNNetwork& network) {
                                << inputInfo.first;
         }
 
-        // verify that batchSize == 1
+        // the batch of the 4D inputs, they all have to agree
         if (inputDims.size() == 4 && inputDims[3] != 1) {
-            THROW_IE_EXCEPTION << "[VPU] Plugin supports only batch size 1. Requested "
-                               << inputDims[3]
-                               << " for input "
-                               << inputInfo.first;
+            if (_batchSize != 1 && _batchSize != inputDims[3]) {
+                THROW_IE_EXCEPTION << "[VPU] Plugin supports one batch size for all inputs. Requested "
+                                   << inputDims[3]
+                                   << " for input "
+                                   << inputInfo.first
+                                   << " and "
+                                   << _batchSize
+                                   << " for another one";
+            }
+            _batchSize = inputDims[3];
         }
 
         if (inputPrecision != Precision::U8 &&
@@ -172,4 +182,51 @@ void GraphTransformerImpl::parseNetwork(ICNNNetwork& network) {
             }
         }
     }
+
+    if (_batchSize == 1)
+        return;
+
+    // Batch > 1 is compiled as the stages of one image repeated for every
+    // image, so each layer has to keep the images apart: the batch is the
+    // outer dimension of all its data.
+    auto checkBatchData = [this](const DataPtr& data, const std::string& layerName) {
+        const auto& dims = data->getTensorDesc().getDims();
+        if (dims.size() < 2 || dims[0] != _batchSize || data->getTensorDesc().getLayout() == InferenceEngine::CN) {
+            THROW_IE_EXCEPTION << "[VPU] Plugin supports batch size " << _batchSize
+                               << " only for networks that process the images one by one, layer "
+                               << layerName << " mixes them in " << data->getName();
+        }
+    };
+
+    for (const auto& inputInfo : _networkInputs) {
+        checkBatchData(inputInfo.second->getInputData(), inputInfo.first);
+    }
+    // Nor may a layer work along the batch or move it, even where its
+    // output still starts with it: a softmax or concat over axis 0, or a
+    // permute that brings another axis first.
+    auto checkBatchAxis = [this](const CNNLayerPtr& layer) {
+        bool mixes = false;
+        if (layer->type == "Permute") {
+            auto order = layer->GetParamAsInts("order", {});
+            mixes = !order.empty() && order[0] != 0;
+        }
+        auto rank = layer->insData.empty() ? 4 : static_cast<int>(layer->insData[0].lock()->getDims().size());
+        for (auto axis : layer->GetParamAsInts("axis", {})) {
+            mixes |= axis == 0 || axis == -rank;
+        }
+        if (mixes) {
+            THROW_IE_EXCEPTION << "[VPU] Plugin supports batch size " << _batchSize
+                               << " only for networks that process the images one by one, layer "
+                               << layer->name << " works across them";
+        }
+    };
+
+    for (const auto& layer : _orderedLayers) {
+        checkBatchAxis(layer);
+        for (const auto& out : layer->outData) {
+            checkBatchData(out, layer->name);
+        }
+    }
+
+    _batchDatas.resize(_batchSize);
 }
@@ -0,0 +1,227 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2017-2018 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+//
+
+#include "memory_planner.hpp"
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+bool overlap(const MemoryRequest& a, const MemoryRequest& b) {
+    return a.start <= b.end && b.start <= a.end;
+}
+
+// Offset for req among the placed requests live at the same time: the lowest
+// gap it fits in, or with bestFit the smallest one. Past the top otherwise.
+uint32_t findOffset(const MemoryRequest& req, const std::vector<const MemoryRequest*>& placed, bool bestFit) {
+    std::vector<std::pair<uint32_t, uint32_t>> busy;
+    for (auto other : placed) {
+        if (overlap(req, *other)) {
+            busy.emplace_back(other->offset, other->offset + other->size);
+        }
+    }
+    std::sort(busy.begin(), busy.end());
+
+    uint32_t top = 0;
+    uint32_t bestOffset = 0;
+    uint32_t bestGap = std::numeric_limits<uint32_t>::max();
+    bool found = false;
+    for (const auto& range : busy) {
+        if (range.first > top) {
+            uint32_t gap = range.first - top;
+            if (gap >= req.size && gap < bestGap) {
+                bestOffset = top;
+                bestGap = gap;
+                found = true;
+                if (!bestFit)
+                    break;
+            }
+        }
+        top = std::max(top, range.second);
+    }
+    return found ? bestOffset : top;
+}
+
+uint32_t place(const std::vector<MemoryRequest*>& order, bool bestFit) {
+    std::vector<const MemoryRequest*> placed;
+    uint32_t used = 0;
+    for (auto req : order) {
+        req->offset = findOffset(*req, placed, bestFit);
+        used = std::max(used, req->offset + req->size);
+        placed.push_back(req);
+    }
+    return used;
+}
+
+// Largest first, longest lived first among equals, each into the tightest gap.
+uint32_t placeBestFit(std::vector<MemoryRequest*> order) {
+    std::stable_sort(order.begin(), order.end(), [](const MemoryRequest* a, const MemoryRequest* b) {
+        if (a->size != b->size)
+            return a->size > b->size;
+        return a->end - a->start > b->end - b->start;
+    });
+    return place(order, true);
+}
+
+// Every request conflicts with those it overlaps in time. The ones with the
+// heaviest neighbourhood (own size plus the sizes it conflicts with) bound
+// the peak, so they go first, each at the lowest offset its placed
+// neighbours leave free.
+uint32_t placeConflictGraph(std::vector<MemoryRequest*> order) {
+    std::vector<uint64_t> weight(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        weight[i] = order[i]->size;
+        for (size_t j = 0; j < order.size(); j++) {
+            if (i != j && overlap(*order[i], *order[j]))
+                weight[i] += order[j]->size;
+        }
+    }
+    std::vector<size_t> index(order.size());
+    for (size_t i = 0; i < index.size(); i++)
+        index[i] = i;
+    std::stable_sort(index.begin(), index.end(), [&](size_t a, size_t b) {
+        if (weight[a] != weight[b])
+            return weight[a] > weight[b];
+        return order[a]->size > order[b]->size;
+    });
+
+    std::vector<MemoryRequest*> sorted;
+    for (auto i : index)
+        sorted.push_back(order[i]);
+    return place(sorted, false);
+}
+
+}  // namespace
+
+uint32_t peakLiveSize(const std::vector<const MemoryRequest*>& requests) {
+    // +size at start, -size after end; ends sort before starts at the same point
+    std::vector<std::pair<int, int64_t>> events;
+    for (auto req : requests) {
+        events.emplace_back(req->start, static_cast<int64_t>(req->size));
+        events.emplace_back(req->end + 1, -static_cast<int64_t>(req->size));
+    }
+    std::sort(events.begin(), events.end());
+
+    int64_t live = 0;
+    int64_t peak = 0;
+    for (const auto& event : events) {
+        live += event.second;
+        peak = std::max(peak, live);
+    }
+    return static_cast<uint32_t>(peak);
+}
+
+const char* memoryPlannerName(VPU::MemoryPlanner planner) {
+    switch (planner) {
+    case VPU::MemoryPlanner::FirstFit:
+        return "FIRST_FIT";
+    case VPU::MemoryPlanner::BestFit:
+        return "BEST_FIT";
+    case VPU::MemoryPlanner::ConflictGraph:
+        return "CONFLICT_GRAPH";
+    case VPU::MemoryPlanner::Auto:
+        return "AUTO";
+    }
+    return "";
+}
+
+MemoryPlan planMemory(std::vector<MemoryRequest>& requests, uint32_t cmxSize, VPU::MemoryPlanner planner) {
+    MemoryPlan plan;
+
+    // CMX: the most traffic saved per byte-stage of CMX first
+    std::vector<MemoryRequest*> cmxCandidates;
+    for (auto& req : requests) {
+        req.inCMX = false;
+        if (req.canUseCMX && req.size <= cmxSize)
+            cmxCandidates.push_back(&req);
+    }
+    std::stable_sort(cmxCandidates.begin(), cmxCandidates.end(), [](const MemoryRequest* a, const MemoryRequest* b) {
+        // a.benefit / (a.size * a.length) > b.benefit / (b.size * b.length)
+        double lhs = static_cast<double>(a->benefit) * b->size * (b->end - b->start + 1);
+        double rhs = static_cast<double>(b->benefit) * a->size * (a->end - a->start + 1);
+        if (lhs != rhs)
+            return lhs > rhs;
+        return a->benefit > b->benefit;
+    });
+
+    std::vector<const MemoryRequest*> inCMX;
+    for (auto req : cmxCandidates) {
+        uint32_t offset = findOffset(*req, inCMX, true);
+        if (offset + req->size <= cmxSize) {
+            req->inCMX = true;
+            req->offset = offset;
+            plan.cmxUsed = std::max(plan.cmxUsed, offset + req->size);
+            inCMX.push_back(req);
+        }
+    }
+    plan.cmxLowerBound = peakLiveSize(inCMX);
+
+    // DDR: everything else
+    std::vector<MemoryRequest*> ddr;
+    std::vector<const MemoryRequest*> inDDR;
+    for (auto& req : requests) {
+        if (!req.inCMX) {
+            ddr.push_back(&req);
+            inDDR.push_back(&req);
+        }
+    }
+    plan.ddrLowerBound = peakLiveSize(inDDR);
+
+    if (planner == VPU::MemoryPlanner::Auto) {
+        // try both, keep the offsets of the smaller
+        std::vector<uint32_t> bestFitOffsets;
+        uint32_t bestFitUsed = placeBestFit(ddr);
+        for (auto req : ddr)
+            bestFitOffsets.push_back(req->offset);
+
+        uint32_t conflictUsed = placeConflictGraph(ddr);
+        if (conflictUsed < bestFitUsed) {
+            plan.planner = VPU::MemoryPlanner::ConflictGraph;
+            plan.ddrUsed = conflictUsed;
+        } else {
+            for (size_t i = 0; i < ddr.size(); i++)
+                ddr[i]->offset = bestFitOffsets[i];
+            plan.planner = VPU::MemoryPlanner::BestFit;
+            plan.ddrUsed = bestFitUsed;
+        }
+    } else if (planner == VPU::MemoryPlanner::ConflictGraph) {
+        plan.planner = planner;
+        plan.ddrUsed = placeConflictGraph(ddr);
+    } else {
+        plan.planner = VPU::MemoryPlanner::BestFit;
+        plan.ddrUsed = placeBestFit(ddr);
+    }
+
+    return plan;
+}
@@ -0,0 +1,73 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2017-2018 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "graph_transformer.hpp"
+
+// A buffer packMemory has to place. It is live from the first stage that
+// writes it to the last stage that reads it, both included, so it may share
+// memory with any buffer whose range does not overlap.
+struct MemoryRequest {
+    uint32_t size = 0;
+    int start = 0;
+    int end = 0;
+    bool canUseCMX = false;
+    // DDR traffic a CMX placement saves, in bytes
+    uint64_t benefit = 0;
+
+    // result
+    bool inCMX = false;
+    uint32_t offset = 0;
+};
+
+struct MemoryPlan {
+    VPU::MemoryPlanner planner = VPU::MemoryPlanner::BestFit;  // what AUTO picked
+    uint32_t ddrUsed = 0;
+    uint32_t cmxUsed = 0;
+    uint32_t ddrLowerBound = 0;
+    uint32_t cmxLowerBound = 0;
+};
+
+// Places the requests with exact live ranges. CMX candidates go first, in
+// order of benefit per byte of CMX they hold and stage they hold it for,
+// while cmxSize has room over their whole range. The rest is packed in DDR
+// with the given strategy (BestFit, ConflictGraph or Auto, FirstFit is the
+// stage order walk packMemory does itself).
+MemoryPlan planMemory(std::vector<MemoryRequest>& requests, uint32_t cmxSize, VPU::MemoryPlanner planner);
+
+// The largest total size live at any one stage, what any placement needs at least.
+uint32_t peakLiveSize(const std::vector<const MemoryRequest*>& requests);
+
+const char* memoryPlannerName(VPU::MemoryPlanner planner);
@@ -35,7 +35,10 @@
 #include <list>
 #include <unordered_set>
 #include <algorithm>
+#include <vector>
+#include "memory_planner.hpp"
 #include "vpu_logger.h"
+#include "fnv1a_hash.h"
 
 
 #ifdef NNLOG
@@ -374,39 +377,180 @@ uint32_t getStageRequiredInputPadding(VpuStageHandle stage, VpuDataHandle parent
     return requiredPadding;
 }
 
+// What an output buffer needs, gathered from every stage that touches it.
+struct BufferInfo {
+    std::unordered_set<VpuStageHandle, VpuStageHandleHash> consumers;
+    std::unordered_set<VpuStageHandle, VpuStageHandleHash> producers;
+    bool canUseCMX = false;
+    uint32_t dataSize = 0;
+    uint32_t padding = 0;
+    uint32_t size = 0;
+};
+
+BufferInfo getBufferInfo(const std::list<VpuStagePtr>& stages,
+                         std::list<VpuStagePtr>::const_iterator stageIt,
+                         const VpuDataHandle& output,
+                         const VpuDataHandle& parent,
+                         bool useCmxBuffers) {
+    BufferInfo info;
+    auto stage = *stageIt;
+
+    // Get list of all consumers and producers
+    for (const auto& consumer : parent->consumers) {
+        assert(consumer != nullptr);
+        if (!consumer->optimized)
+            info.consumers.insert(consumer);
+    }
+    loopOverSubData(parent, [&info](VpuDataHandle subData) {
+        for (const auto& consumer : subData->consumers) {
+            assert(consumer != nullptr);
+            if (!consumer->optimized)
+                info.consumers.insert(consumer);
+        }
+    });
+
+    if (info.consumers.empty()) {
+        THROW_IE_EXCEPTION << "[VPU] Stage " << stage->name
+                           << " have output which is not used " << output->name
+                           << " by any other stage";
+    }
+
+    info.producers.insert(stage);
+    if (stage->parentOp != nullptr && !stage->parentOp->optimized)
+        info.producers.insert(stage->parentOp);
+    if (stage->postOp != nullptr && !stage->postOp->optimized)
+        info.producers.insert(stage->postOp);
+    loopOverSubData(parent, [&info](VpuDataHandle subData) {
+        if (subData->producer != nullptr && !subData->producer->optimized) {
+            info.producers.insert(subData->producer);
+        }
+    });
+
+    // Check if we can use CMX
+
+    info.canUseCMX = useCmxBuffers && isStageCMXFree(stage);
+    for (const auto& consumer : info.consumers) {
+        if (!info.canUseCMX)
+            break;
+
+        if (!isStageCMXFree(consumer)) {
+            info.canUseCMX = false;
+            break;
+        } else {
+            // Check that between current stage and consumer there is no stages that use CMX
+
+            auto nextIt = stageIt;
+            ++nextIt;
+
+            auto consumerIt = std::find_if(nextIt, stages.end(),
+                                           [consumer](const VpuStagePtr &ptr) {
+                                               return ptr.get() == consumer.get();
+                                           });
+            if (consumerIt == stages.end()) {
+                THROW_IE_EXCEPTION << "[VPU] Internal error (invalid list of stages)";
+            }
+
+            for (auto it = nextIt; it != consumerIt; ++it) {
+                auto middleStage = *it;
+                if (!middleStage->optimized && !isStageCMXFree(middleStage)) {
+                    info.canUseCMX = false;
+                    break;
+                }
+            }
+        }
+    }
+    for (const auto& producer : info.producers) {
+        if (!info.canUseCMX)
+            break;
+
+        if (!isStageCMXFree(producer)) {
+            info.canUseCMX = false;
+            break;
+        }
+    }
+
+    // Get required padding size
+
+    for (const auto& producer : info.producers) {
+        auto curPadding = getStageRequiredOutputPadding(producer, parent);
+        info.padding = std::max(info.padding, curPadding);
+    }
+    for (const auto& consumer : info.consumers) {
+        auto curPadding = getStageRequiredInputPadding(consumer, parent);
+        info.padding = std::max(info.padding, curPadding);
+    }
+
+    // Align padding to 16 bytes
+    info.padding = alignVal(info.padding, 16u);
+
+    // Calculate final buffer size
+
+    info.dataSize = calcDataTotalSize(parent);
+    info.size = alignVal(info.dataSize + 2 * info.padding, DATA_ALIGNMENT);
+
+    // TODO: investigate this; makes hw googlenet stable
+    if (info.size > CMX_BUFFER_SIZE_LIMIT)
+        info.canUseCMX = false;
+
+    return info;
+}
+
+// Puts parent at offset in index, and its sub data where they are in it.
+void placeData(const VpuDataHandle& parent, IndexCodes index, uint32_t offset,
+               std::unordered_set<VpuDataHandle, VpuDataHandleHash>& processedData) {
+    parent->index = index;
+    parent->offset = offset;
+    loopOverSubData(parent, [parent, &processedData](VpuDataHandle subData) {
+        if (processedData.find(subData) != processedData.end())
+            return;
+
+        if (subData->parent == nullptr) {
+            THROW_IE_EXCEPTION << "[VPU] in function " << __PRETTY_FUNCTION__ << ": parent of VPU data handle not defined.";
+        }
+
+        subData->index = parent->index;
+        subData->offset =   subData->parent->offset
+                          + calcAbsParentOffset(subData->offsetFromParent, subData->strides);
+
+        processedData.insert(subData);
+    });
+    processedData.insert(parent);
+}
+
+const uint32_t DDR_BUFFER_SIZE_LIMIT = 512u * 1024u * 1024u;
+
+// Writes what data holds to buffer, reusing its storage
+void readContent(const VpuDataHandle& data, std::vector<char>& buffer) {
+    buffer.resize(data->writer->byteSize());
+    data->writer->write(buffer.data());
+}
+
 }  // namespace
 
 void GraphTransformerImpl::packMemory() {
     std::unordered_set<VpuDataHandle, VpuDataHandleHash> processedData;
 
-    VpuAllocator cmxAllocator(_blobConfig.memoryOptimization, IndexCMX, _blobConfig.cmxBufferSize);
-    VpuAllocator ddrAllocator(_blobConfig.memoryOptimization, IndexBSS, 512u * 1024u * 1024u);
-
 #ifdef NNLOG
     ALOGI("[VPU] GraphTransformer packMemory _blobConfig.memoryOptimization = %d",_blobConfig.memoryOptimization);
 #endif
     LOG_INFO("[VPU] GraphTransformer packMemory _blobConfig.memoryOptimization = %d",_blobConfig.memoryOptimization);
 
-    auto findChunk = [&cmxAllocator, &ddrAllocator](VpuDataHandle data) {
-        if (auto chunk = cmxAllocator.find(data))
-            return chunk;
-
-        return ddrAllocator.find(data);
-    };
+    // Exact live range of every BSS/CMX buffer: from the first stage that
+    // writes it to the last one that reads it, in order of the stages that
+    // produce them.
 
-    auto allocateChunk = [&cmxAllocator, &ddrAllocator](
-            bool canUseCMX,
-            uint32_t size, uint32_t padding, uint32_t inuse,
-            VpuDataHandle data) {
-        if (canUseCMX) {
-            if (auto chunk = cmxAllocator.allocate(size, padding, inuse, data))
-                return chunk;
-        }
-
-        return ddrAllocator.allocate(size, padding, inuse, data);
-    };
+    std::unordered_map<VpuStageHandle, int, VpuStageHandleHash> positions;
+    int position = 0;
+    for (const auto& stage : _stages) {
+        if (!stage->optimized)
+            positions[stage] = position++;
+    }
 
-    // Allocate space for BSS/CMX data
+    std::vector<MemoryRequest> requests;
+    std::vector<VpuDataHandle> requestData;
+    std::vector<uint32_t> requestPadding;
+    std::unordered_map<VpuDataHandle, size_t, VpuDataHandleHash> requestOf;
+    std::unordered_set<VpuDataHandle, VpuDataHandleHash> requestedData;
 
     for (auto stageIt = _stages.begin(); stageIt != _stages.end(); ++stageIt) {
         auto stage = *stageIt;
@@ -420,7 +564,7 @@ void GraphTransformerImpl::packMemory() {
         if (stage->optimized)
             continue;
 
-        // allocate outputs
+        // outputs
 
         for (const auto& output : stage->outputs) {
             assert(output != nullptr);
@@ -428,183 +572,61 @@ void GraphTransformerImpl::packMemory() {
             if (output->index != IndexBSS && output->index != IndexCMX)
                 continue;
 
-            if (processedData.find(output) != processedData.end())
+            if (requestedData.find(output) != requestedData.end())
                 continue;
 
             auto parent = getDataTopParent(output);
 
-            auto chunk = findChunk(parent);
-
-            if (chunk != nullptr) {
+            if (requestOf.find(parent) != requestOf.end()) {
                 if (parent == output) {
                     THROW_IE_EXCEPTION << "[VPU] Trying to allocate the same data " << output->name << " twice";
                 }
+                requestedData.insert(output);
+                continue;
+            }
 
-                loopOverSubData(parent, [parent, &processedData](VpuDataHandle subData) {
-                    if (processedData.find(subData) != processedData.end())
-                        return;
-
-                    if (subData->parent == nullptr) {
-                        THROW_IE_EXCEPTION << "[VPU] in function " << __PRETTY_FUNCTION__ << ": parent of VPU data handle not defined.";
-                    }
-
-                    subData->index = parent->index;
-                    subData->offset =   subData->parent->offset
-                                      + calcAbsParentOffset(subData->offsetFromParent, subData->strides);
-
-                    processedData.insert(subData);
-                });
-            } else {
-                // Get list of all consumers and producers
-
-                std::unordered_set<VpuStageHandle, VpuStageHandleHash> consumers;
-                for (const auto& consumer : parent->consumers) {
-                    assert(consumer != nullptr);
-                    if (!consumer->optimized)
-                        consumers.insert(consumer);
-                }
-                loopOverSubData(parent, [&consumers](VpuDataHandle subData) {
-                    for (const auto& consumer : subData->consumers) {
-                        assert(consumer != nullptr);
-                        if (!consumer->optimized)
-                            consumers.insert(consumer);
-                    }
-                });
-
-                if (consumers.empty()) {
-                    THROW_IE_EXCEPTION << "[VPU] Stage " << stage->name
-                                       << " have output which is not used " << output->name
-                                       << " by any other stage";
-                }
-
-                std::unordered_set<VpuStageHandle, VpuStageHandleHash> producers;
-                producers.insert(stage);
-                if (stage->parentOp != nullptr && !stage->parentOp->optimized)
-                    producers.insert(stage->parentOp);
-                if (stage->postOp != nullptr && !stage->postOp->optimized)
-                    producers.insert(stage->postOp);
-                loopOverSubData(parent, [&producers](VpuDataHandle subData) {
-                    if (subData->producer != nullptr && !subData->producer->optimized) {
-                        producers.insert(subData->producer);
-                    }
-                });
-
-                // Check if we can use CMX
-
-                bool canUseCMX = _blobConfig.useCmxBuffers && isStageCMXFree(stage);
-                for (const auto& consumer : consumers) {
-                    if (!canUseCMX)
-                        break;
-
-                    if (!isStageCMXFree(consumer)) {
-                        canUseCMX = false;
-                        break;
-                    } else {
-                        // Check that between current stage and consumer there is no stages that use CMX
-
-                        auto nextIt = stageIt;
-                        ++nextIt;
-
-                        auto consumerIt = std::find_if(nextIt, _stages.end(),
-                                                       [consumer](const VpuStagePtr &ptr) {
-                                                           return ptr.get() == consumer.get();
-                                                       });
-                        if (consumerIt == _stages.end()) {
-                            THROW_IE_EXCEPTION << "[VPU] Internal error (invalid list of stages)";
-                        }
-
-                        for (auto it = nextIt; it != consumerIt; ++it) {
-                            auto middleStage = *it;
-                            if (!middleStage->optimized && !isStageCMXFree(middleStage)) {
-                                canUseCMX = false;
-                                break;
-                            }
-                        }
-                    }
-                }
-                for (const auto& producer : producers) {
-                    if (!canUseCMX)
-                        break;
-
-                    if (!isStageCMXFree(producer)) {
-                        canUseCMX = false;
-                        break;
-                    }
-                }
-
-                // Get required padding size
-
-                uint32_t paddingSize = 0;
-                for (const auto& producer : producers) {
-                    auto curPadding = getStageRequiredOutputPadding(producer, parent);
-                    paddingSize = std::max(paddingSize, curPadding);
-                }
-                for (const auto& consumer : consumers) {
-                    auto curPadding = getStageRequiredInputPadding(consumer, parent);
-                    paddingSize = std::max(paddingSize, curPadding);
-                }
-
-                // Align padding to 16 bytes
-                paddingSize = alignVal(paddingSize, 16u);
-
-                // Calculate final buffer size
-
-                auto dataSize = calcDataTotalSize(parent);
+            auto info = getBufferInfo(_stages, stageIt, output, parent, _blobConfig.useCmxBuffers);
 
-                auto bufferSize = alignVal(dataSize + 2 * paddingSize, DATA_ALIGNMENT);
-                LOG_DEBUG("[VPU] GraphTransformer : data %s dataSize=%u paddingSize=%u bufferSize=%u",
-                          parent->name.c_str(),
-                          static_cast<uint32_t>(dataSize),
-                          static_cast<uint32_t>(paddingSize),
-                          static_cast<uint32_t>(bufferSize));
+            LOG_DEBUG("[VPU] GraphTransformer : data %s dataSize=%u paddingSize=%u bufferSize=%u",
+                      parent->name.c_str(),
+                      static_cast<uint32_t>(info.dataSize),
+                      static_cast<uint32_t>(info.padding),
+                      static_cast<uint32_t>(info.size));
 
-                LOG_INFO("[VPU] GraphTransformer DATA_ALIGNMENT : data %s dataSize=%u paddingSize=%u bufferSize=%u",
-                          parent->name.c_str(),
-                          static_cast<uint32_t>(dataSize),
-                          static_cast<uint32_t>(paddingSize),
-                          static_cast<uint32_t>(bufferSize));
+            LOG_INFO("[VPU] GraphTransformer DATA_ALIGNMENT : data %s dataSize=%u paddingSize=%u bufferSize=%u",
+                      parent->name.c_str(),
+                      static_cast<uint32_t>(info.dataSize),
+                      static_cast<uint32_t>(info.padding),
+                      static_cast<uint32_t>(info.size));
 
 #ifdef NNLOG
-                ALOGI("[VPU] GraphTransformer DATA_ALIGNMENT : data %s dataSize=%u paddingSize=%u bufferSize=%u",
-                          parent->name.c_str(),
-                          static_cast<uint32_t>(dataSize),
-                          static_cast<uint32_t>(paddingSize),
-                          static_cast<uint32_t>(bufferSize));
+            ALOGI("[VPU] GraphTransformer DATA_ALIGNMENT : data %s dataSize=%u paddingSize=%u bufferSize=%u",
+                      parent->name.c_str(),
+                      static_cast<uint32_t>(info.dataSize),
+                      static_cast<uint32_t>(info.padding),
+                      static_cast<uint32_t>(info.size));
 #endif
-                // TODO: investigate this; makes hw googlenet stable
-                if (bufferSize > CMX_BUFFER_SIZE_LIMIT)
-                    canUseCMX = false;
-
-                // Allocate chunk
-
-                chunk = allocateChunk(canUseCMX, bufferSize, paddingSize, consumers.size(), parent);
-                if (chunk == nullptr) {
-                    THROW_IE_EXCEPTION << "[VPU] Could not allocate memory buffer for " << parent->name;
-                }
-
-                parent->index = chunk->index;
-                parent->offset = chunk->offset + chunk->padding;
-                if (parent->index == IndexCMX) {
-                    parent->offset += _blobConfig.cmxBufferStart;
-                }
-                loopOverSubData(parent, [parent, &processedData](VpuDataHandle subData) {
-                    if (processedData.find(subData) != processedData.end())
-                        return;
-
-                    if (subData->parent == nullptr) {
-                        THROW_IE_EXCEPTION << "[VPU] in function " << __PRETTY_FUNCTION__ << ": parent of VPU data handle not defined.";
-                    }
-
-                    subData->index = parent->index;
-                    subData->offset =   subData->parent->offset
-                                      + calcAbsParentOffset(subData->offsetFromParent, subData->strides);
 
-                    processedData.insert(subData);
-                });
+            MemoryRequest request;
+            request.size = info.size;
+            request.start = positions.at(stage);
+            request.end = request.start;
+            for (const auto& producer : info.producers) {
+                request.start = std::min(request.start, positions.at(producer));
+                request.end = std::max(request.end, positions.at(producer));
             }
-
-            processedData.insert(parent);
-            processedData.insert(output);
+            for (const auto& consumer : info.consumers) {
+                request.end = std::max(request.end, positions.at(consumer));
+            }
+            request.canUseCMX = info.canUseCMX;
+            request.benefit = static_cast<uint64_t>(info.dataSize) * (info.producers.size() + info.consumers.size());
+
+            requestOf[parent] = requests.size();
+            requests.push_back(request);
+            requestData.push_back(parent);
+            requestPadding.push_back(info.padding);
+            requestedData.insert(parent);
+            requestedData.insert(output);
         }
 
         // check inputs
@@ -617,36 +639,135 @@ void GraphTransformerImpl::packMemory() {
 
             auto parent = getDataTopParent(input);
 
-            auto chunk = findChunk(parent);
-
-            if (chunk == nullptr) {
+            if (requestOf.find(parent) == requestOf.end()) {
                 auto producer = parent->producer;
                 if (producer == nullptr || !producer->optimized) {
                     THROW_IE_EXCEPTION << "[VPU] Could not allocate memory buffer for " << input->name;
                 }
+            }
+        }
+    }
 
-                continue;
+    // Place them
+
+    uint32_t ddrUsed = 0;
+    uint32_t cmxUsed = 0;
+    MemoryPlanner planner = _blobConfig.memoryOptimization ? _blobConfig.memoryPlanner : MemoryPlanner::FirstFit;
+
+    if (planner == MemoryPlanner::FirstFit) {
+        // allocate and free while walking the stages
+        VpuAllocator cmxAllocator(_blobConfig.memoryOptimization, IndexCMX, _blobConfig.cmxBufferSize);
+        VpuAllocator ddrAllocator(_blobConfig.memoryOptimization, IndexBSS, DDR_BUFFER_SIZE_LIMIT);
+
+        std::vector<std::vector<size_t>> starts(position), ends(position);
+        for (size_t i = 0; i < requests.size(); i++) {
+            starts[requests[i].start].push_back(i);
+            ends[requests[i].end].push_back(i);
+        }
+
+        std::vector<VpuAllocator::Chunk*> chunks(requests.size(), nullptr);
+        for (int pos = 0; pos < position; pos++) {
+            for (auto i : starts[pos]) {
+                auto& request = requests[i];
+                VpuAllocator::Chunk* chunk = nullptr;
+                if (request.canUseCMX)
+                    chunk = cmxAllocator.allocate(request.size, requestPadding[i], 1, requestData[i]);
+                if (chunk == nullptr)
+                    chunk = ddrAllocator.allocate(request.size, requestPadding[i], 1, requestData[i]);
+                if (chunk == nullptr) {
+                    THROW_IE_EXCEPTION << "[VPU] Could not allocate memory buffer for " << requestData[i]->name;
+                }
+                request.inCMX = chunk->index == IndexCMX;
+                request.offset = chunk->offset;
+                chunks[i] = chunk;
+            }
+            for (auto i : ends[pos]) {
+                chunks[i]->allocator->free(chunks[i]);
             }
+        }
+
+        // Self-check
+
+        cmxAllocator.check();
+        ddrAllocator.check();
+
+        ddrUsed = ddrAllocator.memUsed();
+        cmxUsed = cmxAllocator.memUsed();
+    } else {
+        uint32_t cmxSize = _blobConfig.useCmxBuffers ? _blobConfig.cmxBufferSize : 0;
+        auto plan = planMemory(requests, cmxSize, planner);
+        if (plan.ddrUsed > DDR_BUFFER_SIZE_LIMIT) {
+            THROW_IE_EXCEPTION << "[VPU] Could not allocate memory buffers, " << plan.ddrUsed << " bytes needed";
+        }
 
-            if (chunk->inuse == 0) {
-                THROW_IE_EXCEPTION << "[VPU] Input " << input->name << " is not used";
+        // Self-check: buffers live at the same time never share bytes
+        for (size_t i = 0; i < requests.size(); i++) {
+            for (size_t j = i + 1; j < requests.size(); j++) {
+                const auto& a = requests[i];
+                const auto& b = requests[j];
+                if (a.inCMX == b.inCMX && a.start <= b.end && b.start <= a.end &&
+                    a.offset < b.offset + b.size && b.offset < a.offset + a.size) {
+                    THROW_IE_EXCEPTION << "[VPU] Blob memory packing failed";
+                }
             }
+        }
 
-            assert(chunk->allocator != nullptr);
-            chunk->allocator->free(chunk);
+        planner = plan.planner;
+        ddrUsed = plan.ddrUsed;
+        cmxUsed = plan.cmxUsed;
+    }
+
+    std::vector<const MemoryRequest*> ddrRequests, cmxRequests;
+    for (size_t i = 0; i < requests.size(); i++) {
+        const auto& request = requests[i];
+        (request.inCMX ? cmxRequests : ddrRequests).push_back(&request);
+
+        uint32_t offset = request.offset + requestPadding[i];
+        if (request.inCMX) {
+            offset += _blobConfig.cmxBufferStart;
         }
+        placeData(requestData[i], request.inCMX ? IndexCMX : IndexBSS, offset, processedData);
     }
 
-    // Self-check
+    _profile.memoryPlanner = memoryPlannerName(planner);
+    _profile.ddrLowerBound = peakLiveSize(ddrRequests);
+    _profile.cmxLowerBound = peakLiveSize(cmxRequests);
 
-    cmxAllocator.check();
-    ddrAllocator.check();
+    LOG_INFO("[VPU] GraphTransformer : %s placed %u buffers, DDR %u (lower bound %u) CMX %u (lower bound %u)",
+             _profile.memoryPlanner.c_str(), static_cast<uint32_t>(requests.size()),
+             ddrUsed, _profile.ddrLowerBound, cmxUsed, _profile.cmxLowerBound);
 
     // Pack Blob data
 
+    // The stages of every image of a batch read the weights of the same
+    // layers, those are placed once and shared. Only the data placed so far
+    // is kept by hash, its content is written again when a hash matches.
+    std::unordered_map<uint64_t, std::vector<VpuDataHandle>> batchWeights;
+    std::vector<char> content, placedContent;
+
     _blobTotalDataSize = 0;
     for (auto& data : _datas) {
         if (data->index == IndexBlob && data->writer != nullptr) {
+            if (_batchSize > 1 && data->parent == nullptr && data->subData.empty()) {
+                readContent(data, content);
+
+                auto& sameHash = batchWeights[fnv1a(kFnv1aOffset, content.data(), content.size())];
+                auto same = std::find_if(sameHash.begin(), sameHash.end(),
+                                         [&content, &placedContent](const VpuDataHandle& placed) {
+                                             if (placed->writer->byteSize() != content.size())
+                                                 return false;
+                                             readContent(placed, placedContent);
+                                             return placedContent == content;
+                                         });
+                if (same != sameHash.end()) {
+                    // finalize writes only the data with a writer
+                    data->offset = (*same)->offset;
+                    data->writer = nullptr;
+                    continue;
+                }
+                sameHash.push_back(data);
+            }
+
             auto dataSize = data->writer->byteSize();
             auto alignedSize = alignVal(dataSize, static_cast<size_t>(WEIGHTS_ALIGNMENT));
             data->offset = _blobTotalDataSize;
@@ -691,20 +812,22 @@ void GraphTransformerImpl::packMemory() {
             continue;
 
         if (stage->buffer != nullptr) {
-            stage->buffer->offset = ddrAllocator.memUsed();
+            stage->buffer->offset = ddrUsed;
 
             maxTempBufSize = std::max(maxTempBufSize, calcDataTotalSize(stage->buffer));
         }
     }
 
-    _bssMemSize = ddrAllocator.memUsed() + maxTempBufSize;
+    _bssMemSize = ddrUsed + maxTempBufSize;
+    _cmxMemSize = cmxUsed;
+    _profile.ddrTempBytes = maxTempBufSize;
 
     LOG_INFO("[VPU] GraphTransformer : DDR memory usage = %u CMX memory usage = %u",
              static_cast<uint32_t>(_bssMemSize),
-             static_cast<uint32_t>(cmxAllocator.memUsed()));
+             static_cast<uint32_t>(cmxUsed));
 #ifdef NNLOG
     ALOGI("[VPU] GraphTransformer : DDR memory usage = %u CMX memory usage = %u",
              static_cast<uint32_t>(_bssMemSize),
-             static_cast<uint32_t>(cmxAllocator.memUsed()));
+             static_cast<uint32_t>(cmxUsed));
 #endif
 }
@@ -37,6 +37,8 @@
 #include <description_buffer.hpp>
 #include <debug.h>
 #include <precision_utils.h>
+#include <layout_utils.h>
+#include <graph_transformer.hpp>
 
 #include "hddl_infer_request.h"
 #include "common.h"
@@ -75,7 +77,14 @@ HDDLInferRequest::HDDLInferRequest(InputsDataMap networkInputs,
         }
     }
 
-    _deviceLayout = _env->parsedConfig.blobConfig.hwOptimization ? NCHW : NHWC;
+    bool hwOptimization = _env->parsedConfig.blobConfig.hwOptimization;
+    for (auto &networkInput : _networkInputs) {
+        _deviceLayouts[networkInput.first] =
+                VPU::deviceLayout(networkInput.second->getTensorDesc().getLayout(), hwOptimization);
+    }
+    for (auto &networkOutput : _networkOutputs) {
+        _deviceLayouts[networkOutput.first] = VPU::deviceLayout(networkOutput.second->layout, hwOptimization);
+    }
 
     size_t output_buffer_size = 0;  // bytes
 
@@ -130,7 +139,7 @@ HDDLInferRequest::HDDLInferRequest(InputsDataMap networkInputs,
         SizeVector dims = networkInput.second->getDims();
         Precision precision = networkInput.second->getInputPrecision();
         Layout layout = networkInput.second->getTensorDesc().getLayout();
-        Layout ionBlobLayout = layout != _deviceLayout && (layout == NCHW || layout == NHWC) ? _deviceLayout : layout;
+        Layout ionBlobLayout = _deviceLayouts[networkInput.first];
 
         Blob::Ptr inputBlob = nullptr;
         switch (precision) {
@@ -149,7 +158,7 @@ HDDLInferRequest::HDDLInferRequest(InputsDataMap networkInputs,
         inputBlob->allocate();
         _hddlInputs[networkInput.first] = inputBlob;
 
-        if (layout != _deviceLayout && (layout == NCHW || layout == NHWC)) {
+        if (layout != ionBlobLayout) {
             switch (precision) {
                 case Precision::U8:
                     inputBlob = std::make_shared<TBlob<uint8_t>>(precision, layout, dims);
@@ -173,7 +182,7 @@ HDDLInferRequest::HDDLInferRequest(InputsDataMap networkInputs,
         SizeVector dims = networkOutput.second->dims;
         Precision precision = networkOutput.second->precision;
         Layout layout = networkOutput.second->layout;
-        Layout ionBlobLayout = layout != _deviceLayout && (layout == NCHW || layout == NHWC) ? _deviceLayout : layout;
+        Layout ionBlobLayout = _deviceLayouts[networkOutput.first];
 
         Blob::Ptr outputBlob = nullptr;
         switch (precision) {
@@ -189,7 +198,7 @@ HDDLInferRequest::HDDLInferRequest(InputsDataMap networkInputs,
         outputBlob->allocate();
         _hddlOutputs[networkOutput.first] = outputBlob;
 
-        if (layout != _deviceLayout && (layout == NCHW || layout == NHWC)) {
+        if (layout != ionBlobLayout) {
             switch (precision) {
                 case Precision::FP16:
                     outputBlob = std::make_shared<TBlob<ie_fp16>>(precision, layout, dims);
@@ -224,25 +233,7 @@ void HDDLInferRequest::StartAsync_ThreadUnsafe() {
             auto name = input.first;
             auto inputBlobPtr = input.second;
             auto hddlBlobPtr = _hddlInputs[name];
-            Layout layout = inputBlobPtr->getTensorDesc().getLayout();
-            if (layout != _deviceLayout && (layout == NCHW || layout == NHWC)) {
-                switch (inputBlobPtr->precision()) {
-                    case Precision::U8:
-                        ConvertBlobToLayout<uint8_t>(_deviceLayout, inputBlobPtr);
-                        break;
-                    case Precision::FP16:
-                        ConvertBlobToLayout<ie_fp16>(_deviceLayout, inputBlobPtr);
-                        break;
-                    case Precision::FP32:
-                        ConvertBlobToLayout<float>(_deviceLayout, inputBlobPtr);
-                        break;
-                    default:
-                        THROW_IE_EXCEPTION << "unsupported blob precision for converting layout";
-                        break;
-                }
-            }
-            std::copy_n(inputBlobPtr->cbuffer().as<uint8_t *>(), inputBlobPtr->byteSize(),
-                        hddlBlobPtr->buffer().as<uint8_t *>());
+            copyReordered(inputBlobPtr, hddlBlobPtr);
         }
     }
     auto firstInBlobPtr = _hddlInputs.begin()->second;
@@ -293,25 +284,7 @@ void HDDLInferRequest::Infer_ThreadUnsafe() {
             auto name = input.first;
             auto inputBlobPtr = input.second;
             auto hddlBlobPtr = _hddlInputs[name];
-            Layout layout = inputBlobPtr->getTensorDesc().getLayout();
-            if (layout != _deviceLayout && (layout == NCHW || layout == NHWC)) {
-                switch (inputBlobPtr->precision()) {
-                    case Precision::U8:
-                        ConvertBlobToLayout<uint8_t>(_deviceLayout, inputBlobPtr);
-                        break;
-                    case Precision::FP16:
-                        ConvertBlobToLayout<ie_fp16>(_deviceLayout, inputBlobPtr);
-                        break;
-                    case Precision::FP32:
-                        ConvertBlobToLayout<float>(_deviceLayout, inputBlobPtr);
-                        break;
-                    default:
-                        THROW_IE_EXCEPTION << "unsupported blob precision for converting layout";
-                        break;
-                }
-            }
-            std::copy_n(inputBlobPtr->cbuffer().as<uint8_t *>(), inputBlobPtr->byteSize(),
-                        hddlBlobPtr->buffer().as<uint8_t *>());
+            copyReordered(inputBlobPtr, hddlBlobPtr);
         }
     }
     auto firstInBlobPtr = _hddlInputs.begin()->second;
@@ -426,28 +399,27 @@ void *HDDLInferRequest::HDDLCallback() {
     return nullptr;
 }
 
+// Copies between a user blob and its hddl buffer, reordering NCHW <-> NHWC
+// on the way when the two differ; the user blob itself is never touched.
+void HDDLInferRequest::copyReordered(const Blob::Ptr &from, const Blob::Ptr &to) {
+    Layout fromLayout = from->getTensorDesc().getLayout();
+    Layout toLayout = to->getTensorDesc().getLayout();
+    const SizeVector &dims = from->getTensorDesc().getDims();
+    if (fromLayout != toLayout && (fromLayout == NCHW || fromLayout == NHWC) &&
+        (toLayout == NCHW || toLayout == NHWC) && !SameInNCHWAndNHWC(dims)) {
+        if (!LayoutUtils::convertLayout(fromLayout, toLayout, dims, from->element_size(), from->cbuffer(), to->buffer())) {
+            THROW_IE_EXCEPTION << PARAMETER_MISMATCH_str << "Unsupported blob for converting layout";
+        }
+        return;
+    }
+    std::copy_n(from->cbuffer().as<const uint8_t *>(), from->byteSize(), to->buffer().as<uint8_t *>());
+}
+
 void HDDLInferRequest::CopyToExternalOutputs() {
     for (auto &output : _outputs) {
         auto name = output.first;
         auto outputBlobPtr = output.second;
         auto hddlBlobPtr = _hddlOutputs[name];
-        Layout layout = hddlBlobPtr->getTensorDesc().getLayout();
-        SizeVector dims = hddlBlobPtr->getTensorDesc().getDims();
-        if (layout != _deviceLayout && (layout == NCHW || layout == NHWC)
-            && (dims[0] != 1 || dims[1] != 1) && (dims[2] != 1 || dims[3] != 1)) {
-            switch (outputBlobPtr->precision()) {
-                case Precision::FP32:
-                    ConvertBlobToLayout<float>(layout, hddlBlobPtr);
-                    break;
-                case Precision::FP16:
-                    ConvertBlobToLayout<ie_fp16>(layout, hddlBlobPtr);
-                    break;
-                default:
-                    THROW_IE_EXCEPTION << PARAMETER_MISMATCH_str << "Unsupported output precision: "
-                                       << outputBlobPtr->precision() << "! Supported precisions: FP32, FP16";
-            }
-        }
-        std::copy_n(hddlBlobPtr->cbuffer().as<uint8_t *>(), hddlBlobPtr->byteSize(),
-                    outputBlobPtr->buffer().as<uint8_t *>());
+        copyReordered(hddlBlobPtr, outputBlobPtr);
     }
 }
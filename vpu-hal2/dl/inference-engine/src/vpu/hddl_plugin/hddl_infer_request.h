@@ -53,7 +53,8 @@ class HDDLInferRequest : public InferenceEngine::AsyncInferRequestThreadSafeInte
 
     InferenceEngine::BlobMap _hddlInputs;
     InferenceEngine::BlobMap _hddlOutputs;
-    InferenceEngine::Layout _deviceLayout;
+    // layout the graph takes each input and returns each output in
+    std::map<std::string, InferenceEngine::Layout> _deviceLayouts;
     Common::LoggerPtr _log;
 
 public:
@@ -118,6 +119,7 @@ public:
 
 private:
     void CopyToExternalOutputs();
+    void copyReordered(const InferenceEngine::Blob::Ptr &from, const InferenceEngine::Blob::Ptr &to);
 };
 
 using HDDLInferRequestPtr = std::shared_ptr<HDDLInferRequest>;
@@ -0,0 +1,569 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2017 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "myriad_blob_cache.h"
+#include "fnv1a_hash.h"
+
+#ifndef CI_BUILD_NUMBER
+#define CI_BUILD_NUMBER "custom-master-android-nn"
+#endif
+
+using namespace InferenceEngine;
+using namespace VPU::Common;
+using namespace VPU::MyriadPlugin;
+
+namespace {
+
+// Bump whenever the file layout or the graph transformer output changes in a
+// way the build number does not catch.
+const uint32_t kFormatVersion = 3;
+const char kMagic[8] = {'V', 'P', 'U', 'B', 'L', 'O', 'B', '\0'};
+const char *kSuffix = ".blob";
+const char *kTmpInfix = ".blob.tmp.";
+// temporaries older than this are left over from a crashed writer
+const time_t kStaleTmpSeconds = 10 * 60;
+
+std::string toHex(uint64_t v) {
+    std::ostringstream out;
+    out << std::hex << std::setw(16) << std::setfill('0') << v;
+    return out.str();
+}
+
+uint32_t floatBits(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+// mkdir -p
+bool makeDirs(const std::string &path) {
+    for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+        std::string dir = path.substr(0, pos);
+        if (mkdir(dir.c_str(), 0770) != 0 && errno != EEXIST) {
+            return false;
+        }
+        if (pos == std::string::npos) return true;
+    }
+}
+
+bool endsWith(const std::string &str, const std::string &suffix) {
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+class Writer {
+public:
+    template<typename T>
+    void put(const T &v) { _buf.append(reinterpret_cast<const char *>(&v), sizeof(v)); }
+    void putString(const std::string &s) {
+        put(static_cast<uint32_t>(s.size()));
+        _buf.append(s);
+    }
+    void putBytes(const char *data, size_t len) { _buf.append(data, len); }
+    const std::string &data() const { return _buf; }
+
+private:
+    std::string _buf;
+};
+
+class Reader {
+public:
+    Reader(const char *buf, size_t end) : _buf(buf), _end(end) {}
+
+    template<typename T>
+    bool get(T &v) {
+        if (_end - _pos < sizeof(v)) return false;
+        std::memcpy(&v, _buf + _pos, sizeof(v));
+        _pos += sizeof(v);
+        return true;
+    }
+    bool getString(std::string &s) {
+        uint32_t len = 0;
+        if (!get(len) || _end - _pos < len) return false;
+        s.assign(_buf + _pos, len);
+        _pos += len;
+        return true;
+    }
+    void skip(size_t len) { _pos += len; }
+    size_t pos() const { return _pos; }
+
+private:
+    const char *_buf;
+    size_t _end;
+    size_t _pos = 0;
+};
+
+// A whole file mapped read-only, so checking an entry and allocating its
+// graph cost page cache the kernel can take back rather than a heap copy.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        map(fd);
+        close(fd);
+    }
+    explicit MappedFile(int fd) { map(fd); }
+    ~MappedFile() {
+        if (_data != nullptr) munmap(const_cast<char *>(_data), _size);
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool opened() const { return _opened; }
+    const char *data() const { return _data; }
+    size_t size() const { return _size; }
+
+private:
+    void map(int fd) {
+        struct stat st;
+        if (fstat(fd, &st) == 0) {
+            _size = static_cast<size_t>(st.st_size);
+            _opened = true;
+            if (_size > 0) {
+                void *addr = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (addr == MAP_FAILED) {
+                    _opened = false;
+                } else {
+                    _data = static_cast<const char *>(addr);
+                    madvise(addr, _size, MADV_SEQUENTIAL);
+                }
+            }
+        }
+    }
+
+    const char *_data = nullptr;
+    size_t _size = 0;
+    bool _opened = false;
+};
+
+bool writeAll(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        len -= written;
+    }
+    return true;
+}
+
+// Streams the blob into a new entry after its header, hashing all it writes
+// for the checksum at the end. A blob larger than the cache goes to memory
+// instead, and the entry is not written.
+class EntrySink : public VPU::BlobSink {
+public:
+    EntrySink(int fd, const std::string &header, uint64_t maxBytes, std::vector<char> &memory)
+            : _fd(fd), _header(header), _maxBytes(maxBytes), _memory(memory) {}
+
+    void start(size_t blobSize) override {
+        _blobSize = blobSize;
+        if (_header.size() + sizeof(uint64_t) + blobSize + sizeof(uint64_t) > _maxBytes) {
+            _inMemory = true;
+            _memory.start(blobSize);
+            return;
+        }
+        put(_header.data(), _header.size());
+        uint64_t size = blobSize;
+        put(&size, sizeof(size));
+        _blobOffset = _written;
+    }
+
+    void write(const void *data, size_t size) override {
+        if (_inMemory) {
+            _memory.write(data, size);
+        } else {
+            put(data, size);
+        }
+    }
+
+    void put(const void *data, size_t size) {
+        _checksum = fnv1a(_checksum, data, size);
+        _ok = _ok && writeAll(_fd, static_cast<const char *>(data), size);
+        _written += size;
+    }
+
+    bool ok() const { return _ok; }
+    bool inMemory() const { return _inMemory; }
+    uint64_t checksum() const { return _checksum; }
+    size_t written() const { return _written; }
+    size_t blobOffset() const { return _blobOffset; }
+    size_t blobSize() const { return _blobSize; }
+
+private:
+    int _fd;
+    const std::string &_header;
+    uint64_t _maxBytes;
+    VPU::VectorBlobSink _memory;
+    bool _inMemory = false;
+    bool _ok = true;
+    uint64_t _checksum = kFnv1aOffset;
+    size_t _written = 0;
+    size_t _blobOffset = 0;
+    size_t _blobSize = 0;
+};
+
+template<typename T>
+void describePorts(std::ostringstream &key, const char *kind, const std::map<std::string, T> &ports) {
+    for (const auto &port : ports) {
+        auto data = port.second;
+        key << ";" << kind << "=" << port.first << ":" << data->getPrecision().name() << ":"
+            << static_cast<int>(data->getLayout()) << ":";
+        for (auto dim : data->getDims()) key << dim << "x";
+    }
+}
+
+}  // namespace
+
+std::vector<char> &GraphBlob::memory() {
+    _mapping.reset();
+    _data = nullptr;
+    _size = 0;
+    return _memory;
+}
+
+void GraphBlob::map(const std::shared_ptr<const void> &mapping, const char *data, size_t size) {
+    std::vector<char>().swap(_memory);
+    _mapping = mapping;
+    _data = data;
+    _size = size;
+}
+
+BlobCache::BlobCache(ICNNNetwork &network, const ParsedConfig &config, int platform, const LoggerPtr &log)
+        : _log(log) {
+    if (config.blobCacheKey.empty()) {
+        return;
+    }
+
+    if (!config.blobCacheDir.empty() && config.blobCacheSize != 0) {
+        if (makeDirs(config.blobCacheDir)) {
+            _dir = config.blobCacheDir;
+            _maxBytes = static_cast<uint64_t>(config.blobCacheSize) << 20;
+        } else {
+            LOG_WARNING("[VPU] blob cache disabled, cannot create %s: %s",
+                        config.blobCacheDir.c_str(), strerror(errno));
+        }
+    }
+    if (_dir.empty() && config.blobCachePrebuiltDir.empty()) {
+        return;
+    }
+
+    const auto &blobConfig = config.blobConfig;
+    std::ostringstream key;
+    key << "format=" << kFormatVersion
+        << ";build=" << CI_BUILD_NUMBER
+        << ";platform=" << platform
+        << ";model=" << config.blobCacheKey
+        << ";shaves=" << blobConfig.firstShave << "-" << blobConfig.lastShave
+        << ";opt=" << blobConfig.memoryOptimization << blobConfig.hwOptimization << blobConfig.useCmxBuffers
+        << blobConfig.copyOptimization << blobConfig.reshapeOptimization << blobConfig.ignoreUnknownLayers
+        << ";planner=" << static_cast<int>(blobConfig.memoryPlanner)
+        << ";cmx=" << blobConfig.cmxBufferStart << "+" << blobConfig.cmxBufferSize
+        << ";input=" << std::hex << floatBits(blobConfig.inputScale) << "," << floatBits(blobConfig.inputBias)
+        << std::dec;
+    if (blobConfig.hwOptimization) {
+        key << ";hwsel=" << static_cast<int>(blobConfig.hwStageSelection);
+    }
+    if (blobConfig.hwOptimization && blobConfig.hwStageSelection == VPU::HwStageSelection::CostModel) {
+        const auto &model = blobConfig.hwCostModel;
+        key << ";hwcost=" << std::hex << floatBits(model.hwMacsPerUs) << "," << floatBits(model.hwBytesPerUs)
+            << "," << floatBits(model.hwDescriptorUs) << "," << floatBits(model.hwStageUs)
+            << "," << floatBits(model.shaveMacsPerUs) << "," << floatBits(model.shaveBytesPerUs)
+            << "," << floatBits(model.im2colEfficiency) << "," << floatBits(model.swStageUs)
+            << "," << floatBits(model.swMargin) << std::dec;
+    }
+    for (const auto &name : blobConfig.NoneLayers) key << ";none=" << name;
+    for (const auto &name : blobConfig.hwWhiteList) key << ";hw+=" << name;
+    for (const auto &name : blobConfig.hwBlackList) key << ";hw-=" << name;
+
+    InputsDataMap inputs;
+    OutputsDataMap outputs;
+    network.getInputsInfo(inputs);
+    network.getOutputsInfo(outputs);
+    describePorts(key, "in", inputs);
+    describePorts(key, "out", outputs);
+
+    _keyText = key.str();
+    std::string fileName = toHex(fnv1a(kFnv1aOffset, _keyText.data(), _keyText.size())) + kSuffix;
+    if (!_dir.empty()) {
+        _path = _dir + "/" + fileName;
+    }
+    if (!config.blobCachePrebuiltDir.empty()) {
+        _prebuiltPath = config.blobCachePrebuiltDir + "/" + fileName;
+    }
+    _enabled = true;
+}
+
+bool BlobCache::load(GraphBlob &blob, std::vector<BlobMetaData> &metaData, size_t &numStages) {
+    if (!_enabled) return false;
+
+    if (!_path.empty() && loadFile(_path, true, blob, metaData, numStages)) {
+        // mark as recently used for eviction
+        utimes(_path.c_str(), nullptr);
+        LOG_INFO("[VPU] blob cache hit %s (%zu bytes)", _path.c_str(), blob.size());
+        return true;
+    }
+    if (!_prebuiltPath.empty() && loadFile(_prebuiltPath, false, blob, metaData, numStages)) {
+        LOG_INFO("[VPU] blob cache prebuilt hit %s (%zu bytes)", _prebuiltPath.c_str(), blob.size());
+        return true;
+    }
+    return false;
+}
+
+bool BlobCache::loadFile(const std::string &path, bool owned,
+                         GraphBlob &blob, std::vector<BlobMetaData> &metaData, size_t &numStages) {
+    auto mapping = std::make_shared<MappedFile>(path);
+    const auto &file = *mapping;
+    if (!file.opened()) {
+        LOG_INFO("[VPU] blob cache miss %s", path.c_str());
+        return false;
+    }
+
+    // prebuilt entries are read-only, a stale one is just skipped
+    auto reject = [&](const char *reason) {
+        LOG_WARNING("[VPU] blob cache %s %s: %s", owned ? "dropping" : "skipping", path.c_str(), reason);
+        if (owned) unlink(path.c_str());
+        return false;
+    };
+
+    uint64_t checksum = 0;
+    if (file.size() < sizeof(kMagic) + sizeof(checksum)) {
+        return reject("truncated");
+    }
+    size_t end = file.size() - sizeof(checksum);
+    std::memcpy(&checksum, file.data() + end, sizeof(checksum));
+    if (std::memcmp(file.data(), kMagic, sizeof(kMagic)) != 0 ||
+        checksum != fnv1a(kFnv1aOffset, file.data(), end)) {
+        return reject("corrupted");
+    }
+
+    // the graph stays in the mapping, for allocateGraph to read from
+    Reader in(file.data(), end);
+    char magic[sizeof(kMagic)];
+    uint32_t format = 0;
+    std::string keyText;
+    if (!in.get(magic) || !in.get(format) || format != kFormatVersion) {
+        return reject("format version mismatch");
+    }
+    if (!in.getString(keyText) || keyText != _keyText) {
+        // also covers entries from an older plugin build, the build is part of the key
+        return reject("key mismatch");
+    }
+
+    uint64_t blobSize = 0;
+    if (!in.get(blobSize) || end - in.pos() < blobSize) {
+        return reject("bad blob");
+    }
+    size_t blobOffset = in.pos();
+    in.skip(blobSize);
+
+    uint64_t stages = 0;
+    uint32_t count = 0;
+    std::vector<BlobMetaData> meta;
+    if (!in.get(stages) || !in.get(count)) {
+        return reject("bad header");
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        BlobMetaData entry;
+        int32_t status = 0;
+        if (!in.getString(entry.name) || !in.getString(entry.exec_type) ||
+            !in.getString(entry.layer_type) || !in.get(status)) {
+            return reject("bad metadata");
+        }
+        entry.status = static_cast<InferenceEngineProfileInfo::LayerStatus>(status);
+        meta.push_back(entry);
+    }
+    if (in.pos() != end) {
+        return reject("bad metadata");
+    }
+
+    blob.map(mapping, file.data() + blobOffset, static_cast<size_t>(blobSize));
+    metaData.swap(meta);
+    numStages = static_cast<size_t>(stages);
+    return true;
+}
+
+bool BlobCache::generate(IGraphTransformer &graphTransformer, ICNNNetwork &network,
+                         GraphBlob &blob, std::vector<BlobMetaData> &metaData, size_t &numStages) {
+    if (!_enabled || _path.empty()) return false;
+
+    std::ostringstream tmpName;
+    tmpName << _path << ".tmp." << getpid() << "." << std::hash<std::thread::id>()(std::this_thread::get_id());
+    std::string tmpPath = tmpName.str();
+
+    // read back through the mapping once written
+    int fd = open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0660);
+    if (fd < 0) {
+        LOG_WARNING("[VPU] blob cache cannot create %s: %s", tmpPath.c_str(), strerror(errno));
+        return false;
+    }
+
+    Writer header;
+    header.putBytes(kMagic, sizeof(kMagic));
+    header.put(kFormatVersion);
+    header.putString(_keyText);
+    EntrySink sink(fd, header.data(), _maxBytes, blob.memory());
+    try {
+        graphTransformer.generate(network, sink, metaData, numStages);
+    } catch (...) {
+        close(fd);
+        unlink(tmpPath.c_str());
+        throw;
+    }
+    if (sink.inMemory()) {
+        close(fd);
+        unlink(tmpPath.c_str());
+        LOG_INFO("[VPU] blob cache skipping %s, larger than the cache", _path.c_str());
+        return true;
+    }
+
+    Writer trailer;
+    trailer.put(static_cast<uint64_t>(numStages));
+    trailer.put(static_cast<uint32_t>(metaData.size()));
+    for (const auto &entry : metaData) {
+        trailer.putString(entry.name);
+        trailer.putString(entry.exec_type);
+        trailer.putString(entry.layer_type);
+        trailer.put(static_cast<int32_t>(entry.status));
+    }
+    sink.put(trailer.data().data(), trailer.data().size());
+    uint64_t checksum = sink.checksum();
+    sink.put(&checksum, sizeof(checksum));
+
+    // the rename must not become visible before the data does
+    bool ok = sink.ok() && fsync(fd) == 0;
+    std::shared_ptr<MappedFile> mapping;
+    if (ok) {
+        mapping = std::make_shared<MappedFile>(fd);
+        ok = mapping->opened() && mapping->size() == sink.written();
+    }
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(tmpPath.c_str(), _path.c_str()) != 0) {
+        LOG_WARNING("[VPU] blob cache cannot write %s: %s", _path.c_str(), strerror(errno));
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    blob.map(mapping, mapping->data() + sink.blobOffset(), sink.blobSize());
+    LOG_INFO("[VPU] blob cache stored %s (%zu bytes)", _path.c_str(), blob.size());
+
+    evict();
+    return true;
+}
+
+void BlobCache::evict() {
+    struct Entry {
+        std::string path;
+        time_t mtime;
+        uint64_t size;
+    };
+
+    DIR *dir = opendir(_dir.c_str());
+    if (dir == nullptr) return;
+
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    time_t now = time(nullptr);
+    while (struct dirent *ent = readdir(dir)) {
+        std::string name = ent->d_name;
+        std::string path = _dir + "/" + name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+
+        if (name.find(kTmpInfix) != std::string::npos) {
+            if (now - st.st_mtime > kStaleTmpSeconds) unlink(path.c_str());
+            continue;
+        }
+        if (!endsWith(name, kSuffix)) continue;
+
+        entries.push_back({path, st.st_mtime, static_cast<uint64_t>(st.st_size)});
+        total += st.st_size;
+    }
+    closedir(dir);
+
+    if (total <= _maxBytes) return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.mtime < b.mtime;
+    });
+    for (const auto &entry : entries) {
+        if (total <= _maxBytes) break;
+        // keep what was just written even if the clock says otherwise
+        if (entry.path == _path) continue;
+        if (unlink(entry.path.c_str()) == 0) {
+            LOG_INFO("[VPU] blob cache evicted %s", entry.path.c_str());
+            total -= entry.size;
+        }
+    }
+}
+
+bool VPU::MyriadPlugin::loadOrCompileBlob(ICNNNetwork &network, ParsedConfig &config, int platform,
+                                          const LoggerPtr &log, GraphBlob &blob,
+                                          std::vector<BlobMetaData> &metaData, size_t &numStages,
+                                          CompileProfile *profile) {
+    const auto &_log = log;  // for the LOG_ macros
+    // ignore hardware optimization config for MYRIAD2, it is always disabled
+    if (platform == MYRIAD_2) {
+        config.blobConfig.hwOptimization = false;
+        LOG_INFO("[VPU] hardware optimization config for MYRIAD2 always disabled");
+    }
+
+    BlobCache blobCache(network, config, platform, log);
+    if (blobCache.load(blob, metaData, numStages)) {
+        return true;
+    }
+
+    auto graphTransformer = createGraphTransformer(config.blobConfig, log);
+    if (!blobCache.generate(*graphTransformer, network, blob, metaData, numStages)) {
+        // no entry to stream into, or it could not be written: compile
+        // again into memory, with a transformer that has not run
+        graphTransformer = createGraphTransformer(config.blobConfig, log);
+        graphTransformer->generate(network, blob.memory(), metaData, numStages);
+    }
+    LOG_INFO("[VPU] graphTransformer->generate done");
+    if (profile != nullptr) {
+        *profile = graphTransformer->profile();
+    }
+    return false;
+}
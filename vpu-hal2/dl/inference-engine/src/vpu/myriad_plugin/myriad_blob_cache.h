@@ -0,0 +1,124 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2017 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <ie_icnn_network.hpp>
+#include <graph_transformer.hpp>
+#include <parsed_config.h>
+#include <vpu_logger.h>
+
+namespace VPU {
+namespace MyriadPlugin {
+
+// A compiled blob as allocateGraph takes it: mapped from its cache entry, or
+// in memory when it has none. Copies share the mapping.
+class GraphBlob {
+public:
+    const char *data() const { return _mapping ? _data : _memory.data(); }
+    size_t size() const { return _mapping ? _size : _memory.size(); }
+
+    // drops the mapping, for the graph transformer to fill
+    std::vector<char> &memory();
+    // data is in the mapping, which stays until its last user goes
+    void map(const std::shared_ptr<const void> &mapping, const char *data, size_t size);
+
+private:
+    std::shared_ptr<const void> _mapping;
+    const char *_data = nullptr;
+    size_t _size = 0;
+    std::vector<char> _memory;
+};
+
+// Persistent cache of compiled graph blobs, so that loading a network which
+// was compiled before skips the graph transformer and goes straight to
+// allocateGraph.
+//
+// Entries are keyed on the caller supplied content hash of the source model
+// (KEY_VPU_BLOB_CACHE_KEY), the blob config, the network inputs/outputs, the
+// platform and the plugin build. Each entry is one file written to a
+// temporary name and renamed into place, so readers never see a partial
+// blob. A miss streams the graph transformer output into the entry, and a
+// hit or a fresh entry is handed to allocateGraph mapped. File mtime is bumped on every hit and the least recently used
+// entries are removed once the directory grows over KEY_VPU_BLOB_CACHE_SIZE.
+// Entries written by another format or plugin build are dropped on lookup.
+// On a miss the read-only KEY_VPU_BLOB_CACHE_PREBUILT_DIR is searched for the
+// same file name, that is where blobs compiled ahead of time by the blob
+// compiler are installed.
+class BlobCache {
+public:
+    BlobCache(InferenceEngine::ICNNNetwork &network,
+              const Common::ParsedConfig &config,
+              int platform,
+              const Common::LoggerPtr &log);
+
+    bool enabled() const { return _enabled; }
+
+    bool load(GraphBlob &blob, std::vector<BlobMetaData> &metaData, size_t &numStages);
+
+    // Runs the graph transformer into a new entry. Returns false, having
+    // written nothing, when the entry cannot be written; blob is left in
+    // memory when it is larger than the cache.
+    bool generate(IGraphTransformer &graphTransformer, InferenceEngine::ICNNNetwork &network,
+                  GraphBlob &blob, std::vector<BlobMetaData> &metaData, size_t &numStages);
+
+private:
+    bool loadFile(const std::string &path, bool owned,
+                  GraphBlob &blob, std::vector<BlobMetaData> &metaData, size_t &numStages);
+    void evict();
+
+    Common::LoggerPtr _log;
+    bool _enabled = false;
+    std::string _dir;
+    uint64_t _maxBytes = 0;
+    std::string _keyText;
+    std::string _path;
+    std::string _prebuiltPath;
+};
+
+// Takes the blob from the cache, or runs the graph transformer and stores the
+// result. The offline blob compiler goes through here as well, so blobs built
+// ahead of time are keyed exactly like the ones a device load looks up.
+// Returns true on a cache hit. When the graph transformer runs, its pass
+// timings go to profile if one is given.
+bool loadOrCompileBlob(InferenceEngine::ICNNNetwork &network,
+                       Common::ParsedConfig &config,
+                       int platform,
+                       const Common::LoggerPtr &log,
+                       GraphBlob &blob,
+                       std::vector<BlobMetaData> &metaData,
+                       size_t &numStages,
+                       CompileProfile *profile = nullptr);
+
+}  // namespace MyriadPlugin
+}  // namespace VPU
@@ -0,0 +1,136 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2017 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+
+#include <algorithm>
+#include <ie_common.h>
+
+#include "myriad_device_scheduler.h"
+
+using namespace VPU::Common;
+using namespace VPU::MyriadPlugin;
+
+constexpr std::chrono::milliseconds DeviceScheduler::kRetryDelay;
+constexpr std::chrono::milliseconds DeviceScheduler::kMaxRetryDelay;
+
+DeviceScheduler::DeviceScheduler(const std::vector<DeviceGraphPtr> &graphs, const Probe &probe,
+                                 const LoggerPtr &log, std::chrono::milliseconds retryDelay) :
+        _graphs(graphs), _probe(probe), _log(log), _retryDelay(retryDelay) {
+    if (_graphs.empty()) {
+        THROW_IE_EXCEPTION << "[VPU] Network is not allocated on any device";
+    }
+}
+
+void DeviceScheduler::probeDue() {
+    // A device is probed only once the inferences it got before it failed
+    // are done, the probe would wait behind them otherwise.
+    std::vector<DeviceGraphPtr> due;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto now = std::chrono::steady_clock::now();
+        for (auto &graph : _graphs) {
+            if (!graph->_healthy && !graph->_probing && graph->_outstanding == 0 && graph->_retryAt <= now) {
+                graph->_probing = true;
+                due.push_back(graph);
+            }
+        }
+    }
+
+    // unlocked, the other requests keep going to the healthy devices meanwhile
+    for (auto &graph : due) {
+        LOG_INFO("[VPU] Probing device %d", graph->_device->_deviceIdx);
+        bool ok = true;
+        try {
+            _probe(*graph);
+        } catch (...) {
+            ok = false;
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        graph->_probing = false;
+        if (ok) {
+            graph->_healthy = true;
+            graph->_consecutiveErrors = 0;
+            LOG_WARNING("[VPU] Device %d recovered, scheduling on it again", graph->_device->_deviceIdx);
+        } else {
+            graph->_retryDelay = std::min(graph->_retryDelay * 2, kMaxRetryDelay);
+            graph->_retryAt = std::chrono::steady_clock::now() + graph->_retryDelay;
+        }
+    }
+}
+
+DeviceGraphPtr DeviceScheduler::acquire(const std::vector<DeviceGraphPtr> &tried) {
+    probeDue();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto untried = [&](const DeviceGraphPtr &graph) {
+        return std::find(tried.begin(), tried.end(), graph) == tried.end();
+    };
+
+    DeviceGraphPtr best;
+    size_t count = _graphs.size();
+    for (size_t i = 0; i < count; i++) {
+        auto &graph = _graphs[(_next + i) % count];
+        if (graph->_healthy && untried(graph) &&
+            (best == nullptr || graph->_outstanding < best->_outstanding)) {
+            best = graph;
+        }
+    }
+    if (best == nullptr) {
+        THROW_IE_EXCEPTION << "[VPU] All " << count << " devices failed";
+    }
+    _next = (_next + 1) % count;
+    best->_outstanding++;
+    return best;
+}
+
+void DeviceScheduler::release(const DeviceGraphPtr &graph, bool ok) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    graph->_outstanding--;
+    if (ok) {
+        graph->_consecutiveErrors = 0;
+        return;
+    }
+    if (++graph->_consecutiveErrors < kMaxConsecutiveErrors || !graph->_healthy) {
+        return;
+    }
+    // the last device keeps getting work, there is nothing to fail over to
+    size_t healthy = 0;
+    for (auto &other : _graphs) {
+        healthy += other->_healthy ? 1 : 0;
+    }
+    if (healthy > 1) {
+        graph->_healthy = false;
+        graph->_retryDelay = _retryDelay;
+        graph->_retryAt = std::chrono::steady_clock::now() + _retryDelay;
+        LOG_WARNING("[VPU] Device %d failed %d times in a row, no longer scheduling on it",
+                    graph->_device->_deviceIdx, graph->_consecutiveErrors);
+    }
+}
@@ -0,0 +1,112 @@
+//
+// INTEL CONFIDENTIAL
+// Copyright 2017 Intel Corporation.
+//
+// The source code contained or described herein and all documents
+// related to the source code ("Material") are owned by Intel Corporation
+// or its suppliers or licensors. Title to the Material remains with
+// Intel Corporation or its suppliers and licensors. The Material may
+// contain trade secrets and proprietary and confidential information
+// of Intel Corporation and its suppliers and licensors, and is protected
+// by worldwide copyright and trade secret laws and treaty provisions.
+// No part of the Material may be used, copied, reproduced, modified,
+// published, uploaded, posted, transmitted, distributed, or disclosed
+// in any way without Intel's prior express written permission.
+//
+// No license under any patent, copyright, trade secret or other
+// intellectual property right is granted to or conferred upon you by
+// disclosure or delivery of the Materials, either expressly, by implication,
+// inducement, estoppel or otherwise. Any license under such intellectual
+// property rights must be express and approved by Intel in writing.
+//
+// Include any supplier copyright notices as supplier requires Intel to use.
+//
+// Include supplier trademarks or logos as supplier requires Intel to use,
+// preceded by an asterisk. An asterisked footnote can be added as follows:
+// *Third Party trademarks are the property of their respective owners.
+//
+// Unless otherwise agreed by Intel in writing, you may not remove or alter
+// this notice or any other notice embedded in Materials by Intel or Intel's
+// suppliers or licensors in any way.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vpu_logger.h>
+#include "myriad_executor.h"
+
+namespace VPU {
+namespace MyriadPlugin {
+
+// A network allocated on one device.
+struct DeviceGraph {
+    DevicePtr _device;
+    GraphDesc _graphDesc;
+
+    // inferences queued and not yet collected
+    int _outstanding = 0;
+    int _consecutiveErrors = 0;
+    bool _healthy = true;
+
+    // when an unhealthy device is probed next, and the wait after that
+    std::chrono::steady_clock::time_point _retryAt;
+    std::chrono::milliseconds _retryDelay{0};
+    bool _probing = false;
+};
+
+typedef std::shared_ptr<DeviceGraph> DeviceGraphPtr;
+
+// Spreads the inferences of one executable network over the devices it is
+// allocated on. Every inference goes to the healthy device with the fewest
+// outstanding inferences; a request collects its result from the device it
+// queued on, so results never cross requests. A device that fails
+// kMaxConsecutiveErrors times in a row is taken out of rotation, unless it
+// is the last healthy one. After retryDelay the next acquire runs the probe
+// on it, an inference of its own rather than one of a request, and if the
+// probe succeeds the device is back in rotation. Otherwise the delay
+// doubles, up to kMaxRetryDelay.
+class DeviceScheduler {
+public:
+    static const int kMaxConsecutiveErrors = 3;
+    static constexpr std::chrono::milliseconds kRetryDelay{1000};
+    static constexpr std::chrono::milliseconds kMaxRetryDelay{60000};
+
+    // Runs one inference on the device, throws if it fails.
+    typedef std::function<void(DeviceGraph &graph)> Probe;
+
+    DeviceScheduler(const std::vector<DeviceGraphPtr> &graphs, const Probe &probe,
+                    const Common::LoggerPtr &log, std::chrono::milliseconds retryDelay = kRetryDelay);
+
+    // Picks a healthy device for the next inference and counts it as
+    // outstanding, after probing the unhealthy devices that are due. The
+    // devices in tried already failed to take this inference and are
+    // skipped. Throws when no healthy device is left.
+    DeviceGraphPtr acquire(const std::vector<DeviceGraphPtr> &tried = std::vector<DeviceGraphPtr>());
+
+    // Retires an inference taken with acquire, ok tells whether the device
+    // handled it without error.
+    void release(const DeviceGraphPtr &graph, bool ok);
+
+    const std::vector<DeviceGraphPtr> &graphs() const { return _graphs; }
+
+private:
+    void probeDue();
+
+    std::vector<DeviceGraphPtr> _graphs;
+    Probe _probe;
+    Common::LoggerPtr _log;
+    std::chrono::milliseconds _retryDelay;
+    std::mutex _mutex;
+    // rotates the starting point so ties do not always land on the first device
+    size_t _next = 0;
+};
+
+typedef std::shared_ptr<DeviceScheduler> DeviceSchedulerPtr;
+
+}  // namespace MyriadPlugin
+}  // namespace VPU
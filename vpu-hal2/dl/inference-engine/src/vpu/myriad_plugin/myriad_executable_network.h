@@ -35,12 +35,15 @@
 #include <vector>
 #include <map>
 #include <queue>
+#include <algorithm>
 #include <sstream>
 #include <ie_common.h>
 #include <cpp_interfaces/impl/ie_executable_network_thread_safe_default.hpp>
 #include <cpp_interfaces/ie_executor_manager.hpp>
 #include "myriad_executor.h"
+#include "myriad_device_scheduler.h"
 #include "myriad_executable_network.h"
+#include "myriad_blob_cache.h"
 #include "graph_transformer.hpp"
 #include "myriad_infer_request.h"
 #include <environment.h>
@@ -76,32 +79,61 @@ public:
         _log->init(logLevel);
 
         _executor = std::make_shared<MyriadExecutor>(vpuLogLevel, _log);
-        _device = _executor->openDevice(devicePool);
-        _env = std::make_shared<Common::Environment>(_device->_platform, config);
-        // ignore hardware optimization config for MYRIAD2, it is always disabled
-        if (_device->_platform == MYRIAD_2) {
-            _env->parsedConfig.blobConfig.hwOptimization = false;
-            LOG_INFO("[VPU] hardware optimization config for MYRIAD2 always disabled");
+        bool multiDevice = false;
+        auto multiDeviceOption = config.find(VPU_CONFIG_KEY(MULTI_DEVICE));
+        if (multiDeviceOption != config.end()) {
+            multiDevice = multiDeviceOption->second == CONFIG_VALUE(YES);
         }
+        if (multiDevice) {
+            _devices = _executor->openDevices(devicePool);
+        } else {
+            _devices.push_back(_executor->openDevice(devicePool));
+        }
+        int platform = _devices.front()->_platform;
+        _env = std::make_shared<Common::Environment>(platform, config);
 
-        auto graphTrasnformer = createGraphTransformer(_env->parsedConfig.blobConfig, _log);
-
+        // the devices keep their own copy, this one goes once they have it
+        GraphBlob graphBlob;
         size_t numStages = 0;
-        graphTrasnformer->generate(network, _graphBlob, _env->blobMetaData, numStages);
-
-        LOG_INFO("[VPU] ExecutableNetwork : graphTrasnformer->generate done");
+        loadOrCompileBlob(network, _env->parsedConfig, platform, _log,
+                          graphBlob, _env->blobMetaData, numStages);
 
         char networkName[1024] = {};
         network.getName(networkName, sizeof(networkName));
         LOG_INFO("[VPU] org network name %s", networkName);
-        _executor->allocateGraph(_device, _graphDesc, _graphBlob, numStages, networkName);
-        LOG_INFO("[VPU] _executor->allocateGraph");
+        std::vector<DeviceGraphPtr> graphs;
+        size_t totalExecutors = 0;
+        for (auto &device : _devices) {
+            auto graph = std::make_shared<DeviceGraph>();
+            graph->_device = device;
+            try {
+                _executor->allocateGraph(device, graph->_graphDesc, graphBlob.data(), graphBlob.size(), numStages, networkName,
+                                         _env->parsedConfig.graphExecutors, _env->parsedConfig.fifoDepth);
+            } catch (const InferenceEngine::details::InferenceEngineException &error) {
+                if (!multiDevice) {
+                    throw;
+                }
+                // the other devices can still run the network
+                LOG_WARNING("[VPU] Skipping device %d: %s", device->_deviceIdx, error.what());
+                _executor->deallocateGraph(device, graph->_graphDesc);
+                continue;
+            }
+            totalExecutors += graph->_graphDesc._executors;
+            graphs.push_back(graph);
+        }
+        auto executor = _executor;
+        auto probe = [executor](DeviceGraph &graph) { executor->probe(graph._graphDesc); };
+        _scheduler = std::make_shared<DeviceScheduler>(graphs, probe, _log);
+        LOG_INFO("[VPU] _executor->allocateGraph on %zu devices", graphs.size());
         if (_env->parsedConfig.exclusiveAsyncRequests) {
             InferenceEngine::ExecutorManager *executorManager = InferenceEngine::ExecutorManager::getInstance();
             _taskExecutor = executorManager->getExecutor(
                     InferenceEngine::TargetDeviceInfo::name(InferenceEngine::TargetDevice::eMYRIAD));
         }
 
+        // one result reader per device executor, so converting the output of one
+        // inference overlaps waiting for the next
+        _maxTaskExecutorGetResultCount = std::max<size_t>(totalExecutors, 1);
         for (size_t i = 0; i < _maxTaskExecutorGetResultCount; i++) {
             std::stringstream idStream;
             idStream << networkName << "_TaskExecutorGetResult" << i;
@@ -110,16 +142,20 @@ public:
     }
 
     ~ExecutableNetwork() {
-        _executor->deallocateGraph(_device, _graphDesc);
+        if (_scheduler != nullptr) {
+            for (auto &graph : _scheduler->graphs()) {
+                _executor->deallocateGraph(graph->_device, graph->_graphDesc);
+            }
+        }
     }
 
     InferenceEngine::InferRequestInternal::Ptr CreateInferRequestImpl(InferenceEngine::InputsDataMap networkInputs,
                                                                       InferenceEngine::OutputsDataMap networkOutputs) override {
-        return std::make_shared<MyriadInferRequest>(_graphDesc, networkInputs, networkOutputs, _env, _log, _executor);
+        return std::make_shared<MyriadInferRequest>(_scheduler, networkInputs, networkOutputs, _env, _log, _executor);
     }
 
     void CreateInferRequest(InferenceEngine::IInferRequest::Ptr &asyncRequest) override {
-        auto syncRequestImpl = std::make_shared<MyriadInferRequest>(_graphDesc, _networkInputs, _networkOutputs, _env, _log,
+        auto syncRequestImpl = std::make_shared<MyriadInferRequest>(_scheduler, _networkInputs, _networkOutputs, _env, _log,
                                                                     _executor);
         syncRequestImpl->setPointerToExecutableNetworkInternal(shared_from_this());
         auto taskExecutorGetResult = getNextTaskExecutotGetResult();
@@ -144,11 +180,10 @@ private:
     Common::EnvironmentPtr _env;
     Common::LoggerPtr _log;
     MyriadExecutorPtr _executor;
-    std::vector<char> _graphBlob;
-    GraphDesc _graphDesc;
-    DevicePtr _device;
+    std::vector<DevicePtr> _devices;
+    DeviceSchedulerPtr _scheduler;
 
-    const size_t _maxTaskExecutorGetResultCount = 1;
+    size_t _maxTaskExecutorGetResultCount = 1;
     std::queue<std::string> _taskExecutorGetResultIds;
 
     InferenceEngine::ITaskExecutor::Ptr getNextTaskExecutotGetResult() {
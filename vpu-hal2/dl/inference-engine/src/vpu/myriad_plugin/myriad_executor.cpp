@@ -34,6 +34,7 @@
 #include <string>
 #include <vector>
 #include <mutex>
+#include <algorithm>
 #include <sys/stat.h>
 #include <dirent.h>
 
@@ -81,6 +82,35 @@ MyriadExecutor::MyriadExecutor(const LogLevel& vpuLogLevel, const LoggerPtr& log
     }
 }
 
+// Boots the next device that is not in the pool yet. Caller holds device_mutex.
+DevicePtr MyriadExecutor::bootNextDevice(std::vector<DevicePtr> &devicePool,
+                                         ncStatus_t &statusInit, ncStatus_t &statusOpen) {
+    int deviceIdx = devicePool.size();
+    DeviceDesc device;
+    statusInit = ncDeviceInit(deviceIdx, &device._deviceHandle);
+    if (statusInit != NC_OK) {
+        return nullptr;
+    }
+    statusOpen = ncDeviceOpen(device._deviceHandle);
+    if (statusOpen != NC_OK) {
+        return nullptr;
+    }
+    unsigned int dataLength = 0;
+/*    if (NC_OK != ncDeviceGetOption(device._deviceHandle, NC_OPTION_CLASS0,
+            NC_RO_DEVICE_PLATFORM, reinterpret_cast<void*>(&device._platform), &dataLength)
+        || dataLength != sizeof(device._platform)) {
+        LOG_WARNING("WARNING: Failed to get device platform");
+    }
+*/
+#ifdef AKS
+    device._platform = 2450; //fixed for Myriad 2450
+#endif
+    device._executors = 1;
+    device._deviceIdx = deviceIdx;
+    devicePool.push_back(std::make_shared<DeviceDesc>(device));
+    return devicePool.back();
+}
+
 DevicePtr MyriadExecutor::openDevice(std::vector<DevicePtr> &devicePool) {
     std::lock_guard<std::mutex> lock(device_mutex);
     ncStatus_t statusInit = NC_ERROR;
@@ -96,29 +126,7 @@ DevicePtr MyriadExecutor::openDevice(std::vector<DevicePtr> &devicePool) {
     }
 
     // try to boot next device if any
-    if (statusInit != NC_OK) {
-        deviceIdx = devicePool.size();
-        DeviceDesc device;
-        statusInit = ncDeviceInit(deviceIdx, &device._deviceHandle);
-        if (statusInit == NC_OK) {
-            statusOpen = ncDeviceOpen(device._deviceHandle);
-            if (statusOpen == NC_OK) {
-                unsigned int dataLength = 0;
-/*                if (NC_OK != ncDeviceGetOption(device._deviceHandle, NC_OPTION_CLASS0,
-                        NC_RO_DEVICE_PLATFORM, reinterpret_cast<void*>(&device._platform), &dataLength)
-                    || dataLength != sizeof(device._platform)) {
-                    LOG_WARNING("WARNING: Failed to get device platform");
-                }
-*/
-#ifdef AKS
-                device._platform = 2450; //fixed for Myriad 2450
-#endif
-                device._executors = 1;
-                device._deviceIdx = deviceIdx;
-                devicePool.push_back(std::make_shared<DeviceDesc>(device));
-            }
-        }
-    }
+    auto device = bootNextDevice(devicePool, statusInit, statusOpen);
 
     // attach one more executor to already booted device
     if (statusInit != NC_OK) {
@@ -137,11 +145,58 @@ DevicePtr MyriadExecutor::openDevice(std::vector<DevicePtr> &devicePool) {
     if (statusOpen != NC_OK) {
         THROW_IE_EXCEPTION << "Can not open USB device: " << ncStatusToStr(nullptr, statusOpen);
     }
-    if (devicePool[deviceIdx]->_platform == UNKNOWN_DEVICE) {
+    if (device->_platform == UNKNOWN_DEVICE) {
+        THROW_IE_EXCEPTION << "Unknown device";
+    }
+
+    return device;
+}
+
+std::vector<DevicePtr> MyriadExecutor::openDevices(std::vector<DevicePtr> &devicePool) {
+    std::lock_guard<std::mutex> lock(device_mutex);
+    ncStatus_t statusInit = NC_ERROR;
+    ncStatus_t statusOpen = NC_ERROR;
+    std::vector<DevicePtr> devices;
+
+    // one graph slot on every booted device that has a free one
+    for (auto &device : devicePool) {
+        if (device->_deviceHandle != nullptr && device->_executors < DEVICE_MAX_GRAPHS) {
+            device->_executors += 1;
+            devices.push_back(device);
+        }
+    }
+
+    // and every device that is not booted yet
+    while (auto device = bootNextDevice(devicePool, statusInit, statusOpen)) {
+        devices.push_back(device);
+    }
+
+    // all devices must run the same blob
+    if (!devices.empty()) {
+        int platform = devices.front()->_platform;
+        for (auto it = devices.begin(); it != devices.end();) {
+            if ((*it)->_platform != platform) {
+                LOG_WARNING("Skipping device %d: platform %d differs from %d", (*it)->_deviceIdx, (*it)->_platform, platform);
+                (*it)->_executors -= 1;
+                it = devices.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    if (devices.empty()) {
+        if (statusInit != NC_OK) {
+            THROW_IE_EXCEPTION << "Can not init USB device: " << ncStatusToStr(nullptr, statusInit);
+        }
+        THROW_IE_EXCEPTION << "Can not open USB device: " << ncStatusToStr(nullptr, statusOpen);
+    }
+    if (devices.front()->_platform == UNKNOWN_DEVICE) {
         THROW_IE_EXCEPTION << "Unknown device";
     }
+    LOG_INFO("MyriadExecutor::openDevices opened %zu devices", devices.size());
 
-    return devicePool[deviceIdx];
+    return devices;
 }
 
 void MyriadExecutor::closeDevices(std::vector<DevicePtr> &devicePool) {
@@ -166,7 +221,8 @@ void MyriadExecutor::closeDevices(std::vector<DevicePtr> &devicePool) {
 }
 
 void MyriadExecutor::allocateGraph(DevicePtr &device, GraphDesc &graphDesc,
-        const std::vector<char> &graphFileContent, size_t numStages, const char* networkName) {
+        const char *graphFile, size_t graphFileSize, size_t numStages, const char* networkName,
+        int executors, int fifoDepth) {
 
     LOG_INFO("MyriadExecutor::allocateGraph");
     if (device->_deviceHandle == nullptr) {
@@ -184,14 +240,17 @@ void MyriadExecutor::allocateGraph(DevicePtr &device, GraphDesc &graphDesc,
     if (status != NC_OK) {
         THROW_IE_EXCEPTION << "Failed to init graph: " << ncStatusToStr(nullptr, status);
     }
-    int executors = device->_platform == MYRIAD_X ? 2 : 1;
+    if (executors <= 0) {
+        executors = device->_platform == MYRIAD_X ? 2 : 1;
+    }
+    LOG_INFO("MyriadExecutor::allocateGraph executors %d, FIFO depth %d", executors, fifoDepth);
 
     status = ncGraphSetOption(graphDesc._graphHandle, NC_OPTION_CLASS1, NC_RW_GRAPH_EXECUTORS_NUM, &executors, sizeof(executors));
     if (status != NC_OK) {
         THROW_IE_EXCEPTION << "Failed to set graph executors: " << ncStatusToStr(nullptr, status);
     }
 
-    status = ncGraphAllocate(device->_deviceHandle, graphDesc._graphHandle, graphFileContent.data(), graphFileContent.size());
+    status = ncGraphAllocate(device->_deviceHandle, graphDesc._graphHandle, graphFile, graphFileSize);
     if (status != NC_OK) {
         THROW_IE_EXCEPTION << "Failed to allocate graph: " << ncStatusToStr(nullptr, status);
     }
@@ -230,14 +289,13 @@ void MyriadExecutor::allocateGraph(DevicePtr &device, GraphDesc &graphDesc,
         THROW_IE_EXCEPTION << "Failed to get output description: " << ncStatusToStr(graphDesc._graphHandle, status);
     }
 
-    int fifo_elements = 4;
+    // The FIFOs hold the inferences in flight, keep at least one slot per executor
+    // so the device never idles waiting for the host to queue the next frame.
+    int fifo_elements = std::max(fifoDepth, executors);
 
-    status = ncFifoInit(NC_FIFO_HOST_WO, &graphDesc._inputFifoHandle);
-    if (status != NC_OK) {
-        THROW_IE_EXCEPTION << "Failed to init input FIFO: " << ncStatusToStr(graphDesc._graphHandle, status);
-    }
-
-    status = ncFifoCreate(graphDesc._inputFifoHandle, device->_deviceHandle, graphDesc._inputDesc, fifo_elements);
+    graphDesc._deviceHandle = device->_deviceHandle;
+    graphDesc._fifoDepth = fifo_elements;
+    status = createInputFifo(graphDesc);
     if (status != NC_OK) {
         THROW_IE_EXCEPTION << "Failed to create input FIFO: " << ncStatusToStr(graphDesc._graphHandle, status);
     }
@@ -251,17 +309,53 @@ void MyriadExecutor::allocateGraph(DevicePtr &device, GraphDesc &graphDesc,
     if (status != NC_OK) {
         THROW_IE_EXCEPTION << "Failed to create output FIFO: " << ncStatusToStr(graphDesc._graphHandle, status);
     }
+
+    graphDesc._executors = executors;
+    graphDesc._inferQueue = std::make_shared<InferQueue>();
+}
+
+ncStatus_t MyriadExecutor::createInputFifo(GraphDesc &graphDesc) {
+    ncStatus_t status = ncFifoInit(NC_FIFO_HOST_WO, &graphDesc._inputFifoHandle);
+    if (status != NC_OK) {
+        return status;
+    }
+
+    // Don't wait for the input upload in queueInference, so the next request
+    // is sent while the device is still busy with the previous ones. The input
+    // isn't copied either, the infer queue holds it until its result is read
+    int asyncWrite = NC_FIFO_ASYNC_WRITE_IN_PLACE;
+    status = ncFifoSetOption(graphDesc._inputFifoHandle, NC_RW_FIFO_ASYNC_WRITE, &asyncWrite, sizeof(asyncWrite));
+    if (status != NC_OK) {
+        LOG_WARNING("Asynchronous input writes are not supported, falling back to blocking writes");
+    }
+
+    return ncFifoCreate(graphDesc._inputFifoHandle, graphDesc._deviceHandle, graphDesc._inputDesc,
+                        static_cast<unsigned int>(graphDesc._fifoDepth));
 }
 
-void MyriadExecutor::queueInference(GraphDesc &graphDesc, void *input_data, size_t input_bytes,
-                    void **result_data, size_t *result_bytes) {
+uintptr_t MyriadExecutor::queueInference(GraphDesc &graphDesc, void *input_data, size_t input_bytes,
+                                         std::shared_ptr<void> inputOwner) {
+    ncTensorSegment_t segment;
+    segment.data = input_data;
+    segment.length = static_cast<unsigned int>(input_bytes);
+    return queueInference(graphDesc, std::vector<ncTensorSegment_t>{segment}, inputOwner);
+}
+
+uintptr_t MyriadExecutor::queueInference(GraphDesc &graphDesc, const std::vector<ncTensorSegment_t> &input_segments,
+                                         std::shared_ptr<void> inputOwner) {
+    size_t input_bytes = 0;
+    for (auto &segment : input_segments) {
+        input_bytes += segment.length;
+    }
 #ifndef NDEBUG
     if (auto dumpFileName = std::getenv("IE_VPU_DUMP_INPUT_FILE_NAME")) {
         std::ofstream file(dumpFileName, std::ios_base::binary | std::ios_base::out);
         if (!file.is_open()) {
             THROW_IE_EXCEPTION << "[VPU] Cannot open file " << dumpFileName << " for writing";
         }
-        file.write(static_cast<const char*>(input_data), input_bytes);
+        for (auto &segment : input_segments) {
+            file.write(static_cast<const char*>(segment.data), segment.length);
+        }
     }
 #endif
 
@@ -273,41 +367,136 @@ void MyriadExecutor::queueInference(GraphDesc &graphDesc, void *input_data, size
         THROW_IE_EXCEPTION << "Input has unexpected size " << input_bytes << ", expected " << graphDesc._inputDesc->totalSize;
     }
 
+    auto &inferQueue = *graphDesc._inferQueue;
+    // ncsdk moves the user param of the oldest input to the output FIFO on
+    // every trigger, so a write and its trigger must not interleave with another pair
+    std::lock_guard<std::mutex> lock(inferQueue.queueMutex);
+    uintptr_t tag = inferQueue.nextTag++;
+    if (inputOwner != nullptr) {
+        // before the write, a failed one may still be reading the input
+        std::lock_guard<std::mutex> inputsLock(inferQueue.mutex);
+        inferQueue.inputs[tag] = inputOwner;
+    }
+
+    if (graphDesc._inputFifoHandle == nullptr) {
+        THROW_IE_EXCEPTION << "Failed to queue inference: the input FIFO was lost after an earlier failure";
+    }
+
     ncStatus_t status;
 
-    status = ncFifoWriteElem(graphDesc._inputFifoHandle, input_data, graphDesc._inputDesc, nullptr);
+    status = ncFifoWriteElemSegments(graphDesc._inputFifoHandle, input_segments.data(),
+                                     static_cast<unsigned int>(input_segments.size()),
+                                     graphDesc._inputDesc, reinterpret_cast<void *>(tag));
     if (status != NC_OK) {
         THROW_IE_EXCEPTION << "Failed to write input to FIFO: " << ncStatusToStr(graphDesc._graphHandle, status);
     }
 
     status = ncGraphQueueInference(graphDesc._graphHandle, &graphDesc._inputFifoHandle, &graphDesc._outputFifoHandle);
     if (status != NC_OK) {
+        // The input stays in the FIFO and the next trigger would run it in
+        // place of its own, one input short for good. ncsdk can't take it
+        // back out, so the input FIFO starts over; inferences already
+        // triggered keep their place in the output FIFO. No result comes
+        // for this tag, so its input goes now.
+        auto deleted = ncFifoDelete(graphDesc._inputFifoHandle);
+        if (deleted != NC_OK) {
+            LOG_WARNING("ncFifoDelete result %s", ncStatusToStr(nullptr, deleted));
+        }
+        graphDesc._inputFifoHandle = nullptr;
+        auto created = createInputFifo(graphDesc);
+        if (created != NC_OK) {
+            LOG_WARNING("Failed to create input FIFO again: %s", ncStatusToStr(nullptr, created));
+            graphDesc._inputFifoHandle = nullptr;
+        }
+        {
+            std::lock_guard<std::mutex> inputsLock(inferQueue.mutex);
+            inferQueue.inputs.erase(tag);
+        }
         THROW_IE_EXCEPTION << "Failed to queue inference: " << ncStatusToStr(graphDesc._graphHandle, status);
     }
 
-    if (result_data != nullptr && result_bytes != nullptr) {
-        getResult(graphDesc, result_data, result_bytes);
-    }
+    return tag;
 }
 
-void MyriadExecutor::getResult(GraphDesc &graphDesc, void **result_data, size_t *result_bytes) {
+void MyriadExecutor::getResult(GraphDesc &graphDesc, uintptr_t tag, std::vector<uint8_t> &result) {
     LOG_INFO("Graph result");
 #ifdef NNLOG
     ALOGI("Graph result");
 #endif
-    ncStatus_t status;
-    ncTensorDescriptor_t resDesc = {};
-    void *userParam = nullptr;
-    status = ncFifoReadElem(graphDesc._outputFifoHandle, result_data, &resDesc, &userParam);
-    if (status != NC_OK) {
-        THROW_IE_EXCEPTION << "Failed to read output from FIFO: " << ncStatusToStr(graphDesc._graphHandle, status);
-    }
+    auto &inferQueue = *graphDesc._inferQueue;
+    std::unique_lock<std::mutex> lock(inferQueue.mutex);
+    for (;;) {
+        auto found = inferQueue.results.find(tag);
+        if (found != inferQueue.results.end()) {
+            result.swap(found->second);
+            inferQueue.results.erase(found);
+            return;
+        }
+        if (inferQueue.reading) {
+            inferQueue.resultReady.wait(lock);
+            continue;
+        }
+
+        // Only one request reads the output FIFO at a time: ncsdk hands out the
+        // same buffer on every read, so it has to be copied before the next one.
+        inferQueue.reading = true;
+        lock.unlock();
+
+        ncStatus_t status;
+        void *resultData = nullptr;
+        ncTensorDescriptor_t resDesc = {};
+        void *userParam = nullptr;
+        status = ncFifoReadElem(graphDesc._outputFifoHandle, &resultData, &resDesc, &userParam);
+
+        auto readTag = reinterpret_cast<uintptr_t>(userParam);
+        std::vector<uint8_t> other;
+        bool valid = status == NC_OK && resDesc.totalSize == graphDesc._outputDesc->totalSize;
+        if (valid) {
+            auto &dst = readTag == tag ? result : other;
+            auto src = static_cast<const uint8_t *>(resultData);
+            dst.assign(src, src + resDesc.totalSize);
+        }
 
-    if (resDesc.totalSize != graphDesc._outputDesc->totalSize) {
-        THROW_IE_EXCEPTION << "Output has unexpected size " << resDesc.totalSize << ", expected " << graphDesc._outputDesc->totalSize;
+        lock.lock();
+        inferQueue.reading = false;
+        if (status == NC_OK) {
+            inferQueue.inputs.erase(inferQueue.inputs.begin(), inferQueue.inputs.upper_bound(readTag));
+        }
+        if (valid && readTag != tag) {
+            if (inferQueue.abandoned.erase(readTag) == 0) {
+                inferQueue.results[readTag].swap(other);
+            }
+        }
+        inferQueue.resultReady.notify_all();
+
+        if (status != NC_OK) {
+            THROW_IE_EXCEPTION << "Failed to read output from FIFO: " << ncStatusToStr(graphDesc._graphHandle, status);
+        }
+        if (!valid) {
+            THROW_IE_EXCEPTION << "Output has unexpected size " << resDesc.totalSize << ", expected " << graphDesc._outputDesc->totalSize;
+        }
+        if (readTag == tag) {
+            return;
+        }
     }
+}
+
+void MyriadExecutor::probe(GraphDesc &graphDesc) {
+    auto input = std::make_shared<std::vector<uint8_t>>(graphDesc._inputDesc->totalSize);
+    std::vector<uint8_t> result;
+    auto tag = queueInference(graphDesc, input->data(), input->size(), input);
+    getResult(graphDesc, tag, result);
+}
 
-    *result_bytes = resDesc.totalSize;
+void MyriadExecutor::discardResult(GraphDesc &graphDesc, uintptr_t tag) {
+    if (graphDesc._inferQueue == nullptr) {
+        return;
+    }
+    auto &inferQueue = *graphDesc._inferQueue;
+    std::lock_guard<std::mutex> lock(inferQueue.mutex);
+    if (inferQueue.results.erase(tag) == 0) {
+        inferQueue.abandoned.insert(tag);
+    }
 }
 
 void MyriadExecutor::deallocateGraph(DevicePtr &device, GraphDesc &graphDesc) {
@@ -34,6 +34,10 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <map>
+#include <set>
+#include <mutex>
+#include <condition_variable>
 #include <mvnc.h>
 #include <iomanip>
 #include <environment.h>
@@ -42,6 +46,28 @@
 namespace VPU {
 namespace MyriadPlugin {
 
+// Inferences queued on one graph. Each one is tagged through the FIFO user
+// param, so whichever request reads the output FIFO can hand the result to
+// the request that owns it. Shared by all copies of a GraphDesc.
+struct InferQueue {
+    // keeps each FIFO write paired with its trigger, guards nextTag
+    std::mutex queueMutex;
+    uintptr_t nextTag = 1;
+
+    // guards the rest
+    std::mutex mutex;
+    std::condition_variable resultReady;
+    bool reading = false;
+    // results read by a request other than their owner
+    std::map<uintptr_t, std::vector<uint8_t>> results;
+    // tags whose owner will never collect them
+    std::set<uintptr_t> abandoned;
+    // what keeps the inputs of each tag alive, the FIFO sends them without a
+    // copy. Results come in order, so the input of a tag is done with once
+    // the result of that tag or of a later one is read
+    std::map<uintptr_t, std::shared_ptr<void>> inputs;
+};
+
 struct GraphDesc {
     graphHandle_t *_graphHandle = nullptr;
 
@@ -50,6 +76,12 @@ struct GraphDesc {
 
     fifoHandle_t *_inputFifoHandle = nullptr;
     fifoHandle_t *_outputFifoHandle = nullptr;
+    // where the FIFOs live, to create the input FIFO again after a failed trigger
+    deviceHandle_t *_deviceHandle = nullptr;
+
+    int _executors = 1;
+    int _fifoDepth = 1;
+    std::shared_ptr<InferQueue> _inferQueue;
 };
 
 #define DEVICE_MAX_GRAPHS 2
@@ -67,22 +99,49 @@ typedef std::shared_ptr<DeviceDesc> DevicePtr;
 class MyriadExecutor {
     Common::LoggerPtr _log;
 
+    DevicePtr bootNextDevice(std::vector<DevicePtr> &devicePool, ncStatus_t &statusInit, ncStatus_t &statusOpen);
+
+    ncStatus_t createInputFifo(GraphDesc &graphDesc);
+
 public:
     MyriadExecutor(const Common::LogLevel& vpuLogLevel, const Common::LoggerPtr& log);
     ~MyriadExecutor();
 
     DevicePtr openDevice(std::vector<DevicePtr> &devicePool);
 
+    // Takes a graph slot on every device that has one, booting the devices
+    // not in the pool yet.
+    std::vector<DevicePtr> openDevices(std::vector<DevicePtr> &devicePool);
+
     static void closeDevices(std::vector<DevicePtr> &devicePool);
 
-    void allocateGraph(DevicePtr &device, GraphDesc &graphDesc, const std::vector<char> &graphFileContent, size_t numStages, const char* networkName);
+    void allocateGraph(DevicePtr &device, GraphDesc &graphDesc, const char *graphFile, size_t graphFileSize, size_t numStages, const char* networkName,
+                       int executors = 0, int fifoDepth = 4);
 
     void deallocateGraph(DevicePtr &device, GraphDesc &graphDesc);
 
-    void queueInference(GraphDesc &graphDesc, void *input_data, size_t input_bytes,
-                        void **result_data, size_t *result_bytes);
+    // Queues one inference and returns the tag to collect its result with.
+    // The input is sent from where it is: it must not change until the result
+    // is read, inputOwner is held until then. Throws if the inference could
+    // not be queued, there is no result to wait for then.
+    uintptr_t queueInference(GraphDesc &graphDesc, void *input_data, size_t input_bytes,
+                             std::shared_ptr<void> inputOwner = nullptr);
+
+    // Same, with the input given as pieces sent back to back, so several
+    // blobs reach the device without being concatenated first.
+    uintptr_t queueInference(GraphDesc &graphDesc, const std::vector<ncTensorSegment_t> &input_segments,
+                             std::shared_ptr<void> inputOwner = nullptr);
+
+    // Waits for the result of the inference queued under tag and copies it to
+    // result. Results of other inferences read on the way are kept for their owners.
+    void getResult(GraphDesc &graphDesc, uintptr_t tag, std::vector<uint8_t> &result);
+
+    // Drops the result of an inference nobody is going to collect.
+    void discardResult(GraphDesc &graphDesc, uintptr_t tag);
 
-    void getResult(GraphDesc &graphDesc, void **result_data, size_t *result_bytes);
+    // Runs one inference of zeros and waits for it, to tell whether the
+    // device works again. Throws if it does not.
+    void probe(GraphDesc &graphDesc);
 
     const char *ncStatusToStr(graphHandle_t *graphHandle, ncStatus_t status);
 
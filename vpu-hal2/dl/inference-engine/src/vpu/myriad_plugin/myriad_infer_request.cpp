@@ -36,6 +36,7 @@
 #include <ie_layouts.h>
 
 #include "precision_utils.h"
+#include "layout_utils.h"
 #include "myriad_executable_network.h"
 #include "myriad_infer_request.h"
 #include "common.h"
@@ -49,18 +50,18 @@ using namespace VPU::Common;
 using namespace VPU::MyriadPlugin;
 using namespace InferenceEngine;
 
-MyriadInferRequest::MyriadInferRequest(GraphDesc &graphDesc,
+MyriadInferRequest::MyriadInferRequest(const DeviceSchedulerPtr &scheduler,
                                         InferenceEngine::InputsDataMap networkInputs,
                                         InferenceEngine::OutputsDataMap networkOutputs,
                                         const EnvironmentPtr &env, const LoggerPtr &log,
                                         const MyriadExecutorPtr &executor) :
-        InferRequestInternal(networkInputs, networkOutputs), _graphDesc(
-                graphDesc), _env(env), _log(log), _executor(executor) {
+        InferRequestInternal(networkInputs, networkOutputs), _scheduler(
+                scheduler), _env(env), _log(log), _executor(executor) {
 
 
           //LOG_DEBUG("myriad InferRequest allocate network input blob");
 
-    _deviceLayout = _env->parsedConfig.blobConfig.hwOptimization ? NCHW : NHWC;
+    bool hwOptimization = _env->parsedConfig.blobConfig.hwOptimization;
 
     // allocate inputs
     for (auto &networkInput : _networkInputs) {
@@ -71,6 +72,7 @@ MyriadInferRequest::MyriadInferRequest(GraphDesc &graphDesc,
         SizeVector dims = networkInput.second->getDims();
         Precision precision = networkInput.second->getInputPrecision();
         Layout layout = networkInput.second->getTensorDesc().getLayout();
+        _deviceLayouts[networkInput.first] = VPU::deviceLayout(layout, hwOptimization);
 
         Blob::Ptr inputBlob;
         switch (precision) {
@@ -100,6 +102,7 @@ MyriadInferRequest::MyriadInferRequest(GraphDesc &graphDesc,
         SizeVector dims = networkOutput.second->dims;
         Precision precision = networkOutput.second->precision;
         Layout layout = networkOutput.second->layout;
+        _deviceLayouts[networkOutput.first] = VPU::deviceLayout(layout, hwOptimization);
 
         Blob::Ptr outputBlob;
         switch (precision) {
@@ -122,6 +125,19 @@ MyriadInferRequest::MyriadInferRequest(GraphDesc &graphDesc,
     }
 }
 
+MyriadInferRequest::~MyriadInferRequest() {
+    discardPending();
+}
+
+void MyriadInferRequest::discardPending() {
+    if (_pendingGraph != nullptr) {
+        _executor->discardResult(_pendingGraph->_graphDesc, _pendingTag);
+        _scheduler->release(_pendingGraph, true);
+        _pendingGraph = nullptr;
+        _pendingTag = 0;
+    }
+}
+
 void MyriadInferRequest::Infer() {
     InferAsync();
     GetResult();
@@ -149,86 +165,65 @@ void MyriadInferRequest::InferAsync() {
             THROW_IE_EXCEPTION << PARAMETER_MISMATCH_str << "Unsupported output blob precision";
     }
 
-    std::vector<uint8_t> tmpMemory;
-    Blob::Ptr tmpBlob;
-
-    void* inputPtr = nullptr;
-    size_t inputSize = 0;
-
-    if (_inputs.size() > 1) {
-        inputSize = 0;
-        for (auto input : _inputs) {
-            auto const inputBlobPtr = input.second;
-            size_t byteSize = inputBlobPtr->size() * inputBlobPtr->element_size();
-            inputSize += byteSize;
-        }
-
-        tmpMemory.resize(inputSize);
-        auto dst = tmpMemory.data();
+    // the inputs go to the device back to back, straight from their blobs
+    // unless they were set in another layout than the graph takes them in.
+    // The executor holds the blobs until the result is read
+    std::vector<ncTensorSegment_t> inputSegments;
+    auto inputBlobs = std::make_shared<std::vector<Blob::Ptr>>();
+    for (const auto &networkInput : _networkInputs) {
+        auto foundInputBlob = _inputs.find(networkInput.first);
+        if (foundInputBlob == _inputs.end())
+            THROW_IE_EXCEPTION << "Error: input [" << networkInput.first << "] is not provided.";
 
-        for (auto input : _inputs) {
-            auto inputBlobPtr = input.second;
-            size_t byteSize = inputBlobPtr->size() * inputBlobPtr->element_size();
-            Layout layout = inputBlobPtr->getTensorDesc().getLayout();
-            if (layout != _deviceLayout && (layout == NCHW || layout == NHWC)) {
-                switch (inputBlobPtr->precision()) {
-                    case Precision::U8:
-                        ConvertBlobToLayout<uint8_t>(_deviceLayout, inputBlobPtr);
-                        break;
-                    case Precision::FP16:
-                        ConvertBlobToLayout<ie_fp16>(_deviceLayout, inputBlobPtr);
-                        break;
-                    case Precision::FP32:
-                        ConvertBlobToLayout<float>(_deviceLayout, inputBlobPtr);
-                        break;
-                    default:
-                        THROW_IE_EXCEPTION << "unsupported blob precision for converting layout";
-                        break;
-                }
-            }
-            memcpy(dst, inputBlobPtr->buffer(), byteSize);
-            dst += byteSize;
-        }
+        auto inputBlobPtr = inputInDeviceLayout(networkInput.first, foundInputBlob->second);
+        ncTensorSegment_t segment;
+        segment.data = inputBlobPtr->buffer();
+        segment.length = static_cast<unsigned int>(inputBlobPtr->byteSize());
+        inputSegments.push_back(segment);
+        inputBlobs->push_back(inputBlobPtr);
+    }
 
-        inputPtr = tmpMemory.data();
-    } else {
-        auto dataName = _networkInputs.begin()->first;
-        auto foundInputBlob = _inputs.find(dataName);
-        if (foundInputBlob == _inputs.end())
-            THROW_IE_EXCEPTION << "Error: input [" << dataName << "] is not provided.";
+    discardPending();
 
-        tmpBlob = foundInputBlob->second;
-        size_t byteSize = tmpBlob->size() * tmpBlob->element_size();
-        Layout layout = tmpBlob->getTensorDesc().getLayout();
-        if (layout != _deviceLayout && (layout == NCHW || layout == NHWC)) {
-            switch (tmpBlob->precision()) {
-                case Precision::U8:
-                    ConvertBlobToLayout<uint8_t>(_deviceLayout, tmpBlob);
-                    break;
-                case Precision::FP16:
-                    ConvertBlobToLayout<ie_fp16>(_deviceLayout, tmpBlob);
-                    break;
-                case Precision::FP32:
-                    ConvertBlobToLayout<float>(_deviceLayout, tmpBlob);
-                    break;
-                default:
-                    THROW_IE_EXCEPTION << "unsupported blob precision for converting layout";
-                    break;
+    // a device that fails to take the input hands it over to the next one
+    std::vector<DeviceGraphPtr> tried;
+    for (;;) {
+        auto graph = _scheduler->acquire(tried);
+        try {
+            _pendingTag = _executor->queueInference(graph->_graphDesc, inputSegments, inputBlobs);
+            _pendingGraph = graph;
+            break;
+        } catch (...) {
+            _scheduler->release(graph, false);
+            tried.push_back(graph);
+            if (tried.size() >= _scheduler->graphs().size()) {
+                throw;
             }
+            LOG_WARNING("[VPU] Failed to queue inference on device %d, retrying", graph->_device->_deviceIdx);
         }
-
-        inputPtr = tmpBlob->buffer();
-        inputSize = byteSize;
     }
-
-    _executor->queueInference(_graphDesc, inputPtr, inputSize, nullptr, nullptr);
 }
 
 void MyriadInferRequest::GetResult() {
-    void *resultPtr = NULL;
-    size_t resultSize = 0;
+    if (_pendingGraph == nullptr) {
+        THROW_IE_EXCEPTION << "No inference was queued for this request";
+    }
+    auto graph = _pendingGraph;
+    uintptr_t tag = _pendingTag;
+    _pendingGraph = nullptr;
+    _pendingTag = 0;
 
-    _executor->getResult(_graphDesc, &resultPtr, &resultSize);
+    try {
+        _executor->getResult(graph->_graphDesc, tag, _resultBuffer);
+    } catch (...) {
+        _scheduler->release(graph, false);
+        throw;
+    }
+    _scheduler->release(graph, true);
+    _lastGraph = graph;
+
+    void *resultPtr = _resultBuffer.data();
+    size_t resultSize = _resultBuffer.size();
 
     size_t resultOffset = 0;
     for (auto pp : _outputs) {
@@ -237,28 +232,18 @@ void MyriadInferRequest::GetResult() {
         }
         auto const outputBlobPtr = pp.second;
         Layout layout = outputBlobPtr->getTensorDesc().getLayout();
-        SizeVector dims = outputBlobPtr->getTensorDesc().getDims();
-        if (layout != _deviceLayout && (layout == NCHW || layout == NHWC)
-            && (dims[0] != 1 || dims[1] != 1) && (dims[2] != 1 || dims[3] != 1)) {
-            Blob::Ptr tmpBlob = nullptr;
-            switch (outputBlobPtr->precision()) {
-            case Precision::FP32:
-                tmpBlob = InferenceEngine::make_shared_blob<float>(Precision::FP32, _deviceLayout, outputBlobPtr->dims(),
-                                                                   reinterpret_cast<float *>(reinterpret_cast<uint8_t *>(resultPtr) + resultOffset));
-                ConvertBlobToLayout<float>(layout, tmpBlob);
-                break;
-            case Precision::FP16:
-                tmpBlob = InferenceEngine::make_shared_blob<ie_fp16>(Precision::FP16, _deviceLayout, outputBlobPtr->dims(),
-                                                                     reinterpret_cast<short *>(reinterpret_cast<uint8_t *>(resultPtr) + resultOffset));
-                ConvertBlobToLayout<ie_fp16>(layout, tmpBlob);
-                break;
-            default:
-                THROW_IE_EXCEPTION << PARAMETER_MISMATCH_str << "Unsupported output precision: "
-                                   << outputBlobPtr->precision() << "! Supported precisions: FP32, FP16";
+        Layout device = _deviceLayouts[pp.first];
+        const SizeVector &dims = outputBlobPtr->getTensorDesc().getDims();
+        auto result = reinterpret_cast<uint8_t *>(resultPtr) + resultOffset;
+        if (layout != device && (layout == NCHW || layout == NHWC) && !SameInNCHWAndNHWC(dims)) {
+            // straight from the result into the blob, reordered on the way
+            if (!LayoutUtils::convertLayout(device, layout, dims, outputBlobPtr->element_size(),
+                                            result, outputBlobPtr->buffer())) {
+                THROW_IE_EXCEPTION << PARAMETER_MISMATCH_str << "Cannot convert output " << pp.first
+                                   << " to the blob layout";
             }
-            memcpy(outputBlobPtr->buffer(), tmpBlob->cbuffer(), outputBlobPtr->byteSize());
         } else {
-            memcpy(outputBlobPtr->buffer(), reinterpret_cast<uint8_t *>(resultPtr) + resultOffset, outputBlobPtr->byteSize());
+            memcpy(outputBlobPtr->buffer(), result, outputBlobPtr->byteSize());
         }
 
         resultOffset += outputBlobPtr->byteSize();
@@ -269,8 +254,47 @@ void MyriadInferRequest::GetResult() {
 #endif
 }
 
+// The input as the graph takes it. An NCHW/NHWC blob set in the other layout
+// is reordered into a buffer kept for the next inference; anything else,
+// ANY included, goes as it is.
+Blob::Ptr MyriadInferRequest::inputInDeviceLayout(const std::string &name, const Blob::Ptr &blob) {
+    Layout layout = blob->getTensorDesc().getLayout();
+    Layout device = _deviceLayouts[name];
+    const SizeVector &dims = blob->getTensorDesc().getDims();
+    if (layout == device || (layout != NCHW && layout != NHWC) || SameInNCHWAndNHWC(dims)) {
+        return blob;
+    }
+
+    // a staging blob still held by the executor may be on its way to the
+    // device, the next input goes to a new one
+    auto &staging = _inputStaging[name];
+    if (staging == nullptr || staging.use_count() > 1 || staging->precision() != blob->precision() ||
+        staging->getTensorDesc().getDims() != dims) {
+        TensorDesc desc(blob->precision(), dims, device);
+        switch (blob->precision()) {
+            case Precision::U8:
+                staging = std::make_shared<TBlob<uint8_t>>(desc);
+                break;
+            case Precision::FP16:
+                staging = std::make_shared<TBlob<ie_fp16>>(desc);
+                break;
+            case Precision::FP32:
+                staging = std::make_shared<TBlob<float>>(desc);
+                break;
+            default:
+                THROW_IE_EXCEPTION << "unsupported blob precision for converting layout";
+        }
+        staging->allocate();
+    }
+    if (!LayoutUtils::convertLayout(layout, device, dims, blob->element_size(), blob->cbuffer(), staging->buffer())) {
+        THROW_IE_EXCEPTION << "Cannot convert input " << name << " to the device layout";
+    }
+    return staging;
+}
+
 void MyriadInferRequest::GetPerformanceCounts(std::map<std::string, InferenceEngineProfileInfo> &perfMap) const {
-    std::shared_ptr<GraphInfo<float>> graphInfo = _executor->getPerfTimeInfo(_graphDesc._graphHandle);
+    auto graph = _lastGraph != nullptr ? _lastGraph : _scheduler->graphs().front();
+    std::shared_ptr<GraphInfo<float>> graphInfo = _executor->getPerfTimeInfo(graph->_graphDesc._graphHandle);
     if (_log->getLogLevel() >= LogLevel::eLOGINFO) {
         if (graphInfo != nullptr && graphInfo->numElements()) {
             LOG_INFO("** Device execution time %.3lf **"
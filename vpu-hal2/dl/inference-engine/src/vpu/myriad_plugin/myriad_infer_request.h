@@ -36,6 +36,7 @@
 #include <memory>
 #include <ie_common.h>
 #include "myriad_executor.h"
+#include "myriad_device_scheduler.h"
 #include "cpp_interfaces/impl/ie_infer_request_internal.hpp"
 #include "cpp_interfaces/impl/ie_executable_network_internal.hpp"
 #include <environment.h>
@@ -47,18 +48,31 @@ namespace MyriadPlugin {
 class MyriadInferRequest : public InferenceEngine::InferRequestInternal {
     MyriadExecutorPtr _executor;
     Common::EnvironmentPtr _env;
-    InferenceEngine::Layout _deviceLayout;
+    // layout the graph takes each input and returns each output in
+    std::map<std::string, InferenceEngine::Layout> _deviceLayouts;
+    // inputs set in the other layout, reordered for the device
+    std::map<std::string, InferenceEngine::Blob::Ptr> _inputStaging;
     Common::LoggerPtr _log;
 
-    GraphDesc _graphDesc;
+    DeviceSchedulerPtr _scheduler;
+    // device and tag of the inference queued by InferAsync
+    DeviceGraphPtr _pendingGraph;
+    uintptr_t _pendingTag = 0;
+    // device that ran the last completed inference
+    DeviceGraphPtr _lastGraph;
+    std::vector<uint8_t> _resultBuffer;
+
+    void discardPending();
+    InferenceEngine::Blob::Ptr inputInDeviceLayout(const std::string &name, const InferenceEngine::Blob::Ptr &blob);
 
 public:
     typedef std::shared_ptr<MyriadInferRequest> Ptr;
 
-    explicit MyriadInferRequest(GraphDesc &_graphDesc, InferenceEngine::InputsDataMap networkInputs, InferenceEngine::OutputsDataMap networkOutputs,
+    explicit MyriadInferRequest(const DeviceSchedulerPtr &scheduler, InferenceEngine::InputsDataMap networkInputs, InferenceEngine::OutputsDataMap networkOutputs,
                           const Common::EnvironmentPtr &env,
                           const Common::LoggerPtr &log,
                           const MyriadExecutorPtr &executor);
+    ~MyriadInferRequest();
 
     void Infer() override;
     void InferAsync();
@@ -165,6 +165,9 @@ typedef enum {
     NC_RO_FIFO_WRITE_FILL_LEVEL = 6,  // return number of tensors in a write buffer
     NC_RO_FIFO_TENSOR_DESCRIPTOR = 7, // return the tensor descriptor of the FIFO
     NC_RO_FIFO_STATE = 8, // return the device state
+    NC_RW_FIFO_ASYNC_WRITE = 9, // 1 to let WriteTensor return before the tensor
+                                // reaches the device. The tensor is copied, up to
+                                // the FIFO capacity of writes stay in flight
 } ncFifoOption_t;
 
 
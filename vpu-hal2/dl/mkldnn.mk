@@ -0,0 +1,58 @@
+LOCAL_PATH := $(call my-dir)
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := libmkldnn
+LOCAL_PROPRIETARY_MODULE := true
+LOCAL_MODULE_OWNER := intel
+LOCAL_MULTILIB := both
+#LOCAL_MULTILIB := 64
+
+LOCAL_SRC_FILES := \
+	$(call all-cpp-files-under, inference-engine/thirdparty/mkl-dnn/src)
+
+LOCAL_C_INCLUDES += \
+	$(LOCAL_PATH)/inference-engine/thirdparty/mkl-dnn/include \
+	$(LOCAL_PATH)/inference-engine/thirdparty/mkl-dnn/src \
+	$(LOCAL_PATH)/inference-engine/thirdparty/mkl-dnn/src/common \
+	$(LOCAL_PATH)/inference-engine/thirdparty/mkl-dnn/src/cpu/xbyak
+
+LOCAL_CFLAGS += -std=c++11 -Wall -Wno-unknown-pragmas -Wno-strict-overflow -fPIC -Wformat -Wformat-security -fstack-protector-all
+LOCAL_CFLAGS += -Wno-unused-variable -Wno-unused-parameter -Wno-missing-field-initializers -fexceptions -frtti -Wno-error
+LOCAL_CFLAGS += -D__STDC_LIMIT_MACROS -D__STDC_CONSTANT_MACROS -DDISABLE_VERBOSE -fopenmp -fvisibility-inlines-hidden
+
+include $(BUILD_STATIC_LIBRARY)
+##########################################################################
+include $(CLEAR_VARS)
+
+# the eCPU plugin the driver runs the CPU partitions on, see VpuPartitionedNetwork
+LOCAL_MODULE := libMKLDNNPlugin
+LOCAL_PROPRIETARY_MODULE := true
+LOCAL_MODULE_OWNER := intel
+LOCAL_MULTILIB := both
+#LOCAL_MULTILIB := 64
+
+LOCAL_SRC_FILES := \
+	$(call all-cpp-files-under, inference-engine/src/mkldnn_plugin)
+
+LOCAL_C_INCLUDES += \
+	$(LOCAL_PATH)/inference-engine/include \
+	$(LOCAL_PATH)/inference-engine/include/cpp \
+	$(LOCAL_PATH)/inference-engine/src/inference_engine \
+	$(LOCAL_PATH)/inference-engine/src/inference_engine/cpp_interfaces \
+	$(LOCAL_PATH)/inference-engine/src/inference_engine/cpp_interfaces/base \
+	$(LOCAL_PATH)/inference-engine/src/inference_engine/cpp_interfaces/impl \
+	$(LOCAL_PATH)/inference-engine/src/inference_engine/cpp_interfaces/interface \
+	$(LOCAL_PATH)/inference-engine/src/mkldnn_plugin \
+	$(LOCAL_PATH)/inference-engine/src/mkldnn_plugin/mkldnn \
+	$(LOCAL_PATH)/inference-engine/thirdparty/mkl-dnn/include
+
+LOCAL_CFLAGS += -std=c++11 -Wall -Wno-unknown-pragmas -Wno-strict-overflow -fPIC -Wformat -Wformat-security -fstack-protector-all
+LOCAL_CFLAGS += -Wno-unused-variable -Wno-unused-parameter -Wno-non-virtual-dtor -Wno-missing-field-initializers -fexceptions -frtti -Wno-error
+LOCAL_CFLAGS += -DAKS -DIMPLEMENT_INFERENCE_ENGINE_PLUGIN -fvisibility=default -std=gnu++11 -D_FORTIFY_SOURCE=2 -fopenmp
+LOCAL_CFLAGS += -DCI_BUILD_NUMBER=\"android\"
+LOCAL_LDFLAGS += -fopenmp
+
+LOCAL_STATIC_LIBRARIES := libmkldnn
+LOCAL_SHARED_LIBRARIES := libinference_engine liblog
+
+include $(BUILD_SHARED_LIBRARY)
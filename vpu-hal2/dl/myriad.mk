@@ -9,6 +9,8 @@ LOCAL_MODULE_OWNER := intel
 
 LOCAL_SRC_FILES := \
 	inference-engine/src/vpu/myriad_plugin/myriad_async_infer_request.cpp \
+	inference-engine/src/vpu/myriad_plugin/myriad_blob_cache.cpp \
+	inference-engine/src/vpu/myriad_plugin/myriad_device_scheduler.cpp \
 	inference-engine/src/vpu/myriad_plugin/myriad_executor.cpp \
 	inference-engine/src/vpu/myriad_plugin/myriad_infer_request.cpp \
 	inference-engine/src/vpu/myriad_plugin/myriad_plugin.cpp
@@ -0,0 +1,375 @@
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// vpu_fp16_bench times the FP32 <-> FP16 array conversions of
+// fp16_convert.h from 1K to 50M elements, in both rounding flavours, with
+// and without the fused scale/bias. Every kernel the target has runs on
+// its own: scalar, SSE2 and AVX2 on x86, NEON on ARM, and the dispatching
+// entry point the stack calls. The conversion instructions (F16C on x86,
+// fcvt on AArch64) are timed too for reference; they round to nearest even,
+// so the FP32 -> FP16 ones are not checked. Each case is checked against
+// the scalar code first, then run for at least -m seconds. -f keeps the
+// cases whose name contains the given text, -n the sizes up to that many
+// elements. The data holds -0 and +0, which plain conversions keep and the
+// scale/bias ones, even by 1 and 0, turn into +0.
+
+#include <getopt.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fp16_convert.h>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Size {
+    const char* name;
+    size_t elements;
+};
+
+// from a small tensor that stays in L1 to the weights of a large model
+const Size kSizes[] = {
+    {"1K", 1 << 10},
+    {"64K", 1 << 16},
+    {"1M", 1 << 20},
+    {"16M", 1 << 24},
+    {"50M", 50 * 1000 * 1000},
+};
+
+struct Case {
+    std::string name;
+    size_t bytes;                // read plus written per call
+    std::function<void()> run;
+    std::function<bool()> check;
+};
+
+struct Params {
+    const char* name;
+    float scale, bias;
+    int affine;
+};
+
+const Params kParams[] = {
+    {"plain", 1.f, 0.f, 0},
+    {"unit", 1.f, 0.f, 1},
+    {"scalebias", 1.f / 255, -0.5f, 1},
+};
+
+struct Mode {
+    const char* name;
+    fp16_rounding_t mode;
+};
+
+const Mode kModes[] = {
+    {"vpu", FP16_ROUND_VPU},
+    {"ieee", FP16_ROUND_IEEE},
+};
+
+// A kernel converts a prefix of the array and returns its length, the
+// scalar code does the rest
+typedef std::function<size_t(uint16_t*, const float*, size_t, float, float, int, fp16_rounding_t)> ToHalfKernel;
+typedef std::function<size_t(float*, const uint16_t*, size_t, float, float, int, fp16_rounding_t)> ToFloatKernel;
+
+void scalarToHalf(uint16_t* dst, const float* src, size_t from, size_t n, float scale, float bias, int affine,
+                  fp16_rounding_t mode) {
+    for (size_t i = from; i < n; i++) {
+        float x = affine ? src[i] * scale + bias : src[i];
+        dst[i] = mode == FP16_ROUND_VPU ? fp16_from_f32_vpu(x) : fp16_from_f32_bits_ieee(fp16_as_uint(x));
+    }
+}
+
+void scalarToFloat(float* dst, const uint16_t* src, size_t from, size_t n, float scale, float bias, int affine,
+                   fp16_rounding_t mode) {
+    for (size_t i = from; i < n; i++) {
+        float x = mode == FP16_ROUND_VPU ? fp16_to_f32_vpu(src[i]) : fp16_as_float(fp16_to_f32_bits_ieee(src[i]));
+        dst[i] = affine ? x * scale + bias : x;
+    }
+}
+
+struct Kernels {
+    std::vector<std::pair<std::string, ToHalfKernel>> toHalf;
+    std::vector<std::pair<std::string, ToFloatKernel>> toFloat;
+    // conversion instructions, round to nearest even and keep subnormals
+    ToHalfKernel hwToHalf;
+    ToFloatKernel hwToFloat;
+    const char* hwName = nullptr;
+};
+
+#if defined(FP16_CONVERT_X86)
+__attribute__((target("f16c,avx"))) size_t f16cToHalf(uint16_t* dst, const float* src, size_t n,
+                                                      float scale, float bias, int affine, fp16_rounding_t) {
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 vbias = _mm256_set1_ps(bias);
+    size_t i;
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(src + i);
+        if (affine) x = _mm256_add_ps(_mm256_mul_ps(x, vscale), vbias);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_cvtps_ph(x, _MM_FROUND_TO_NEAREST_INT));
+    }
+    return i;
+}
+
+__attribute__((target("f16c,avx"))) size_t f16cToFloat(float* dst, const uint16_t* src, size_t n,
+                                                       float scale, float bias, int affine, fp16_rounding_t) {
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 vbias = _mm256_set1_ps(bias);
+    size_t i;
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+        if (affine) x = _mm256_add_ps(_mm256_mul_ps(x, vscale), vbias);
+        _mm256_storeu_ps(dst + i, x);
+    }
+    return i;
+}
+#elif defined(FP16_CONVERT_NEON) && defined(__aarch64__)
+size_t fcvtToHalf(uint16_t* dst, const float* src, size_t n, float scale, float bias, int affine, fp16_rounding_t) {
+    const float32x4_t vscale = vdupq_n_f32(scale);
+    const float32x4_t vbias = vdupq_n_f32(bias);
+    size_t i;
+    for (i = 0; i + 4 <= n; i += 4) {
+        float32x4_t x = vld1q_f32(src + i);
+        if (affine) x = vaddq_f32(vmulq_f32(x, vscale), vbias);
+        vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(x)));
+    }
+    return i;
+}
+
+size_t fcvtToFloat(float* dst, const uint16_t* src, size_t n, float scale, float bias, int affine, fp16_rounding_t) {
+    const float32x4_t vscale = vdupq_n_f32(scale);
+    const float32x4_t vbias = vdupq_n_f32(bias);
+    size_t i;
+    for (i = 0; i + 4 <= n; i += 4) {
+        float32x4_t x = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i)));
+        if (affine) x = vaddq_f32(vmulq_f32(x, vscale), vbias);
+        vst1q_f32(dst + i, x);
+    }
+    return i;
+}
+#endif
+
+Kernels targetKernels() {
+    Kernels k;
+    k.toHalf.push_back({"scalar", [](uint16_t*, const float*, size_t, float, float, int, fp16_rounding_t) {
+        return size_t(0);
+    }});
+    k.toFloat.push_back({"scalar", [](float*, const uint16_t*, size_t, float, float, int, fp16_rounding_t) {
+        return size_t(0);
+    }});
+#if defined(FP16_CONVERT_X86)
+    k.toHalf.push_back({"sse2", fp16_sse2_f32_to_f16});
+    k.toFloat.push_back({"sse2", fp16_sse2_f16_to_f32});
+    if (fp16_has_avx2()) {
+        k.toHalf.push_back({"avx2", fp16_avx2_f32_to_f16});
+        k.toFloat.push_back({"avx2", fp16_avx2_f16_to_f32});
+    }
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c")) {
+        k.hwToHalf = f16cToHalf;
+        k.hwToFloat = f16cToFloat;
+        k.hwName = "f16c";
+    }
+#elif defined(FP16_CONVERT_NEON)
+    k.toHalf.push_back({"neon", fp16_neon_f32_to_f16});
+    k.toFloat.push_back({"neon", fp16_neon_f16_to_f32});
+#if defined(__aarch64__)
+    k.hwToHalf = fcvtToHalf;
+    k.hwToFloat = fcvtToFloat;
+    k.hwName = "fcvt";
+#endif
+#endif
+    return k;
+}
+
+// Buffers shared by the cases of one size. Mostly activations around the
+// FP16 range, with a few values that overflow, underflow or are subnormal,
+// and both zeros.
+struct Data {
+    std::vector<float> f32, f32Out, f32Ref;
+    std::vector<uint16_t> f16, f16Out, f16Ref;
+    explicit Data(size_t n) : f32(n), f32Out(n), f32Ref(n), f16(n), f16Out(n), f16Ref(n) {
+        for (size_t i = 0; i < n; i++) {
+            int r = rand();
+            if (r % 64 == 0) {
+                f32[i] = ldexpf(static_cast<float>(r % 1000) / 1000, r % 60 - 30);
+            } else {
+                f32[i] = static_cast<float>(r % 200001 - 100000) / 1024;
+            }
+        }
+        f32[0] = -0.f;
+        f32[1] = 0.f;
+        scalarToHalf(f16.data(), f32.data(), 0, n, 1.f, 0.f, 0, FP16_ROUND_IEEE);
+    }
+};
+
+void addCases(std::vector<Case>& cases, const Kernels& kernels, const Size& size, const std::shared_ptr<Data>& data) {
+    size_t n = size.elements;
+    size_t bytes = n * (sizeof(float) + sizeof(uint16_t));
+    for (const auto& mode : kModes) {
+        for (const auto& params : kParams) {
+            fp16_rounding_t m = mode.mode;
+            float scale = params.scale, bias = params.bias;
+            int affine = params.affine;
+            std::string suffix = std::string("/") + mode.name + "/" + params.name + "/" + size.name;
+
+            auto checkHalf = [=] {
+                scalarToHalf(data->f16Ref.data(), data->f32.data(), 0, n, scale, bias, affine, m);
+                return memcmp(data->f16Out.data(), data->f16Ref.data(), n * sizeof(uint16_t)) == 0;
+            };
+            auto checkFloat = [=] {
+                scalarToFloat(data->f32Ref.data(), data->f16.data(), 0, n, scale, bias, affine, m);
+                return memcmp(data->f32Out.data(), data->f32Ref.data(), n * sizeof(float)) == 0;
+            };
+
+            for (const auto& kernel : kernels.toHalf) {
+                ToHalfKernel run = kernel.second;
+                cases.push_back({"f32to16/" + kernel.first + suffix, bytes, [=] {
+                    size_t done = run(data->f16Out.data(), data->f32.data(), n, scale, bias, affine, m);
+                    scalarToHalf(data->f16Out.data(), data->f32.data(), done, n, scale, bias, affine, m);
+                }, checkHalf});
+            }
+            cases.push_back({"f32to16/dispatch" + suffix, bytes, [=] {
+                if (affine) {
+                    fp16_convert_f32_to_f16(data->f16Out.data(), data->f32.data(), n, scale, bias, m);
+                } else {
+                    fp16_convert_f32_to_f16_plain(data->f16Out.data(), data->f32.data(), n, m);
+                }
+            }, checkHalf});
+
+            for (const auto& kernel : kernels.toFloat) {
+                ToFloatKernel run = kernel.second;
+                cases.push_back({"f16to32/" + kernel.first + suffix, bytes, [=] {
+                    size_t done = run(data->f32Out.data(), data->f16.data(), n, scale, bias, affine, m);
+                    scalarToFloat(data->f32Out.data(), data->f16.data(), done, n, scale, bias, affine, m);
+                }, checkFloat});
+            }
+            cases.push_back({"f16to32/dispatch" + suffix, bytes, [=] {
+                if (affine) {
+                    fp16_convert_f16_to_f32(data->f32Out.data(), data->f16.data(), n, scale, bias, m);
+                } else {
+                    fp16_convert_f16_to_f32_plain(data->f32Out.data(), data->f16.data(), n, m);
+                }
+            }, checkFloat});
+        }
+    }
+
+    // the instructions don't depend on the flavour. They widen exactly, like
+    // the IEEE flavour does, but narrow with another rounding
+    if (kernels.hwName != nullptr) {
+        for (const auto& params : kParams) {
+            float scale = params.scale, bias = params.bias;
+            int affine = params.affine;
+            std::string suffix = std::string("/") + kernels.hwName + "/" + params.name + "/" + size.name;
+            ToHalfKernel toHalf = kernels.hwToHalf;
+            ToFloatKernel toFloat = kernels.hwToFloat;
+            cases.push_back({"f32to16/hw" + suffix, bytes, [=] {
+                size_t done = toHalf(data->f16Out.data(), data->f32.data(), n, scale, bias, affine, FP16_ROUND_IEEE);
+                scalarToHalf(data->f16Out.data(), data->f32.data(), done, n, scale, bias, affine, FP16_ROUND_IEEE);
+            }, [] { return true; }});
+            cases.push_back({"f16to32/hw" + suffix, bytes, [=] {
+                size_t done = toFloat(data->f32Out.data(), data->f16.data(), n, scale, bias, affine, FP16_ROUND_IEEE);
+                scalarToFloat(data->f32Out.data(), data->f16.data(), done, n, scale, bias, affine, FP16_ROUND_IEEE);
+            }, [=] {
+                scalarToFloat(data->f32Ref.data(), data->f16.data(), 0, n, scale, bias, affine, FP16_ROUND_IEEE);
+                return memcmp(data->f32Out.data(), data->f32Ref.data(), n * sizeof(float)) == 0;
+            }});
+        }
+    }
+}
+
+// Runs the case in growing batches until one takes at least minSeconds,
+// returns the time per call of that batch.
+double timeCase(const Case& c, double minSeconds, size_t& iterations) {
+    c.run();  // warm up caches and page in the buffers
+    for (iterations = 1;; iterations *= 2) {
+        auto start = Clock::now();
+        for (size_t i = 0; i < iterations; i++) c.run();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (seconds >= minSeconds || iterations >= (1u << 24)) {
+            return seconds / iterations;
+        }
+    }
+}
+
+void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -f text   run only the cases whose name contains text\n"
+            "  -n count  run only the sizes of up to count elements\n"
+            "  -m sec    minimum time per case (default 0.5)\n"
+            "  -l        list the cases and exit\n",
+            argv0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string filter;
+    size_t maxElements = 0;
+    double minSeconds = 0.5;
+    bool list = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:n:m:lh")) != -1) {
+        switch (opt) {
+            case 'f': filter = optarg; break;
+            case 'n': maxElements = strtoull(optarg, nullptr, 0); break;
+            case 'm': minSeconds = atof(optarg); break;
+            case 'l': list = true; break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    Kernels kernels = targetKernels();
+    int failed = 0;
+    if (!list) printf("%-44s %14s %12s %10s\n", "case", "time/call", "iterations", "GB/s");
+    // one size at a time, the 50M buffers alone take 900MB
+    for (const auto& size : kSizes) {
+        if (maxElements && size.elements > maxElements) continue;
+        std::vector<Case> cases;
+        addCases(cases, kernels, size, nullptr);
+        bool any = false;
+        for (const auto& c : cases) any |= filter.empty() || c.name.find(filter) != std::string::npos;
+        if (!any) continue;
+        if (!list) {
+            cases.clear();
+            addCases(cases, kernels, size, std::make_shared<Data>(size.elements));
+        }
+        for (const auto& c : cases) {
+            if (!filter.empty() && c.name.find(filter) == std::string::npos) continue;
+            if (list) {
+                printf("%s\n", c.name.c_str());
+                continue;
+            }
+            size_t iterations = 0;
+            double seconds = timeCase(c, minSeconds, iterations);
+            if (!c.check()) {
+                printf("%-44s MISMATCH\n", c.name.c_str());
+                failed++;
+                continue;
+            }
+            printf("%-44s %11.1f us %12zu %10.2f\n", c.name.c_str(), seconds * 1e6, iterations,
+                   c.bytes / seconds / 1e9);
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * INTEL CONFIDENTIAL
+ * Copyright 2017 Intel Corporation.
+ *
+ * The source code contained or described herein and all documents
+ * related to the source code ("Material") are owned by Intel Corporation
+ * or its suppliers or licensors. Title to the Material remains with
+ * Intel Corporation or its suppliers and licensors. The Material may
+ * contain trade secrets and proprietary and confidential information
+ * of Intel Corporation and its suppliers and licensors, and is protected
+ * by worldwide copyright and trade secret laws and treaty provisions.
+ * No part of the Material may be used, copied, reproduced, modified,
+ * published, uploaded, posted, transmitted, distributed, or disclosed
+ * in any way without Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other
+ * intellectual property right is granted to or conferred upon you by
+ * disclosure or delivery of the Materials, either expressly, by implication,
+ * inducement, estoppel or otherwise. Any license under such intellectual
+ * property rights must be express and approved by Intel in writing.
+ *
+ * Include any supplier copyright notices as supplier requires Intel to use.
+ *
+ * Include supplier trademarks or logos as supplier requires Intel to use,
+ * preceded by an asterisk. An asterisked footnote can be added as follows:
+ * *Third Party trademarks are the property of their respective owners.
+ *
+ * Unless otherwise agreed by Intel in writing, you may not remove or alter
+ * this notice or any other notice embedded in Materials by Intel or Intel's
+ * suppliers or licensors in any way.
+ */
+
+#include "IRConstantStore.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <fnv1a_hash.h>
+
+using namespace IRBuilder;
+using namespace InferenceEngine;
+
+namespace
+{
+
+bool sameDesc(const TensorDesc &a, const TensorDesc &b)
+{
+    return a.getPrecision() == b.getPrecision() && a.getLayout() == b.getLayout() && a.getDims() == b.getDims();
+}
+
+}  // namespace
+
+IRConstantStore &IRConstantStore::instance()
+{
+    // never destroyed, blobs outliving static destruction still release into it
+    static IRConstantStore *store = new IRConstantStore();
+    return *store;
+}
+
+/**
+ * \brief check a blob with a matching key against the source, a chunk at a
+ * time so a hit costs no allocation
+ */
+bool IRConstantStore::sameContent(const IRBlob &blob, const void *src, size_t srcElemSize, const Converter &convert)
+{
+    const size_t kChunk = 1024;
+    short converted[kChunk];
+    const short *data = blob.cbuffer().as<const short *>();
+    const char *in = static_cast<const char *>(src);
+    size_t nelem = blob.size();
+    for (size_t i = 0; i < nelem; i += kChunk)
+    {
+        size_t count = std::min(kChunk, nelem - i);
+        convert(converted, in + i * srcElemSize, count);
+        if (std::memcmp(converted, data + i, count * sizeof(short)) != 0)
+            return false;
+    }
+    return true;
+}
+
+IRBlob::Ptr IRConstantStore::get(const void *src, size_t srcElemSize, const TensorDesc &desc,
+                                 const Converter &convert)
+{
+    IR_ASSERT(desc.getPrecision().size() == sizeof(short));
+
+    size_t nelem = sizeOf(desc.getDims());
+    uint64_t key = kFnv1aOffset;
+    key = fnv1aValue(key, static_cast<int>(desc.getPrecision()));
+    key = fnv1aValue(key, static_cast<int>(desc.getLayout()));
+    key = fnv1aValue(key, desc.getDims().size());
+    for (auto d : desc.getDims())
+        key = fnv1aValue(key, d);
+    key = fnv1aSized(key, src, nelem * srcElemSize);
+
+    // a blob locked here may lose its other owners meanwhile; its deleter
+    // takes _mutex and erases from _entries, so the references are dropped
+    // only after the lock is released
+    std::vector<IRBlob::Ptr> candidates;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.lookups++;
+        auto range = _entries.equal_range(key);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            // an expired entry is erased by the deleter of its blob
+            auto blob = it->second.blob.lock();
+            if (!blob)
+                continue;
+            candidates.push_back(blob);
+            if (sameDesc(blob->getTensorDesc(), desc) && sameContent(*blob, src, srcElemSize, convert))
+            {
+                _stats.hits++;
+                _stats.savedBytes += blob->byteSize();
+                return blob;
+            }
+        }
+    }
+
+    // converted unlocked, two models racing on the same weights may both
+    // keep a copy
+    IRBlob *raw = new IRBlob(desc);
+    raw->allocate();
+    convert(raw->buffer().as<short *>(), src, nelem);
+    IRBlob::Ptr blob(raw, [this, key](IRBlob *b) { release(b, key); });
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.emplace(key, Entry{blob, raw});
+    _stats.liveBlobs++;
+    _stats.liveBytes += raw->byteSize();
+    return blob;
+}
+
+void IRConstantStore::release(IRBlob *blob, uint64_t key)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto range = _entries.equal_range(key);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second.raw == blob)
+            {
+                _entries.erase(it);
+                break;
+            }
+        }
+        _stats.liveBlobs--;
+        _stats.liveBytes -= blob->byteSize();
+    }
+    delete blob;
+}
+
+IRConstantStore::Stats IRConstantStore::stats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
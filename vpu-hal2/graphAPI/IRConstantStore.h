@@ -0,0 +1,100 @@
+/*
+ * INTEL CONFIDENTIAL
+ * Copyright 2017 Intel Corporation.
+ *
+ * The source code contained or described herein and all documents
+ * related to the source code ("Material") are owned by Intel Corporation
+ * or its suppliers or licensors. Title to the Material remains with
+ * Intel Corporation or its suppliers and licensors. The Material may
+ * contain trade secrets and proprietary and confidential information
+ * of Intel Corporation and its suppliers and licensors, and is protected
+ * by worldwide copyright and trade secret laws and treaty provisions.
+ * No part of the Material may be used, copied, reproduced, modified,
+ * published, uploaded, posted, transmitted, distributed, or disclosed
+ * in any way without Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other
+ * intellectual property right is granted to or conferred upon you by
+ * disclosure or delivery of the Materials, either expressly, by implication,
+ * inducement, estoppel or otherwise. Any license under such intellectual
+ * property rights must be express and approved by Intel in writing.
+ *
+ * Include any supplier copyright notices as supplier requires Intel to use.
+ *
+ * Include supplier trademarks or logos as supplier requires Intel to use,
+ * preceded by an asterisk. An asterisked footnote can be added as follows:
+ * *Third Party trademarks are the property of their respective owners.
+ *
+ * Unless otherwise agreed by Intel in writing, you may not remove or alter
+ * this notice or any other notice embedded in Materials by Intel or Intel's
+ * suppliers or licensors in any way.
+ */
+
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include "IRLayer.h"
+
+namespace IRBuilder
+{
+
+/**
+ * Content-addressed store of constant tensors, shared by every network built
+ * in the process. Two models with the same backbone, or one model prepared
+ * twice, get the same converted blob for the same weights. A blob stays in
+ * the store while something holds it and is dropped with its last user.
+ */
+class IRConstantStore
+{
+public:
+    // converts nelem source elements to the blob precision
+    typedef std::function<void(void *dst, const void *src, size_t nelem)> Converter;
+
+    struct Stats
+    {
+        size_t lookups = 0;
+        size_t hits = 0;
+        size_t liveBlobs = 0;
+        size_t liveBytes = 0;
+        // blob bytes hits did not have to allocate, since the process started
+        size_t savedBytes = 0;
+    };
+
+    static IRConstantStore &instance();
+
+    /**
+     * \brief The blob of desc holding src converted element by element.
+     * One still held with the same source bytes, precision, layout and dims
+     * is handed out again.
+     * \param src the source elements
+     * \param srcElemSize the size of one source element
+     * \param desc precision, dims and layout of the blob, a 16-bit precision
+     * \param convert fills the blob from src
+     */
+    IRBlob::Ptr get(const void *src, size_t srcElemSize, const InferenceEngine::TensorDesc &desc,
+                    const Converter &convert);
+
+    Stats stats();
+
+private:
+    struct Entry
+    {
+        std::weak_ptr<IRBlob> blob;
+        const IRBlob *raw;
+    };
+
+    IRConstantStore() = default;
+    IRConstantStore(const IRConstantStore &) = delete;
+    IRConstantStore &operator=(const IRConstantStore &) = delete;
+
+    static bool sameContent(const IRBlob &blob, const void *src, size_t srcElemSize, const Converter &convert);
+    void release(IRBlob *blob, uint64_t key);
+
+    std::mutex _mutex;
+    std::unordered_multimap<uint64_t, Entry> _entries;
+    Stats _stats;
+};
+
+}  // namespace IRBuilder
@@ -33,7 +33,11 @@
 //#define LOG_TAG "graphAPI"
 
 #include "IRDocument.h"
+#include "IRConstantStore.h"
 #include "cnn_network_impl.hpp"
+#include "fnv1a_hash.h"
+#include <algorithm>
+#include <cstring>
 #include <locale>
 #include "IRLayers.h"
 #include <fstream>
@@ -210,26 +214,34 @@ void
 IRDocument::saveBlobToIR(std::ostream &binFile, const /*IRBlob::Ptr*/InferenceEngine::Blob::Ptr &blob, pugi::xml_node &layer, const std::string &name)
 {
 
-    //const float *fp = static_cast<const float *>(blob->readOnly());
-    const void *fp = static_cast<const void *>(blob->cbuffer());
-    auto fit = _segmentsMap.find((float*)fp);
-    bool newBlob = fit == _segmentsMap.end();
+    const char *data = blob->cbuffer().as<const char *>();
+    size_t size = blob->byteSize();
+    uint64_t key = InferenceEngine::fnv1a(InferenceEngine::kFnv1aOffset, data, size);
+    auto range = _segmentsMap.equal_range(key);
+    auto fit = std::find_if(range.first, range.second, [&](const std::pair<const uint64_t, Segment> &kvp)
+    {
+        const auto &seg = kvp.second;
+        return seg.blob == blob || (seg.blob->byteSize() == size &&
+                                    seg.blob->precision() == blob->precision() &&
+                                    memcmp(seg.blob->cbuffer().as<const char *>(), data, size) == 0);
+    });
+    bool newBlob = fit == range.second;
     size_t offset;
     if(newBlob)
     {
         offset = binFile.tellp();
-        _segmentsMap[(float*)fp] = offset;
+        _segmentsMap.emplace(key, Segment{blob, offset});
     }
     else
     {
-        offset = fit->second;
+        offset = fit->second.offset;
     }
     auto node = layer.append_child(name.c_str());
     node.append_attribute("offset").set_value(offset);
     node.append_attribute("size").set_value(blob->byteSize());
     if(newBlob)
     {
-        binFile.write(reinterpret_cast<const char *>(fp), blob->byteSize());
+        binFile.write(data, size);
     }
     //node.append_attribute("precision").set_value("FP16");
 	node.append_attribute("precision").set_value(blob->precision().name());
@@ -240,6 +252,7 @@ void IRDocument::save(std::ostream &xml_os, std::ostream &bin_os)
     pugi::xml_document doc;
 
     build();
+    _segmentsMap.clear();
     pugi::xml_node root = doc.append_child("net");
     root.append_attribute("name").set_value(_name.c_str());
     root.append_attribute("version").set_value(2);
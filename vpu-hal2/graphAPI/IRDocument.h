@@ -32,6 +32,7 @@
 
 #pragma once
 #include "IRLayer.h"
+#include <unordered_map>
 #include "ie_icnn_network.hpp"
 #include "ie_common.h"
 
@@ -59,7 +60,14 @@ private:
     size_t _layer_id_cnt = 1;
     bool _processed = false;
 
-    std::map<const float *, size_t> _segmentsMap;
+    struct Segment
+    {
+        InferenceEngine::Blob::Ptr blob;
+        size_t offset;
+    };
+    // blobs already in the bin file, by content hash, so equal weights are
+    // written once whichever layers hold them
+    std::unordered_multimap<uint64_t, Segment> _segmentsMap;
 
     static bool shouldRemove(const IRLayer &l);
     void process(const IRLayer &value);
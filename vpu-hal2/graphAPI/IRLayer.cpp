@@ -35,7 +35,7 @@
 
 using namespace IRBuilder;
 
-int IRBuilder::layer_name_count = 0;
+thread_local int IRBuilder::layer_name_count = 0;
 
 const std::string ActivationLayer::Sigmoid("sigmoid");
 
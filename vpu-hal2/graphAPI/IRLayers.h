@@ -48,7 +48,9 @@
 namespace IRBuilder
 {
 
-extern int layer_name_count;
+// Numbers generated layer names. Per thread, and reset before each network is
+// built, so a model always gets the same names: they end up in the blob cache key.
+extern thread_local int layer_name_count;
 
 inline OutputPort addOutput(const IRLayer &layer, const InferenceEngine::SizeVector &dims)
 {
@@ -8,6 +8,7 @@ LOCAL_MODULE_OWNER := intel
 LOCAL_MULTILIB := both
 #LOCAL_MULTILIB := 64
 LOCAL_SRC_FILES := \
+    IRConstantStore.cpp \
     IRDocument.cpp \
     IRLayer.cpp
 
@@ -0,0 +1,223 @@
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// vpu_layout_bench times the layout conversions the plugins run on every
+// inference: NCHW <-> NHWC on 8, 16 and 32-bit data, and the fused
+// U8/FP32 -> FP16 variants. Each case is checked against the element by
+// element conversion first, then run for at least -m seconds, reporting
+// the time per call and the bytes moved per second, one line per case in
+// the manner of Google benchmark. -f keeps the cases whose name contains
+// the given text.
+
+#include <getopt.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <ie_layouts.h>
+#include <layout_utils.h>
+#include <precision_utils.h>
+
+using namespace InferenceEngine;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Shape {
+    const char* name;
+    SizeVector dims;
+};
+
+// network inputs and feature maps of typical mobile models
+const Shape kShapes[] = {
+    {"1x3x224x224", {1, 3, 224, 224}},
+    {"1x3x300x300", {1, 3, 300, 300}},
+    {"1x32x112x112", {1, 32, 112, 112}},
+    {"1x256x56x56", {1, 256, 56, 56}},
+    {"1x1024x7x7", {1, 1024, 7, 7}},
+    {"8x3x224x224", {8, 3, 224, 224}},
+};
+
+struct Case {
+    std::string name;
+    size_t bytes;                // read plus written per call
+    std::function<void()> run;
+    std::function<bool()> check;
+};
+
+size_t total(const SizeVector& dims) {
+    size_t n = 1;
+    for (auto dim : dims) n *= dim;
+    return n;
+}
+
+// The conversion every layout change went through before: one element at a
+// time, the offsets recomputed for each.
+template<typename T>
+void naiveConvert(Layout from, Layout to, const SizeVector& dims, const T* src, T* dst) {
+    SizeVector irDims(dims.rbegin(), dims.rend());
+    LayoutOffsetCounter srcOffsets(from, irDims);
+    LayoutOffsetCounter dstOffsets(to, irDims);
+    SizeVector pos(irDims.size(), 0);
+    for (size_t n = 0; n < irDims[3]; n++)
+        for (size_t c = 0; c < irDims[2]; c++)
+            for (size_t h = 0; h < irDims[1]; h++)
+                for (size_t w = 0; w < irDims[0]; w++) {
+                    pos[0] = w, pos[1] = h, pos[2] = c, pos[3] = n;
+                    dst[dstOffsets.Offset(pos)] = src[srcOffsets.Offset(pos)];
+                }
+}
+
+// Buffers shared by the cases of one shape and element type.
+template<typename T>
+struct Data {
+    std::vector<T> src, dst, ref;
+    explicit Data(size_t n) : src(n), dst(n), ref(n) {
+        for (size_t i = 0; i < n; i++) src[i] = static_cast<T>(rand());
+    }
+};
+
+template<typename T>
+void addTransposeCases(std::vector<Case>& cases, const Shape& shape, const char* type) {
+    auto data = std::make_shared<Data<T>>(total(shape.dims));
+    size_t bytes = 2 * data->src.size() * sizeof(T);
+    const Layout pairs[][2] = {{NCHW, NHWC}, {NHWC, NCHW}};
+    for (auto& pair : pairs) {
+        Layout from = pair[0], to = pair[1];
+        std::string name = std::string(from == NCHW ? "nchw2nhwc" : "nhwc2nchw") + "/" + type + "/" + shape.name;
+        SizeVector dims = shape.dims;
+        auto check = [=] {
+            naiveConvert(from, to, dims, data->src.data(), data->ref.data());
+            return memcmp(data->dst.data(), data->ref.data(), data->dst.size() * sizeof(T)) == 0;
+        };
+        cases.push_back({name + "/naive", bytes, [=] {
+            naiveConvert(from, to, dims, data->src.data(), data->dst.data());
+        }, check});
+        cases.push_back({name + "/blocked", bytes, [=] {
+            LayoutUtils::convertLayout(from, to, dims, sizeof(T), data->src.data(), data->dst.data(), 1);
+        }, check});
+        if (LayoutUtils::transposeThreads(bytes / 2) > 1) {
+            cases.push_back({name + "/threads", bytes, [=] {
+                LayoutUtils::convertLayout(from, to, dims, sizeof(T), data->src.data(), data->dst.data());
+            }, check});
+        }
+    }
+}
+
+// Fused conversion against a transpose followed by a conversion pass.
+template<typename T>
+void addFP16Cases(std::vector<Case>& cases, const Shape& shape, const char* type, Precision precision) {
+    size_t n = total(shape.dims);
+    auto data = std::make_shared<Data<T>>(n);
+    if (precision == Precision::FP32) {
+        for (auto& value : data->src) value = static_cast<T>(rand() % 20000 - 10000) / 64;
+    }
+    auto half = std::make_shared<std::vector<ie_fp16>>(n);
+    auto refHalf = std::make_shared<std::vector<ie_fp16>>(n);
+    size_t bytes = n * (sizeof(T) + sizeof(ie_fp16));
+    SizeVector dims = shape.dims;
+    std::string name = std::string("nchw2nhwc/") + type + "2fp16/" + shape.name;
+
+    auto separate = [=] {
+        LayoutUtils::convertLayout(NCHW, NHWC, dims, sizeof(T), data->src.data(), data->dst.data(), 1);
+        LayoutUtils::convertLayoutToFP16(NHWC, NHWC, dims, precision, data->dst.data(), refHalf->data(), 1);
+    };
+    auto check = [=] {
+        separate();
+        return memcmp(half->data(), refHalf->data(), n * sizeof(ie_fp16)) == 0;
+    };
+    cases.push_back({name + "/separate", bytes, separate, [] { return true; }});
+    cases.push_back({name + "/fused", bytes, [=] {
+        LayoutUtils::convertLayoutToFP16(NCHW, NHWC, dims, precision, data->src.data(), half->data(), 1);
+    }, check});
+}
+
+std::vector<Case> allCases() {
+    std::vector<Case> cases;
+    for (const auto& shape : kShapes) {
+        addTransposeCases<uint8_t>(cases, shape, "u8");
+        addTransposeCases<uint16_t>(cases, shape, "fp16");
+        addTransposeCases<float>(cases, shape, "fp32");
+        addFP16Cases<uint8_t>(cases, shape, "u8", Precision::U8);
+        addFP16Cases<float>(cases, shape, "fp32", Precision::FP32);
+    }
+    return cases;
+}
+
+// Runs the case in growing batches until one takes at least minSeconds,
+// returns the time per call of that batch.
+double timeCase(const Case& c, double minSeconds, size_t& iterations) {
+    c.run();  // warm up caches and page in the buffers
+    for (iterations = 1;; iterations *= 2) {
+        auto start = Clock::now();
+        for (size_t i = 0; i < iterations; i++) c.run();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (seconds >= minSeconds || iterations >= (1u << 24)) {
+            return seconds / iterations;
+        }
+    }
+}
+
+void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -f text   run only the cases whose name contains text\n"
+            "  -m sec    minimum time per case (default 0.5)\n"
+            "  -l        list the cases and exit\n",
+            argv0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string filter;
+    double minSeconds = 0.5;
+    bool list = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:m:lh")) != -1) {
+        switch (opt) {
+            case 'f': filter = optarg; break;
+            case 'm': minSeconds = atof(optarg); break;
+            case 'l': list = true; break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    int failed = 0;
+    printf("%-44s %14s %12s %10s\n", "case", "time/call", "iterations", "GB/s");
+    for (const auto& c : allCases()) {
+        if (!filter.empty() && c.name.find(filter) == std::string::npos) continue;
+        if (list) {
+            printf("%s\n", c.name.c_str());
+            continue;
+        }
+        size_t iterations = 0;
+        double seconds = timeCase(c, minSeconds, iterations);
+        if (!c.check()) {
+            printf("%-44s MISMATCH\n", c.name.c_str());
+            failed++;
+            continue;
+        }
+        printf("%-44s %11.1f us %12zu %10.2f\n", c.name.c_str(), seconds * 1e6, iterations,
+               c.bytes / seconds / 1e9);
+    }
+    return failed ? 1 : 0;
+}
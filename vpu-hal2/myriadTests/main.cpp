@@ -0,0 +1,512 @@
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// vpu_myriad_test runs MyriadExecutor against the mock ncsdk of
+// mock_mvnc.cpp, no device needed. It checks that tagged results reach the
+// request that queued them whatever order the device finishes in, that
+// inputs sent in place stay alive until their inference ran, that a failed
+// trigger does not shift the inputs of the next ones, that more
+// graph executors give more throughput and that the device scheduler drops
+// a failing device and takes it back once it works. -f keeps the tests whose name
+// contains the given text.
+
+#include <getopt.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ie_common.h>
+#include <vpu_logger.h>
+#include "myriad_device_scheduler.h"
+#include "myriad_executor.h"
+#include "mock_mvnc.h"
+
+using namespace VPU::Common;
+using namespace VPU::MyriadPlugin;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Test {
+    const char *name;
+    std::function<bool(std::string &)> run;
+};
+
+// A graph of one mock device, released when the test is done.
+struct MockGraph {
+    MyriadExecutor executor;
+    std::vector<DevicePtr> devices;
+    DevicePtr device;
+    GraphDesc graph;
+
+    MockGraph(int executors, int fifoDepth)
+        : executor(eLOGNONE, std::make_shared<Logger>()) {
+        device = executor.openDevice(devices);
+        std::vector<char> blob(64);
+        executor.allocateGraph(device, graph, blob.data(), blob.size(), 1, "mock", executors, fifoDepth);
+    }
+
+    ~MockGraph() {
+        executor.deallocateGraph(device, graph);
+        MyriadExecutor::closeDevices(devices);
+    }
+};
+
+// An input as the infer request hands it over: the executor keeps it alive
+// through the owner. The bytes are overwritten on release, so an inference
+// that reads them too late sees other content.
+struct Frame {
+    std::shared_ptr<std::vector<uint8_t>> input;
+    std::vector<uint8_t> expected;
+};
+
+Frame makeFrame(size_t bytes, std::mt19937 &rng) {
+    Frame frame;
+    frame.input = std::shared_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>(bytes),
+        [](std::vector<uint8_t> *data) {
+            std::fill(data->begin(), data->end(), 0xee);
+            delete data;
+        });
+    frame.expected.resize(bytes);
+    for (size_t i = 0; i < bytes; i++) {
+        (*frame.input)[i] = static_cast<uint8_t>(rng());
+        frame.expected[i] = (*frame.input)[i] ^ MockMvnc::kResultXor;
+    }
+    return frame;
+}
+
+uintptr_t queue(MockGraph &mock, Frame &frame) {
+    auto input = frame.input;
+    frame.input.reset();
+    return mock.executor.queueInference(mock.graph, input->data(), input->size(), input);
+}
+
+bool waitHeld(size_t count) {
+    for (int i = 0; i < 5000 && MockMvnc::held() < count; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return MockMvnc::held() == count;
+}
+
+// Every inference is finished before any result is let out, then the results
+// come in the given order while one thread per request waits for its own.
+bool routesInOrder(const std::vector<size_t> &order, std::string &error) {
+    const size_t count = order.size();
+    MockMvnc::Config config;
+    config.latencyUs = 100;
+    MockMvnc::configure(config);
+    MockGraph mock(1, static_cast<int>(count));
+    std::mt19937 rng(1);
+
+    MockMvnc::hold();
+    std::vector<Frame> frames;
+    std::vector<uintptr_t> tags;
+    for (size_t i = 0; i < count; i++) {
+        frames.push_back(makeFrame(config.tensorBytes, rng));
+        tags.push_back(queue(mock, frames.back()));
+    }
+    if (!waitHeld(count)) {
+        MockMvnc::release({});
+        error = "the mock device did not finish the inferences";
+        return false;
+    }
+
+    std::vector<std::vector<uint8_t>> results(count);
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < count; i++) {
+        readers.emplace_back([&, i] { mock.executor.getResult(mock.graph, tags[i], results[i]); });
+    }
+    std::vector<uintptr_t> released;
+    for (auto i : order) {
+        released.push_back(tags[i]);
+    }
+    MockMvnc::release(released);
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (results[i] != frames[i].expected) {
+            error = "request " + std::to_string(i) + " got another result";
+            return false;
+        }
+    }
+    if (!mock.graph._inferQueue->results.empty() || !mock.graph._inferQueue->inputs.empty()) {
+        error = "results or inputs left in the infer queue";
+        return false;
+    }
+    return true;
+}
+
+bool testReversed(std::string &error) {
+    std::vector<size_t> order(8);
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = order.size() - 1 - i;
+    }
+    return routesInOrder(order, error);
+}
+
+bool testShuffled(std::string &error) {
+    std::mt19937 rng(7);
+    for (int round = 0; round < 20; round++) {
+        std::vector<size_t> order(6);
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+        std::shuffle(order.begin(), order.end(), rng);
+        if (!routesInOrder(order, error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A result whose request gave up is dropped, whoever reads it.
+bool testDiscarded(std::string &error) {
+    MockMvnc::Config config;
+    config.latencyUs = 100;
+    MockMvnc::configure(config);
+    MockGraph mock(1, 4);
+    std::mt19937 rng(3);
+
+    MockMvnc::hold();
+    std::vector<Frame> frames;
+    std::vector<uintptr_t> tags;
+    for (int i = 0; i < 4; i++) {
+        frames.push_back(makeFrame(config.tensorBytes, rng));
+        tags.push_back(queue(mock, frames.back()));
+    }
+    mock.executor.discardResult(mock.graph, tags[1]);
+    if (!waitHeld(4)) {
+        MockMvnc::release({});
+        error = "the mock device did not finish the inferences";
+        return false;
+    }
+    MockMvnc::release({tags[3], tags[1], tags[2], tags[0]});
+
+    for (int i : {3, 0, 2}) {
+        std::vector<uint8_t> result;
+        mock.executor.getResult(mock.graph, tags[i], result);
+        if (result != frames[i].expected) {
+            error = "request " + std::to_string(i) + " got another result";
+            return false;
+        }
+    }
+    auto &inferQueue = *mock.graph._inferQueue;
+    if (!inferQueue.results.empty() || !inferQueue.abandoned.empty() || !inferQueue.inputs.empty()) {
+        error = "the discarded result was kept";
+        return false;
+    }
+    return true;
+}
+
+// A trigger that fails leaves no input behind for the next trigger to run in
+// place of its own, and the request that failed holds nothing.
+bool testFailedTrigger(std::string &error) {
+    MockMvnc::Config config;
+    config.latencyUs = 100;
+    MockMvnc::configure(config);
+    MockGraph mock(1, 4);
+    std::mt19937 rng(5);
+
+    std::vector<Frame> frames;
+    for (int i = 0; i < 3; i++) {
+        frames.push_back(makeFrame(config.tensorBytes, rng));
+    }
+    MockMvnc::hold();
+    uintptr_t first = queue(mock, frames[0]);
+    MockMvnc::failNextTrigger();
+    bool thrown = false;
+    uintptr_t failed = mock.graph._inferQueue->nextTag;
+    try {
+        queue(mock, frames[1]);
+    } catch (const std::exception &) {
+        thrown = true;
+    }
+    if (!thrown) {
+        MockMvnc::release({});
+        error = "the failed trigger was not reported";
+        return false;
+    }
+    uintptr_t last = queue(mock, frames[2]);
+    if (!waitHeld(2)) {
+        MockMvnc::release({});
+        error = "the mock device did not finish the inferences";
+        return false;
+    }
+    MockMvnc::release({});
+
+    for (auto tag : {last, first}) {
+        std::vector<uint8_t> result;
+        mock.executor.getResult(mock.graph, tag, result);
+        if (result != frames[tag == first ? 0 : 2].expected) {
+            error = "request " + std::to_string(tag) + " got another result";
+            return false;
+        }
+    }
+    auto &inferQueue = *mock.graph._inferQueue;
+    if (!inferQueue.results.empty() || inferQueue.inputs.count(failed) != 0) {
+        error = "the failed request left a result or its input behind";
+        return false;
+    }
+    return true;
+}
+
+// Runs frames on threads, each queueing one frame and waiting for its result
+// in turn. Returns the wall time, or a negative one on a wrong result.
+double runThreads(MockGraph &mock, int threads, int frames, unsigned int tensorBytes, std::string &error) {
+    std::vector<int> wrong(threads);
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            std::mt19937 rng(t);
+            for (int i = 0; i < frames; i++) {
+                Frame frame = makeFrame(tensorBytes, rng);
+                uintptr_t tag = queue(mock, frame);
+                std::vector<uint8_t> result;
+                mock.executor.getResult(mock.graph, tag, result);
+                wrong[t] += result != frame.expected;
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (int t = 0; t < threads; t++) {
+        if (wrong[t] != 0) {
+            error = "thread " + std::to_string(t) + " got " + std::to_string(wrong[t]) + " wrong results";
+            return -1;
+        }
+    }
+    return seconds;
+}
+
+// Requests on several threads, executors finishing in random order.
+bool testConcurrent(std::string &error) {
+    MockMvnc::Config config;
+    config.latencyUs = 200;
+    config.jitterUs = 800;
+    MockMvnc::configure(config);
+    MockGraph mock(3, 4);
+    return runThreads(mock, 6, 100, config.tensorBytes, error) >= 0;
+}
+
+// The host-side work of one frame overlaps the device work of the others, so
+// twice the executors should come close to twice the frames per second.
+bool testScaling(std::string &error) {
+    MockMvnc::Config config;
+    config.latencyUs = 4000;
+    MockMvnc::configure(config);
+    const int threads = 4, frames = 50;
+    double seconds[2];
+    for (int executors = 1; executors <= 2; executors++) {
+        MockGraph mock(executors, 4);
+        seconds[executors - 1] = runThreads(mock, threads, frames, config.tensorBytes, error);
+        if (seconds[executors - 1] < 0) {
+            return false;
+        }
+    }
+    printf("    %d frames: %.0f ms with 1 executor, %.0f ms with 2\n", threads * frames,
+           seconds[0] * 1e3, seconds[1] * 1e3);
+    if (seconds[1] * 1.5 > seconds[0]) {
+        error = "2 executors are not faster than 1";
+        return false;
+    }
+    return true;
+}
+
+// The network on every mock device, spread by a DeviceScheduler.
+struct MockDevices {
+    MyriadExecutor executor;
+    std::vector<DevicePtr> devices;
+    std::vector<DeviceGraphPtr> graphs;
+    std::shared_ptr<DeviceScheduler> scheduler;
+    std::atomic<int> probes{0};
+
+    MockDevices(std::chrono::milliseconds retryDelay)
+        : executor(eLOGNONE, std::make_shared<Logger>()) {
+        std::vector<char> blob(64);
+        for (auto &device : executor.openDevices(devices)) {
+            auto graph = std::make_shared<DeviceGraph>();
+            graph->_device = device;
+            executor.allocateGraph(device, graph->_graphDesc, blob.data(), blob.size(), 1, "mock", 1, 4);
+            graphs.push_back(graph);
+        }
+        auto probe = [this](DeviceGraph &graph) {
+            probes++;
+            executor.probe(graph._graphDesc);
+        };
+        scheduler = std::make_shared<DeviceScheduler>(graphs, probe, std::make_shared<Logger>(), retryDelay);
+    }
+
+    ~MockDevices() {
+        for (auto &graph : graphs) {
+            executor.deallocateGraph(graph->_device, graph->_graphDesc);
+        }
+        MyriadExecutor::closeDevices(devices);
+    }
+
+    // One inference the way MyriadInferRequest runs it: a device that fails
+    // to take the input hands it over to the next one.
+    bool infer(Frame &frame) {
+        auto input = frame.input;
+        frame.input.reset();
+        std::vector<DeviceGraphPtr> tried;
+        for (;;) {
+            auto graph = scheduler->acquire(tried);
+            uintptr_t tag;
+            try {
+                tag = executor.queueInference(graph->_graphDesc, input->data(), input->size(), input);
+            } catch (...) {
+                scheduler->release(graph, false);
+                tried.push_back(graph);
+                if (tried.size() >= graphs.size()) {
+                    return false;
+                }
+                continue;
+            }
+            std::vector<uint8_t> result;
+            executor.getResult(graph->_graphDesc, tag, result);
+            scheduler->release(graph, true);
+            return result == frame.expected;
+        }
+    }
+
+    bool run(int threads, int frames, unsigned int tensorBytes) {
+        std::vector<int> wrong(threads);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] {
+                std::mt19937 rng(t);
+                for (int i = 0; i < frames; i++) {
+                    Frame frame = makeFrame(tensorBytes, rng);
+                    wrong[t] += !infer(frame);
+                }
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        return std::count(wrong.begin(), wrong.end(), 0) == threads;
+    }
+};
+
+// A device that keeps failing leaves the rotation without costing a request,
+// is probed again after the retry delay and comes back once it works.
+bool testRecovery(std::string &error) {
+    MockMvnc::Config config;
+    config.devices = 3;
+    config.latencyUs = 200;
+    MockMvnc::configure(config);
+    const std::chrono::milliseconds retryDelay(20);
+    MockDevices mock(retryDelay);
+    if (mock.graphs.size() != 3) {
+        error = "expected 3 devices, got " + std::to_string(mock.graphs.size());
+        return false;
+    }
+    auto &failing = *mock.graphs[1];
+
+    MockMvnc::setFailing(1, true);
+    bool ok = mock.run(4, 30, config.tensorBytes);
+    if (ok && failing._healthy) {
+        error = "the failing device was kept in rotation";
+        ok = false;
+    }
+
+    // probes while it still fails keep it out, with a longer delay each time
+    if (ok) {
+        std::this_thread::sleep_for(retryDelay * 2);
+        ok = mock.run(4, 30, config.tensorBytes);
+        if (ok && mock.probes == 0) {
+            error = "the failing device was not probed";
+            ok = false;
+        }
+        if (ok && (failing._healthy || failing._retryDelay <= retryDelay)) {
+            error = "a failed probe did not back off";
+            ok = false;
+        }
+    }
+
+    MockMvnc::setFailing(1, false);
+    if (ok) {
+        std::this_thread::sleep_until(failing._retryAt);
+        ok = mock.run(4, 30, config.tensorBytes);
+        if (ok && !failing._healthy) {
+            error = "the device did not come back after it recovered";
+            ok = false;
+        }
+    }
+    if (!ok && error.empty()) {
+        error = "a request failed or got another result";
+    }
+    return ok;
+}
+
+const Test kTests[] = {
+    {"routing/reversed", testReversed},
+    {"routing/shuffled", testShuffled},
+    {"routing/discarded", testDiscarded},
+    {"routing/failed-trigger", testFailedTrigger},
+    {"routing/concurrent", testConcurrent},
+    {"scaling/executors", testScaling},
+    {"scheduler/recovery", testRecovery},
+};
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    std::string filter;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:h")) != -1) {
+        switch (opt) {
+            case 'f': filter = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-f text]\n", argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    int failed = 0;
+    for (const auto &test : kTests) {
+        if (!filter.empty() && std::string(test.name).find(filter) == std::string::npos) {
+            continue;
+        }
+        std::string error;
+        bool passed = false;
+        try {
+            passed = test.run(error);
+        } catch (const std::exception &e) {
+            error = e.what();
+        }
+        if (passed && MockMvnc::staleInputs() != 0) {
+            error = "an input was released before its inference ran";
+            passed = false;
+        }
+        printf("%-24s %s%s%s\n", test.name, passed ? "OK" : "FAILED", error.empty() ? "" : ": ", error.c_str());
+        failed += !passed;
+    }
+    return failed ? 1 : 0;
+}
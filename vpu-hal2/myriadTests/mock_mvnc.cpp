@@ -0,0 +1,497 @@
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mock_mvnc.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include <mvnc.h>
+
+namespace {
+
+struct Input {
+    std::vector<ncTensorSegment_t> segments;
+    uint32_t checksum;
+    void *userParam;
+};
+
+struct Result {
+    std::vector<uint8_t> data;
+    void *userParam;
+};
+
+uint32_t checksum(const std::vector<ncTensorSegment_t> &segments) {
+    uint32_t sum = 2166136261u;
+    for (auto &segment : segments) {
+        auto bytes = static_cast<const uint8_t *>(segment.data);
+        for (unsigned int i = 0; i < segment.length; i++) {
+            sum = (sum ^ bytes[i]) * 16777619u;
+        }
+    }
+    return sum;
+}
+
+// One lock for the whole mock, nothing here is performance critical
+std::mutex mockMutex;
+std::condition_variable mockChanged;
+MockMvnc::Config mockConfig;
+bool holding = false;
+std::vector<std::pair<_fifoPrivate_t *, Result>> parked;
+size_t stale = 0;
+std::set<int> failingDevices;
+bool failTrigger = false;
+
+}  // namespace
+
+struct _devicePrivate_t {
+    int index;
+};
+
+struct _fifoPrivate_t {
+    ncFifoType_t type;
+    int device = -1;
+    unsigned int capacity = 0;
+    bool created = false;
+    bool deleted = false;
+    // written and not yet taken by an executor
+    std::deque<Input> inputs;
+    unsigned int inFlight = 0;
+    std::deque<Result> results;
+    // what the last read returned, like ncsdk the same buffer every time
+    std::vector<uint8_t> readBuffer;
+};
+
+struct _graphPrivate_t {
+    int executors = 1;
+    bool allocated = false;
+    bool stopping = false;
+    ncTensorDescriptor_t desc = {};
+    std::deque<std::pair<Input, _fifoPrivate_t *>> jobs;
+    std::vector<std::thread> threads;
+};
+
+namespace {
+
+// Deleted FIFOs, executors may still hold a pointer to them
+std::vector<std::unique_ptr<fifoHandle_t>> deletedFifos;
+std::vector<std::unique_ptr<_fifoPrivate_t>> deletedFifoData;
+
+void pushResult(_fifoPrivate_t *out, Result result) {
+    out->results.push_back(std::move(result));
+    mockChanged.notify_all();
+}
+
+void runExecutor(_graphPrivate_t *graph, unsigned int latencyUs, unsigned int jitterUs) {
+    std::unique_lock<std::mutex> lock(mockMutex);
+    for (;;) {
+        mockChanged.wait(lock, [&] { return graph->stopping || !graph->jobs.empty(); });
+        if (graph->jobs.empty()) {
+            return;
+        }
+        auto job = std::move(graph->jobs.front());
+        graph->jobs.pop_front();
+        Input &input = job.first;
+        _fifoPrivate_t *out = job.second;
+
+        // the input is read only now, the write left it where it was
+        Result result;
+        result.userParam = input.userParam;
+        for (auto &segment : input.segments) {
+            auto bytes = static_cast<const uint8_t *>(segment.data);
+            result.data.insert(result.data.end(), bytes, bytes + segment.length);
+        }
+        if (checksum(input.segments) != input.checksum) {
+            stale++;
+        }
+        for (auto &byte : result.data) {
+            byte ^= MockMvnc::kResultXor;
+        }
+
+        unsigned int us = latencyUs + (jitterUs ? static_cast<unsigned int>(rand()) % jitterUs : 0);
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+        lock.lock();
+
+        if (holding) {
+            parked.emplace_back(out, std::move(result));
+            mockChanged.notify_all();
+        } else if (!out->deleted) {
+            pushResult(out, std::move(result));
+        }
+    }
+}
+
+}  // namespace
+
+namespace MockMvnc {
+
+void configure(const Config &config) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    mockConfig = config;
+}
+
+void hold() {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    holding = true;
+}
+
+void release(const std::vector<uintptr_t> &userParams) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    holding = false;
+    for (auto userParam : userParams) {
+        for (auto it = parked.begin(); it != parked.end(); ++it) {
+            if (reinterpret_cast<uintptr_t>(it->second.userParam) == userParam) {
+                pushResult(it->first, std::move(it->second));
+                parked.erase(it);
+                break;
+            }
+        }
+    }
+    for (auto &result : parked) {
+        pushResult(result.first, std::move(result.second));
+    }
+    parked.clear();
+}
+
+size_t held() {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    return parked.size();
+}
+
+void setFailing(int device, bool failing) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    if (failing) {
+        failingDevices.insert(device);
+    } else {
+        failingDevices.erase(device);
+    }
+}
+
+void failNextTrigger() {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    failTrigger = true;
+}
+
+size_t staleInputs() {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    return stale;
+}
+
+}  // namespace MockMvnc
+
+ncStatus_t ncGlobalSetOption(int option, const void *data, unsigned int dataLength) {
+    return NC_OK;
+}
+
+ncStatus_t ncGlobalGetOption(int option, void *data, unsigned int *dataLength) {
+    return NC_UNSUPPORTED_FEATURE;
+}
+
+ncStatus_t ncDeviceSetOption(struct deviceHandle_t *deviceHandle, ncOptionClass_t opClass, int option,
+                             const void *data, unsigned int dataLength) {
+    return NC_UNSUPPORTED_FEATURE;
+}
+
+ncStatus_t ncDeviceGetOption(struct deviceHandle_t *deviceHandle, ncOptionClass_t opClass, int option,
+                             void *data, unsigned int *dataLength) {
+    return NC_UNSUPPORTED_FEATURE;
+}
+
+ncStatus_t ncDeviceInit(int index, struct deviceHandle_t **deviceHandle) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    if (deviceHandle == nullptr) {
+        return NC_INVALID_PARAMETERS;
+    }
+    if (index < 0 || index >= mockConfig.devices) {
+        return NC_DEVICE_NOT_FOUND;
+    }
+    *deviceHandle = new deviceHandle_t;
+    (*deviceHandle)->private_data = new _devicePrivate_t{index};
+    return NC_OK;
+}
+
+ncStatus_t ncDeviceOpen(struct deviceHandle_t *deviceHandle) {
+    return deviceHandle != nullptr ? NC_OK : NC_INVALID_PARAMETERS;
+}
+
+ncStatus_t ncDeviceClose(struct deviceHandle_t *deviceHandle) {
+    if (deviceHandle == nullptr) {
+        return NC_INVALID_PARAMETERS;
+    }
+    delete deviceHandle->private_data;
+    delete deviceHandle;
+    return NC_OK;
+}
+
+ncStatus_t ncGraphInit(const char *name, struct graphHandle_t **graphHandle) {
+    if (graphHandle == nullptr) {
+        return NC_INVALID_PARAMETERS;
+    }
+    *graphHandle = new graphHandle_t;
+    (*graphHandle)->private_data = new _graphPrivate_t;
+    return NC_OK;
+}
+
+ncStatus_t ncGraphAllocate(struct deviceHandle_t *deviceHandle, struct graphHandle_t *graphHandle,
+                           const void *graphFile, unsigned int graphFileLength) {
+    if (deviceHandle == nullptr || graphHandle == nullptr) {
+        return NC_INVALID_PARAMETERS;
+    }
+    std::lock_guard<std::mutex> lock(mockMutex);
+    auto graph = graphHandle->private_data;
+    graph->desc.n = 1;
+    graph->desc.c = 1;
+    graph->desc.h = 1;
+    graph->desc.w = mockConfig.tensorBytes / 2;
+    graph->desc.totalSize = mockConfig.tensorBytes;
+    for (int i = 0; i < graph->executors; i++) {
+        graph->threads.emplace_back(runExecutor, graph, mockConfig.latencyUs, mockConfig.jitterUs);
+    }
+    graph->allocated = true;
+    return NC_OK;
+}
+
+ncStatus_t ncGraphDeallocate(struct graphHandle_t *graphHandle) {
+    if (graphHandle == nullptr) {
+        return NC_INVALID_PARAMETERS;
+    }
+    auto graph = graphHandle->private_data;
+    {
+        std::lock_guard<std::mutex> lock(mockMutex);
+        graph->stopping = true;
+        graph->jobs.clear();
+        mockChanged.notify_all();
+    }
+    for (auto &thread : graph->threads) {
+        thread.join();
+    }
+    delete graph;
+    delete graphHandle;
+    return NC_OK;
+}
+
+ncStatus_t ncGraphSetOption(struct graphHandle_t *graphHandle, ncOptionClass_t opClass, int option,
+                            const void *data, unsigned int dataLength) {
+    if (graphHandle == nullptr || data == nullptr) {
+        return NC_INVALID_PARAMETERS;
+    }
+    if (option != NC_RW_GRAPH_EXECUTORS_NUM || dataLength != sizeof(int)) {
+        return NC_UNSUPPORTED_FEATURE;
+    }
+    int executors = *static_cast<const int *>(data);
+    if (executors < 1) {
+        return NC_INVALID_PARAMETERS;
+    }
+    graphHandle->private_data->executors = executors;
+    return NC_OK;
+}
+
+ncStatus_t ncGraphGetOption(struct graphHandle_t *graphHandle, ncOptionClass_t opClass, int option,
+                            void *data, unsigned int *dataLength) {
+    if (graphHandle == nullptr || data == nullptr || dataLength == nullptr) {
+        return NC_INVALID_PARAMETERS;
+    }
+    auto graph = graphHandle->private_data;
+    switch (option) {
+    case NC_RO_GRAPH_INPUT_COUNT:
+    case NC_RO_GRAPH_OUTPUT_COUNT:
+        *static_cast<int *>(data) = 1;
+        *dataLength = sizeof(int);
+        return NC_OK;
+    case NC_RO_GRAPH_INPUT_TENSOR_DESCRIPTORS:
+    case NC_RO_GRAPH_OUTPUT_TENSOR_DESCRIPTORS:
+        // like ncsdk, a pointer to the descriptor the graph keeps
+        *static_cast<ncTensorDescriptor_t **>(data) = &graph->desc;
+        *dataLength = sizeof(ncTensorDescriptor_t *);
+        return NC_OK;
+    default:
+        return NC_UNSUPPORTED_FEATURE;
+    }
+}
+
+ncStatus_t ncGraphQueueInference(struct graphHandle_t *graphHandle, struct fifoHandle_t **fifoIn,
+                                 struct fifoHandle_t **fifoOut) {
+    if (graphHandle == nullptr || fifoIn == nullptr || *fifoIn == nullptr ||
+        fifoOut == nullptr || *fifoOut == nullptr) {
+        return NC_INVALID_PARAMETERS;
+    }
+    std::lock_guard<std::mutex> lock(mockMutex);
+    auto graph = graphHandle->private_data;
+    auto in = (*fifoIn)->private_data;
+    if (!graph->allocated) {
+        return NC_NOT_ALLOCATED;
+    }
+    if (in->inputs.empty() || failTrigger) {
+        failTrigger = false;
+        return NC_ERROR;
+    }
+    // the oldest input, with its user param
+    graph->jobs.emplace_back(std::move(in->inputs.front()), (*fifoOut)->private_data);
+    in->inputs.pop_front();
+    in->inFlight--;
+    mockChanged.notify_all();
+    return NC_OK;
+}
+
+ncStatus_t ncGraphQueueInferenceWithFifoElem(struct graphHandle_t *graphHandle, struct fifoHandle_t **fifoIn,
+                                             struct fifoHandle_t **fifoOut, const void *inputTensor,
+                                             struct ncTensorDescriptor_t *inputDesc, void *userParam) {
+    if (fifoIn == nullptr) {
+        return NC_INVALID_PARAMETERS;
+    }
+    ncStatus_t status = ncFifoWriteElem(*fifoIn, inputTensor, inputDesc, userParam);
+    if (status != NC_OK) {
+        return status;
+    }
+    return ncGraphQueueInference(graphHandle, fifoIn, fifoOut);
+}
+
+ncStatus_t ncFifoInit(ncFifoType_t type, struct fifoHandle_t **fifo) {
+    if (fifo == nullptr) {
+        return NC_INVALID_PARAMETERS;
+    }
+    *fifo = new fifoHandle_t;
+    (*fifo)->private_data = new _fifoPrivate_t;
+    (*fifo)->private_data->type = type;
+    return NC_OK;
+}
+
+ncStatus_t ncFifoCreate(struct fifoHandle_t *fifo, struct deviceHandle_t *device,
+                        struct ncTensorDescriptor_t *tensorDesc, unsigned int numElem) {
+    if (fifo == nullptr || device == nullptr || tensorDesc == nullptr || numElem == 0) {
+        return NC_INVALID_PARAMETERS;
+    }
+    fifo->private_data->device = device->private_data->index;
+    fifo->private_data->capacity = numElem;
+    fifo->private_data->created = true;
+    return NC_OK;
+}
+
+ncStatus_t ncFifoSetOption(struct fifoHandle_t *fifo, ncFifoOption_t option,
+                           const void *data, unsigned int dataLength) {
+    if (fifo == nullptr) {
+        return NC_INVALID_PARAMETERS;
+    }
+    // inputs are always sent in place, see NC_FIFO_ASYNC_WRITE_IN_PLACE
+    return option == NC_RW_FIFO_ASYNC_WRITE ? NC_OK : NC_UNSUPPORTED_FEATURE;
+}
+
+ncStatus_t ncFifoGetOption(struct fifoHandle_t *fifo, ncFifoOption_t option,
+                           void *data, unsigned int *dataLength) {
+    return NC_UNSUPPORTED_FEATURE;
+}
+
+ncStatus_t ncFifoDelete(struct fifoHandle_t *fifo) {
+    if (fifo == nullptr) {
+        return NC_INVALID_PARAMETERS;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mockMutex);
+        fifo->private_data->deleted = true;
+        for (auto it = parked.begin(); it != parked.end();) {
+            it = it->first == fifo->private_data ? parked.erase(it) : it + 1;
+        }
+        deletedFifoData.emplace_back(fifo->private_data);
+        deletedFifos.emplace_back(fifo);
+        mockChanged.notify_all();
+    }
+    return NC_OK;
+}
+
+ncStatus_t ncFifoWriteElem(struct fifoHandle_t *fifo, const void *inputTensor,
+                           struct ncTensorDescriptor_t *inputDesc, void *userParam) {
+    if (inputDesc == nullptr) {
+        return NC_INVALID_PARAMETERS;
+    }
+    ncTensorSegment_t segment;
+    segment.data = inputTensor;
+    segment.length = inputDesc->totalSize;
+    return ncFifoWriteElemSegments(fifo, &segment, 1, inputDesc, userParam);
+}
+
+ncStatus_t ncFifoWriteElemSegments(struct fifoHandle_t *fifo, const struct ncTensorSegment_t *segments,
+                                   unsigned int count, struct ncTensorDescriptor_t *inputDesc, void *userParam) {
+    if (fifo == nullptr || segments == nullptr || count == 0 || inputDesc == nullptr) {
+        return NC_INVALID_PARAMETERS;
+    }
+    Input input;
+    input.segments.assign(segments, segments + count);
+    unsigned int length = 0;
+    for (auto &segment : input.segments) {
+        length += segment.length;
+    }
+    if (length != inputDesc->totalSize) {
+        return NC_INVALID_PARAMETERS;
+    }
+    input.checksum = checksum(input.segments);
+    input.userParam = userParam;
+
+    std::unique_lock<std::mutex> lock(mockMutex);
+    auto in = fifo->private_data;
+    if (!in->created || in->deleted || in->type == NC_FIFO_HOST_RO) {
+        return NC_UNAUTHORIZED;
+    }
+    if (failingDevices.count(in->device) != 0) {
+        return NC_ERROR;
+    }
+    // a full FIFO blocks the writer until an executor takes an input
+    mockChanged.wait(lock, [&] { return in->deleted || in->inFlight < in->capacity; });
+    if (in->deleted) {
+        return NC_NOT_ALLOCATED;
+    }
+    in->inputs.push_back(std::move(input));
+    in->inFlight++;
+    return NC_OK;
+}
+
+ncStatus_t ncFifoReadElem(struct fifoHandle_t *fifo, void **outputData,
+                          struct ncTensorDescriptor_t *outputDesc, void **userParam) {
+    if (fifo == nullptr || outputData == nullptr || outputDesc == nullptr) {
+        return NC_INVALID_PARAMETERS;
+    }
+    std::unique_lock<std::mutex> lock(mockMutex);
+    auto out = fifo->private_data;
+    if (!out->created || out->type == NC_FIFO_HOST_WO) {
+        return NC_UNAUTHORIZED;
+    }
+    mockChanged.wait(lock, [&] { return out->deleted || !out->results.empty(); });
+    if (out->results.empty()) {
+        return NC_NOT_ALLOCATED;
+    }
+    out->readBuffer.swap(out->results.front().data);
+    if (userParam != nullptr) {
+        *userParam = out->results.front().userParam;
+    }
+    out->results.pop_front();
+    *outputData = out->readBuffer.data();
+    outputDesc->n = 1;
+    outputDesc->c = 1;
+    outputDesc->h = 1;
+    outputDesc->w = static_cast<unsigned int>(out->readBuffer.size() / 2);
+    outputDesc->totalSize = static_cast<unsigned int>(out->readBuffer.size());
+    return NC_OK;
+}
+
+ncStatus_t ncFifoRemoveElem(struct fifoHandle_t *fifo) {
+    return NC_UNSUPPORTED_FEATURE;
+}
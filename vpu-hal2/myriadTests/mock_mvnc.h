@@ -0,0 +1,63 @@
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Test backend for the ncsdk API: mock_mvnc.cpp defines the nc* calls the
+// Myriad plugin makes, without a device. Each graph runs as many executor
+// threads as NC_RW_GRAPH_EXECUTORS_NUM asks for. An executor takes the oldest
+// queued input, reads it only then (the plugin writes in place), sleeps for
+// the configured latency and puts the input bytes XOR kResultXor in the
+// output FIFO with the user param of the input. Results therefore reach the
+// output FIFO in the order the executors finish, which with jitter or
+// several executors is not the order the inferences were queued in.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MockMvnc {
+
+const uint8_t kResultXor = 0x5a;
+
+struct Config {
+    int devices = 1;
+    unsigned int tensorBytes = 4096;   // input and output size of every graph
+    unsigned int latencyUs = 1000;     // time one executor spends on an inference
+    unsigned int jitterUs = 0;         // plus up to this much, at random
+};
+
+// Applies to the devices and graphs created from now on.
+void configure(const Config &config);
+
+// While held, finished inferences are parked instead of reaching the output
+// FIFO. release() then sends them in the order given by the user params, the
+// ones not listed after those.
+void hold();
+void release(const std::vector<uintptr_t> &userParams);
+// Number of inferences finished and parked since hold().
+size_t held();
+
+// While failing, the device rejects every input written to it.
+void setFailing(int device, bool failing);
+
+// The next trigger fails and leaves its input in the FIFO, as ncsdk does
+// when the trigger command doesn't reach the graph.
+void failNextTrigger();
+
+// Inputs whose content changed between the write and the executor reading
+// them, i.e. buffers released or reused while the inference was queued.
+size_t staleInputs();
+
+}  // namespace MockMvnc
@@ -0,0 +1,69 @@
+LOCAL_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := vpu_myriad_test
+LOCAL_PROPRIETARY_MODULE := true
+LOCAL_MODULE_OWNER := intel
+
+# the executor runs against mock_mvnc.cpp instead of libmvnc
+LOCAL_SRC_FILES := \
+    main.cpp \
+    mock_mvnc.cpp \
+    ../dl/inference-engine/src/vpu/myriad_plugin/myriad_device_scheduler.cpp \
+    ../dl/inference-engine/src/vpu/myriad_plugin/myriad_executor.cpp
+
+LOCAL_C_INCLUDES += \
+	$(LOCAL_PATH) \
+	$(LOCAL_PATH)/../dl/inference-engine/include \
+	$(LOCAL_PATH)/../dl/inference-engine/include/vpu \
+	$(LOCAL_PATH)/../dl/inference-engine/include/cpp \
+	$(LOCAL_PATH)/../dl/inference-engine/src/vpu/myriad_plugin \
+	$(LOCAL_PATH)/../dl/inference-engine/src/vpu/graph_transformer \
+	$(LOCAL_PATH)/../dl/inference-engine/src/vpu/common \
+	$(LOCAL_PATH)/../dl/inference-engine/src/inference_engine \
+	$(LOCAL_PATH)/../dl/inference-engine/thirdparty/pugixml/src \
+	$(LOCAL_PATH)/../ncsdk2/api/include
+
+LOCAL_CFLAGS += -std=c++11 -Wall -Wno-unknown-pragmas -Wno-strict-overflow -fPIC -Wformat -Wformat-security -fstack-protector-all
+LOCAL_CFLAGS += -Wno-unused-variable -Wno-unused-parameter -Wno-non-virtual-dtor -Wno-missing-field-initializers -fexceptions -frtti -Wno-error
+LOCAL_CFLAGS += -DENABLE_VPU -DENABLE_MYRIAD -DAKS -std=gnu++11 -O2 -D_FORTIFY_SOURCE=2 -fPIE
+
+LOCAL_STATIC_LIBRARIES := libvpu_common
+LOCAL_SHARED_LIBRARIES := libinference_engine liblog
+
+include $(BUILD_EXECUTABLE)
+
+# executable: vpu_myriad_scaling, the scheduler over 1..n emulated sticks
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := vpu_myriad_scaling
+LOCAL_PROPRIETARY_MODULE := true
+LOCAL_MODULE_OWNER := intel
+
+LOCAL_SRC_FILES := \
+    scaling.cpp \
+    ../dl/inference-engine/src/vpu/myriad_plugin/myriad_device_scheduler.cpp \
+    ../dl/inference-engine/src/vpu/myriad_plugin/myriad_executor.cpp
+
+LOCAL_C_INCLUDES += \
+	$(LOCAL_PATH) \
+	$(LOCAL_PATH)/../dl/inference-engine/include \
+	$(LOCAL_PATH)/../dl/inference-engine/include/vpu \
+	$(LOCAL_PATH)/../dl/inference-engine/include/cpp \
+	$(LOCAL_PATH)/../dl/inference-engine/src/vpu/myriad_plugin \
+	$(LOCAL_PATH)/../dl/inference-engine/src/vpu/graph_transformer \
+	$(LOCAL_PATH)/../dl/inference-engine/src/vpu/common \
+	$(LOCAL_PATH)/../dl/inference-engine/src/inference_engine \
+	$(LOCAL_PATH)/../dl/inference-engine/thirdparty/pugixml/src \
+	$(LOCAL_PATH)/../ncsdk2/api/include
+
+LOCAL_CFLAGS += -std=c++11 -Wall -Wno-unknown-pragmas -Wno-strict-overflow -fPIC -Wformat -Wformat-security -fstack-protector-all
+LOCAL_CFLAGS += -Wno-unused-variable -Wno-unused-parameter -Wno-non-virtual-dtor -Wno-missing-field-initializers -fexceptions -frtti -Wno-error
+LOCAL_CFLAGS += -DENABLE_VPU -DENABLE_MYRIAD -DAKS -std=gnu++11 -O2 -D_FORTIFY_SOURCE=2 -fPIE
+
+# the socket transport is only in the emulator variant of libmvnc
+LOCAL_STATIC_LIBRARIES := libvpu_common libmvnc_emulator
+LOCAL_SHARED_LIBRARIES := libinference_engine libusb1.0 liblog
+
+include $(BUILD_EXECUTABLE)
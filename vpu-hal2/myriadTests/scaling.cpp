@@ -0,0 +1,284 @@
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// vpu_myriad_scaling measures how one network scales over several sticks.
+// It starts -n mvnc_emulator processes, each emulating a stick on its own
+// socket, then for 1 to n of them allocates a graph on every device and runs
+// the requests through the DeviceScheduler the way the plugin does, over the
+// real libmvnc and XLink socket transport. Each device count runs in a child
+// process, as libmvnc reads XLINK_SOCKET_PATH once. Prints the time and the
+// inferences each device took; returns 1 if a run failed or a result was lost.
+
+#include <getopt.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ie_common.h>
+#include <vpu_logger.h>
+#include "myriad_device_scheduler.h"
+#include "myriad_executor.h"
+
+using namespace VPU::Common;
+using namespace VPU::MyriadPlugin;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    int devices = 4;
+    const char *emulator = "mvnc_emulator";
+    const char *socketDir = "/tmp";
+    int latencyUs = 10000;
+    int executors = 1;
+    int threads = 8;
+    int frames = 25;
+    unsigned int tensorBytes = 224 * 224 * 3 * 2;
+};
+
+// A blob the emulator takes: only the header and the stage section header
+// are read, for the tensor sizes. See graph_transformer/mv_blob_format.h
+std::vector<char> emulatorBlob(unsigned int inputBytes, unsigned int outputBytes) {
+    const uint32_t kElfHeaderSize = 48, kMagicNumber = 8708;
+    const uint32_t stageSection = kElfHeaderSize + 9 * sizeof(uint32_t);
+    uint32_t header[9] = {kMagicNumber, stageSection + 4 * sizeof(uint32_t), 2, 0, 1, 0, stageSection, 0, 0};
+    uint32_t stages[4] = {1, 4 * sizeof(uint32_t), inputBytes, outputBytes};
+    std::vector<char> blob(header[1]);
+    memcpy(&blob[kElfHeaderSize], header, sizeof(header));
+    memcpy(&blob[stageSection], stages, sizeof(stages));
+    return blob;
+}
+
+// Runs in the child, on the devices XLINK_SOCKET_PATH names. Returns the
+// wall time or a negative one on failure.
+double runDevices(const Options &options, int count) {
+    auto log = std::make_shared<Logger>();
+    MyriadExecutor executor(eLOGNONE, log);
+    std::vector<DevicePtr> pool;
+    std::vector<DeviceGraphPtr> graphs;
+    auto blob = emulatorBlob(options.tensorBytes, options.tensorBytes);
+    try {
+        for (auto &device : executor.openDevices(pool)) {
+            auto graph = std::make_shared<DeviceGraph>();
+            graph->_device = device;
+            executor.allocateGraph(device, graph->_graphDesc, blob.data(), blob.size(), 1, "scaling", options.executors, 4);
+            graphs.push_back(graph);
+        }
+    } catch (const std::exception &e) {
+        fprintf(stderr, "%d devices: %s\n", count, e.what());
+        return -1;
+    }
+    if (static_cast<int>(graphs.size()) != count) {
+        fprintf(stderr, "%d devices: only %zu opened\n", count, graphs.size());
+        return -1;
+    }
+    DeviceScheduler scheduler(graphs, [&executor](DeviceGraph &graph) { executor.probe(graph._graphDesc); }, log);
+
+    std::mutex mutex;
+    std::map<int, int> perDevice;
+    int failed = 0;
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < options.threads; t++) {
+        workers.emplace_back([&] {
+            auto input = std::make_shared<std::vector<uint8_t>>(options.tensorBytes);
+            std::vector<uint8_t> result;
+            for (int i = 0; i < options.frames; i++) {
+                auto graph = scheduler.acquire();
+                bool ok = true;
+                try {
+                    uintptr_t tag = executor.queueInference(graph->_graphDesc, input->data(), input->size(), input);
+                    executor.getResult(graph->_graphDesc, tag, result);
+                    ok = result.size() == options.tensorBytes;
+                } catch (const std::exception &e) {
+                    ok = false;
+                }
+                scheduler.release(graph, ok);
+                std::lock_guard<std::mutex> lock(mutex);
+                perDevice[graph->_device->_deviceIdx]++;
+                failed += !ok;
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::string split;
+    for (auto &device : perDevice) {
+        split += " " + std::to_string(device.second);
+    }
+    printf("%-8d %10.0f ms %12.1f   %s\n", count, seconds * 1e3,
+           options.threads * options.frames / seconds, split.c_str());
+    fflush(stdout);
+
+    for (auto &graph : graphs) {
+        executor.deallocateGraph(graph->_device, graph->_graphDesc);
+    }
+    MyriadExecutor::closeDevices(pool);
+    if (failed) {
+        fprintf(stderr, "%d devices: %d inferences failed\n", count, failed);
+        return -1;
+    }
+    return seconds;
+}
+
+pid_t startEmulator(const Options &options, const std::string &socket) {
+    unlink(socket.c_str());
+    pid_t pid = fork();
+    if (pid == 0) {
+        std::string latency = std::to_string(options.latencyUs);
+        std::string executors = std::to_string(options.executors);
+        freopen("/dev/null", "w", stdout);
+        execlp(options.emulator, options.emulator, "-s", socket.c_str(), "-l", latency.c_str(),
+               "-e", executors.c_str(), static_cast<char *>(nullptr));
+        _exit(127);
+    }
+    return pid;
+}
+
+bool waitForSocket(const std::string &socket, pid_t pid) {
+    for (int i = 0; i < 500; i++) {
+        struct stat st;
+        if (stat(socket.c_str(), &st) == 0) {
+            return true;
+        }
+        if (waitpid(pid, nullptr, WNOHANG) == pid) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -n count  largest number of emulated devices (default 4)\n"
+            "  -e path   mvnc_emulator binary (default mvnc_emulator, from PATH)\n"
+            "  -s dir    directory for the emulator sockets (default /tmp)\n"
+            "  -l us     time one inference takes on a device (default 10000)\n"
+            "  -x count  graph executors per device (default 1)\n"
+            "  -t count  request threads (default 8)\n"
+            "  -r count  inferences per thread (default 25)\n",
+            argv0);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:e:s:l:x:t:r:h")) != -1) {
+        switch (opt) {
+            case 'n': options.devices = atoi(optarg); break;
+            case 'e': options.emulator = optarg; break;
+            case 's': options.socketDir = optarg; break;
+            case 'l': options.latencyUs = atoi(optarg); break;
+            case 'x': options.executors = atoi(optarg); break;
+            case 't': options.threads = atoi(optarg); break;
+            case 'r': options.frames = atoi(optarg); break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (options.devices < 1 || options.threads < 1 || options.frames < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> sockets;
+    std::vector<pid_t> emulators;
+    bool started = true;
+    for (int i = 0; i < options.devices && started; i++) {
+        sockets.push_back(std::string(options.socketDir) + "/vpu_scaling_" + std::to_string(getpid()) +
+                          "_" + std::to_string(i) + ".sock");
+        emulators.push_back(startEmulator(options, sockets.back()));
+        started = emulators.back() > 0 && waitForSocket(sockets.back(), emulators.back());
+    }
+
+    int failed = 0;
+    if (!started) {
+        fprintf(stderr, "Can't start %s\n", options.emulator);
+        failed = 1;
+    } else {
+        printf("%d threads x %d inferences, %d us per inference\n", options.threads, options.frames,
+               options.latencyUs);
+        printf("%-8s %13s %12s   %s\n", "devices", "time", "inferences/s", "per device");
+        fflush(stdout);
+    }
+
+    std::string socketPath;
+    double single = 0;
+    for (int count = 1; started && count <= options.devices; count++) {
+        socketPath += (count > 1 ? ":" : "") + sockets[count - 1];
+        int fds[2];
+        if (pipe(fds) != 0) {
+            failed++;
+            break;
+        }
+        fflush(stdout);
+        pid_t child = fork();
+        if (child == 0) {
+            close(fds[0]);
+            setenv("XLINK_TRANSPORT", "socket", 1);
+            setenv("XLINK_SOCKET_PATH", socketPath.c_str(), 1);
+            double seconds = runDevices(options, count);
+            ssize_t written = write(fds[1], &seconds, sizeof(seconds));
+            _exit(seconds < 0 || written != sizeof(seconds) ? 1 : 0);
+        }
+        close(fds[1]);
+        double seconds = -1;
+        if (child < 0 || read(fds[0], &seconds, sizeof(seconds)) != sizeof(seconds)) {
+            seconds = -1;
+        }
+        close(fds[0]);
+        int status = 1;
+        if (child > 0) {
+            waitpid(child, &status, 0);
+        }
+        if (seconds < 0 || status != 0) {
+            failed++;
+            continue;
+        }
+        if (count == 1) {
+            single = seconds;
+        } else {
+            printf("         speedup over 1 device: %.2fx\n", single / seconds);
+        }
+    }
+
+    for (size_t i = 0; i < emulators.size(); i++) {
+        if (emulators[i] > 0) {
+            kill(emulators[i], SIGTERM);
+            waitpid(emulators[i], nullptr, 0);
+        }
+        unlink(sockets[i].c_str());
+    }
+    return failed ? 1 : 0;
+}
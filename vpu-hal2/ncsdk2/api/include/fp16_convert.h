@@ -0,0 +1,725 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * FP32 <-> FP16 array conversion shared by the HAL, the inference engine and
+ * the NCSDK API.
+ *
+ * Two rounding flavours exist in the stack and both are kept bit-exact:
+ *
+ *  FP16_ROUND_VPU   inference engine / HAL flavour: round half up in
+ *                   magnitude, FP16 denormals flushed (inputs just below the
+ *                   smallest normal round up to it), overflow saturates to
+ *                   the largest finite value.
+ *  FP16_ROUND_IEEE  NCSDK flavour (from numpy): round half away from zero,
+ *                   subnormals kept, overflow goes to infinity.
+ *
+ * Neither matches the round-to-nearest-even of F16C/NEON conversion
+ * instructions, so the vector paths implement the bit manipulations with
+ * integer and float lanes instead: SSE2 or AVX2 (picked at run time) on x86
+ * and NEON on ARM, with a scalar fallback elsewhere and for tails.
+ *
+ * Header only, so it can be compiled into C and C++ modules that do not
+ * share a library.
+ */
+
+#ifndef FP16_CONVERT_H
+#define FP16_CONVERT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FP16_CONVERT_X86 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FP16_CONVERT_NEON 1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    FP16_ROUND_VPU = 0,
+    FP16_ROUND_IEEE = 1
+} fp16_rounding_t;
+
+#define FP16_EXP_MASK_F32 0x7F800000U
+#define FP16_EXP_MASK_F16 0x7C00U
+
+static inline float fp16_as_float(uint32_t v) {
+    float f;
+    memcpy(&f, &v, sizeof(f));
+    return f;
+}
+
+static inline uint32_t fp16_as_uint(float f) {
+    uint32_t v;
+    memcpy(&v, &f, sizeof(v));
+    return v;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Scalar reference conversions                                            */
+/* ----------------------------------------------------------------------- */
+
+static inline float fp16_to_f32_vpu(uint16_t x) {
+    uint32_t u = x;
+    uint32_t s = (u & 0x8000) << 16;
+
+    if ((u & FP16_EXP_MASK_F16) == FP16_EXP_MASK_F16) {
+        /* NAN and INF, NAN gets the quiet bit like the intrinsics do */
+        u &= 0x03FF;
+        if (u) {
+            u |= 0x0200;
+        }
+        u <<= (23 - 10);
+        u |= FP16_EXP_MASK_F32;
+        u |= s;
+    } else if ((u & FP16_EXP_MASK_F16) == 0) {
+        /* zero and denormals are both converted to zero */
+        u = s;
+    } else {
+        /* move mantissa and exponent into place and rebias 15 -> 127 */
+        u = (u & 0x7FFF) << (23 - 10);
+        u += (127 - 15) << 23;
+        u |= s;
+    }
+    return fp16_as_float(u);
+}
+
+static inline uint16_t fp16_from_f32_vpu(float x) {
+    /* smallest normal f16 (2^-14) and largest finite f16, in f32 */
+    const float min16 = fp16_as_float((127 - 14) << 23);
+    const float max16 = fp16_as_float(((127 + 15) << 23) | 0x007FE000);
+    const uint32_t max16f16 = ((15 + 15) << 10) | 0x3FF;
+
+    uint32_t u = fp16_as_uint(x);
+    uint32_t s = (u >> 16) & 0x8000;
+    float f;
+
+    u &= 0x7FFFFFFF;
+
+    if ((u & FP16_EXP_MASK_F32) == FP16_EXP_MASK_F32) {
+        /* NAN keeps its top mantissa bits plus the quiet bit, INF stays INF.
+         * Note the exponent bits above bit 15 are cut off by the cast. */
+        if (u & 0x007FFFFF) {
+            return (uint16_t)(s | (u >> (23 - 10)) | 0x0200);
+        }
+        return (uint16_t)(s | (u >> (23 - 10)));
+    }
+
+    /* add half of an f16 ULP so that truncation rounds to nearest */
+    f = fp16_as_float(u) + fp16_as_float(u & FP16_EXP_MASK_F32) * fp16_as_float((127 - 11) << 23);
+
+    if (f < min16 * 0.5F) {
+        return (uint16_t)s;
+    }
+    if (f < min16) {
+        return (uint16_t)(s | (1 << 10));
+    }
+    if (f >= max16) {
+        return (uint16_t)(max16f16 | s);
+    }
+
+    u = fp16_as_uint(f);
+    u -= (127 - 15) << 23;
+    u >>= (23 - 10);
+    return (uint16_t)(u | s);
+}
+
+static inline uint32_t fp16_to_f32_bits_ieee(uint16_t h) {
+    uint16_t h_exp = h & 0x7c00u;
+    uint16_t h_sig;
+    uint32_t f_sgn = ((uint32_t)h & 0x8000u) << 16;
+    uint32_t f_exp, f_sig;
+
+    switch (h_exp) {
+        case 0x0000u: /* 0 or subnormal */
+            h_sig = h & 0x03ffu;
+            if (h_sig == 0) {
+                return f_sgn;
+            }
+            h_sig <<= 1;
+            while ((h_sig & 0x0400u) == 0) {
+                h_sig <<= 1;
+                h_exp++;
+            }
+            f_exp = ((uint32_t)(127 - 15 - h_exp)) << 23;
+            f_sig = ((uint32_t)(h_sig & 0x03ffu)) << 13;
+            return f_sgn + f_exp + f_sig;
+        case 0x7c00u: /* inf or NaN, keep the significand */
+            return f_sgn + 0x7f800000u + (((uint32_t)(h & 0x03ffu)) << 13);
+        default: /* normalized, adjust the exponent and shift */
+            return f_sgn + (((uint32_t)(h & 0x7fffu) + 0x1c000u) << 13);
+    }
+}
+
+static inline uint16_t fp16_from_f32_bits_ieee(uint32_t f) {
+    uint32_t f_exp, f_sig;
+    uint16_t h_sgn, h_exp, h_sig;
+
+    h_sgn = (uint16_t)((f & 0x80000000u) >> 16);
+    f_exp = f & 0x7f800000u;
+
+    /* exponent overflow/NaN converts to signed inf/NaN */
+    if (f_exp >= 0x47800000u) {
+        if (f_exp == 0x7f800000u) {
+            f_sig = f & 0x007fffffu;
+            if (f_sig != 0) {
+                /* propagate the NaN payload, but make sure it stays a NaN */
+                uint16_t ret = (uint16_t)(0x7c00u + (f_sig >> 13));
+                if (ret == 0x7c00u) {
+                    ret++;
+                }
+                return h_sgn + ret;
+            }
+            return (uint16_t)(h_sgn + 0x7c00u);
+        }
+        return (uint16_t)(h_sgn + 0x7c00u);
+    }
+
+    /* exponent underflow converts to a subnormal half or signed zero */
+    if (f_exp <= 0x38000000u) {
+        if (f_exp < 0x33000000u) {
+            return h_sgn;
+        }
+        f_exp >>= 23;
+        f_sig = 0x00800000u + (f & 0x007fffffu);
+        f_sig >>= (113 - f_exp);
+        /* round by adding 1 to the bit beyond half precision */
+        f_sig += 0x00001000u;
+        h_sig = (uint16_t)(f_sig >> 13);
+        /* a carry into h_exp yields the smallest normal, which is correct */
+        return (uint16_t)(h_sgn + h_sig);
+    }
+
+    h_exp = (uint16_t)((f_exp - 0x38000000u) >> 13);
+    f_sig = f & 0x007fffffu;
+    f_sig += 0x00001000u;
+    h_sig = (uint16_t)(f_sig >> 13);
+    /* a carry into h_exp is the correct result, up to signed inf */
+    return h_sgn + h_exp + h_sig;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Vector kernels. Each handles a multiple of its lane count and returns    */
+/* the number of elements converted; the caller finishes the tail.         */
+/* ----------------------------------------------------------------------- */
+
+#if defined(FP16_CONVERT_X86)
+
+/* The IEEE flavour leaves the rare subnormal-producing f32 inputs to the
+ * scalar code, this is the exponent range that needs it. */
+#define FP16_IEEE_SUBNORMAL_LO 0x33000000
+#define FP16_IEEE_SUBNORMAL_HI 0x38000000
+
+static inline __m128i fp16_sse2_sel(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/* Keeps the low 16 bits of each 32-bit lane, like a C cast would. */
+static inline void fp16_sse2_store4(uint16_t *dst, __m128i r) {
+    r = _mm_srai_epi32(_mm_slli_epi32(r, 16), 16);
+    _mm_storel_epi64((__m128i *)dst, _mm_packs_epi32(r, r));
+}
+
+static inline __m128i fp16_sse2_load4(const uint16_t *src) {
+    return _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)src), _mm_setzero_si128());
+}
+
+static inline __m128i fp16_sse2_from_f32_vpu(__m128 x) {
+    const __m128i expMask = _mm_set1_epi32((int)FP16_EXP_MASK_F32);
+    const __m128 min16 = _mm_set1_ps(fp16_as_float((127 - 14) << 23));
+    const __m128 halfMin16 = _mm_set1_ps(fp16_as_float((127 - 14) << 23) * 0.5F);
+    const __m128 max16 = _mm_set1_ps(fp16_as_float(((127 + 15) << 23) | 0x007FE000));
+
+    __m128i u = _mm_castps_si128(x);
+    __m128i s = _mm_and_si128(_mm_srli_epi32(u, 16), _mm_set1_epi32(0x8000));
+    __m128i a = _mm_and_si128(u, _mm_set1_epi32(0x7FFFFFFF));
+    __m128i e = _mm_and_si128(a, expMask);
+    __m128i isNanInf = _mm_cmpeq_epi32(e, expMask);
+    __m128i isInf = _mm_cmpeq_epi32(_mm_and_si128(a, _mm_set1_epi32(0x007FFFFF)), _mm_setzero_si128());
+    __m128i nanInf = _mm_or_si128(_mm_srli_epi32(a, 13), _mm_andnot_si128(isInf, _mm_set1_epi32(0x0200)));
+
+    __m128 f = _mm_add_ps(_mm_castsi128_ps(a),
+                          _mm_mul_ps(_mm_castsi128_ps(e), _mm_set1_ps(fp16_as_float((127 - 11) << 23))));
+    __m128i r = _mm_srli_epi32(_mm_sub_epi32(_mm_castps_si128(f), _mm_set1_epi32((127 - 15) << 23)), 13);
+
+    r = fp16_sse2_sel(_mm_castps_si128(_mm_cmpge_ps(f, max16)), _mm_set1_epi32(0x7BFF), r);
+    r = fp16_sse2_sel(_mm_castps_si128(_mm_cmplt_ps(f, min16)), _mm_set1_epi32(0x0400), r);
+    r = _mm_andnot_si128(_mm_castps_si128(_mm_cmplt_ps(f, halfMin16)), r);
+    r = fp16_sse2_sel(isNanInf, nanInf, r);
+    return _mm_or_si128(r, s);
+}
+
+static inline __m128 fp16_sse2_to_f32_vpu(__m128i u) {
+    __m128i s = _mm_slli_epi32(_mm_and_si128(u, _mm_set1_epi32(0x8000)), 16);
+    __m128i e = _mm_and_si128(u, _mm_set1_epi32(FP16_EXP_MASK_F16));
+    __m128i m = _mm_and_si128(u, _mm_set1_epi32(0x03FF));
+    __m128i isZeroMant = _mm_cmpeq_epi32(m, _mm_setzero_si128());
+    __m128i nanInf = _mm_or_si128(_mm_slli_epi32(_mm_or_si128(m, _mm_andnot_si128(isZeroMant, _mm_set1_epi32(0x0200))), 13),
+                                  _mm_set1_epi32((int)FP16_EXP_MASK_F32));
+    __m128i r = _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(u, _mm_set1_epi32(0x7FFF)), 13),
+                              _mm_set1_epi32((127 - 15) << 23));
+
+    r = fp16_sse2_sel(_mm_cmpeq_epi32(e, _mm_set1_epi32(FP16_EXP_MASK_F16)), nanInf, r);
+    r = _mm_andnot_si128(_mm_cmpeq_epi32(e, _mm_setzero_si128()), r);
+    return _mm_castsi128_ps(_mm_or_si128(r, s));
+}
+
+static inline __m128i fp16_sse2_from_f32_ieee(__m128i f, int *needScalar) {
+    __m128i sgn = _mm_and_si128(_mm_srli_epi32(f, 16), _mm_set1_epi32(0x8000));
+    __m128i fexp = _mm_and_si128(f, _mm_set1_epi32((int)FP16_EXP_MASK_F32));
+    __m128i fsig = _mm_and_si128(f, _mm_set1_epi32(0x007FFFFF));
+
+    __m128i normal = _mm_add_epi32(_mm_srli_epi32(_mm_sub_epi32(fexp, _mm_set1_epi32(0x38000000)), 13),
+                                   _mm_srli_epi32(_mm_add_epi32(fsig, _mm_set1_epi32(0x1000)), 13));
+    __m128i nanSig = _mm_srli_epi32(fsig, 13);
+    nanSig = _mm_sub_epi32(nanSig, _mm_cmpeq_epi32(nanSig, _mm_setzero_si128()));
+    __m128i isNan = _mm_andnot_si128(_mm_cmpeq_epi32(fsig, _mm_setzero_si128()),
+                                     _mm_cmpeq_epi32(fexp, _mm_set1_epi32((int)FP16_EXP_MASK_F32)));
+    __m128i big = _mm_add_epi32(_mm_set1_epi32(0x7C00), _mm_and_si128(isNan, nanSig));
+
+    __m128i isBig = _mm_cmpgt_epi32(fexp, _mm_set1_epi32(0x47800000 - 1));
+    __m128i isSmall = _mm_cmplt_epi32(fexp, _mm_set1_epi32(FP16_IEEE_SUBNORMAL_HI + 1));
+    __m128i isSub = _mm_andnot_si128(_mm_cmplt_epi32(fexp, _mm_set1_epi32(FP16_IEEE_SUBNORMAL_LO)), isSmall);
+
+    __m128i r = fp16_sse2_sel(isBig, big, normal);
+    r = _mm_andnot_si128(isSmall, r);
+    *needScalar = _mm_movemask_epi8(isSub);
+    return _mm_add_epi32(r, sgn);
+}
+
+static inline __m128i fp16_sse2_to_f32_ieee(__m128i h) {
+    __m128i sgn = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16);
+    __m128i hexp = _mm_and_si128(h, _mm_set1_epi32(0x7C00));
+    __m128i hsig = _mm_and_si128(h, _mm_set1_epi32(0x03FF));
+
+    __m128i normal = _mm_slli_epi32(_mm_add_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7FFF)), _mm_set1_epi32(0x1C000)), 13);
+    __m128i nanInf = _mm_add_epi32(_mm_set1_epi32(0x7F800000), _mm_slli_epi32(hsig, 13));
+    /* subnormal halves are exactly sig * 2^-24, which is a normal float */
+    __m128i sub = _mm_castps_si128(_mm_mul_ps(_mm_cvtepi32_ps(hsig), _mm_set1_ps(fp16_as_float((127 - 24) << 23))));
+
+    __m128i r = fp16_sse2_sel(_mm_cmpeq_epi32(hexp, _mm_set1_epi32(0x7C00)), nanInf, normal);
+    r = fp16_sse2_sel(_mm_cmpeq_epi32(hexp, _mm_setzero_si128()), sub, r);
+    return _mm_add_epi32(r, sgn);
+}
+
+static inline size_t fp16_sse2_f32_to_f16(uint16_t *dst, const float *src, size_t n,
+                                          float scale, float bias, int affine, fp16_rounding_t mode) {
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 vbias = _mm_set1_ps(bias);
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(src + i);
+        if (affine) {
+            x = _mm_add_ps(_mm_mul_ps(x, vscale), vbias);
+        }
+        if (mode == FP16_ROUND_VPU) {
+            fp16_sse2_store4(dst + i, fp16_sse2_from_f32_vpu(x));
+        } else {
+            int needScalar;
+            __m128i r = fp16_sse2_from_f32_ieee(_mm_castps_si128(x), &needScalar);
+            fp16_sse2_store4(dst + i, r);
+            if (needScalar) {
+                float tmp[4];
+                size_t k;
+                _mm_storeu_ps(tmp, x);
+                for (k = 0; k < 4; k++) {
+                    dst[i + k] = fp16_from_f32_bits_ieee(fp16_as_uint(tmp[k]));
+                }
+            }
+        }
+    }
+    return i;
+}
+
+static inline size_t fp16_sse2_f16_to_f32(float *dst, const uint16_t *src, size_t n,
+                                          float scale, float bias, int affine, fp16_rounding_t mode) {
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 vbias = _mm_set1_ps(bias);
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+        __m128i h = fp16_sse2_load4(src + i);
+        __m128 x = mode == FP16_ROUND_VPU ? fp16_sse2_to_f32_vpu(h)
+                                          : _mm_castsi128_ps(fp16_sse2_to_f32_ieee(h));
+        if (affine) {
+            x = _mm_add_ps(_mm_mul_ps(x, vscale), vbias);
+        }
+        _mm_storeu_ps(dst + i, x);
+    }
+    return i;
+}
+
+#define FP16_AVX2 __attribute__((target("avx2")))
+
+static inline FP16_AVX2 __m256i fp16_avx2_sel(__m256i mask, __m256i a, __m256i b) {
+    return _mm256_blendv_epi8(b, a, mask);
+}
+
+static inline FP16_AVX2 void fp16_avx2_store8(uint16_t *dst, __m256i r) {
+    /* masked to 16 bits the unsigned saturating pack is exact */
+    r = _mm256_and_si256(r, _mm256_set1_epi32(0xFFFF));
+    r = _mm256_permute4x64_epi64(_mm256_packus_epi32(r, r), 0x08);
+    _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(r));
+}
+
+static inline FP16_AVX2 __m256i fp16_avx2_from_f32_vpu(__m256 x) {
+    const __m256i expMask = _mm256_set1_epi32((int)FP16_EXP_MASK_F32);
+    const __m256 min16 = _mm256_set1_ps(fp16_as_float((127 - 14) << 23));
+    const __m256 halfMin16 = _mm256_set1_ps(fp16_as_float((127 - 14) << 23) * 0.5F);
+    const __m256 max16 = _mm256_set1_ps(fp16_as_float(((127 + 15) << 23) | 0x007FE000));
+
+    __m256i u = _mm256_castps_si256(x);
+    __m256i s = _mm256_and_si256(_mm256_srli_epi32(u, 16), _mm256_set1_epi32(0x8000));
+    __m256i a = _mm256_and_si256(u, _mm256_set1_epi32(0x7FFFFFFF));
+    __m256i e = _mm256_and_si256(a, expMask);
+    __m256i isNanInf = _mm256_cmpeq_epi32(e, expMask);
+    __m256i isInf = _mm256_cmpeq_epi32(_mm256_and_si256(a, _mm256_set1_epi32(0x007FFFFF)), _mm256_setzero_si256());
+    __m256i nanInf = _mm256_or_si256(_mm256_srli_epi32(a, 13), _mm256_andnot_si256(isInf, _mm256_set1_epi32(0x0200)));
+
+    __m256 f = _mm256_add_ps(_mm256_castsi256_ps(a),
+                             _mm256_mul_ps(_mm256_castsi256_ps(e), _mm256_set1_ps(fp16_as_float((127 - 11) << 23))));
+    __m256i r = _mm256_srli_epi32(_mm256_sub_epi32(_mm256_castps_si256(f), _mm256_set1_epi32((127 - 15) << 23)), 13);
+
+    r = fp16_avx2_sel(_mm256_castps_si256(_mm256_cmp_ps(f, max16, _CMP_GE_OQ)), _mm256_set1_epi32(0x7BFF), r);
+    r = fp16_avx2_sel(_mm256_castps_si256(_mm256_cmp_ps(f, min16, _CMP_LT_OQ)), _mm256_set1_epi32(0x0400), r);
+    r = _mm256_andnot_si256(_mm256_castps_si256(_mm256_cmp_ps(f, halfMin16, _CMP_LT_OQ)), r);
+    r = fp16_avx2_sel(isNanInf, nanInf, r);
+    return _mm256_or_si256(r, s);
+}
+
+static inline FP16_AVX2 __m256 fp16_avx2_to_f32_vpu(__m256i u) {
+    __m256i s = _mm256_slli_epi32(_mm256_and_si256(u, _mm256_set1_epi32(0x8000)), 16);
+    __m256i e = _mm256_and_si256(u, _mm256_set1_epi32(FP16_EXP_MASK_F16));
+    __m256i m = _mm256_and_si256(u, _mm256_set1_epi32(0x03FF));
+    __m256i isZeroMant = _mm256_cmpeq_epi32(m, _mm256_setzero_si256());
+    __m256i nanInf = _mm256_or_si256(
+            _mm256_slli_epi32(_mm256_or_si256(m, _mm256_andnot_si256(isZeroMant, _mm256_set1_epi32(0x0200))), 13),
+            _mm256_set1_epi32((int)FP16_EXP_MASK_F32));
+    __m256i r = _mm256_add_epi32(_mm256_slli_epi32(_mm256_and_si256(u, _mm256_set1_epi32(0x7FFF)), 13),
+                                 _mm256_set1_epi32((127 - 15) << 23));
+
+    r = fp16_avx2_sel(_mm256_cmpeq_epi32(e, _mm256_set1_epi32(FP16_EXP_MASK_F16)), nanInf, r);
+    r = _mm256_andnot_si256(_mm256_cmpeq_epi32(e, _mm256_setzero_si256()), r);
+    return _mm256_castsi256_ps(_mm256_or_si256(r, s));
+}
+
+static inline FP16_AVX2 __m256i fp16_avx2_from_f32_ieee(__m256i f, int *needScalar) {
+    __m256i sgn = _mm256_and_si256(_mm256_srli_epi32(f, 16), _mm256_set1_epi32(0x8000));
+    __m256i fexp = _mm256_and_si256(f, _mm256_set1_epi32((int)FP16_EXP_MASK_F32));
+    __m256i fsig = _mm256_and_si256(f, _mm256_set1_epi32(0x007FFFFF));
+
+    __m256i normal = _mm256_add_epi32(_mm256_srli_epi32(_mm256_sub_epi32(fexp, _mm256_set1_epi32(0x38000000)), 13),
+                                      _mm256_srli_epi32(_mm256_add_epi32(fsig, _mm256_set1_epi32(0x1000)), 13));
+    __m256i nanSig = _mm256_srli_epi32(fsig, 13);
+    nanSig = _mm256_sub_epi32(nanSig, _mm256_cmpeq_epi32(nanSig, _mm256_setzero_si256()));
+    __m256i isNan = _mm256_andnot_si256(_mm256_cmpeq_epi32(fsig, _mm256_setzero_si256()),
+                                        _mm256_cmpeq_epi32(fexp, _mm256_set1_epi32((int)FP16_EXP_MASK_F32)));
+    __m256i big = _mm256_add_epi32(_mm256_set1_epi32(0x7C00), _mm256_and_si256(isNan, nanSig));
+
+    __m256i isBig = _mm256_cmpgt_epi32(fexp, _mm256_set1_epi32(0x47800000 - 1));
+    __m256i isSmall = _mm256_cmpgt_epi32(_mm256_set1_epi32(FP16_IEEE_SUBNORMAL_HI + 1), fexp);
+    __m256i isSub = _mm256_andnot_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(FP16_IEEE_SUBNORMAL_LO), fexp), isSmall);
+
+    __m256i r = fp16_avx2_sel(isBig, big, normal);
+    r = _mm256_andnot_si256(isSmall, r);
+    *needScalar = _mm256_movemask_epi8(isSub);
+    return _mm256_add_epi32(r, sgn);
+}
+
+static inline FP16_AVX2 __m256i fp16_avx2_to_f32_ieee(__m256i h) {
+    __m256i sgn = _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(0x8000)), 16);
+    __m256i hexp = _mm256_and_si256(h, _mm256_set1_epi32(0x7C00));
+    __m256i hsig = _mm256_and_si256(h, _mm256_set1_epi32(0x03FF));
+
+    __m256i normal = _mm256_slli_epi32(_mm256_add_epi32(_mm256_and_si256(h, _mm256_set1_epi32(0x7FFF)),
+                                                        _mm256_set1_epi32(0x1C000)), 13);
+    __m256i nanInf = _mm256_add_epi32(_mm256_set1_epi32(0x7F800000), _mm256_slli_epi32(hsig, 13));
+    __m256i sub = _mm256_castps_si256(_mm256_mul_ps(_mm256_cvtepi32_ps(hsig),
+                                                    _mm256_set1_ps(fp16_as_float((127 - 24) << 23))));
+
+    __m256i r = fp16_avx2_sel(_mm256_cmpeq_epi32(hexp, _mm256_set1_epi32(0x7C00)), nanInf, normal);
+    r = fp16_avx2_sel(_mm256_cmpeq_epi32(hexp, _mm256_setzero_si256()), sub, r);
+    return _mm256_add_epi32(r, sgn);
+}
+
+static inline FP16_AVX2 size_t fp16_avx2_f32_to_f16(uint16_t *dst, const float *src, size_t n,
+                                                    float scale, float bias, int affine, fp16_rounding_t mode) {
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 vbias = _mm256_set1_ps(bias);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(src + i);
+        if (affine) {
+            /* separate multiply and add, FMA would change the rounding */
+            x = _mm256_add_ps(_mm256_mul_ps(x, vscale), vbias);
+        }
+        if (mode == FP16_ROUND_VPU) {
+            fp16_avx2_store8(dst + i, fp16_avx2_from_f32_vpu(x));
+        } else {
+            int needScalar;
+            __m256i r = fp16_avx2_from_f32_ieee(_mm256_castps_si256(x), &needScalar);
+            fp16_avx2_store8(dst + i, r);
+            if (needScalar) {
+                float tmp[8];
+                size_t k;
+                _mm256_storeu_ps(tmp, x);
+                for (k = 0; k < 8; k++) {
+                    dst[i + k] = fp16_from_f32_bits_ieee(fp16_as_uint(tmp[k]));
+                }
+            }
+        }
+    }
+    return i;
+}
+
+static inline FP16_AVX2 size_t fp16_avx2_f16_to_f32(float *dst, const uint16_t *src, size_t n,
+                                                    float scale, float bias, int affine, fp16_rounding_t mode) {
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 vbias = _mm256_set1_ps(bias);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m256i h = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(src + i)));
+        __m256 x = mode == FP16_ROUND_VPU ? fp16_avx2_to_f32_vpu(h)
+                                          : _mm256_castsi256_ps(fp16_avx2_to_f32_ieee(h));
+        if (affine) {
+            x = _mm256_add_ps(_mm256_mul_ps(x, vscale), vbias);
+        }
+        _mm256_storeu_ps(dst + i, x);
+    }
+    return i;
+}
+
+static inline int fp16_has_avx2(void) {
+    static int hasAvx2 = -1;
+    if (hasAvx2 < 0) {
+        __builtin_cpu_init();
+        hasAvx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+    return hasAvx2;
+}
+
+#elif defined(FP16_CONVERT_NEON)
+
+static inline uint32x4_t fp16_neon_from_f32_vpu(float32x4_t x) {
+    const uint32x4_t expMask = vdupq_n_u32(FP16_EXP_MASK_F32);
+    const float32x4_t min16 = vdupq_n_f32(fp16_as_float((127 - 14) << 23));
+    const float32x4_t halfMin16 = vdupq_n_f32(fp16_as_float((127 - 14) << 23) * 0.5F);
+    const float32x4_t max16 = vdupq_n_f32(fp16_as_float(((127 + 15) << 23) | 0x007FE000));
+
+    uint32x4_t u = vreinterpretq_u32_f32(x);
+    uint32x4_t s = vandq_u32(vshrq_n_u32(u, 16), vdupq_n_u32(0x8000));
+    uint32x4_t a = vandq_u32(u, vdupq_n_u32(0x7FFFFFFF));
+    uint32x4_t e = vandq_u32(a, expMask);
+    uint32x4_t isNanInf = vceqq_u32(e, expMask);
+    uint32x4_t isNan = vtstq_u32(a, vdupq_n_u32(0x007FFFFF));
+    uint32x4_t nanInf = vorrq_u32(vshrq_n_u32(a, 13), vandq_u32(isNan, vdupq_n_u32(0x0200)));
+
+    float32x4_t f = vaddq_f32(vreinterpretq_f32_u32(a),
+                              vmulq_f32(vreinterpretq_f32_u32(e), vdupq_n_f32(fp16_as_float((127 - 11) << 23))));
+    uint32x4_t r = vshrq_n_u32(vsubq_u32(vreinterpretq_u32_f32(f), vdupq_n_u32((127 - 15) << 23)), 13);
+
+    r = vbslq_u32(vcgeq_f32(f, max16), vdupq_n_u32(0x7BFF), r);
+    r = vbslq_u32(vcltq_f32(f, min16), vdupq_n_u32(0x0400), r);
+    r = vbicq_u32(r, vcltq_f32(f, halfMin16));
+    r = vbslq_u32(isNanInf, nanInf, r);
+    return vorrq_u32(r, s);
+}
+
+static inline float32x4_t fp16_neon_to_f32_vpu(uint32x4_t u) {
+    uint32x4_t s = vshlq_n_u32(vandq_u32(u, vdupq_n_u32(0x8000)), 16);
+    uint32x4_t e = vandq_u32(u, vdupq_n_u32(FP16_EXP_MASK_F16));
+    uint32x4_t m = vandq_u32(u, vdupq_n_u32(0x03FF));
+    uint32x4_t nanInf = vorrq_u32(vshlq_n_u32(vorrq_u32(m, vandq_u32(vtstq_u32(m, m), vdupq_n_u32(0x0200))), 13),
+                                  vdupq_n_u32(FP16_EXP_MASK_F32));
+    uint32x4_t r = vaddq_u32(vshlq_n_u32(vandq_u32(u, vdupq_n_u32(0x7FFF)), 13), vdupq_n_u32((127 - 15) << 23));
+
+    r = vbslq_u32(vceqq_u32(e, vdupq_n_u32(FP16_EXP_MASK_F16)), nanInf, r);
+    r = vbicq_u32(r, vceqq_u32(e, vdupq_n_u32(0)));
+    return vreinterpretq_f32_u32(vorrq_u32(r, s));
+}
+
+static inline uint32x4_t fp16_neon_from_f32_ieee(uint32x4_t f, int *needScalar) {
+    uint32x4_t sgn = vandq_u32(vshrq_n_u32(f, 16), vdupq_n_u32(0x8000));
+    uint32x4_t fexp = vandq_u32(f, vdupq_n_u32(FP16_EXP_MASK_F32));
+    uint32x4_t fsig = vandq_u32(f, vdupq_n_u32(0x007FFFFF));
+
+    uint32x4_t normal = vaddq_u32(vshrq_n_u32(vsubq_u32(fexp, vdupq_n_u32(0x38000000)), 13),
+                                  vshrq_n_u32(vaddq_u32(fsig, vdupq_n_u32(0x1000)), 13));
+    uint32x4_t nanSig = vshrq_n_u32(fsig, 13);
+    nanSig = vsubq_u32(nanSig, vceqq_u32(nanSig, vdupq_n_u32(0)));
+    uint32x4_t isNan = vandq_u32(vtstq_u32(fsig, fsig), vceqq_u32(fexp, vdupq_n_u32(FP16_EXP_MASK_F32)));
+    uint32x4_t big = vaddq_u32(vdupq_n_u32(0x7C00), vandq_u32(isNan, nanSig));
+
+    uint32x4_t isBig = vcgeq_u32(fexp, vdupq_n_u32(0x47800000));
+    uint32x4_t isSmall = vcleq_u32(fexp, vdupq_n_u32(0x38000000));
+    uint32x4_t isSub = vandq_u32(isSmall, vcgeq_u32(fexp, vdupq_n_u32(0x33000000)));
+    uint32x2_t any = vorr_u32(vget_low_u32(isSub), vget_high_u32(isSub));
+
+    uint32x4_t r = vbslq_u32(isBig, big, normal);
+    r = vbicq_u32(r, isSmall);
+    *needScalar = (vget_lane_u32(any, 0) | vget_lane_u32(any, 1)) != 0;
+    return vaddq_u32(r, sgn);
+}
+
+static inline uint32x4_t fp16_neon_to_f32_ieee(uint32x4_t h) {
+    uint32x4_t sgn = vshlq_n_u32(vandq_u32(h, vdupq_n_u32(0x8000)), 16);
+    uint32x4_t hexp = vandq_u32(h, vdupq_n_u32(0x7C00));
+    uint32x4_t hsig = vandq_u32(h, vdupq_n_u32(0x03FF));
+
+    uint32x4_t normal = vshlq_n_u32(vaddq_u32(vandq_u32(h, vdupq_n_u32(0x7FFF)), vdupq_n_u32(0x1C000)), 13);
+    uint32x4_t nanInf = vaddq_u32(vdupq_n_u32(0x7F800000), vshlq_n_u32(hsig, 13));
+    uint32x4_t sub = vreinterpretq_u32_f32(vmulq_f32(vcvtq_f32_u32(hsig),
+                                                     vdupq_n_f32(fp16_as_float((127 - 24) << 23))));
+
+    uint32x4_t r = vbslq_u32(vceqq_u32(hexp, vdupq_n_u32(0x7C00)), nanInf, normal);
+    r = vbslq_u32(vceqq_u32(hexp, vdupq_n_u32(0)), sub, r);
+    return vaddq_u32(r, sgn);
+}
+
+static inline size_t fp16_neon_f32_to_f16(uint16_t *dst, const float *src, size_t n,
+                                          float scale, float bias, int affine, fp16_rounding_t mode) {
+    const float32x4_t vscale = vdupq_n_f32(scale);
+    const float32x4_t vbias = vdupq_n_f32(bias);
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+        float32x4_t x = vld1q_f32(src + i);
+        if (affine) {
+            x = vaddq_f32(vmulq_f32(x, vscale), vbias);
+        }
+        if (mode == FP16_ROUND_VPU) {
+            vst1_u16(dst + i, vmovn_u32(fp16_neon_from_f32_vpu(x)));
+        } else {
+            int needScalar;
+            uint32x4_t r = fp16_neon_from_f32_ieee(vreinterpretq_u32_f32(x), &needScalar);
+            vst1_u16(dst + i, vmovn_u32(r));
+            if (needScalar) {
+                float tmp[4];
+                size_t k;
+                vst1q_f32(tmp, x);
+                for (k = 0; k < 4; k++) {
+                    dst[i + k] = fp16_from_f32_bits_ieee(fp16_as_uint(tmp[k]));
+                }
+            }
+        }
+    }
+    return i;
+}
+
+static inline size_t fp16_neon_f16_to_f32(float *dst, const uint16_t *src, size_t n,
+                                          float scale, float bias, int affine, fp16_rounding_t mode) {
+    const float32x4_t vscale = vdupq_n_f32(scale);
+    const float32x4_t vbias = vdupq_n_f32(bias);
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+        uint32x4_t h = vmovl_u16(vld1_u16(src + i));
+        float32x4_t x = mode == FP16_ROUND_VPU ? fp16_neon_to_f32_vpu(h)
+                                               : vreinterpretq_f32_u32(fp16_neon_to_f32_ieee(h));
+        if (affine) {
+            x = vaddq_f32(vmulq_f32(x, vscale), vbias);
+        }
+        vst1q_f32(dst + i, x);
+    }
+    return i;
+}
+
+#endif
+
+/* ----------------------------------------------------------------------- */
+/* Array entry points                                                      */
+/* ----------------------------------------------------------------------- */
+
+static inline void fp16_convert_f32_to_f16_impl(uint16_t *dst, const float *src, size_t n,
+                                                float scale, float bias, int affine, fp16_rounding_t mode) {
+    size_t i = 0;
+
+#if defined(FP16_CONVERT_X86)
+    if (fp16_has_avx2()) {
+        i = fp16_avx2_f32_to_f16(dst, src, n, scale, bias, affine, mode);
+    } else {
+        i = fp16_sse2_f32_to_f16(dst, src, n, scale, bias, affine, mode);
+    }
+#elif defined(FP16_CONVERT_NEON)
+    i = fp16_neon_f32_to_f16(dst, src, n, scale, bias, affine, mode);
+#endif
+
+    for (; i < n; i++) {
+        float x = affine ? src[i] * scale + bias : src[i];
+        dst[i] = mode == FP16_ROUND_VPU ? fp16_from_f32_vpu(x) : fp16_from_f32_bits_ieee(fp16_as_uint(x));
+    }
+}
+
+static inline void fp16_convert_f16_to_f32_impl(float *dst, const uint16_t *src, size_t n,
+                                                float scale, float bias, int affine, fp16_rounding_t mode) {
+    size_t i = 0;
+
+#if defined(FP16_CONVERT_X86)
+    if (fp16_has_avx2()) {
+        i = fp16_avx2_f16_to_f32(dst, src, n, scale, bias, affine, mode);
+    } else {
+        i = fp16_sse2_f16_to_f32(dst, src, n, scale, bias, affine, mode);
+    }
+#elif defined(FP16_CONVERT_NEON)
+    i = fp16_neon_f16_to_f32(dst, src, n, scale, bias, affine, mode);
+#endif
+
+    for (; i < n; i++) {
+        float x = mode == FP16_ROUND_VPU ? fp16_to_f32_vpu(src[i]) : fp16_as_float(fp16_to_f32_bits_ieee(src[i]));
+        dst[i] = affine ? x * scale + bias : x;
+    }
+}
+
+/* dst[i] = f16(src[i] * scale + bias), applied even for a scale of 1 and a
+ * bias of 0, so -0 converts to +0 as it always has in the inference engine */
+static inline void fp16_convert_f32_to_f16(uint16_t *dst, const float *src, size_t n,
+                                           float scale, float bias, fp16_rounding_t mode) {
+    fp16_convert_f32_to_f16_impl(dst, src, n, scale, bias, 1, mode);
+}
+
+/* dst[i] = f32(src[i]) * scale + bias, see above */
+static inline void fp16_convert_f16_to_f32(float *dst, const uint16_t *src, size_t n,
+                                           float scale, float bias, fp16_rounding_t mode) {
+    fp16_convert_f16_to_f32_impl(dst, src, n, scale, bias, 1, mode);
+}
+
+/* dst[i] = f16(src[i]), keeping the sign of zeros as the NCSDK does */
+static inline void fp16_convert_f32_to_f16_plain(uint16_t *dst, const float *src, size_t n,
+                                                 fp16_rounding_t mode) {
+    fp16_convert_f32_to_f16_impl(dst, src, n, 1.f, 0.f, 0, mode);
+}
+
+/* dst[i] = f32(src[i]), keeping the sign of zeros */
+static inline void fp16_convert_f16_to_f32_plain(float *dst, const uint16_t *src, size_t n,
+                                                 fp16_rounding_t mode) {
+    fp16_convert_f16_to_f32_impl(dst, src, n, 1.f, 0.f, 0, mode);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FP16_CONVERT_H */
@@ -141,6 +141,14 @@ typedef enum {
     NC_FIFO_FP32 = 1,
 } ncFifoDatatype_t;
 
+// values of NC_RW_FIFO_ASYNC_WRITE
+typedef enum {
+    NC_FIFO_ASYNC_WRITE_OFF = 0,
+    NC_FIFO_ASYNC_WRITE_COPY = 1,     // the tensor is copied before WriteTensor returns
+    NC_FIFO_ASYNC_WRITE_IN_PLACE = 2, // the tensor is sent from where it is, it must not
+                                      // change until its result is read. fp32 FIFOs copy
+} ncFifoAsyncWrite_t;
+
 struct ncTensorDescriptor_t {
     unsigned int n;
     unsigned int c;
@@ -149,6 +157,12 @@ struct ncTensorDescriptor_t {
     unsigned int totalSize;
 };
 
+// one piece of a tensor written with ncFifoWriteElemSegments
+struct ncTensorSegment_t {
+    const void *data;
+    unsigned int length;
+};
+
 typedef enum {
     NC_RW_FIFO_TYPE = 0, // configure the fifo type to one type from ncFifoType_t
     NC_RW_FIFO_CONSUMER_COUNT = 1,  // The number of consumers of elements
@@ -165,6 +179,9 @@ typedef enum {
     NC_RO_FIFO_WRITE_FILL_LEVEL = 6,  // return number of tensors in a write buffer
     NC_RO_FIFO_TENSOR_DESCRIPTOR = 7, // return the tensor descriptor of the FIFO
     NC_RO_FIFO_STATE = 8, // return the device state
+    NC_RW_FIFO_ASYNC_WRITE = 9, // one of ncFifoAsyncWrite_t, to let WriteTensor return
+                                // before the tensor reaches the device. Up to the
+                                // FIFO capacity of writes stay in flight
 } ncFifoOption_t;
 
 
@@ -219,6 +236,12 @@ ncStatus_t ncFifoGetOption(struct fifoHandle_t* fifo, ncFifoOption_t option,
 ncStatus_t ncFifoDelete(struct fifoHandle_t* fifo);
 ncStatus_t ncFifoWriteElem(struct fifoHandle_t* fifo, const void *inputTensor,
                            struct ncTensorDescriptor_t *inputDesc, void *userParam);
+// Writes one element gathered from several buffers, without concatenating them
+// first when the write is synchronous. The lengths add up to the tensor size,
+// twice that for an fp32 FIFO
+ncStatus_t ncFifoWriteElemSegments(struct fifoHandle_t* fifo,
+                           const struct ncTensorSegment_t *segments, unsigned int count,
+                           struct ncTensorDescriptor_t *inputDesc, void *userParam);
 ncStatus_t ncFifoReadElem(struct fifoHandle_t* fifo, void **outputData,
                           struct ncTensorDescriptor_t *outputDesc, void **userParam);
 ncStatus_t ncFifoRemoveElem(struct fifoHandle_t* fifo);
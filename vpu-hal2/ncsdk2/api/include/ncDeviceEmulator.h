@@ -0,0 +1,56 @@
+///
+/// @file
+/// @copyright All code copyright Movidius Ltd 2012, all rights reserved.
+///            For License Warranty see: common/license.txt
+///
+/// @brief     Host side stand-in for the NCS firmware
+///
+/// Serves the device end of an XLink link with the monitor protocol libmvnc
+/// speaks (ncCommPrivate.h). Graphs are not executed: every inference takes
+/// latency_us and produces an all zero output of the size the blob declares.
+/// Meant for exercising the API, the transport and the scheduling without a
+/// stick attached.
+///
+
+// Includes
+// ----------------------------------------------------------------------------
+
+#ifndef _NC_DEVICE_EMULATOR_H_
+#define _NC_DEVICE_EMULATOR_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct {
+    uint32_t max_graphs;
+    uint32_t max_fifos;
+    uint32_t max_memory;
+    uint32_t max_executors;   // inferences run in parallel for one graph
+    uint32_t latency_us;      // time taken by one inference
+} ncEmulatorConfig_t;
+
+// Default capabilities of a ma2450. NC_EMULATOR_LATENCY_US and
+// NC_EMULATOR_EXECUTORS override the inference time and the executor count
+void ncEmulatorDefaultConfig(ncEmulatorConfig_t *config);
+
+// Starts serving the device end of a transport link (see XLinkAccept),
+// returns once the session threads run. 0 on success
+int ncEmulatorServe(void *fd, const ncEmulatorConfig_t *config);
+
+// Lets the loopback transport reach an emulator in this process, NULL config
+// for the defaults
+void ncEmulatorInstallLoopback(const ncEmulatorConfig_t *config);
+
+// Listens on a UNIX socket for the socket transport and serves every host
+// that connects. XLinkInitialize has to be called before. Returns on error only
+int ncEmulatorRunSocket(const char *path, const ncEmulatorConfig_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -86,5 +86,18 @@ struct _fifoPrivate_t{
     pthread_mutex_t fifo_mutex;
     ncFifoState_t state;
     void* output_data;
+    // asynchronous writes, completed on the XLink dispatcher thread. Guarded by
+    // async_m rather than fifo_mutex, which is held around synchronous XLink calls
+    int async_write;
+    int writes_in_flight;
+    // a write failed after its element was triggered: the graph takes the next
+    // element in its place, only a new FIFO brings the two back in step
+    int async_write_error;
+    // elements, by write_count, whose write failed before they were triggered.
+    // The trigger that reaches one drops it and fails, the next ones go through
+    int *lost_writes;
+    int lost_count;
+    pthread_mutex_t async_m;
+    pthread_cond_t write_cond;
 };
 #endif
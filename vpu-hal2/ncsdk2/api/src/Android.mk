@@ -24,36 +24,64 @@ XLINK_CFLAGS:= -I$(XLINK_BASE)/shared \
 								-I$(MV_COMMON_BASE)/shared/include
 
 
-LOCAL_MODULE := libmvnc
-LOCAL_PROPRIETARY_MODULE := true
-#LOCAL_MULTILIB := 64
-LOCAL_MULTILIB := both
-LOCAL_MODULE_OWNER := intel
-LOCAL_SRC_FILES := \
+MVNC_SRC_FILES:= \
 	mvnc_api.c \
 	fp16.c \
 	mvnc_api_highclass.c \
 	common/components/XLink/pc/UsbLinkPlatform.cpp \
+	common/components/XLink/pc/UsbLinkTransfer.c \
 	common/components/XLink/pc/usb_boot.c \
 	common/components/XLink/shared/XLink.c \
 	common/components/XLink/shared/XLinkDispatcher.c \
+	common/components/XLink/shared/XLinkTransport.c \
 	common/components/XLinkConsole/pc/XLinkConsole.c
 
-
-LOCAL_C_INCLUDES += \
+MVNC_C_INCLUDES:= \
 	$(LOCAL_PATH) \
 	$(LOCAL_PATH)/../include \
 	$(LIBUSB_HEADER)
 
+MVNC_CFLAGS:= $(XLINK_CFLAGS) -D__PC__ -DUSE_USB_VSC -DDEVICE_SHELL_ENABLED -Wno-error \
+	-O2 -Wall -pthread -fPIC -MMD -MP
+
+
+LOCAL_MODULE := libmvnc
+LOCAL_PROPRIETARY_MODULE := true
+#LOCAL_MULTILIB := 64
+LOCAL_MULTILIB := both
+LOCAL_MODULE_OWNER := intel
+LOCAL_SRC_FILES := $(MVNC_SRC_FILES)
+
+LOCAL_C_INCLUDES += $(MVNC_C_INCLUDES)
+
 #LOCAL_C_INCLUDES += $(LIBUSB_ROOT_ABS)
 
-LOCAL_CFLAGS += $(XLINK_CFLAGS) -D__PC__ -DUSE_USB_VSC -DDEVICE_SHELL_ENABLED -Wno-error
-LOCAL_CFLAGS += -O2 -Wall -pthread -fPIC -MMD -MP
+LOCAL_CFLAGS += $(MVNC_CFLAGS)
 
 LOCAL_SHARED_LIBRARIES := libusb1.0 liblog
 
 include $(BUILD_SHARED_LIBRARY)
 
+# libmvnc_emulator: libmvnc plus the loopback/socket transports and the
+# device emulator, for ncs-test-apps only. Never installed on the device
+$(info LOCAL_PATH =$(LOCAL_PATH))
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := libmvnc_emulator
+LOCAL_PROPRIETARY_MODULE := true
+LOCAL_MULTILIB := both
+LOCAL_MODULE_OWNER := intel
+LOCAL_SRC_FILES := \
+	$(MVNC_SRC_FILES) \
+	ncDeviceEmulator.c \
+	common/components/XLink/pc/XLinkSocketTransport.c
+
+LOCAL_C_INCLUDES += $(MVNC_C_INCLUDES)
+
+LOCAL_CFLAGS += $(MVNC_CFLAGS) -DXLINK_EMULATOR
+
+include $(BUILD_STATIC_LIBRARY)
+
 #include $(BUILD_STATIC_LIBRARY)
 $(info LOCAL_PATH =$(LOCAL_PATH))
 include $(CLEAR_VARS)
@@ -21,6 +21,7 @@
 ///
 
 #include "UsbLinkPlatform.h"
+#include "XLinkTransport.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -39,6 +40,7 @@
 #include <termios.h>
 #include <libusb.h>
 #include "usb_boot.h"
+#include "UsbLinkTransfer.h"
 
 #ifdef USE_LINK_JTAG
 #include <sys/types.h>          /* See NOTES */
@@ -98,20 +100,14 @@ static double seconds()
     return ts.tv_sec + ts.tv_nsec * 1e-9 - s;
 }
 
+static usbLinkTransferConfig_t transferConfig;
+
 static int usb_write(libusb_device_handle *f, const void *data, size_t size, unsigned int timeout)
 {
-    while(size > 0)
-    {
-        int bt, ss = size;
-        if(ss > 1024*1024*10)
-            ss = 1024*1024*10;
-        int rc = libusb_bulk_transfer(f, USB_ENDPOINT_OUT, (unsigned char *)data, ss, &bt, timeout);
-        if(rc)
-            return rc;
-        data = (char *)data + bt;
-        size -= bt;
-    }
-    return 0;
+    streamSegmentDesc_t segment;
+    segment.data = (const uint8_t *)data;
+    segment.length = size;
+    return usbLinkBulkWrite(f, USB_ENDPOINT_OUT, &segment, 1, timeout, &transferConfig);
 }
 
 static int usb_read(libusb_device_handle *f, void *data, size_t size, unsigned int timeout)
@@ -219,6 +215,24 @@ int USBLinkWrite(void* fd, void* data, int size, unsigned int timeout)
     return rc;
 }
 
+int USBLinkWriteSegments(void* fd, const streamSegmentDesc_t* segments, int count,
+                         unsigned int timeout)
+{
+#ifndef USE_USB_VSC
+    int i;
+    for (i = 0; i < count; i++)
+    {
+        int rc = USBLinkWrite(fd, (void*)segments[i].data, segments[i].length, timeout);
+        if (rc)
+            return rc;
+    }
+    return 0;
+#else
+    return usbLinkBulkWrite((libusb_device_handle *) fd, USB_ENDPOINT_OUT, segments, count,
+                            timeout, &transferConfig);
+#endif  /*USE_USB_VSC*/
+}
+
  int USBLinkRead(void* fd, void* data, int size, unsigned int timeout)
 {
     //printf("%s() fd %p size %d\n", __func__, fd, size);
@@ -468,19 +482,19 @@ int UsbLinkPlatformConnect(const char* devPathRead, const char* devPathWrite, vo
 int UsbLinkPlatformInit(int loglevel)
 {
     usb_loglevel = loglevel;
+    usbLinkTransferDefaultConfig(&transferConfig);
     return 0;
 }
 
-void deallocateData(void* ptr,uint32_t size, uint32_t alignment)
-{
-    if (!ptr)
-        return;
-    free(ptr);
-}
-
-void* allocateData(uint32_t size, uint32_t alignment)
-{
-    void* ret = NULL;
-    posix_memalign(&ret, alignment, size);
-    return ret;
-}
+const xLinkTransport_t usbLinkTransport = {
+    "usb",
+    UsbLinkPlatformInit,
+    UsbLinkPlatformConnect,
+    USBLinkWrite,
+    USBLinkWriteSegments,
+    USBLinkRead,
+    UsbLinkPlatformGetDeviceName,
+    UsbLinkPlatformBootRemote,
+    USBLinkPlatformResetRemote,
+    NULL, // the device drops off the bus when it resets
+};
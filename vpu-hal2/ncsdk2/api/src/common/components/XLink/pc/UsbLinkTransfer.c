@@ -0,0 +1,237 @@
+/*
+* Copyright 2017 Intel Corporation.
+* The source code, information and material ("Material") contained herein is
+* owned by Intel Corporation or its suppliers or licensors, and title to such
+* Material remains with Intel Corporation or its suppliers or licensors.
+* The Material contains proprietary information of Intel or its suppliers and
+* licensors. The Material is protected by worldwide copyright laws and treaty
+* provisions.
+* No part of the Material may be used, copied, reproduced, modified, published,
+* uploaded, posted, transmitted, distributed or disclosed in any way without
+* Intel's prior express written permission. No license under any patent,
+* copyright or other intellectual property rights in the Material is granted to
+* or conferred upon you, either expressly, by implication, inducement, estoppel
+* or otherwise.
+* Any license under such intellectual property rights must be express and
+* approved by Intel in writing.
+*/
+
+///
+/// @brief     Bulk writes with several libusb transfers in flight
+///
+#include <stdlib.h>
+#include <string.h>
+
+#include "UsbLinkTransfer.h"
+
+#define DEFAULT_CHUNK_SIZE  (1024 * 1024)
+#define DEFAULT_QUEUE_DEPTH 4
+#define MAX_QUEUE_DEPTH     32
+
+typedef struct {
+    struct libusb_transfer* transfer;
+    int busy;
+    int done;                 // set by the libusb callback
+    int* completed;           // any transfer of the call completed
+    uint8_t bounce[USB_LINK_MAX_PACKET_SIZE];
+} transferSlot_t;
+
+// next byte to submit
+typedef struct {
+    const streamSegmentDesc_t* segments;
+    int count;
+    int segment;
+    uint32_t offset;
+    uint32_t left;
+} segmentCursor_t;
+
+static int envValue(const char* name, int defaultValue)
+{
+    const char* env = getenv(name);
+    int value = env ? atoi(env) : 0;
+    return value > 0 ? value : defaultValue;
+}
+
+void usbLinkTransferDefaultConfig(usbLinkTransferConfig_t* config)
+{
+    config->chunkSize = envValue("XLINK_USB_CHUNK_SIZE", DEFAULT_CHUNK_SIZE);
+    config->queueDepth = envValue("XLINK_USB_QUEUE_DEPTH", DEFAULT_QUEUE_DEPTH);
+}
+
+static void LIBUSB_CALL transferDone(struct libusb_transfer* transfer)
+{
+    transferSlot_t* slot = (transferSlot_t*) transfer->user_data;
+    __atomic_store_n(&slot->done, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(slot->completed, 1, __ATOMIC_RELEASE);
+}
+
+static void skipEmptySegments(segmentCursor_t* cursor)
+{
+    while (cursor->segment < cursor->count &&
+           cursor->offset == cursor->segments[cursor->segment].length) {
+        cursor->segment++;
+        cursor->offset = 0;
+    }
+}
+
+static void advance(segmentCursor_t* cursor, uint32_t length, uint8_t* copyTo)
+{
+    cursor->left -= length;
+    while (length > 0) {
+        const streamSegmentDesc_t* segment = &cursor->segments[cursor->segment];
+        uint32_t n = segment->length - cursor->offset;
+        if (n > length)
+            n = length;
+        if (copyTo) {
+            memcpy(copyTo, segment->data + cursor->offset, n);
+            copyTo += n;
+        }
+        cursor->offset += n;
+        length -= n;
+        skipEmptySegments(cursor);
+    }
+}
+
+static int submitNext(libusb_device_handle* handle, unsigned char endpoint,
+                      transferSlot_t* slot, segmentCursor_t* cursor,
+                      uint32_t chunk, unsigned int timeout)
+{
+    const streamSegmentDesc_t* segment = &cursor->segments[cursor->segment];
+    uint32_t inSegment = segment->length - cursor->offset;
+    uint8_t* buffer;
+    uint32_t length;
+
+    if (inSegment >= USB_LINK_MAX_PACKET_SIZE || inSegment == cursor->left) {
+        // in place, whole packets unless it is the end of the data
+        buffer = (uint8_t*) segment->data + cursor->offset;
+        length = inSegment < chunk ? inSegment : chunk;
+        if (length < cursor->left)
+            length -= length % USB_LINK_MAX_PACKET_SIZE;
+        advance(cursor, length, NULL);
+    } else {
+        // the segment ends within a packet, gather the packet
+        buffer = slot->bounce;
+        length = cursor->left < USB_LINK_MAX_PACKET_SIZE ?
+                 cursor->left : USB_LINK_MAX_PACKET_SIZE;
+        advance(cursor, length, slot->bounce);
+    }
+
+    if (slot->transfer == NULL) {
+        slot->transfer = libusb_alloc_transfer(0);
+        if (slot->transfer == NULL)
+            return LIBUSB_ERROR_NO_MEM;
+    }
+    libusb_fill_bulk_transfer(slot->transfer, handle, endpoint, buffer, (int) length,
+                              transferDone, slot, timeout);
+    slot->done = 0;
+    int rc = libusb_submit_transfer(slot->transfer);
+    if (rc == 0)
+        slot->busy = 1;
+    return rc;
+}
+
+static int transferStatus(const struct libusb_transfer* transfer)
+{
+    switch (transfer->status) {
+    case LIBUSB_TRANSFER_COMPLETED:
+        return transfer->actual_length == transfer->length ? 0 : LIBUSB_ERROR_IO;
+    case LIBUSB_TRANSFER_TIMED_OUT:
+        return LIBUSB_ERROR_TIMEOUT;
+    case LIBUSB_TRANSFER_STALL:
+        return LIBUSB_ERROR_PIPE;
+    case LIBUSB_TRANSFER_NO_DEVICE:
+        return LIBUSB_ERROR_NO_DEVICE;
+    case LIBUSB_TRANSFER_OVERFLOW:
+        return LIBUSB_ERROR_OVERFLOW;
+    case LIBUSB_TRANSFER_CANCELLED:
+        return LIBUSB_ERROR_INTERRUPTED;
+    default:
+        return LIBUSB_ERROR_IO;
+    }
+}
+
+int usbLinkBulkWrite(libusb_device_handle* handle, unsigned char endpoint,
+                     const streamSegmentDesc_t* segments, int count,
+                     unsigned int timeout, const usbLinkTransferConfig_t* config)
+{
+    usbLinkTransferConfig_t defaults;
+    segmentCursor_t cursor;
+    transferSlot_t* slots;
+    int completed = 0;
+    int inFlight = 0;
+    int rc = 0;
+    int i;
+
+    if (config == NULL) {
+        usbLinkTransferDefaultConfig(&defaults);
+        config = &defaults;
+    }
+    uint32_t chunk = config->chunkSize - config->chunkSize % USB_LINK_MAX_PACKET_SIZE;
+    if ((int) chunk < USB_LINK_MAX_PACKET_SIZE)
+        chunk = USB_LINK_MAX_PACKET_SIZE;
+    int depth = config->queueDepth;
+    if (depth < 1)
+        depth = 1;
+    if (depth > MAX_QUEUE_DEPTH)
+        depth = MAX_QUEUE_DEPTH;
+
+    cursor.segments = segments;
+    cursor.count = count;
+    cursor.segment = 0;
+    cursor.offset = 0;
+    cursor.left = 0;
+    for (i = 0; i < count; i++)
+        cursor.left += segments[i].length;
+    skipEmptySegments(&cursor);
+    if (cursor.left == 0)
+        return 0;
+
+    slots = (transferSlot_t*) calloc(depth, sizeof(transferSlot_t));
+    if (slots == NULL)
+        return LIBUSB_ERROR_NO_MEM;
+    for (i = 0; i < depth; i++)
+        slots[i].completed = &completed;
+
+    while ((cursor.left > 0 && rc == 0) || inFlight > 0) {
+        for (i = 0; i < depth && cursor.left > 0 && rc == 0; i++) {
+            if (slots[i].busy)
+                continue;
+            rc = submitNext(handle, endpoint, &slots[i], &cursor, chunk, timeout);
+            if (rc == 0)
+                inFlight++;
+        }
+        if (inFlight == 0)
+            break;
+
+        // reap at least one transfer, another thread may handle the events
+        int reaped = 0;
+        while (!reaped) {
+            __atomic_store_n(&completed, 0, __ATOMIC_RELEASE);
+            for (i = 0; i < depth; i++) {
+                if (!slots[i].busy || !__atomic_load_n(&slots[i].done, __ATOMIC_ACQUIRE))
+                    continue;
+                slots[i].busy = 0;
+                inFlight--;
+                reaped++;
+                int status = transferStatus(slots[i].transfer);
+                if (status != 0 && rc == 0) {
+                    rc = status;
+                    int j;
+                    for (j = 0; j < depth; j++)
+                        if (slots[j].busy)
+                            libusb_cancel_transfer(slots[j].transfer);
+                }
+            }
+            if (!reaped)
+                libusb_handle_events_completed(NULL, &completed);
+        }
+    }
+
+    for (i = 0; i < depth; i++)
+        if (slots[i].transfer)
+            libusb_free_transfer(slots[i].transfer);
+    free(slots);
+    return rc;
+}
+
+/* end of file */
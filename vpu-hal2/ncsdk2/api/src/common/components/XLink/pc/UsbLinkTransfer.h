@@ -0,0 +1,58 @@
+/*
+* Copyright 2017 Intel Corporation.
+* The source code, information and material ("Material") contained herein is
+* owned by Intel Corporation or its suppliers or licensors, and title to such
+* Material remains with Intel Corporation or its suppliers or licensors.
+* The Material contains proprietary information of Intel or its suppliers and
+* licensors. The Material is protected by worldwide copyright laws and treaty
+* provisions.
+* No part of the Material may be used, copied, reproduced, modified, published,
+* uploaded, posted, transmitted, distributed or disclosed in any way without
+* Intel's prior express written permission. No license under any patent,
+* copyright or other intellectual property rights in the Material is granted to
+* or conferred upon you, either expressly, by implication, inducement, estoppel
+* or otherwise.
+* Any license under such intellectual property rights must be express and
+* approved by Intel in writing.
+*/
+
+///
+/// @brief     Bulk writes with several libusb transfers in flight
+///
+#ifndef _USB_LINK_TRANSFER_H
+#define _USB_LINK_TRANSFER_H
+#include <libusb.h>
+#include "XLinkPublicDefines.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Every transfer but the last one of a call is a multiple of this, so the
+// device never sees a short packet in the middle of a write
+#define USB_LINK_MAX_PACKET_SIZE 1024
+
+typedef struct {
+    int chunkSize;   // bytes per libusb transfer, rounded down to the packet size
+    int queueDepth;  // libusb transfers kept in flight
+} usbLinkTransferConfig_t;
+
+// 1 MiB transfers, 4 in flight. XLINK_USB_CHUNK_SIZE and
+// XLINK_USB_QUEUE_DEPTH override them
+void usbLinkTransferDefaultConfig(usbLinkTransferConfig_t* config);
+
+// Writes the segments, in order, as one bulk stream to an OUT endpoint.
+// Segment boundaries that don't fall on a packet go through a small bounce
+// buffer, everything else is sent in place. NULL config for the defaults.
+// Returns 0 or a negative libusb error
+int usbLinkBulkWrite(libusb_device_handle* handle, unsigned char endpoint,
+                     const streamSegmentDesc_t* segments, int count,
+                     unsigned int timeout, const usbLinkTransferConfig_t* config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/* end of include file */
@@ -0,0 +1,295 @@
+/*
+* Copyright 2017 Intel Corporation.
+* The source code, information and material ("Material") contained herein is
+* owned by Intel Corporation or its suppliers or licensors, and title to such
+* Material remains with Intel Corporation or its suppliers or licensors.
+* The Material contains proprietary information of Intel or its suppliers and
+* licensors. The Material is protected by worldwide copyright laws and treaty
+* provisions.
+* No part of the Material may be used, copied, reproduced, modified, published,
+* uploaded, posted, transmitted, distributed or disclosed in any way without
+* Intel's prior express written permission. No license under any patent,
+* copyright or other intellectual property rights in the Material is granted to
+* or conferred upon you, either expressly, by implication, inducement, estoppel
+* or otherwise.
+* Any license under such intellectual property rights must be express and
+* approved by Intel in writing.
+*/
+
+///
+/// @brief     Loopback and UNIX domain socket transports, for running XLink
+///            against an emulated device
+///
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "XLinkTransport.h"
+
+#define MVLOG_UNIT_NAME xLink
+#include "mvLog.h"
+
+#define DEFAULT_SOCKET_PATH "/tmp/xlink_emulator.sock"
+#define EMULATED_PRODUCT    "-ma2450"
+
+typedef struct {
+    int sock;
+} fdLink_t;
+
+static xLinkLoopbackPeer_t loopbackPeer;
+static void* loopbackPeerCtx;
+
+// Largest chunk handed to the socket at once, XLINK_PACKET_LENGTH overrides
+// PACKET_LENGTH to see what the transfer size does to the throughput
+static int packetLength(void)
+{
+    static int length;
+    if (!length) {
+        const char* env = getenv("XLINK_PACKET_LENGTH");
+        int value = env ? atoi(env) : 0;
+        length = value > 0 ? value : PACKET_LENGTH;
+    }
+    return length;
+}
+
+static void* fdLinkCreate(int sock)
+{
+    fdLink_t* link = malloc(sizeof(fdLink_t));
+    if (!link) {
+        close(sock);
+        return NULL;
+    }
+    link->sock = sock;
+    return link;
+}
+
+// timeouts are not enforced, a dead peer closes the socket instead
+static int fdLinkWrite(void* fd, void* data, int size, unsigned int timeout)
+{
+    fdLink_t* link = (fdLink_t*) fd;
+    const char* p = (const char*) data;
+    int chunk = packetLength();
+    while (size > 0) {
+        int toWrite = size > chunk ? chunk : size;
+        ssize_t wc = send(link->sock, p, toWrite, MSG_NOSIGNAL);
+        if (wc < 0) {
+            if (errno == EINTR)
+                continue;
+            return -2;
+        }
+        p += wc;
+        size -= wc;
+    }
+    return 0;
+}
+
+static int fdLinkRead(void* fd, void* data, int size, unsigned int timeout)
+{
+    fdLink_t* link = (fdLink_t*) fd;
+    char* p = (char*) data;
+    int chunk = packetLength();
+    while (size > 0) {
+        int toRead = size > chunk ? chunk : size;
+        ssize_t rc = recv(link->sock, p, toRead, 0);
+        if (rc < 0 && errno == EINTR)
+            continue;
+        if (rc <= 0)
+            return -2;
+        p += rc;
+        size -= rc;
+    }
+    return 0;
+}
+
+static int fdLinkInit(int loglevel)
+{
+    return 0;
+}
+
+static int fdLinkBootRemote(const char* deviceName, const char* binaryPath)
+{
+    // the emulator is running already, there is no firmware to load
+    return 0;
+}
+
+static int fdLinkResetRemote(void* fd)
+{
+    fdLink_t* link = (fdLink_t*) fd;
+    if (link) {
+        close(link->sock);
+        free(link);
+    }
+    return 0;
+}
+
+static int fdLinkDisconnect(void* fd)
+{
+    fdLink_t* link = (fdLink_t*) fd;
+    shutdown(link->sock, SHUT_RDWR);
+    return 0;
+}
+
+static int deviceIndex(const char* name, const char* prefix)
+{
+    size_t len = strlen(prefix);
+    if (!name || strncmp(name, prefix, len) != 0)
+        return -1;
+    return atoi(name + len);
+}
+
+/*################################# loopback ####################################*/
+
+void xLinkLoopbackSetPeer(xLinkLoopbackPeer_t peer, void* ctx)
+{
+    loopbackPeer = peer;
+    loopbackPeerCtx = ctx;
+}
+
+static int loopbackDevices(void)
+{
+    const char* env = getenv("XLINK_LOOPBACK_DEVICES");
+    int count = env ? atoi(env) : 1;
+    return count > 0 ? count : 1;
+}
+
+static int loopbackGetDeviceName(int index, char* name, int nameSize)
+{
+    if (!loopbackPeer || index >= loopbackDevices())
+        return USB_LINK_PLATFORM_DEVICE_NOT_FOUND;
+    snprintf(name, nameSize, "loopback%d" EMULATED_PRODUCT, index);
+    return USB_LINK_PLATFORM_SUCCESS;
+}
+
+static int loopbackConnect(const char* devPathRead, const char* devPathWrite, void** fd)
+{
+    int sv[2];
+    if (!loopbackPeer || deviceIndex(devPathWrite, "loopback") < 0)
+        return -1;
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv))
+        return -1;
+    void* host = fdLinkCreate(sv[0]);
+    void* device = fdLinkCreate(sv[1]);
+    if (!host || !device) {
+        fdLinkResetRemote(host);
+        fdLinkResetRemote(device);
+        return -1;
+    }
+    loopbackPeer(device, loopbackPeerCtx);
+    *fd = host;
+    return 0;
+}
+
+const xLinkTransport_t loopbackLinkTransport = {
+    .name = "loopback",
+    .init = fdLinkInit,
+    .connect = loopbackConnect,
+    .write = fdLinkWrite,
+    .read = fdLinkRead,
+    .getDeviceName = loopbackGetDeviceName,
+    .bootRemote = fdLinkBootRemote,
+    .resetRemote = fdLinkResetRemote,
+    .disconnect = fdLinkDisconnect,
+};
+
+/*################################## socket #####################################*/
+
+// XLINK_SOCKET_PATH is a ':' separated list, one emulated device per socket
+static int socketPath(int index, char* path, int pathSize)
+{
+    const char* list = getenv("XLINK_SOCKET_PATH");
+    if (!list || !*list)
+        list = DEFAULT_SOCKET_PATH;
+    while (index-- > 0) {
+        list = strchr(list, ':');
+        if (!list)
+            return -1;
+        list++;
+    }
+    const char* end = strchr(list, ':');
+    int len = end ? (int)(end - list) : (int)strlen(list);
+    if (len == 0 || len >= pathSize)
+        return -1;
+    memcpy(path, list, len);
+    path[len] = '\0';
+    return 0;
+}
+
+static int socketGetDeviceName(int index, char* name, int nameSize)
+{
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    if (socketPath(index, path, sizeof(path)) || access(path, F_OK))
+        return USB_LINK_PLATFORM_DEVICE_NOT_FOUND;
+    snprintf(name, nameSize, "socket%d" EMULATED_PRODUCT, index);
+    return USB_LINK_PLATFORM_SUCCESS;
+}
+
+static int socketConnect(const char* devPathRead, const char* devPathWrite, void** fd)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    int index = deviceIndex(devPathWrite, "socket");
+    if (index < 0 || socketPath(index, addr.sun_path, sizeof(addr.sun_path)))
+        return -1;
+
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0)
+        return -1;
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr))) {
+        mvLog(MVLOG_WARN, "can't connect to %s: %s\n", addr.sun_path, strerror(errno));
+        close(sock);
+        return -1;
+    }
+    *fd = fdLinkCreate(sock);
+    return *fd ? 0 : -1;
+}
+
+int xLinkSocketListen(const char* path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+    strcpy(addr.sun_path, path);
+
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0)
+        return -1;
+    unlink(path);
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) || listen(sock, 4)) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+void* xLinkSocketAccept(int listenSock)
+{
+    int sock;
+    do {
+        sock = accept(listenSock, NULL, NULL);
+    } while (sock < 0 && errno == EINTR);
+    if (sock < 0)
+        return NULL;
+    return fdLinkCreate(sock);
+}
+
+const xLinkTransport_t socketLinkTransport = {
+    .name = "socket",
+    .init = fdLinkInit,
+    .connect = socketConnect,
+    .write = fdLinkWrite,
+    .read = fdLinkRead,
+    .getDeviceName = socketGetDeviceName,
+    .bootRemote = fdLinkBootRemote,
+    .resetRemote = fdLinkResetRemote,
+    .disconnect = fdLinkDisconnect,
+};
+
+/* end of file */
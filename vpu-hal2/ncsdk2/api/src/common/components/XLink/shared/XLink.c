@@ -38,6 +38,7 @@
 #include "mvMacros.h"
 #include "UsbLinkPlatform.h"
 #include "XLinkDispatcher.h"
+#include "XLinkTransport.h"
 #define _USBLINK_ENABLE_PRIVATE_INCLUDE_
 #include "XLinkPrivateDefines.h"
 #define MVLOG_UNIT_NAME xLink
@@ -77,6 +78,8 @@ void releaseStream(streamDesc_t*);
 int addNewPacketToStream(streamDesc_t* stream, void* buffer, uint32_t size);
 
 struct dispatcherControlFunctions controlFunctionTbl;
+static const xLinkTransport_t* transport; //selected at XLinkInitialize
+static const xLinkTransport_t* requestedTransport;
 XLinkGlobalHandler_t* glHandler; //TODO EMAN need to either protect this with semaphor
                                  //or make profiling data per device
 linkId_t nextUniqueLinkId = 0; //incremental number, doesn't get decremented.
@@ -133,7 +136,7 @@ int handleIncomingEvent(xLinkEvent_t* event){
             mvLog(MVLOG_FATAL,"out of memory\n");
             ASSERT_X_LINK(0);
         }
-        int sc = USBLinkRead(event->xLinkFD, buffer, event->header.size, USB_DATA_TIMEOUT);
+        int sc = transport->read(event->xLinkFD, buffer, event->header.size, USB_DATA_TIMEOUT);
         if(sc < 0){
             mvLog(MVLOG_ERROR,"%s() Read failed %d\n", __func__, (int)sc);
         }
@@ -178,12 +181,12 @@ int handleIncomingEvent(xLinkEvent_t* event){
         ASSERT_X_LINK(0);
     }
     //adding event for the scheduler. We let it know that this is a remote event
-    dispatcherAddEvent(EVENT_REMOTE, event);
+    dispatcherAddEvent(event);
     return 0;
 }
  int dispatcherEventReceive(xLinkEvent_t* event){
     static xLinkEvent_t prevEvent;
-    int sc = USBLinkRead(event->xLinkFD, &event->header, sizeof(event->header), 0);
+    int sc = transport->read(event->xLinkFD, &event->header, sizeof(event->header), 0);
 
     if(sc < 0 && event->header.type == USB_RESET_RESP) {
         return sc;
@@ -703,17 +706,35 @@ int dispatcherRemoteEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response
         case USB_PING_RESP:
             break;
         case USB_RESET_RESP:
+            //wake the reader, the scheduler frees the fd once it's joined
+            if (transport->disconnect)
+                transport->disconnect(event->xLinkFD);
             break;
         default:
             ASSERT_X_LINK(0);
     }
     return 0;
 }
+static int writeSegments(void* fd, const streamSegmentDesc_t* segments, int count,
+                         unsigned int timeout)
+{
+    int i;
+    if (transport->writeSegments)
+        return transport->writeSegments(fd, segments, count, timeout);
+    for (i = 0; i < count; i++)
+    {
+        int rc = transport->write(fd, (void*)segments[i].data, segments[i].length, timeout);
+        if (rc < 0)
+            return rc;
+    }
+    return 0;
+}
+
 //adds a new event with parameters and returns event id
 int dispatcherEventSend(xLinkEvent_t *event)
 {
     mvLog(MVLOG_DEBUG,"sending %d %d\n", (int)event->header.type,  (int)event->header.id);
-    int rc = USBLinkWrite(event->xLinkFD, &event->header, sizeof(event->header), 0);
+    int rc = transport->write(event->xLinkFD, &event->header, sizeof(event->header), 0);
     if(rc < 0)
     {
         mvLog(MVLOG_ERROR,"Write failed %d\n", rc);
@@ -721,8 +742,12 @@ int dispatcherEventSend(xLinkEvent_t *event)
     if (event->header.type == USB_WRITE_REQ)
     {
         //write requested data
-        rc = USBLinkWrite(event->xLinkFD, event->data,
-                          event->header.size, USB_DATA_TIMEOUT);
+        if (event->segments)
+            rc = writeSegments(event->xLinkFD, (const streamSegmentDesc_t*) event->data,
+                               event->segments, USB_DATA_TIMEOUT);
+        else
+            rc = transport->write(event->xLinkFD, event->data,
+                              event->header.size, USB_DATA_TIMEOUT);
         if(rc < 0) {
             mvLog(MVLOG_ERROR,"Write failed %d\n", rc);
         }
@@ -754,7 +779,7 @@ void dispatcherCloseUsbLink(void*fd)
 
 void dispatcherResetDevice(void* fd)
 {
-    USBLinkPlatformResetRemote(fd);//TODO EMAN
+    transport->resetRemote(fd);//TODO EMAN
 }
 
 
@@ -764,30 +789,66 @@ void dispatcherResetDevice(void* fd)
 //Called only from app - per device
 XLinkError_t XLinkConnect(XLinkHandler_t* handler)
 {
-    int index = getNextAvailableLinkIndex();
-    ASSERT_X_LINK(index != -1);
-
-    xLinkDesc_t* link = &availableXLinks[index];
+    void* fd = NULL;
     mvLog(MVLOG_DEBUG,"%s() device name %s \n", __func__, handler->devicePath);
 
-    if (UsbLinkPlatformConnect(handler->devicePath2, handler->devicePath, &link->fd) == -1)
+    //connect before taking a link, a loopback peer takes one while connecting
+    if (transport->connect(handler->devicePath2, handler->devicePath, &fd) != 0)
     {
         return X_LINK_ERROR;
     }
+    int index = getNextAvailableLinkIndex();
+    ASSERT_X_LINK(index != -1);
 
-    dispatcherStart(link->fd);
+    xLinkDesc_t* link = &availableXLinks[index];
+    link->fd = fd;
+    //registered before the dispatcher runs, a reset from the remote releases
+    //the link and must not be undone here
+    link->id = nextUniqueLinkId++;
+    link->peerState = USB_LINK_UP;
+    handler->linkId = link->id;
+
+    dispatcherStart(fd);
 
     xLinkEvent_t event = {0};
     event.header.type = USB_PING_REQ;
-    event.xLinkFD = link->fd;
-    dispatcherAddEvent(EVENT_LOCAL, &event);
-    dispatcherWaitEventComplete(link->fd);
+    event.xLinkFD = fd;
+    dispatcherServeEvent(&event);
+
+    return 0;
+}
 
+XLinkError_t XLinkAccept(void* fd, linkId_t* linkId)
+{
+    int index = getNextAvailableLinkIndex();
+    if (index == -1)
+    {
+        return X_LINK_ERROR;
+    }
+    xLinkDesc_t* link = &availableXLinks[index];
+    link->fd = fd;
     link->id = nextUniqueLinkId++;
     link->peerState = USB_LINK_UP;
-    handler->linkId = link->id;
 
-    return 0;
+    if (dispatcherStart(link->fd))
+    {
+        link->id = INVALID_LINK_ID;
+        link->fd = NULL;
+        return X_LINK_ERROR;
+    }
+    *linkId = link->id;
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkSetTransport(const char* name)
+{
+    const xLinkTransport_t* t = xLinkTransportByName(name);
+    if (t == NULL)
+    {
+        return X_LINK_ERROR;
+    }
+    requestedTransport = t;
+    return X_LINK_SUCCESS;
 }
 
 XLinkError_t XLinkInitialize(XLinkGlobalHandler_t* handler)
@@ -796,7 +857,9 @@ XLinkError_t XLinkInitialize(XLinkGlobalHandler_t* handler)
     glHandler = handler;
     sem_init(&pingSem,0,0);
     int i;
-    int sc = UsbLinkPlatformInit(handler->loglevel);
+    transport = requestedTransport ? requestedTransport : xLinkDefaultTransport();
+    mvLog(MVLOG_DEBUG,"%s() transport %s\n", __func__, transport->name);
+    int sc = transport->init(handler->loglevel);
     if (sc)
     {
        return X_LINK_COMMUNICATION_NOT_OPEN;
@@ -845,8 +908,7 @@ XLinkError_t XLinkGetFillLevel(streamId_t streamId, int isRemote, int* fillLevel
     xLinkDesc_t* link = getLinkById(id);
     streamDesc_t* stream;
 
-    ASSERT_X_LINK(link != NULL);
-    if (getXLinkState(link) != USB_LINK_UP)
+    if (link == NULL || getXLinkState(link) != USB_LINK_UP)
     {
         return X_LINK_COMMUNICATION_NOT_OPEN;
     }
@@ -866,8 +928,7 @@ streamId_t XLinkOpenStream(linkId_t id, const char* name, int stream_write_size)
     xLinkEvent_t event = {0};
     xLinkDesc_t* link = getLinkById(id);
     mvLog(MVLOG_DEBUG,"%s() id %d link %p\n", __func__, id, link);
-    ASSERT_X_LINK(link != NULL);
-    if (getXLinkState(link) != USB_LINK_UP)
+    if (link == NULL || getXLinkState(link) != USB_LINK_UP)
     {
         /*no link*/
         mvLog(MVLOG_DEBUG,"%s() no link up\n", __func__);
@@ -889,11 +950,14 @@ streamId_t XLinkOpenStream(linkId_t id, const char* name, int stream_write_size)
         event.header.streamId = INVALID_STREAM_ID;
         event.xLinkFD = link->fd;
 
-        dispatcherAddEvent(EVENT_LOCAL, &event);
-        dispatcherWaitEventComplete(link->fd);
+        dispatcherServeEvent(&event);
 
     }
     streamId_t streamId = getStreamIdByName(link, name);
+    if (streamId == INVALID_STREAM_ID) {
+        //a lookup of a stream the remote didn't create yet
+        return INVALID_STREAM_ID;
+    }
     if (streamId > 0xFFFFFFF) {
         mvLog(MVLOG_ERROR,"Max streamId reached!");
         return INVALID_STREAM_ID;
@@ -911,20 +975,18 @@ XLinkError_t XLinkCloseStream(streamId_t streamId)
     linkId_t id;
     EXTRACT_IDS(streamId,id);
     xLinkDesc_t* link = getLinkById(id);
-    ASSERT_X_LINK(link != NULL);
 
     mvLog(MVLOG_DEBUG,"%s(): streamId %d\n", __func__, (int)streamId);
-    if (getXLinkState(link) != USB_LINK_UP)
+    if (link == NULL || getXLinkState(link) != USB_LINK_UP)
         return X_LINK_COMMUNICATION_NOT_OPEN;
 
     xLinkEvent_t event = {0};
     event.header.type = USB_CLOSE_STREAM_REQ;
     event.header.streamId = streamId;
     event.xLinkFD = link->fd;
-    xLinkEvent_t* ev = dispatcherAddEvent(EVENT_LOCAL, &event);
-    dispatcherWaitEventComplete(link->fd);
+    dispatcherServeEvent(&event);
 
-    if (ev->header.flags.bitField.ack == 1)
+    if (event.header.flags.bitField.ack == 1)
         return X_LINK_SUCCESS;
     else
         return X_LINK_COMMUNICATION_FAIL;
@@ -936,8 +998,7 @@ XLinkError_t XLinkCloseStream(streamId_t streamId)
 XLinkError_t XLinkGetAvailableStreams(linkId_t id)
 {
     xLinkDesc_t* link = getLinkById(id);
-    ASSERT_X_LINK(link != NULL);
-    if (getXLinkState(link) != USB_LINK_UP)
+    if (link == NULL || getXLinkState(link) != USB_LINK_UP)
     {
         return X_LINK_COMMUNICATION_NOT_OPEN;
     }
@@ -947,7 +1008,7 @@ XLinkError_t XLinkGetAvailableStreams(linkId_t id)
 
 XLinkError_t XLinkGetDeviceName(int index, char* name, int nameSize)
 {
-    int rc = UsbLinkPlatformGetDeviceName(index, name, nameSize);
+    int rc = transport->getDeviceName(index, name, nameSize);
     switch(rc) {
         case USB_LINK_PLATFORM_SUCCESS:
             return X_LINK_SUCCESS;
@@ -961,14 +1022,12 @@ XLinkError_t XLinkGetDeviceName(int index, char* name, int nameSize)
     }
 }
 
-XLinkError_t XLinkWriteData(streamId_t streamId, const uint8_t* buffer,
-                            int size)
+static XLinkError_t writeData(streamId_t streamId, void* data, int size, int segments)
 {
     linkId_t id;
     EXTRACT_IDS(streamId,id);
     xLinkDesc_t* link = getLinkById(id);
-    ASSERT_X_LINK(link != NULL);
-    if (getXLinkState(link) != USB_LINK_UP)
+    if (link == NULL || getXLinkState(link) != USB_LINK_UP)
     {
         return X_LINK_COMMUNICATION_NOT_OPEN;
     }
@@ -980,14 +1039,14 @@ XLinkError_t XLinkWriteData(streamId_t streamId, const uint8_t* buffer,
     event.header.size = size;
     event.header.streamId = streamId;
     event.xLinkFD = link->fd;
-    event.data = (void*)buffer;
+    event.data = data;
+    event.segments = segments;
 
-    xLinkEvent_t* ev = dispatcherAddEvent(EVENT_LOCAL, &event);
-    dispatcherWaitEventComplete(link->fd);
+    dispatcherServeEvent(&event);
     clock_gettime(CLOCK_REALTIME, &end);
 
 
-    if (ev->header.flags.bitField.ack == 1)
+    if (event.header.flags.bitField.ack == 1)
     {
          //profile only on success
         if( glHandler->profEnable)
@@ -1001,22 +1060,161 @@ XLinkError_t XLinkWriteData(streamId_t streamId, const uint8_t* buffer,
         return X_LINK_COMMUNICATION_FAIL;
 }
 
-XLinkError_t XLinkAsyncWriteData()
+XLinkError_t XLinkWriteData(streamId_t streamId, const uint8_t* buffer,
+                            int size)
 {
-    if (getXLinkState(NULL) != USB_LINK_UP)
+    return writeData(streamId, (void*)buffer, size, 0);
+}
+
+XLinkError_t XLinkWriteDataSegments(streamId_t streamId, const streamSegmentDesc_t* segments,
+                                    int count)
+{
+    int i;
+    int size = 0;
+    if (segments == NULL || count <= 0)
+    {
+        return X_LINK_ERROR;
+    }
+    for (i = 0; i < count; i++)
+    {
+        size += segments[i].length;
+    }
+    return writeData(streamId, (void*)segments, size, count);
+}
+
+//state of an asynchronous request, lives until its callback returns
+typedef struct xLinkAsyncRequest_t {
+    XLinkCompletionCallback_t callback;
+    void* userContext;
+    streamId_t streamId;
+    streamPacketDesc_t* packet;
+    int size;
+    struct timespec start;
+} xLinkAsyncRequest_t;
+
+static void asyncEventComplete(xLinkEvent_t* event, void* ctx)
+{
+    xLinkAsyncRequest_t* req = (xLinkAsyncRequest_t*) ctx;
+    XLinkError_t status = X_LINK_COMMUNICATION_FAIL;
+    int isRead = event->header.type == USB_READ_REQ;
+    struct timespec end;
+    clock_gettime(CLOCK_REALTIME, &end);
+
+    if (event->header.flags.bitField.ack == 1)
+    {
+        status = X_LINK_SUCCESS;
+        if (glHandler->profEnable)
+        {
+            if (isRead)
+            {
+                glHandler->profilingData.totalReadBytes += req->packet->length;
+                glHandler->profilingData.totalReadTime += timespec_diff(&req->start, &end);
+            }
+            else
+            {
+                glHandler->profilingData.totalWriteBytes += req->size;
+                glHandler->profilingData.totalWriteTime += timespec_diff(&req->start, &end);
+            }
+        }
+    }
+    req->callback(req->streamId, status,
+                  (isRead && status == X_LINK_SUCCESS) ? req->packet : NULL,
+                  req->userContext);
+    free(req);
+}
+
+static XLinkError_t addAsyncRequest(streamId_t streamId, xLinkEventType_t type,
+                                    const uint8_t* buffer, int size,
+                                    const streamSegmentDesc_t* segments, int count,
+                                    XLinkCompletionCallback_t callback, void* userContext)
+{
+    streamId_t fullId = streamId;
+    linkId_t id;
+    EXTRACT_IDS(streamId,id);
+    xLinkDesc_t* link = getLinkById(id);
+    if (link == NULL || getXLinkState(link) != USB_LINK_UP)
     {
         return X_LINK_COMMUNICATION_NOT_OPEN;
     }
+    if (callback == NULL)
+    {
+        return X_LINK_ERROR;
+    }
+    //the segment descriptors of a gathered write live right after the request
+    xLinkAsyncRequest_t* req = malloc(sizeof(xLinkAsyncRequest_t) +
+                                      count * sizeof(streamSegmentDesc_t));
+    if (req == NULL)
+    {
+        return X_LINK_ERROR;
+    }
+    req->callback = callback;
+    req->userContext = userContext;
+    req->streamId = fullId;
+    req->packet = NULL;
+    req->size = size;
+    clock_gettime(CLOCK_REALTIME, &req->start);
+
+    xLinkEvent_t event = {0};
+    event.header.type = type;
+    event.header.size = size;
+    event.header.streamId = streamId;
+    event.xLinkFD = link->fd;
+    if (type == USB_READ_REQ)
+        event.data = (void*)&req->packet;
+    else if (count)
+    {
+        streamSegmentDesc_t* copy = (streamSegmentDesc_t*)(req + 1);
+        memcpy(copy, segments, count * sizeof(streamSegmentDesc_t));
+        event.data = copy;
+        event.segments = count;
+    }
+    else
+        event.data = (void*)buffer;
+
+    if (dispatcherAddEventAsync(&event, asyncEventComplete, req))
+    {
+        free(req);
+        return X_LINK_COMMUNICATION_FAIL;
+    }
     return X_LINK_SUCCESS;
 }
 
+XLinkError_t XLinkAsyncWriteData(streamId_t streamId, const uint8_t* buffer, int size,
+                                 XLinkCompletionCallback_t callback, void* userContext)
+{
+    return addAsyncRequest(streamId, USB_WRITE_REQ, buffer, size, NULL, 0, callback, userContext);
+}
+
+XLinkError_t XLinkAsyncWriteDataSegments(streamId_t streamId, const streamSegmentDesc_t* segments,
+                                         int count, XLinkCompletionCallback_t callback,
+                                         void* userContext)
+{
+    int i;
+    int size = 0;
+    if (segments == NULL || count <= 0)
+    {
+        return X_LINK_ERROR;
+    }
+    for (i = 0; i < count; i++)
+    {
+        size += segments[i].length;
+    }
+    return addAsyncRequest(streamId, USB_WRITE_REQ, NULL, size, segments, count,
+                           callback, userContext);
+}
+
+XLinkError_t XLinkAsyncReadData(streamId_t streamId,
+                                XLinkCompletionCallback_t callback, void* userContext)
+{
+    return addAsyncRequest(streamId, USB_READ_REQ, NULL, 0, NULL, 0, callback, userContext);
+}
+
 XLinkError_t XLinkReadData(streamId_t streamId, streamPacketDesc_t** packet)
 {
     linkId_t id;
     EXTRACT_IDS(streamId,id);
     xLinkDesc_t* link = getLinkById(id);
-    ASSERT_X_LINK(link != NULL);
-    if (getXLinkState(link) != USB_LINK_UP)
+    if (link == NULL || getXLinkState(link) != USB_LINK_UP)
     {
         return X_LINK_COMMUNICATION_NOT_OPEN;
     }
@@ -1031,18 +1229,18 @@ XLinkError_t XLinkReadData(streamId_t streamId, streamPacketDesc_t** packet)
     event.data = (void*)packet;
 
     clock_gettime(CLOCK_REALTIME, &start);
-    xLinkEvent_t* ev = dispatcherAddEvent(EVENT_LOCAL, &event);
-    dispatcherWaitEventComplete(link->fd);
+    dispatcherServeEvent(&event);
     clock_gettime(CLOCK_REALTIME, &end);
 
-    if( glHandler->profEnable)
+    if (event.header.flags.bitField.ack == 1)
     {
-        glHandler->profilingData.totalReadBytes += (*packet)->length;
-        glHandler->profilingData.totalReadTime += timespec_diff(&start, &end);
-    }
-
-    if (ev->header.flags.bitField.ack == 1)
+        if( glHandler->profEnable)
+        {
+            glHandler->profilingData.totalReadBytes += (*packet)->length;
+            glHandler->profilingData.totalReadTime += timespec_diff(&start, &end);
+        }
         return X_LINK_SUCCESS;
+    }
     else
         return X_LINK_COMMUNICATION_FAIL;
 }
@@ -1052,8 +1250,7 @@ XLinkError_t XLinkReleaseData(streamId_t streamId)
     linkId_t id;
     EXTRACT_IDS(streamId,id);
     xLinkDesc_t* link = getLinkById(id);
-    ASSERT_X_LINK(link != NULL);
-    if (getXLinkState(link) != USB_LINK_UP)
+    if (link == NULL || getXLinkState(link) != USB_LINK_UP)
     {
         return X_LINK_COMMUNICATION_NOT_OPEN;
     }
@@ -1063,10 +1260,9 @@ XLinkError_t XLinkReleaseData(streamId_t streamId)
     event.header.streamId = streamId;
     event.xLinkFD = link->fd;
 
-    xLinkEvent_t* ev = dispatcherAddEvent(EVENT_LOCAL, &event);
-    dispatcherWaitEventComplete(link->fd);
+    dispatcherServeEvent(&event);
 
-    if (ev->header.flags.bitField.ack == 1)
+    if (event.header.flags.bitField.ack == 1)
         return X_LINK_SUCCESS;
     else
         return X_LINK_COMMUNICATION_FAIL;
@@ -1074,7 +1270,7 @@ XLinkError_t XLinkReleaseData(streamId_t streamId)
 
 XLinkError_t XLinkBootRemote(const char* deviceName, const char* binaryPath)
 {
-    if (UsbLinkPlatformBootRemote(deviceName, binaryPath) == 0)
+    if (transport->bootRemote(deviceName, binaryPath) == 0)
         return X_LINK_SUCCESS;
     else
         return X_LINK_COMMUNICATION_FAIL;
@@ -1083,18 +1279,23 @@ XLinkError_t XLinkBootRemote(const char* deviceName, const char* binaryPath)
 XLinkError_t XLinkResetRemote(linkId_t id)
 {
     xLinkDesc_t* link = getLinkById(id);
-    ASSERT_X_LINK(link != NULL);
+    if (link == NULL)
+    {
+        //the remote reset the link already
+        return X_LINK_COMMUNICATION_NOT_OPEN;
+    }
     if (getXLinkState(link) != USB_LINK_UP)
     {
-        USBLinkPlatformResetRemote(link->fd);
+        transport->resetRemote(link->fd);
         return X_LINK_COMMUNICATION_NOT_OPEN;
     }
     xLinkEvent_t event = {0};
     event.header.type = USB_RESET_REQ;
     event.xLinkFD = link->fd;
     mvLog(MVLOG_DEBUG,"sending reset remote event\n");
-    dispatcherAddEvent(EVENT_LOCAL, &event);
-    dispatcherWaitEventComplete(link->fd);
+    //the dispatcher owns the fd from here on, it disconnects and frees it
+    //when the response comes or the remote resets the link first
+    dispatcherServeEvent(&event);
 
     return X_LINK_SUCCESS;
 }
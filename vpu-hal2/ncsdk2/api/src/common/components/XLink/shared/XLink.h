@@ -38,6 +38,14 @@ XLinkError_t XLinkInitialize(XLinkGlobalHandler_t* handler);
 // Connects to specific device, starts dispatcher and pings remote
 XLinkError_t XLinkConnect(XLinkHandler_t* handler);
 
+// Selects the transport by name ("usb", "loopback", "socket"), call before
+// XLinkInitialize. XLINK_TRANSPORT or usb is used otherwise
+XLinkError_t XLinkSetTransport(const char* name);
+
+// Serves the remote end of a link created by the transport (emulated device).
+// Starts the dispatcher, the host side does the ping
+XLinkError_t XLinkAccept(void* fd, linkId_t* linkId);
+
 
 // Opens a stream in the remote that can be written to by the local
 // Allocates stream_write_size (aligned up to 64 bytes) for that stream
@@ -56,13 +64,33 @@ XLinkError_t XLinkGetDeviceName(int index, char* name, int nameSize);
 // Note that the actual size of the written data is ALIGN_UP(size, 64)
 XLinkError_t XLinkWriteData(streamId_t streamId, const uint8_t* buffer, int size);
 
-// Currently useless
-XLinkError_t XLinkAsyncWriteData();
+// Same as XLinkWriteData for the segments put one after the other, the
+// remote gets a single packet. Nothing is copied on the transports that can
+// send from several buffers
+XLinkError_t XLinkWriteDataSegments(streamId_t streamId, const streamSegmentDesc_t* segments,
+                                    int count);
+
+// Queue a write without waiting for the remote to accept it, callback is
+// called once it is done. buffer must stay valid until then.
+// Blocks only while too many asynchronous requests are pending on the link
+XLinkError_t XLinkAsyncWriteData(streamId_t streamId, const uint8_t* buffer, int size,
+                                 XLinkCompletionCallback_t callback, void* userContext);
+
+// XLinkWriteDataSegments queued the same way. The segment array is copied,
+// the data it points to must stay valid until the callback
+XLinkError_t XLinkAsyncWriteDataSegments(streamId_t streamId, const streamSegmentDesc_t* segments,
+                                         int count, XLinkCompletionCallback_t callback,
+                                         void* userContext);
 
 // Read data from local stream. Will only have something if it was written
 // to by the remote
 XLinkError_t XLinkReadData(streamId_t streamId, streamPacketDesc_t** packet);
 
+// Queue a read of the next packet of the stream, callback gets the packet.
+// XLinkReleaseData still has to be called, from outside of the callback
+XLinkError_t XLinkAsyncReadData(streamId_t streamId,
+                                XLinkCompletionCallback_t callback, void* userContext);
+
 // Release data from stream - This should be called after ReadData
 XLinkError_t XLinkReleaseData(streamId_t streamId);
 
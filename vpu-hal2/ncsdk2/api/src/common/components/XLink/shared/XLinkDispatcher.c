@@ -31,6 +31,7 @@
 #include <assert.h>
 #include <stdlib.h>
 
+#include <errno.h>
 #include <pthread.h>
 #include <semaphore.h>
 
@@ -47,28 +48,37 @@ typedef enum {
     EVENT_SERVED,
 } xLinkEventState_t;
 
+//waiter of a synchronous local event, lives on the stack of the calling thread
+typedef struct {
+    sem_t sem;
+    xLinkEvent_t* event; //gets the header of the served event
+} eventCompletion_t;
+
 typedef struct xLinkEventPriv_t {
     xLinkEvent_t packet;
     xLinkEventState_t isServed;
     xLinkEventOrigin_t origin;
-    sem_t* sem;
-    void* data;
-    uint32_t pad;
+    eventCompletion_t* completion;
+    dispatcherCompletion_t complete;
+    void* completeCtx;
+    struct xLinkEventPriv_t* next; //in the list of pending and blocked events
 } xLinkEventPriv_t;
 
+/*
+Single producer single consumer ring of events. head is written by the
+consumer only and tail by the producer only, so neither side takes a lock.
+The local queue has many producers, they are serialized by addEventSem.
+*/
 typedef struct {
-    sem_t sem;
-    pthread_t threadId;
-} localSem_t;
+    xLinkEventPriv_t* ring[MAX_EVENTS];
+    uint32_t head;
+    uint32_t tail;
+} eventRing_t;
 
 typedef struct{
-    xLinkEventPriv_t* end;
-    xLinkEventPriv_t* base;
-
-    xLinkEventPriv_t* curProc;
-    xLinkEventPriv_t* cur;
     __attribute__((aligned(8))) xLinkEventPriv_t q[MAX_EVENTS];
-
+    eventRing_t toProc; //events added, waiting for the dispatcher
+    eventRing_t free;   //slots handed back by the dispatcher
 }eventQueueHandler_t;
 typedef struct {
     void* xLinkFD; //will be device handler
@@ -76,31 +86,19 @@ typedef struct {
 
     sem_t addEventSem;
     sem_t notifyDispatcherSem;
+    sem_t asyncEventSem; //free slots for asynchronous events
     uint32_t resetXLink;
-    uint32_t semaphores;
+    uint32_t dispatcherIdle; //set while the dispatcher waits for notifyDispatcherSem
     pthread_t xLinkThreadId;
 
     eventQueueHandler_t lQueue; //local queue
     eventQueueHandler_t rQueue; //remote queue
-    localSem_t eventSemaphores[MAXIMUM_SEMAPHORES];
+    //owned by the dispatcher thread
+    eventRing_t readyQueue;   //unblocked local events, served before new ones
+    xLinkEventPriv_t* waiting; //pending and blocked local events, oldest first
 } xLinkSchedulerState_t;
 
 
-#define CIRCULAR_INCREMENT(x, maxVal, base) \
-    { \
-        x++; \
-        if (x == maxVal) \
-            x = base; \
-    }
-//avoid problems with unsigned. first compare and then give the nuw value
-#define CIRCULAR_DECREMENT(x, maxVal, base) \
-{ \
-    if (x == base) \
-        x = maxVal - 1; \
-    else \
-        x--; \
-}
-
 char* TypeToStr(int type)
 {
     switch(type)
@@ -155,39 +153,38 @@ static void* eventReader(void* ctx)
 }
 
 
-static sem_t* getCurrentSem(pthread_t threadId, xLinkSchedulerState_t* curr)
+static int ringPush(eventRing_t* r, xLinkEventPriv_t* event)
 {
-    ASSERT_X_LINK(curr != NULL);
-
-    localSem_t* sem = curr->eventSemaphores;
-    while (sem < curr->eventSemaphores + curr->semaphores) {
-        if (sem->threadId == threadId) {
-            return &sem->sem;
-        }
-        sem++;
+    uint32_t tail = r->tail;
+    if (tail - __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == MAX_EVENTS) {
+        return -1;
     }
-    return NULL;
+    r->ring[tail % MAX_EVENTS] = event;
+    __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+    return 0;
 }
 
-static sem_t* createSem(xLinkSchedulerState_t* curr)
+static xLinkEventPriv_t* ringPop(eventRing_t* r)
 {
-    ASSERT_X_LINK(curr != NULL);
-
-    sem_t* sem = getCurrentSem(pthread_self(), curr);
-    if (sem) // it already exists, error
+    uint32_t head = r->head;
+    if (head == __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE)) {
         return NULL;
-    else
-    {
-        //allocate space
-        if (curr->semaphores < MAXIMUM_SEMAPHORES)
-            curr->semaphores++;
-        else
-            return NULL;
-        sem = &curr->eventSemaphores[curr->semaphores - 1].sem;
-        curr->eventSemaphores[curr->semaphores - 1].threadId = pthread_self();
-        if (sem_init(sem, 0, 0))
-            perror("Can't create semaphore\n");
-        return sem;
+    }
+    xLinkEventPriv_t* event = r->ring[head % MAX_EVENTS];
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+    return event;
+}
+
+static void initQueue(eventQueueHandler_t* q)
+{
+    int i;
+    q->toProc.head = q->toProc.tail = 0;
+    q->free.head = q->free.tail = 0;
+    for (i = 0; i < MAX_EVENTS; i++) {
+        q->q[i].isServed = EVENT_SERVED;
+        q->q[i].completion = NULL;
+        q->q[i].complete = NULL;
+        ringPush(&q->free, &q->q[i]);
     }
 }
 
@@ -199,24 +196,57 @@ static int isEventTypeRequest(xLinkEventPriv_t* event)
         return 0;
 }
 
-static void markEventBlocked(xLinkEventPriv_t* event)
+static void addWaitingEvent(xLinkEventPriv_t* event, xLinkSchedulerState_t* curr)
+{
+    xLinkEventPriv_t** last = &curr->waiting;
+    while (*last != NULL) {
+        last = &(*last)->next;
+    }
+    event->next = NULL;
+    *last = event;
+}
+
+static void removeWaitingEvent(xLinkEventPriv_t** link)
+{
+    xLinkEventPriv_t* event = *link;
+    *link = event->next;
+    event->next = NULL;
+}
+
+static void markEventBlocked(xLinkEventPriv_t* event, xLinkSchedulerState_t* curr)
 {
     event->isServed = EVENT_BLOCKED;
+    addWaitingEvent(event, curr);
 }
 
-static void markEventReady(xLinkEventPriv_t* event)
+static void markEventReady(xLinkEventPriv_t* event, xLinkSchedulerState_t* curr)
 {
     event->isServed = EVENT_READY;
+    //at most MAX_EVENTS local events exist, the ring can't be full
+    ringPush(&curr->readyQueue, event);
 }
 
-static void markEventServed(xLinkEventPriv_t* event)
+static void markEventServed(xLinkEventPriv_t* event, xLinkSchedulerState_t* curr)
 {
-    if(event->sem){
-        if (sem_post(event->sem)) {
+    if (event->completion) {
+        eventCompletion_t* completion = event->completion;
+        event->completion = NULL;
+        completion->event->header = event->packet.header;
+        if (sem_post(&completion->sem)) {
+            mvLog(MVLOG_ERROR,"can't post semaphore\n");
+        }
+    }
+    if (event->complete) {
+        dispatcherCompletion_t complete = event->complete;
+        event->complete = NULL;
+        complete(&event->packet, event->completeCtx);
+        if (sem_post(&curr->asyncEventSem)) {
             mvLog(MVLOG_ERROR,"can't post semaphore\n");
         }
     }
     event->isServed = EVENT_SERVED;
+    //the slot can be reused as soon as it is back in the ring
+    ringPush(&curr->lQueue.free, event);
 }
 
 
@@ -225,14 +255,15 @@ static int dispatcherRequestServe(xLinkEventPriv_t * event, xLinkSchedulerState_
     ASSERT_X_LINK(isEventTypeRequest(event));
     xLinkEventHeader_t *header = &event->packet.header;
     if (header->flags.bitField.block){ //block is requested
-        markEventBlocked(event);
+        markEventBlocked(event, curr);
     }else if(header->flags.bitField.localServe == 1 ||
              (header->flags.bitField.ack == 0
              && header->flags.bitField.nack == 1)){ //this event is served locally, or it is failed
-        markEventServed(event);
+        markEventServed(event, curr);
     }else if (header->flags.bitField.ack == 1
               && header->flags.bitField.nack == 0){
         event->isServed = EVENT_PENDING;
+        addWaitingEvent(event, curr);
         mvLog(MVLOG_DEBUG,"------------------------UNserved %s\n",
               TypeToStr(event->packet.header.type));
     }else{
@@ -244,15 +275,16 @@ static int dispatcherRequestServe(xLinkEventPriv_t * event, xLinkSchedulerState_
 
 static int dispatcherResponseServe(xLinkEventPriv_t * event, xLinkSchedulerState_t* curr)
 {
-    int i = 0;
     ASSERT_X_LINK(curr != NULL);
     ASSERT_X_LINK(!isEventTypeRequest(event));
-    for (i = 0; i < MAX_EVENTS; i++)
+    xLinkEventPriv_t** link;
+    for (link = &curr->waiting; *link != NULL; link = &(*link)->next)
     {
-        xLinkEventHeader_t *header = &curr->lQueue.q[i].packet.header;
+        xLinkEventPriv_t* request = *link;
+        xLinkEventHeader_t *header = &request->packet.header;
         xLinkEventHeader_t *evHeader = &event->packet.header;
 
-        if (curr->lQueue.q[i].isServed == EVENT_PENDING &&
+        if (request->isServed == EVENT_PENDING &&
                         header->id == evHeader->id &&
                         header->type == evHeader->type - USB_REQUEST_LAST -1)
         {
@@ -260,70 +292,42 @@ static int dispatcherResponseServe(xLinkEventPriv_t * event, xLinkSchedulerState
                     TypeToStr(header->type));
             //propagate back flags
             header->flags = evHeader->flags;
-            markEventServed(&curr->lQueue.q[i]);
-            break;
+            removeWaitingEvent(link);
+            markEventServed(request, curr);
+            return 0;
         }
     }
-    if (i == MAX_EVENTS) {
-        mvLog(MVLOG_FATAL,"no request for this response: %s %d\n", TypeToStr(event->packet.header.type), event->origin);
-        ASSERT_X_LINK(0);
-    }
+    mvLog(MVLOG_FATAL,"no request for this response: %s %d\n", TypeToStr(event->packet.header.type), event->origin);
+    ASSERT_X_LINK(0);
     return 0;
 }
 
-static inline xLinkEventPriv_t* getNextElementWithState(xLinkEventPriv_t* base, xLinkEventPriv_t* end,
-                                                        xLinkEventPriv_t* start, xLinkEventState_t state){
-    xLinkEventPriv_t* tmp = start;
-    while (start->isServed != state){
-        CIRCULAR_INCREMENT(start, end, base);
-        if(tmp == start){
-            break;
-        }
-    }
-    if(start->isServed == state){
-        return start;
-    }else{
-        return NULL;
-    }
-}
-
-static xLinkEventPriv_t* searchForReadyEvent(xLinkSchedulerState_t* curr)
+static xLinkEventPriv_t* popNextEvent(xLinkSchedulerState_t* curr)
 {
-    ASSERT_X_LINK(curr != NULL);
-    xLinkEventPriv_t* ev = NULL;
-
-    ev = getNextElementWithState(curr->lQueue.base, curr->lQueue.end, curr->lQueue.base, EVENT_READY);
-    if(ev){
+    xLinkEventPriv_t* event = ringPop(&curr->readyQueue);
+    if (event) {
         mvLog(MVLOG_DEBUG,"ready %s %d \n",
-              TypeToStr((int)ev->packet.header.type),
-              (int)ev->packet.header.id);
+              TypeToStr((int)event->packet.header.type),
+              (int)event->packet.header.id);
+        return event;
     }
-    return ev;
-}
-
-static xLinkEventPriv_t* getNextQueueElemToProc(eventQueueHandler_t *q ){
-    xLinkEventPriv_t* event = NULL;
-    if (q->cur != q->curProc) {
-        event = getNextElementWithState(q->base, q->end, q->curProc, EVENT_SERVED);
-        q->curProc = event;
-        CIRCULAR_INCREMENT(q->curProc, q->end, q->base);
+    event = ringPop(&curr->lQueue.toProc);
+    if (event) {
+        return event;
     }
-    return event;
+    return ringPop(&curr->rQueue.toProc);
 }
 
-
-static xLinkEvent_t* addNextQueueElemToProc(eventQueueHandler_t *q, xLinkEvent_t* event,
-                                                sem_t* sem, xLinkEventOrigin_t o){
-    xLinkEvent_t* ev;
-    xLinkEventPriv_t* eventP = getNextElementWithState(q->base, q->end, q->cur, EVENT_SERVED);
-    mvLog(MVLOG_DEBUG,"received event %s %d\n",TypeToStr(event->header.type), o);
-    ev = &eventP->packet;
-    eventP->sem = sem;
-    eventP->packet = *event;
-    eventP->origin = o;
-    q->cur = eventP;
-    CIRCULAR_INCREMENT(q->cur, q->end, q->base);
-    return ev;
+static void notifyDispatcher(xLinkSchedulerState_t* curr)
+{
+    //only wake the dispatcher when it sleeps, a busy one drains the rings
+    //before it sleeps again
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_exchange_n(&curr->dispatcherIdle, 0, __ATOMIC_SEQ_CST)) {
+        if (sem_post(&curr->notifyDispatcherSem)) {
+            mvLog(MVLOG_ERROR,"can't post semaphore\n");
+        }
+    }
 }
 
 static xLinkEventPriv_t* dispatcherGetNextEvent(xLinkSchedulerState_t* curr)
@@ -331,42 +335,58 @@ static xLinkEventPriv_t* dispatcherGetNextEvent(xLinkSchedulerState_t* curr)
     ASSERT_X_LINK(curr != NULL);
 
     xLinkEventPriv_t* event = NULL;
-    event = searchForReadyEvent(curr);
-    if (event) {
-        return event;
-    }
-    if (sem_wait(&curr->notifyDispatcherSem)) {
-        mvLog(MVLOG_ERROR,"can't post semaphore\n");
-    }
-    event = getNextQueueElemToProc(&curr->lQueue);
-    if (event) {
-        return event;
+    while (1) {
+        event = popNextEvent(curr);
+        if (event) {
+            return event;
+        }
+        __atomic_store_n(&curr->dispatcherIdle, 1, __ATOMIC_SEQ_CST);
+        //an event added before the flag was set doesn't post, check again
+        event = popNextEvent(curr);
+        if (event) {
+            __atomic_store_n(&curr->dispatcherIdle, 0, __ATOMIC_SEQ_CST);
+            return event;
+        }
+        if (sem_wait(&curr->notifyDispatcherSem)) {
+            mvLog(MVLOG_ERROR,"can't wait semaphore\n");
+        }
     }
-    event = getNextQueueElemToProc(&curr->rQueue);
-    return event;
 }
 
 static void dispatcherReset(xLinkSchedulerState_t* curr)
 {
     ASSERT_X_LINK(curr != NULL);
+    xLinkEventPriv_t* event;
+    int i;
 
     glControlFunc->closeLink(curr->xLinkFD);
-    if (sem_post(&curr->notifyDispatcherSem)) {
-        mvLog(MVLOG_ERROR,"can't post semaphore\n"); //to allow us to get a NULL event
-    }
-    xLinkEventPriv_t* event = dispatcherGetNextEvent(curr);
-    while (event != NULL) {
-       event = dispatcherGetNextEvent(curr);
-    }
-
-    event = getNextElementWithState(curr->lQueue.base, curr->lQueue.end, curr->lQueue.base, EVENT_SERVED);
-    while (event != NULL) {
-        markEventServed(event);
-        event = getNextElementWithState(curr->lQueue.base, curr->lQueue.end, curr->lQueue.base, EVENT_PENDING);
-    }
-    glControlFunc->resetDevice(curr->xLinkFD);
+    //resetXLink is set, wait for a local event being added right now so that
+    //it is failed below. Later ones see the flag and aren't queued
+    sem_wait(&curr->addEventSem);
+    sem_post(&curr->addEventSem);
+    //drop whatever nobody is going to process
+    while (popNextEvent(curr) != NULL)
+        ;
+    curr->waiting = NULL;
+
+    //the link is gone, fail whoever still waits for a response, for data
+    //(blocked) or for the dispatcher (ready)
+    for (i = 0; i < MAX_EVENTS; i++) {
+        event = &curr->lQueue.q[i];
+        if (event->isServed == EVENT_SERVED)
+            continue;
+        event->packet.header.flags.bitField.ack = 0;
+        event->packet.header.flags.bitField.nack = 1;
+        markEventServed(event, curr);
+    }
+    //release the scheduler before the fd, a new link may get the same fd and
+    //must not be matched to this scheduler
+    void* xLinkFD = curr->xLinkFD;
+    sem_wait(&addSchedulerSem);
     curr->schedulerId = -1;
     numSchedulers--;
+    sem_post(&addSchedulerSem);
+    glControlFunc->resetDevice(xLinkFD);
     mvLog(MVLOG_INFO,"Reset Successfully\n");
 }
 
@@ -416,10 +436,12 @@ static void* eventSchedulerRun(void* ctx)
 
         res = getResp(&event->packet, &response.packet);
         if (isEventTypeRequest(event)){
+            //decide before serving, a served local event is reused right away
+            int send = res == 0 && event->packet.header.flags.bitField.localServe == 0;
             if (event->origin == EVENT_LOCAL){ //we need to do this for locals only
                 dispatcherRequestServe(event, curr);
             }
-            if (res == 0 && event->packet.header.flags.bitField.localServe == 0){
+            if (send){
                 glControlFunc->eventSend(toSend);
             }
         }else{
@@ -430,9 +452,11 @@ static void* eventSchedulerRun(void* ctx)
 
         //TODO: dispatcher shouldn't know about this packet. Seems to be easily move-able to protocol
         if (event->origin == EVENT_REMOTE){
-            if (event->packet.header.type == USB_RESET_REQ) {
+            if (event->packet.header.type == USB_RESET_REQ ||
+                event->packet.header.type == USB_RESET_RESP) {
                 curr->resetXLink = 1;
             }
+            ringPush(&curr->rQueue.free, event);
         }
     }
     pthread_join(readerThreadId, NULL);
@@ -463,58 +487,125 @@ static xLinkSchedulerState_t* findCorrespondingScheduler(void* xLinkFD)
     return NULL;
 }
 ///////////////// External Interface //////////////////////////
-/*Adds a new event with parameters and returns event id*/
-xLinkEvent_t* dispatcherAddEvent(xLinkEventOrigin_t origin, xLinkEvent_t *event)
+static xLinkEventPriv_t* addNextQueueElemToProc(eventQueueHandler_t *q, xLinkEvent_t* event,
+                                                eventCompletion_t* completion, xLinkEventOrigin_t o,
+                                                dispatcherCompletion_t complete, void* ctx){
+    xLinkEventPriv_t* eventP = ringPop(&q->free);
+    if (eventP == NULL) {
+        mvLog(MVLOG_WARN,"No more events. Increase MAX_EVENTS\n");
+        return NULL;
+    }
+    mvLog(MVLOG_DEBUG,"received event %s %d\n",TypeToStr(event->header.type), o);
+    eventP->completion = completion;
+    eventP->complete = complete;
+    eventP->completeCtx = ctx;
+    eventP->packet = *event;
+    eventP->origin = o;
+    eventP->next = NULL;
+    eventP->isServed = EVENT_READY;
+    ringPush(&q->toProc, eventP);
+    return eventP;
+}
+
+/*Adds an event read from the link*/
+int dispatcherAddEvent(xLinkEvent_t *event)
 {
     xLinkSchedulerState_t* curr = findCorrespondingScheduler(event->xLinkFD);
     ASSERT_X_LINK(curr != NULL);
 
     if(curr->resetXLink) {
-        return NULL;
+        return -1;
     }
-    mvLog(MVLOG_DEBUG,"receiving event %s %d\n",TypeToStr(event->header.type), origin);
-    if (sem_wait(&curr->addEventSem)) {
-        mvLog(MVLOG_ERROR,"can't wait semaphore\n");
+    mvLog(MVLOG_DEBUG,"receiving event %s %d\n",TypeToStr(event->header.type), EVENT_REMOTE);
+    //the reader thread is the only producer of the remote queue
+    if (addNextQueueElemToProc(&curr->rQueue, event, NULL, EVENT_REMOTE, NULL, NULL) == NULL) {
+        return -1;
     }
-    sem_t *sem = NULL;
-    xLinkEvent_t* ev;
-    if (origin == EVENT_LOCAL) {
-        event->header.id = createUniqueID();
-        sem = getCurrentSem(pthread_self(), curr);
-        if (!sem) {
+    notifyDispatcher(curr);
+    return 0;
+}
 
-            sem = createSem(curr);
-        }
-        if (!sem) {
-            mvLog(MVLOG_WARN,"No more semaphores. Increase XLink or OS resources\n");
-            return NULL;
-        }
-        event->header.flags.raw = 0;
-        event->header.flags.bitField.ack = 1;
-        ev = addNextQueueElemToProc(&curr->lQueue, event, sem, origin);
-    } else {
-        ev = addNextQueueElemToProc(&curr->rQueue, event, NULL, origin);
+//Under addEventSem: the link may have been reset, or its scheduler reused,
+//since the caller looked the scheduler up
+static int schedulerAcceptsEvents(xLinkSchedulerState_t* curr, void* xLinkFD)
+{
+    return !curr->resetXLink && curr->schedulerId != -1 && curr->xLinkFD == xLinkFD;
+}
+
+int dispatcherServeEvent(xLinkEvent_t *event)
+{
+    xLinkSchedulerState_t* curr = findCorrespondingScheduler(event->xLinkFD);
+    //a link reset by the remote is gone by the time its user gets here
+    if(curr == NULL || curr->resetXLink) {
+        event->header.flags.bitField.ack = 0;
+        event->header.flags.bitField.nack = 1;
+        return -1;
+    }
+    mvLog(MVLOG_DEBUG,"receiving event %s %d\n",TypeToStr(event->header.type), EVENT_LOCAL);
+    eventCompletion_t completion;
+    completion.event = event;
+    if (sem_init(&completion.sem, 0, 0)) {
+        mvLog(MVLOG_ERROR,"can't create semaphore\n");
+        return -1;
+    }
+    if (sem_wait(&curr->addEventSem)) {
+        mvLog(MVLOG_ERROR,"can't wait semaphore\n");
     }
+    event->header.id = createUniqueID();
+    event->header.flags.raw = 0;
+    event->header.flags.bitField.ack = 1;
+    xLinkEventPriv_t* ev = NULL;
+    if (schedulerAcceptsEvents(curr, event->xLinkFD))
+        ev = addNextQueueElemToProc(&curr->lQueue, event, &completion,
+                                    EVENT_LOCAL, NULL, NULL);
     if (sem_post(&curr->addEventSem)) {
         mvLog(MVLOG_ERROR,"can't post semaphore\n");
     }
-    if (sem_post(&curr->notifyDispatcherSem)) {
-        mvLog(MVLOG_ERROR, "can't post semaphore\n");
+    if (ev == NULL) {
+        event->header.flags.bitField.ack = 0;
+        event->header.flags.bitField.nack = 1;
+        sem_destroy(&completion.sem);
+        return -1;
     }
-    return ev;
+    notifyDispatcher(curr);
+
+    int rc;
+    while ((rc = sem_wait(&completion.sem)) && errno == EINTR)
+        ;
+    sem_destroy(&completion.sem);
+    return rc;
 }
 
-int dispatcherWaitEventComplete(void* xLinkFD)
+int dispatcherAddEventAsync(xLinkEvent_t *event, dispatcherCompletion_t complete, void* ctx)
 {
-    xLinkSchedulerState_t* curr = findCorrespondingScheduler(xLinkFD);
-    ASSERT_X_LINK(curr != NULL);
+    xLinkSchedulerState_t* curr = findCorrespondingScheduler(event->xLinkFD);
+    ASSERT_X_LINK(complete != NULL);
 
-    sem_t* id = getCurrentSem(pthread_self(), curr);
-    if (id == NULL) {
+    if(curr == NULL || curr->resetXLink) {
         return -1;
     }
-
-    return sem_wait(id);
+    mvLog(MVLOG_DEBUG,"receiving async event %s\n",TypeToStr(event->header.type));
+    if (sem_wait(&curr->asyncEventSem)) {
+        mvLog(MVLOG_ERROR,"can't wait semaphore\n");
+    }
+    if (sem_wait(&curr->addEventSem)) {
+        mvLog(MVLOG_ERROR,"can't wait semaphore\n");
+    }
+    event->header.id = createUniqueID();
+    event->header.flags.raw = 0;
+    event->header.flags.bitField.ack = 1;
+    xLinkEventPriv_t* ev = NULL;
+    if (schedulerAcceptsEvents(curr, event->xLinkFD))
+        ev = addNextQueueElemToProc(&curr->lQueue, event, NULL, EVENT_LOCAL, complete, ctx);
+    if (sem_post(&curr->addEventSem)) {
+        mvLog(MVLOG_ERROR,"can't post semaphore\n");
+    }
+    if (ev == NULL) {
+        sem_post(&curr->asyncEventSem);
+        return -1;
+    }
+    notifyDispatcher(curr);
+    return 0;
 }
 
 int dispatcherUnblockEvent(eventId_t id, xLinkEventType_t type, streamId_t stream, void* xLinkFD)
@@ -523,11 +614,10 @@ int dispatcherUnblockEvent(eventId_t id, xLinkEventType_t type, streamId_t strea
     ASSERT_X_LINK(curr != NULL);
 
     mvLog(MVLOG_DEBUG,"unblock\n");
-    xLinkEventPriv_t* blockedEvent;
-    for (blockedEvent = curr->lQueue.q;
-         blockedEvent < curr->lQueue.q + MAX_EVENTS;
-         blockedEvent++)
+    xLinkEventPriv_t** link;
+    for (link = &curr->waiting; *link != NULL; link = &(*link)->next)
     {
+        xLinkEventPriv_t* blockedEvent = *link;
         if (blockedEvent->isServed == EVENT_BLOCKED &&
             ((blockedEvent->packet.header.id == id || id == -1)
             && blockedEvent->packet.header.type == type
@@ -536,7 +626,8 @@ int dispatcherUnblockEvent(eventId_t id, xLinkEventType_t type, streamId_t strea
             mvLog(MVLOG_DEBUG,"unblocked**************** %d %s\n",
                   (int)blockedEvent->packet.header.id,
                   TypeToStr((int)blockedEvent->packet.header.type));
-            markEventReady(blockedEvent);
+            removeWaitingEvent(link);
+            markEventReady(blockedEvent, curr);
             return 1;
         } else {
             mvLog(MVLOG_DEBUG,"%d %s\n",
@@ -559,7 +650,6 @@ int findAvailableScheduler()
 int dispatcherStart(void* fd)
 {
     pthread_attr_t attr;
-    int eventIdx;
     if (numSchedulers >= MAX_SCHEDULERS)
     {
         mvLog(MVLOG_ERROR,"Max number Schedulers reached!\n");
@@ -567,27 +657,15 @@ int dispatcherStart(void* fd)
     }
     int idx = findAvailableScheduler();
 
-    schedulerState[idx].semaphores = 0;
-
     schedulerState[idx].resetXLink = 0;
+    schedulerState[idx].dispatcherIdle = 0;
     schedulerState[idx].xLinkFD = fd;
     schedulerState[idx].schedulerId = idx;
 
-    schedulerState[idx].lQueue.cur = schedulerState[idx].lQueue.q;
-    schedulerState[idx].lQueue.curProc = schedulerState[idx].lQueue.q;
-    schedulerState[idx].lQueue.base = schedulerState[idx].lQueue.q;
-    schedulerState[idx].lQueue.end = &schedulerState[idx].lQueue.q[MAX_EVENTS];
-
-    schedulerState[idx].rQueue.cur = schedulerState[idx].rQueue.q;
-    schedulerState[idx].rQueue.curProc = schedulerState[idx].rQueue.q;
-    schedulerState[idx].rQueue.base = schedulerState[idx].rQueue.q;
-    schedulerState[idx].rQueue.end = &schedulerState[idx].rQueue.q[MAX_EVENTS];
-
-    for (eventIdx = 0 ; eventIdx < MAX_EVENTS; eventIdx++)
-    {
-        schedulerState[idx].rQueue.q[eventIdx].isServed = EVENT_SERVED;
-        schedulerState[idx].lQueue.q[eventIdx].isServed = EVENT_SERVED;
-    }
+    initQueue(&schedulerState[idx].lQueue);
+    initQueue(&schedulerState[idx].rQueue);
+    schedulerState[idx].readyQueue.head = schedulerState[idx].readyQueue.tail = 0;
+    schedulerState[idx].waiting = NULL;
 
     if (sem_init(&schedulerState[idx].addEventSem, 0, 1)) {
         perror("Can't create semaphore\n");
@@ -596,6 +674,9 @@ int dispatcherStart(void* fd)
     if (sem_init(&schedulerState[idx].notifyDispatcherSem, 0, 0)) {
         perror("Can't create semaphore\n");
     }
+    if (sem_init(&schedulerState[idx].asyncEventSem, 0, MAX_ASYNC_EVENTS)) {
+        perror("Can't create semaphore\n");
+    }
     if (pthread_attr_init(&attr) != 0) {
         mvLog(MVLOG_ERROR,"pthread_attr_init error");
     }
@@ -34,11 +34,19 @@ extern "C"
 #endif
 typedef int (*getRespFunction) (xLinkEvent_t*,
                 xLinkEvent_t*);
-///Adds a new event with parameters and returns event.header.id
-xLinkEvent_t* dispatcherAddEvent(xLinkEventOrigin_t origin,
-									xLinkEvent_t *event);
+///Called on the dispatcher thread once an asynchronous event is served
+typedef void (*dispatcherCompletion_t) (xLinkEvent_t* event, void* ctx);
+///Adds an event read from the link, called from the reader thread only
+int dispatcherAddEvent(xLinkEvent_t *event);
+///Adds a local event and waits until it is served. The header of the served
+///event is copied back, its flags tell if it was acked. 0 once served
+int dispatcherServeEvent(xLinkEvent_t *event);
+///Adds a local event that nobody waits for, complete is called when it is served
+///Blocks while MAX_ASYNC_EVENTS events of the link are in flight. 0 if queued
+int dispatcherAddEventAsync(xLinkEvent_t *event,
+									dispatcherCompletion_t complete,
+									void* ctx);
 
-int dispatcherWaitEventComplete(void* xlinkFD);
 int dispatcherUnblockEvent(eventId_t id,
 							xLinkEventType_t type,
 							streamId_t stream,
@@ -113,6 +113,9 @@ typedef enum
 } xLinkEventOrigin_t;
 
 #define MAX_EVENTS 64
+//asynchronous events may take up to half of the local queue, the rest is
+//left for the synchronous callers (one event per thread)
+#define MAX_ASYNC_EVENTS (MAX_EVENTS / 2)
 
 #define MAX_SCHEDULERS MAX_LINKS
 //static int eventCount;
@@ -143,6 +146,7 @@ typedef struct xLinkEvent_t {
     xLinkEventHeader_t header;
     void* xLinkFD;
     void* data;
+    int segments; //data of a write is a streamSegmentDesc_t array if not 0
 }xLinkEvent_t;
 
 #ifdef __cplusplus
@@ -61,6 +61,20 @@ typedef struct streamPacketDesc_t
 
 } streamPacketDesc_t;
 
+// One piece of a gathered write
+typedef struct streamSegmentDesc_t
+{
+    const uint8_t* data;
+    uint32_t length;
+} streamSegmentDesc_t;
+
+// Completion of an asynchronous read or write. Runs on the dispatcher thread
+// of the link, so it must not block nor call the synchronous XLink functions.
+// For reads packet points to the received data, it is valid until
+// XLinkReleaseData is called for the stream; for writes it is NULL
+typedef void (*XLinkCompletionCallback_t)(streamId_t streamId, XLinkError_t status,
+                                          streamPacketDesc_t* packet, void* userContext);
+
 typedef struct XLinkProf_t
 {
     float totalReadTime;
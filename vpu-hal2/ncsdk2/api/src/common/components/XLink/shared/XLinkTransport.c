@@ -0,0 +1,77 @@
+/*
+* Copyright 2017 Intel Corporation.
+* The source code, information and material ("Material") contained herein is
+* owned by Intel Corporation or its suppliers or licensors, and title to such
+* Material remains with Intel Corporation or its suppliers or licensors.
+* The Material contains proprietary information of Intel or its suppliers and
+* licensors. The Material is protected by worldwide copyright laws and treaty
+* provisions.
+* No part of the Material may be used, copied, reproduced, modified, published,
+* uploaded, posted, transmitted, distributed or disclosed in any way without
+* Intel's prior express written permission. No license under any patent,
+* copyright or other intellectual property rights in the Material is granted to
+* or conferred upon you, either expressly, by implication, inducement, estoppel
+* or otherwise.
+* Any license under such intellectual property rights must be express and
+* approved by Intel in writing.
+*/
+
+///
+/// @brief     XLink transport selection
+///
+#include <stdlib.h>
+#include <string.h>
+
+#include "XLinkTransport.h"
+
+#define MVLOG_UNIT_NAME xLink
+#include "mvLog.h"
+
+static const xLinkTransport_t* transports[] = {
+#ifndef XLINK_NO_USB_TRANSPORT
+    &usbLinkTransport,
+#endif
+#ifdef XLINK_EMULATOR
+    &loopbackLinkTransport,
+    &socketLinkTransport,
+#endif
+};
+
+const xLinkTransport_t* xLinkTransportByName(const char* name)
+{
+    unsigned int i;
+    for (i = 0; i < sizeof(transports) / sizeof(transports[0]); i++) {
+        if (strcmp(transports[i]->name, name) == 0)
+            return transports[i];
+    }
+    return NULL;
+}
+
+const xLinkTransport_t* xLinkDefaultTransport(void)
+{
+    const char* name = getenv("XLINK_TRANSPORT");
+    if (name && *name) {
+        const xLinkTransport_t* transport = xLinkTransportByName(name);
+        if (transport)
+            return transport;
+        mvLog(MVLOG_WARN, "Unknown XLink transport %s, using %s\n", name, transports[0]->name);
+    }
+    return transports[0];
+}
+
+void deallocateData(void* ptr,uint32_t size, uint32_t alignment)
+{
+    if (!ptr)
+        return;
+    free(ptr);
+}
+
+void* allocateData(uint32_t size, uint32_t alignment)
+{
+    void* ret = NULL;
+    if (posix_memalign(&ret, alignment, size))
+        return NULL;
+    return ret;
+}
+
+/* end of file */
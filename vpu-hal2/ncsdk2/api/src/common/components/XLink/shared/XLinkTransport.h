@@ -0,0 +1,88 @@
+/*
+* Copyright 2017 Intel Corporation.
+* The source code, information and material ("Material") contained herein is
+* owned by Intel Corporation or its suppliers or licensors, and title to such
+* Material remains with Intel Corporation or its suppliers or licensors.
+* The Material contains proprietary information of Intel or its suppliers and
+* licensors. The Material is protected by worldwide copyright laws and treaty
+* provisions.
+* No part of the Material may be used, copied, reproduced, modified, published,
+* uploaded, posted, transmitted, distributed or disclosed in any way without
+* Intel's prior express written permission. No license under any patent,
+* copyright or other intellectual property rights in the Material is granted to
+* or conferred upon you, either expressly, by implication, inducement, estoppel
+* or otherwise.
+* Any license under such intellectual property rights must be express and
+* approved by Intel in writing.
+*/
+
+///
+/// @brief     Transport the XLink events and data are carried over
+///
+#ifndef _XLINK_TRANSPORT_H
+#define _XLINK_TRANSPORT_H
+#include "UsbLinkPlatform.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+The link layer only needs a reliable, ordered byte pipe to the remote. Each
+backend fills in this table, the functions have the same contract as the
+UsbLinkPlatform ones. fd is whatever handle connect returned, XLink uses it
+as the identity of the link.
+*/
+typedef struct xLinkTransport_t {
+    const char* name;
+    int (*init)(int loglevel);
+    int (*connect)(const char* devPathRead, const char* devPathWrite, void** fd);
+    int (*write)(void* fd, void* data, int size, unsigned int timeout);
+    // optional, writes the segments as one piece of data. XLink writes them
+    // one by one when NULL, which is fine for byte pipes
+    int (*writeSegments)(void* fd, const streamSegmentDesc_t* segments, int count,
+                         unsigned int timeout);
+    int (*read)(void* fd, void* data, int size, unsigned int timeout);
+    int (*getDeviceName)(int index, char* name, int nameSize);
+    int (*bootRemote)(const char* deviceName, const char* binaryPath);
+    int (*resetRemote)(void* fd);
+    // optional, called on the dispatcher thread once the remote acknowledged
+    // a reset request so that pending reads on the link return. The fd stays
+    // valid until resetRemote, which only that thread calls. NULL if the
+    // remote drops the link itself
+    int (*disconnect)(void* fd);
+} xLinkTransport_t;
+
+#ifndef XLINK_NO_USB_TRANSPORT
+extern const xLinkTransport_t usbLinkTransport;
+#endif
+#ifdef XLINK_EMULATOR
+// Test transports, only built into the emulator variant of libmvnc
+// in-process pipe to a peer installed with xLinkLoopbackSetPeer
+extern const xLinkTransport_t loopbackLinkTransport;
+// UNIX domain socket, see XLINK_SOCKET_PATH
+extern const xLinkTransport_t socketLinkTransport;
+
+// Called from connect with the remote end of a new loopback link, it has to
+// start serving it (XLinkAccept) before returning
+typedef void (*xLinkLoopbackPeer_t)(void* fd, void* ctx);
+void xLinkLoopbackSetPeer(xLinkLoopbackPeer_t peer, void* ctx);
+
+// Device side of the socket transport. Listen returns the socket or -1,
+// accept blocks for the next host and returns an fd for XLinkAccept
+int xLinkSocketListen(const char* path);
+void* xLinkSocketAccept(int listenSock);
+#endif
+
+// Backend by name: "usb", "loopback" or "socket". NULL if unknown
+const xLinkTransport_t* xLinkTransportByName(const char* name);
+// Backend named by the XLINK_TRANSPORT environment variable, USB by default
+const xLinkTransport_t* xLinkDefaultTransport(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/* end of include file */
@@ -33,6 +33,9 @@
 #include "ncCommPrivate.h"
 #include "ncPrivateTypes.h"
 #include "ncHighClass.h"
+#ifdef XLINK_EMULATOR
+#include "ncDeviceEmulator.h"
+#endif
 
 #include <android/log.h>
 #include <cutils/log.h>
@@ -157,6 +160,10 @@ static void initialize()
     mvLogDefaultLevelSet(MVLOG_FATAL);
 	// We sanitize the situation by trying to reset the devices that have been left open
 	initialized = 1;
+#ifdef XLINK_EMULATOR
+	// only reachable when XLINK_TRANSPORT=loopback
+	ncEmulatorInstallLoopback(NULL);
+#endif
 	int sc = XLinkInitialize(&ghandler); //need to be called once
 	if (sc != X_LINK_SUCCESS) {
 	    mvLog(MVLOG_ERROR," Initialization failed\n");
@@ -1438,6 +1445,13 @@ ncStatus_t ncFifoInit(ncFifoType_t type, struct fifoHandle_t** fifo) {
     handle->id = fifoIdCounter++;
     handle->datatype = NC_FIFO_FP16;
     handle->num_elements = 0;
+    handle->async_write = 0;
+    handle->writes_in_flight = 0;
+    handle->async_write_error = 0;
+    handle->lost_writes = NULL;
+    handle->lost_count = 0;
+    pthread_mutex_init(&handle->async_m, NULL);
+    pthread_cond_init(&handle->write_cond, NULL);
     snprintf(handle->name, 16, "FIFO%d", handle->id);
     return NC_OK;
 }
@@ -1606,6 +1620,12 @@ ncStatus_t ncFifoDelete(struct fifoHandle_t* fifo) {
         mvLog(MVLOG_ERROR, "FIFO is not yet created.");
         return NC_INVALID_PARAMETERS; //TODO: better error code
     }
+    //Let the pending asynchronous writes land before the fifo goes away
+    pthread_mutex_lock(&handle->async_m);
+    while (handle->writes_in_flight > 0)
+        pthread_cond_wait(&handle->write_cond, &handle->async_m);
+    pthread_mutex_unlock(&handle->async_m);
+
     //First write to the fifo to stop it's thread
     if (fifoWriteAccess(handle)) {
         int msg = 0xdead;
@@ -1642,17 +1662,174 @@ ncStatus_t ncFifoDelete(struct fifoHandle_t* fifo) {
     }
     pthread_mutex_unlock(&d->dev_data_m);
 
+    free(handle->lost_writes);
     free(fifo->private_data);
     free(fifo);
     return NC_OK;
 
 }
 
+struct _asyncWritePrivate_t {
+    struct _fifoPrivate_t* fifo;
+    void* buffer; // NULL when the caller's segments went out as they are
+    int element;  // write_count when it was written
+};
+
+static void fifoAsyncWriteDone(streamId_t streamId, XLinkError_t status,
+                               streamPacketDesc_t* packet, void* userContext)
+{
+    struct _asyncWritePrivate_t* w = (struct _asyncWritePrivate_t*) userContext;
+    struct _fifoPrivate_t* handle = w->fifo;
+    int element = w->element;
+    free(w->buffer);
+    free(w);
+    //consumed_by_graph only changes with async_m held too, fifo_mutex can't be
+    //taken here: it is held around synchronous XLink calls this thread serves
+    pthread_mutex_lock(&handle->async_m);
+    if (status != X_LINK_SUCCESS) {
+        mvLog(MVLOG_ERROR, "Asynchronous write to %s failed %d", handle->name, status);
+        int* lost = NULL;
+        if (element >= handle->consumed_by_graph)
+            lost = realloc(handle->lost_writes, (handle->lost_count + 1) * sizeof(int));
+        if (lost) {
+            handle->lost_writes = lost;
+            handle->lost_writes[handle->lost_count++] = element;
+        } else {
+            handle->async_write_error = 1;
+        }
+    }
+    handle->writes_in_flight--;
+    pthread_cond_broadcast(&handle->write_cond);
+    pthread_mutex_unlock(&handle->async_m);
+}
+
+// Drops element from the lost writes of the FIFO and tells whether it was
+// there. Called with async_m held
+static int takeLostWrite(struct _fifoPrivate_t* handle, int element)
+{
+    int i;
+    for (i = 0; i < handle->lost_count; i++) {
+        if (handle->lost_writes[i] == element) {
+            handle->lost_writes[i] = handle->lost_writes[--handle->lost_count];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static streamSegmentDesc_t* toStreamSegments(const struct ncTensorSegment_t *segments,
+                                             unsigned int count)
+{
+    streamSegmentDesc_t* gather = malloc(count * sizeof(streamSegmentDesc_t));
+    unsigned int i;
+    if (!gather)
+        return NULL;
+    for (i = 0; i < count; i++) {
+        gather[i].data = segments[i].data;
+        gather[i].length = segments[i].length;
+    }
+    return gather;
+}
+
+// Takes ownership of the malloc'ed buffer, it is freed once the write completes.
+// Without a buffer the segments are written in place and have to stay valid
+// until then
+static ncStatus_t fifoWriteAsync(struct _fifoPrivate_t* handle, void* buffer,
+                                 const struct ncTensorSegment_t *segments, unsigned int count,
+                                 unsigned int length)
+{
+    struct _asyncWritePrivate_t* w = malloc(sizeof(struct _asyncWritePrivate_t));
+    if (!w) {
+        free(buffer);
+        return NC_OUT_OF_MEMORY;
+    }
+    w->fifo = handle;
+    w->buffer = buffer;
+    //writes to one FIFO don't overlap, or their user params would not match either
+    pthread_mutex_lock(&handle->fifo_mutex);
+    w->element = handle->write_count;
+    pthread_mutex_unlock(&handle->fifo_mutex);
+
+    pthread_mutex_lock(&handle->async_m);
+    while (handle->writes_in_flight >= handle->num_elements && !handle->async_write_error)
+        pthread_cond_wait(&handle->write_cond, &handle->async_m);
+    if (handle->async_write_error) {
+        pthread_mutex_unlock(&handle->async_m);
+        free(buffer);
+        free(w);
+        return NC_ERROR;
+    }
+    handle->writes_in_flight++;
+    pthread_mutex_unlock(&handle->async_m);
+
+    XLinkError_t sc = X_LINK_ERROR;
+    if (buffer) {
+        sc = XLinkAsyncWriteData(handle->streamId, buffer, length, fifoAsyncWriteDone, w);
+    } else {
+        // XLink keeps its own copy of the descriptors
+        streamSegmentDesc_t* gather = toStreamSegments(segments, count);
+        if (gather)
+            sc = XLinkAsyncWriteDataSegments(handle->streamId, gather, count,
+                                             fifoAsyncWriteDone, w);
+        free(gather);
+    }
+    if (sc != X_LINK_SUCCESS) {
+        pthread_mutex_lock(&handle->async_m);
+        handle->writes_in_flight--;
+        pthread_cond_broadcast(&handle->write_cond);
+        pthread_mutex_unlock(&handle->async_m);
+        free(buffer);
+        free(w);
+        return NC_ERROR;
+    }
+    return NC_OK;
+}
+
 ncStatus_t ncFifoWriteElem(struct fifoHandle_t* fifo, const void *inputTensor,
                            struct ncTensorDescriptor_t *inputDesc, void *userParam) {
     if (!fifo)
         return NC_INVALID_PARAMETERS;
     struct _fifoPrivate_t* handle = (struct _fifoPrivate_t*) fifo->private_data;
+    //default to the FIFO descriptor
+    if (inputDesc == NULL){
+        inputDesc = &handle->tensor_desc;
+    }
+    struct ncTensorSegment_t segment;
+    segment.data = inputTensor;
+    segment.length = inputDesc->totalSize;
+    if (handle->datatype == NC_FIFO_FP32)
+        segment.length *= 2;
+    return ncFifoWriteElemSegments(fifo, &segment, 1, inputDesc, userParam);
+}
+
+// Puts the segments one after the other in a malloc'ed buffer, converting
+// fp32 to fp16 on the way
+static void* gatherSegments(const struct ncTensorSegment_t *segments, unsigned int count,
+                            unsigned int length, int fp32)
+{
+    unsigned char *buffer = malloc(length);
+    unsigned int i;
+    if (!buffer)
+        return NULL;
+    unsigned char *dst = buffer;
+    for (i = 0; i < count; i++) {
+        if (fp32) {
+            floattofp16(dst, (float *)segments[i].data, segments[i].length / sizeof(float));
+            dst += segments[i].length / 2;
+        } else {
+            memcpy(dst, segments[i].data, segments[i].length);
+            dst += segments[i].length;
+        }
+    }
+    return buffer;
+}
+
+ncStatus_t ncFifoWriteElemSegments(struct fifoHandle_t* fifo,
+                           const struct ncTensorSegment_t *segments, unsigned int count,
+                           struct ncTensorDescriptor_t *inputDesc, void *userParam) {
+    if (!fifo || !segments || count == 0)
+        return NC_INVALID_PARAMETERS;
+    struct _fifoPrivate_t* handle = (struct _fifoPrivate_t*) fifo->private_data;
     if (!fifoWriteAccess(handle)) {
         return NC_UNAUTHORIZED;
     }
@@ -1664,23 +1841,51 @@ ncStatus_t ncFifoWriteElem(struct fifoHandle_t* fifo, const void *inputTensor,
         return NC_INVALID_PARAMETERS; // the tensor size given is bigger than the size supported by the FIFOs
     }
     unsigned int inputTensorLength = inputDesc->totalSize;
-    // Convert fp32 to fp16
-    if (handle->datatype == NC_FIFO_FP32){
-        unsigned char *inputTensorFP16 = malloc(inputTensorLength);
-        //TODO: for now, hardcode to sizeof(fp16), since tensor_descs don't yet have correct dimensions
-        int sizeof_td_dt = 2; //inputDesc->totalSize / (inputDesc->n * inputDesc->c * inputDesc->w * inputDesc->h);
-        unsigned int cnt = inputTensorLength / sizeof_td_dt;
-        floattofp16(inputTensorFP16, (float *)inputTensor, cnt);
-        inputTensor = (void *)inputTensorFP16;
-    }
-    if(XLinkWriteData(handle->streamId, inputTensor, inputTensorLength) != 0 )
-    {
-        if (handle->datatype == NC_FIFO_FP32)
-            free(inputTensor);
-        return NC_ERROR;
+    // fp32 is converted to fp16
+    int fp32 = handle->datatype == NC_FIFO_FP32;
+    unsigned int segmentsLength = 0;
+    unsigned int i;
+    for (i = 0; i < count; i++) {
+        if (fp32 && segments[i].length % sizeof(float))
+            return NC_INVALID_PARAMETERS;
+        segmentsLength += segments[i].length;
+    }
+    if (segmentsLength != (fp32 ? 2 * inputTensorLength : inputTensorLength))
+        return NC_INVALID_PARAMETERS;
+
+    if (handle->async_write == NC_FIFO_ASYNC_WRITE_IN_PLACE && !fp32) {
+        //the caller leaves the segments alone until the result is read
+        ncStatus_t rc = fifoWriteAsync(handle, NULL, segments, count, inputTensorLength);
+        if (rc != NC_OK)
+            return rc;
+    } else if (handle->async_write || fp32) {
+        //the caller may reuse its tensor as soon as we return, and a
+        //converted one needs a buffer anyway
+        void* buffer = gatherSegments(segments, count, inputTensorLength, fp32);
+        if (!buffer)
+            return NC_OUT_OF_MEMORY;
+        if (handle->async_write) {
+            ncStatus_t rc = fifoWriteAsync(handle, buffer, NULL, 0, inputTensorLength);
+            if (rc != NC_OK)
+                return rc;
+        } else {
+            int wc = XLinkWriteData(handle->streamId, buffer, inputTensorLength);
+            free(buffer);
+            if (wc != 0)
+                return NC_ERROR;
+        }
+    } else if (count == 1) {
+        if(XLinkWriteData(handle->streamId, segments[0].data, inputTensorLength) != 0 )
+            return NC_ERROR;
+    } else {
+        streamSegmentDesc_t* gather = toStreamSegments(segments, count);
+        if (!gather)
+            return NC_OUT_OF_MEMORY;
+        int wc = XLinkWriteDataSegments(handle->streamId, gather, count);
+        free(gather);
+        if (wc != 0)
+            return NC_ERROR;
     }
-    if (handle->datatype == NC_FIFO_FP32)
-        free(inputTensor);
     pthread_mutex_lock(&handle->fifo_mutex);
     int rc = pushUserParam(handle, userParam , 1);
     if(rc != NC_OK) {
@@ -1778,6 +1983,9 @@ ncStatus_t ncFifoSetOption(struct fifoHandle_t* fifo, ncFifoOption_t option,
     case NC_RW_FIFO_DONT_BLOCK:
         return NC_UNSUPPORTED_FEATURE; //TODO: XLink support for this (fill level may be enough for it)
         break;
+    case NC_RW_FIFO_ASYNC_WRITE:
+        f->async_write = *(int *) data;
+        break;
     case NC_RO_FIFO_CAPACITY:
     case NC_RO_FIFO_READ_FILL_LEVEL:
     case NC_RO_FIFO_WRITE_FILL_LEVEL:
@@ -1863,6 +2071,10 @@ ncStatus_t ncFifoGetOption(struct fifoHandle_t* fifo, ncFifoOption_t option,
     case NC_RW_FIFO_DONT_BLOCK:
         return NC_UNSUPPORTED_FEATURE; //TODO: XLink support for this (fill level may be enough for it)
         break;
+    case NC_RW_FIFO_ASYNC_WRITE:
+        *(int*) data = fifo->private_data->async_write;
+        *dataLength = sizeof(int);
+        break;
     case NC_RO_FIFO_STATE:
         *(int*) data = fifo->private_data->state;
         *dataLength = sizeof(int);
@@ -1897,6 +2109,13 @@ ncStatus_t ncGraphQueueInference(struct graphHandle_t *graphHandle,
     ncStatus_t rc;
     if (fi->state != NC_FIFO_CREATED|| fo->state != NC_FIFO_CREATED)
         return NC_ERROR; //TODO: could add specific error code
+    pthread_mutex_lock(&fi->async_m);
+    int writeFailed = fi->async_write_error;
+    pthread_mutex_unlock(&fi->async_m);
+    if (writeFailed) {
+        mvLog(MVLOG_WARN, "An asynchronous write to the input FIFO failed after its trigger");
+        return NC_ERROR;
+    }
     //WO fifos have no graph access
     if (fo->type == NC_FIFO_HOST_WO){
         //graphs have no access to one of the fifos
@@ -1939,7 +2158,18 @@ ncStatus_t ncGraphQueueInference(struct graphHandle_t *graphHandle,
         pthread_mutex_unlock(&fi->fifo_mutex);
         return NC_UNAUTHORIZED;
     }
+    pthread_mutex_lock(&fi->async_m);
+    int writeLost = takeLostWrite(fi, fi->consumed_by_graph);
     fi->consumed_by_graph++;
+    pthread_mutex_unlock(&fi->async_m);
+    if (writeLost) {
+        //the element never reached the device, so there is nothing to trigger
+        //for it. Its user param is gone with it and the next trigger takes the
+        //next element, as the device does
+        pthread_mutex_unlock(&fi->fifo_mutex);
+        mvLog(MVLOG_WARN, "The asynchronous write of this input failed, it is dropped");
+        return NC_ERROR;
+    }
     pthread_mutex_unlock(&fi->fifo_mutex);
 
     pthread_mutex_lock(&fo->fifo_mutex);
@@ -0,0 +1,698 @@
+/*
+* Copyright 2017 Intel Corporation.
+* The source code, information and material ("Material") contained herein is
+* owned by Intel Corporation or its suppliers or licensors, and title to such
+* Material remains with Intel Corporation or its suppliers or licensors.
+* The Material contains proprietary information of Intel or its suppliers and
+* licensors. The Material is protected by worldwide copyright laws and treaty
+* provisions.
+* No part of the Material may be used, copied, reproduced, modified, published,
+* uploaded, posted, transmitted, distributed or disclosed in any way without
+* Intel's prior express written permission. No license under any patent,
+* copyright or other intellectual property rights in the Material is granted to
+* or conferred upon you, either expressly, by implication, inducement, estoppel
+* or otherwise.
+* Any license under such intellectual property rights must be express and
+* approved by Intel in writing.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "XLink.h"
+#include "XLinkTransport.h"
+#include "ncCommPrivate.h"
+#include "ncDeviceEmulator.h"
+
+#define MVLOG_UNIT_NAME ncEmulator
+#include "mvLog.h"
+
+// Sizes libmvnc expects, see mvnc_api.c
+#define THERMAL_BUFFER_SIZE     100
+#define DEBUG_BUFFER_SIZE       120
+#define OPTIMISATION_NAME_LEN   50
+#define CONFIG_STREAM_SIZE      2000
+#define BLOB_STREAM_SIZE        4096
+#define GRAPH_REPLY_STREAM_SIZE 1024
+
+#define EMU_MAX_GRAPHS      32
+#define EMU_MAX_FIFOS       64
+#define EMU_MAX_EXECUTORS   8
+#define STREAM_WAIT_MS      30000
+
+// Graph blob layout, see graph_transformer/mv_blob_format.h
+#define BLOB_ELF_HEADER_SIZE    48
+#define BLOB_MAGIC_NUMBER       8708
+
+typedef struct {
+    uint32_t magic_number;
+    uint32_t file_size;
+    uint32_t blob_ver_major;
+    uint32_t blob_ver_minor;
+    uint32_t num_shaves;
+    uint32_t bss_mem_size;
+    uint32_t stage_section_offset;
+    uint32_t buffer_section_offset;
+    uint32_t relocation_section_offset;
+} blobHeader_t;
+
+typedef struct {
+    uint32_t stage_count;
+    uint32_t stage_section_size;
+    uint32_t input_size;
+    uint32_t output_size;
+} blobStageSectionHeader_t;
+
+typedef struct {
+    int used;
+    uint32_t id;
+    streamId_t stream;
+    int hostWrites;     // the device reads the inputs the host writes
+    int hostReads;      // the device opened the stream to write results
+} emuFifo_t;
+
+typedef struct emuJob_t {
+    struct emuJob_t *next;
+    uint32_t ticket;
+    emuFifo_t *in;
+    emuFifo_t *out;
+} emuJob_t;
+
+struct emuSession_t;
+
+typedef struct {
+    int used;
+    uint32_t id;
+    uint32_t blobSize;
+    streamId_t stream;
+    uint32_t inputSize;
+    uint32_t outputSize;
+    uint32_t nstages;
+    uint8_t *output;
+    struct emuSession_t *session;
+
+    // triggers are queued in order, inputs are read and outputs are written
+    // in that order whatever executor ran the inference
+    pthread_mutex_t m;
+    pthread_cond_t cond;
+    pthread_mutex_t read_m;
+    emuJob_t *head;
+    emuJob_t *tail;
+    uint32_t nextTicket;
+    uint32_t nextOut;
+    int stop;
+    int executorCount;
+    pthread_t executors[EMU_MAX_EXECUTORS];
+} emuGraph_t;
+
+typedef struct emuSession_t {
+    ncEmulatorConfig_t config;
+    linkId_t link;
+    streamId_t deviceMonitor;
+    streamId_t graphMonitor;
+    pthread_t deviceThread;
+    int deviceThreadStarted;
+    pthread_mutex_t m;
+    uint32_t usedMemory;
+    emuGraph_t graphs[EMU_MAX_GRAPHS];
+    emuFifo_t fifos[EMU_MAX_FIFOS];
+} emuSession_t;
+
+static ncEmulatorConfig_t loopbackConfig;
+
+void ncEmulatorDefaultConfig(ncEmulatorConfig_t *config)
+{
+    config->max_graphs = 10;
+    config->max_fifos = 20;
+    config->max_memory = 500 * 1024 * 1024;
+    config->max_executors = 4;
+    config->latency_us = 10000;
+
+    const char *env = getenv("NC_EMULATOR_LATENCY_US");
+    if (env)
+        config->latency_us = atoi(env);
+    env = getenv("NC_EMULATOR_EXECUTORS");
+    if (env && atoi(env) > 0)
+        config->max_executors = atoi(env);
+}
+
+// Streams are created by the host, wait until its request arrived and open
+// the device half of it
+static streamId_t openHostStream(emuSession_t *s, const char *name, int writeSize)
+{
+    int waited;
+    streamId_t id = INVALID_STREAM_ID;
+    for (waited = 0; waited < STREAM_WAIT_MS; waited++) {
+        id = XLinkOpenStream(s->link, name, 0);
+        if (id != INVALID_STREAM_ID)
+            break;
+        usleep(1000);
+    }
+    if (id == INVALID_STREAM_ID) {
+        mvLog(MVLOG_WARN, "Host didn't open stream %s\n", name);
+        return INVALID_STREAM_ID;
+    }
+    if (writeSize)
+        id = XLinkOpenStream(s->link, name, writeSize);
+    return id;
+}
+
+static int sendAck(emuSession_t *s, int value)
+{
+    return XLinkWriteData(s->graphMonitor, (const uint8_t *) &value, sizeof(value));
+}
+
+/*############################### device monitor ###############################*/
+
+static int deviceCommand(emuSession_t *s, const deviceCommand_t *cmd)
+{
+    if (cmd->optionClass != 0) {
+        mvLog(MVLOG_WARN, "Unexpected device option class %u\n", cmd->optionClass);
+        return 0;
+    }
+    switch (cmd->type.c0) {
+    case CLASS0_DEVICE_CAPABILITIES: {
+        deviceCapabilities_t caps;
+        memset(&caps, 0, sizeof(caps));
+        caps.max_graphs = s->config.max_graphs;
+        caps.max_fifos = s->config.max_fifos;
+        caps.max_memory = s->config.max_memory;
+        caps.max_device_opt_class = 3;
+        caps.max_graph_opt_class = 3;
+        caps.max_executors = s->config.max_executors;
+        caps.fw_version[0] = 2;
+        caps.fw_version[1] = 2450;
+        return XLinkWriteData(s->deviceMonitor, (const uint8_t *) &caps, sizeof(caps));
+    }
+    case CLASS0_THERMAL_STATS: {
+        // thermal stats are followed by the throttling level, all zero
+        uint8_t stats[THERMAL_BUFFER_SIZE + sizeof(float)];
+        memset(stats, 0, sizeof(stats));
+        return XLinkWriteData(s->deviceMonitor, stats, sizeof(stats));
+    }
+    case CLASS0_OPT_LIST: {
+        char list[OPTIMISATION_NAME_LEN];
+        memset(list, 0, sizeof(list));
+        strcpy(list, "none~");
+        return XLinkWriteData(s->deviceMonitor, (const uint8_t *) list, sizeof(list));
+    }
+    case CLASS0_DEVICE_USED_MEMORY: {
+        pthread_mutex_lock(&s->m);
+        uint32_t used = s->usedMemory;
+        pthread_mutex_unlock(&s->m);
+        return XLinkWriteData(s->deviceMonitor, (const uint8_t *) &used, sizeof(used));
+    }
+    default:
+        mvLog(MVLOG_WARN, "Unexpected device command %d\n", cmd->type.c0);
+        return 0;
+    }
+}
+
+static void *deviceMonitorRun(void *ctx)
+{
+    emuSession_t *s = (emuSession_t *) ctx;
+    streamPacketDesc_t *packet;
+    deviceCommand_t cmd;
+
+    while (XLinkReadData(s->deviceMonitor, &packet) == X_LINK_SUCCESS) {
+        int valid = packet->length == sizeof(cmd);
+        if (valid)
+            memcpy(&cmd, packet->data, sizeof(cmd));
+        if (XLinkReleaseData(s->deviceMonitor) != X_LINK_SUCCESS)
+            break;
+        if (!valid) {
+            mvLog(MVLOG_WARN, "Broken device command of %u bytes\n", packet->length);
+            continue;
+        }
+        if (deviceCommand(s, &cmd))
+            break;
+    }
+    return NULL;
+}
+
+/*################################# executors ##################################*/
+
+static emuGraph_t *findGraph(emuSession_t *s, uint32_t id)
+{
+    int i;
+    for (i = 0; i < EMU_MAX_GRAPHS; i++)
+        if (s->graphs[i].used && s->graphs[i].id == id)
+            return &s->graphs[i];
+    return NULL;
+}
+
+static emuFifo_t *findFifo(emuSession_t *s, uint32_t id)
+{
+    int i;
+    for (i = 0; i < EMU_MAX_FIFOS; i++)
+        if (s->fifos[i].used && s->fifos[i].id == id)
+            return &s->fifos[i];
+    return NULL;
+}
+
+static void *executorRun(void *ctx)
+{
+    emuGraph_t *g = (emuGraph_t *) ctx;
+    streamPacketDesc_t *packet;
+
+    while (1) {
+        pthread_mutex_lock(&g->read_m);
+        pthread_mutex_lock(&g->m);
+        while (!g->head && !g->stop)
+            pthread_cond_wait(&g->cond, &g->m);
+        emuJob_t *job = g->head;
+        if (job) {
+            g->head = job->next;
+            if (!g->head)
+                g->tail = NULL;
+        }
+        pthread_mutex_unlock(&g->m);
+        if (!job) {
+            pthread_mutex_unlock(&g->read_m);
+            break;
+        }
+        int ok = 1;
+        if (job->in->hostWrites) {
+            ok = XLinkReadData(job->in->stream, &packet) == X_LINK_SUCCESS &&
+                 XLinkReleaseData(job->in->stream) == X_LINK_SUCCESS;
+        }
+        pthread_mutex_unlock(&g->read_m);
+
+        if (g->session->config.latency_us)
+            usleep(g->session->config.latency_us);
+
+        pthread_mutex_lock(&g->m);
+        while (g->nextOut != job->ticket)
+            pthread_cond_wait(&g->cond, &g->m);
+        pthread_mutex_unlock(&g->m);
+
+        if (ok && job->out->hostReads &&
+            XLinkWriteData(job->out->stream, g->output, g->outputSize) != X_LINK_SUCCESS)
+            mvLog(MVLOG_WARN, "Can't write the output of graph %u\n", g->id);
+
+        pthread_mutex_lock(&g->m);
+        g->nextOut++;
+        pthread_cond_broadcast(&g->cond);
+        pthread_mutex_unlock(&g->m);
+        free(job);
+    }
+    return NULL;
+}
+
+static void waitGraphIdle(emuGraph_t *g)
+{
+    pthread_mutex_lock(&g->m);
+    while (g->nextOut != g->nextTicket)
+        pthread_cond_wait(&g->cond, &g->m);
+    pthread_mutex_unlock(&g->m);
+}
+
+static void stopGraph(emuGraph_t *g)
+{
+    int i;
+    pthread_mutex_lock(&g->m);
+    g->stop = 1;
+    pthread_cond_broadcast(&g->cond);
+    pthread_mutex_unlock(&g->m);
+    for (i = 0; i < g->executorCount; i++)
+        pthread_join(g->executors[i], NULL);
+    pthread_mutex_destroy(&g->m);
+    pthread_mutex_destroy(&g->read_m);
+    pthread_cond_destroy(&g->cond);
+    free(g->output);
+    g->used = 0;
+}
+
+/*################################ graph monitor ###############################*/
+
+static int parseBlob(const uint8_t *blob, uint32_t length, emuGraph_t *g)
+{
+    blobHeader_t hdr;
+    blobStageSectionHeader_t stages;
+
+    if (length < BLOB_ELF_HEADER_SIZE + sizeof(hdr))
+        return -1;
+    memcpy(&hdr, blob + BLOB_ELF_HEADER_SIZE, sizeof(hdr));
+    if (hdr.magic_number != BLOB_MAGIC_NUMBER ||
+        hdr.stage_section_offset > length - sizeof(stages))
+        return -1;
+    memcpy(&stages, blob + hdr.stage_section_offset, sizeof(stages));
+    g->inputSize = stages.input_size;
+    g->outputSize = stages.output_size;
+    g->nstages = stages.stage_count;
+    return 0;
+}
+
+// Replies on the graph stream the way the firmware does, libmvnc reads three
+// packets before the ack whatever the outcome
+static int sendGraphInfo(emuGraph_t *g, int valid)
+{
+    struct tensorDescriptor_t in = {1, g->inputSize / 2, 1, 1, g->inputSize};
+    struct tensorDescriptor_t out = {1, g->outputSize / 2, 1, 1, g->outputSize};
+    int error = -1;
+
+    if (!valid) {
+        return XLinkWriteData(g->stream, (const uint8_t *) &error, sizeof(error)) ||
+               XLinkWriteData(g->stream, (const uint8_t *) &error, sizeof(error)) ||
+               XLinkWriteData(g->stream, (const uint8_t *) &error, sizeof(error));
+    }
+    return XLinkWriteData(g->stream, (const uint8_t *) &in, sizeof(in)) ||
+           XLinkWriteData(g->stream, (const uint8_t *) &out, sizeof(out)) ||
+           XLinkWriteData(g->stream, (const uint8_t *) &g->nstages, sizeof(g->nstages));
+}
+
+static int graphAllocate(emuSession_t *s, const graphCommand_t *cmd)
+{
+    emuGraph_t *g = NULL;
+    streamPacketDesc_t *packet;
+    char name[sizeof(cmd->streamName) + 1];
+    int i, allocated = 0;
+
+    for (i = 0; i < EMU_MAX_GRAPHS && i < (int) s->config.max_graphs; i++) {
+        if (s->graphs[i].used)
+            allocated++;
+        else if (!g)
+            g = &s->graphs[i];
+    }
+    memcpy(name, cmd->streamName, sizeof(cmd->streamName));
+    name[sizeof(cmd->streamName)] = '\0';
+
+    streamId_t stream = openHostStream(s, name, GRAPH_REPLY_STREAM_SIZE);
+    if (stream == INVALID_STREAM_ID || XLinkReadData(stream, &packet) != X_LINK_SUCCESS)
+        return -1;
+
+    emuGraph_t tmp;
+    memset(&tmp, 0, sizeof(tmp));
+    tmp.id = cmd->id;
+    tmp.stream = stream;
+    tmp.blobSize = packet->length;
+    int valid = parseBlob(packet->data, packet->length, &tmp) == 0;
+    if (XLinkReleaseData(stream) != X_LINK_SUCCESS)
+        return -1;
+    if (!valid)
+        mvLog(MVLOG_WARN, "Graph %u isn't a blob this device can parse\n", cmd->id);
+
+    pthread_mutex_lock(&s->m);
+    if (valid && (!g || s->usedMemory + tmp.blobSize > s->config.max_memory)) {
+        mvLog(MVLOG_WARN, "No room for graph %u (%d allocated)\n", cmd->id, allocated);
+        valid = 0;
+    }
+    if (valid)
+        s->usedMemory += tmp.blobSize;
+    pthread_mutex_unlock(&s->m);
+
+    if (valid) {
+        *g = tmp;
+        g->session = s;
+        g->output = calloc(1, g->outputSize ? g->outputSize : 1);
+        pthread_mutex_init(&g->m, NULL);
+        pthread_mutex_init(&g->read_m, NULL);
+        pthread_cond_init(&g->cond, NULL);
+
+        uint32_t executors = cmd->executors_number;
+        if (executors < 1)
+            executors = 1;
+        if (executors > s->config.max_executors)
+            executors = s->config.max_executors;
+        if (executors > EMU_MAX_EXECUTORS)
+            executors = EMU_MAX_EXECUTORS;
+        for (i = 0; i < (int) executors; i++) {
+            if (pthread_create(&g->executors[i], NULL, executorRun, g))
+                break;
+            g->executorCount++;
+        }
+        g->used = 1;
+        if (g->executorCount == 0) {
+            stopGraph(g);
+            pthread_mutex_lock(&s->m);
+            s->usedMemory -= tmp.blobSize;
+            pthread_mutex_unlock(&s->m);
+            valid = 0;
+        } else {
+            mvLog(MVLOG_INFO, "Graph %u: %u stages, %u -> %u bytes, %d executors\n",
+                  g->id, g->nstages, g->inputSize, g->outputSize, g->executorCount);
+        }
+    }
+    if (sendGraphInfo(valid ? g : &tmp, valid))
+        return -1;
+    return valid ? 0 : 1;
+}
+
+static int graphDeallocate(emuSession_t *s, const graphCommand_t *cmd)
+{
+    emuGraph_t *g = findGraph(s, cmd->id);
+    if (!g)
+        return 1;
+    streamId_t stream = g->stream;
+    uint32_t size = g->blobSize;
+    stopGraph(g);
+    pthread_mutex_lock(&s->m);
+    s->usedMemory -= size;
+    pthread_mutex_unlock(&s->m);
+    XLinkCloseStream(stream);
+    return 0;
+}
+
+static int graphTrigger(emuSession_t *s, const graphCommand_t *cmd)
+{
+    emuGraph_t *g = findGraph(s, cmd->id);
+    emuFifo_t *in = findFifo(s, cmd->buffId1);
+    emuFifo_t *out = findFifo(s, cmd->buffId2);
+    if (!g || !in || !out)
+        return 1;
+
+    emuJob_t *job = calloc(1, sizeof(emuJob_t));
+    if (!job)
+        return 1;
+    job->in = in;
+    job->out = out;
+
+    pthread_mutex_lock(&g->m);
+    job->ticket = g->nextTicket++;
+    if (g->tail)
+        g->tail->next = job;
+    else
+        g->head = job;
+    g->tail = job;
+    pthread_cond_signal(&g->cond);
+    pthread_mutex_unlock(&g->m);
+    return 0;
+}
+
+static int bufferAllocate(emuSession_t *s, const bufferCommand_t *cmd)
+{
+    emuFifo_t *f = NULL;
+    char name[sizeof(cmd->name) + 1];
+    int i;
+
+    for (i = 0; i < EMU_MAX_FIFOS && i < (int) s->config.max_fifos; i++) {
+        if (!s->fifos[i].used) {
+            f = &s->fifos[i];
+            break;
+        }
+    }
+    if (!f)
+        return 1;
+    memcpy(name, cmd->name, sizeof(cmd->name));
+    name[sizeof(cmd->name)] = '\0';
+
+    int writeSize = cmd->readChannel ? cmd->desc.totalSize * cmd->elemCnt : 0;
+    f->stream = openHostStream(s, name, writeSize);
+    if (f->stream == INVALID_STREAM_ID)
+        return -1;
+    f->id = cmd->id;
+    f->hostWrites = cmd->writeChannel;
+    f->hostReads = cmd->readChannel;
+    f->used = 1;
+    return 0;
+}
+
+static int bufferDeallocate(emuSession_t *s, const bufferCommand_t *cmd)
+{
+    streamPacketDesc_t *packet;
+    int i, level = 0;
+    emuFifo_t *f = findFifo(s, cmd->id);
+    if (!f)
+        return 1;
+
+    for (i = 0; i < EMU_MAX_GRAPHS; i++)
+        if (s->graphs[i].used)
+            waitGraphIdle(&s->graphs[i]);
+
+    // inputs nobody triggered on and the host's stop message are still
+    // queued, the host can't close the stream before they are released
+    if (f->hostWrites) {
+        while (XLinkGetFillLevel(f->stream, 0, &level) == X_LINK_SUCCESS && level > 0) {
+            if (XLinkReadData(f->stream, &packet) != X_LINK_SUCCESS ||
+                XLinkReleaseData(f->stream) != X_LINK_SUCCESS)
+                return -1;
+        }
+    }
+    if (f->hostReads)
+        XLinkCloseStream(f->stream);
+    f->used = 0;
+    return 0;
+}
+
+static int graphOption(emuSession_t *s, const graphMonCommand_t *cmd)
+{
+    if (cmd->cmdClass != GRAPH_MON_CLASS_GET_CLASS0)
+        return 0;
+
+    emuGraph_t *g = findGraph(s, cmd->cmd.optionCmd.id);
+    switch (cmd->cmd.optionCmd.type.c0) {
+    case CLASS0_TIMING_DATA: {
+        uint32_t nstages = g ? g->nstages : 0;
+        float *timings = calloc(nstages ? nstages : 1, sizeof(float));
+        uint32_t i;
+        if (!timings)
+            return -1;
+        for (i = 0; i < nstages; i++)
+            timings[i] = s->config.latency_us / 1000.0f / nstages;
+        int rc = XLinkWriteData(s->graphMonitor, (const uint8_t *) timings, nstages * sizeof(float));
+        free(timings);
+        return rc ? -1 : 0;
+    }
+    case CLASS0_DEBUG_DATA: {
+        char debug[DEBUG_BUFFER_SIZE];
+        memset(debug, 0, sizeof(debug));
+        snprintf(debug, sizeof(debug), "emulated device");
+        return XLinkWriteData(s->graphMonitor, (const uint8_t *) debug, sizeof(debug)) ? -1 : 0;
+    }
+    default:
+        return 1;
+    }
+}
+
+// Returns the status acked to the host, -1 when the link is gone
+static int graphMonitorCommand(emuSession_t *s, const graphMonCommand_t *cmd)
+{
+    switch (cmd->cmdClass) {
+    case GRAPH_MON_CLASS_GRAPH_CMD:
+        switch (cmd->cmd.graphCmd.type) {
+        case GRAPH_ALLOCATE_CMD:
+            return graphAllocate(s, &cmd->cmd.graphCmd);
+        case GRAPH_DEALLOCATE_CMD:
+            return graphDeallocate(s, &cmd->cmd.graphCmd);
+        case GRAPH_TRIGGER_CMD:
+            return graphTrigger(s, &cmd->cmd.graphCmd);
+        default:
+            return 1;
+        }
+    case GRAPH_MON_CLASS_BUFFER_CMD:
+        switch (cmd->cmd.buffCmd.type) {
+        case BUFFER_ALLOCATE_CMD:
+            return bufferAllocate(s, &cmd->cmd.buffCmd);
+        case BUFFER_DEALLOCATE_CMD:
+            return bufferDeallocate(s, &cmd->cmd.buffCmd);
+        default:
+            return 1;
+        }
+    default:
+        return graphOption(s, cmd);
+    }
+}
+
+static void *sessionRun(void *ctx)
+{
+    emuSession_t *s = (emuSession_t *) ctx;
+    streamPacketDesc_t *packet;
+    graphMonCommand_t cmd;
+    int i;
+
+    s->deviceMonitor = openHostStream(s, "deviceMonitor", CONFIG_STREAM_SIZE);
+    if (s->deviceMonitor != INVALID_STREAM_ID &&
+        pthread_create(&s->deviceThread, NULL, deviceMonitorRun, s) == 0)
+        s->deviceThreadStarted = 1;
+
+    if (s->deviceThreadStarted)
+        s->graphMonitor = openHostStream(s, "graphMonitor", BLOB_STREAM_SIZE);
+    while (s->deviceThreadStarted && s->graphMonitor != INVALID_STREAM_ID &&
+           XLinkReadData(s->graphMonitor, &packet) == X_LINK_SUCCESS) {
+        int valid = packet->length == sizeof(cmd);
+        if (valid)
+            memcpy(&cmd, packet->data, sizeof(cmd));
+        if (XLinkReleaseData(s->graphMonitor) != X_LINK_SUCCESS)
+            break;
+        int rc = valid ? graphMonitorCommand(s, &cmd) : 1;
+        if (rc < 0 || sendAck(s, rc))
+            break;
+    }
+
+    // drop the link so that the host and the device monitor see it's gone
+    mvLog(MVLOG_INFO, "Emulated device session on link %d ends\n", s->link);
+    XLinkResetRemote(s->link);
+    if (s->deviceThreadStarted)
+        pthread_join(s->deviceThread, NULL);
+    for (i = 0; i < EMU_MAX_GRAPHS; i++)
+        if (s->graphs[i].used)
+            stopGraph(&s->graphs[i]);
+    pthread_mutex_destroy(&s->m);
+    free(s);
+    return NULL;
+}
+
+int ncEmulatorServe(void *fd, const ncEmulatorConfig_t *config)
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+    emuSession_t *s = calloc(1, sizeof(emuSession_t));
+    if (!s)
+        return -1;
+    s->config = *config;
+    pthread_mutex_init(&s->m, NULL);
+
+    if (XLinkAccept(fd, &s->link) != X_LINK_SUCCESS) {
+        mvLog(MVLOG_ERROR, "Can't serve a new link\n");
+        pthread_mutex_destroy(&s->m);
+        free(s);
+        return -1;
+    }
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int rc = pthread_create(&thread, &attr, sessionRun, s);
+    pthread_attr_destroy(&attr);
+    if (rc) {
+        XLinkResetRemote(s->link);
+        pthread_mutex_destroy(&s->m);
+        free(s);
+        return -1;
+    }
+    return 0;
+}
+
+static void loopbackPeer(void *fd, void *ctx)
+{
+    ncEmulatorServe(fd, (const ncEmulatorConfig_t *) ctx);
+}
+
+void ncEmulatorInstallLoopback(const ncEmulatorConfig_t *config)
+{
+    if (config)
+        loopbackConfig = *config;
+    else
+        ncEmulatorDefaultConfig(&loopbackConfig);
+    xLinkLoopbackSetPeer(loopbackPeer, &loopbackConfig);
+}
+
+int ncEmulatorRunSocket(const char *path, const ncEmulatorConfig_t *config)
+{
+    int sock = xLinkSocketListen(path);
+    if (sock < 0) {
+        mvLog(MVLOG_ERROR, "Can't listen on %s\n", path);
+        return -1;
+    }
+    mvLog(MVLOG_INFO, "Emulated device listening on %s\n", path);
+    while (1) {
+        void *fd = xLinkSocketAccept(sock);
+        if (!fd)
+            break;
+        ncEmulatorServe(fd, config);
+    }
+    close(sock);
+    return -1;
+}
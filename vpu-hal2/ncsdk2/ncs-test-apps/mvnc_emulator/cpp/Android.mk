@@ -0,0 +1,28 @@
+LOCAL_PATH:= $(call my-dir)
+
+# ==================================
+
+# executable: mvnc_emulator
+$(info LOCAL_PATH =$(LOCAL_PATH))
+include $(CLEAR_VARS)
+
+MVNC_API:= $(LOCAL_PATH)/../../../api
+
+LOCAL_SRC_FILES := mvnc_emulator.cpp
+
+LOCAL_MODULE := mvnc_emulator
+
+LOCAL_C_INCLUDES += \
+	$(LOCAL_PATH) \
+	$(MVNC_API)/include \
+	$(MVNC_API)/src/common/components/XLink/shared \
+	$(MVNC_API)/src/common/shared/include
+
+
+LOCAL_CFLAGS += -O2 -Wall -pthread -fPIC -MMD -MP -fPIE -D__PC__ -DXLINK_EMULATOR
+
+# the emulator is only in the static test variant of libmvnc
+LOCAL_SHARED_LIBRARIES := liblog libusb1.0
+LOCAL_STATIC_LIBRARIES := libmvnc_emulator
+
+include $(BUILD_EXECUTABLE)
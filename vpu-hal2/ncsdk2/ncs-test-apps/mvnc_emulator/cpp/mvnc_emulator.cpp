@@ -0,0 +1,65 @@
+// Copyright 2017 Intel Corporation.
+// The source code, information and material ("Material") contained herein is
+// owned by Intel Corporation or its suppliers or licensors, and title to such
+// Material remains with Intel Corporation or its suppliers or licensors.
+// The Material contains proprietary information of Intel or its suppliers and
+// licensors. The Material is protected by worldwide copyright laws and treaty
+// provisions.
+// No part of the Material may be used, copied, reproduced, modified, published,
+// uploaded, posted, transmitted, distributed or disclosed in any way without
+// Intel's prior express written permission. No license under any patent,
+// copyright or other intellectual property rights in the Material is granted to
+// or conferred upon you, either expressly, by implication, inducement, estoppel
+// or otherwise.
+// Any license under such intellectual property rights must be express and
+// approved by Intel in writing.
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <XLink.h>
+#include <ncDeviceEmulator.h>
+
+static void usage(const char* name)
+{
+    printf("Usage: %s [-s socket] [-l latency_us] [-e executors]\n", name);
+    printf("    socket defaults to /tmp/xlink_emulator.sock, run the host with\n");
+    printf("    XLINK_TRANSPORT=socket XLINK_SOCKET_PATH=<socket>\n");
+}
+
+int main(int argc, char** argv)
+{
+    const char* path = "/tmp/xlink_emulator.sock";
+    ncEmulatorConfig_t config;
+    ncEmulatorDefaultConfig(&config);
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+            path = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "-l") == 0) {
+            config.latency_us = atoi(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "-e") == 0) {
+            config.max_executors = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // The emulator is the device end of the socket transport
+    static XLinkGlobalHandler_t ghandler;
+    if (XLinkSetTransport("socket") != X_LINK_SUCCESS ||
+        XLinkInitialize(&ghandler) != X_LINK_SUCCESS) {
+        printf("Error - XLink initialization failed.\n");
+        return 1;
+    }
+
+    printf("Emulating a ma2450 on %s, %u us per inference, %u executors\n",
+           path, config.latency_us, config.max_executors);
+    ncEmulatorRunSocket(path, &config);
+    printf("Error - can't serve %s.\n", path);
+    return 1;
+}
@@ -0,0 +1,32 @@
+LOCAL_PATH:= $(call my-dir)
+
+# ==================================
+
+# executable: usb_link_bench
+$(info LOCAL_PATH =$(LOCAL_PATH))
+include $(CLEAR_VARS)
+
+MVNC_API:= $(LOCAL_PATH)/../../../api
+LIBUSB_HEADER:= $(LOCAL_PATH)/../../../../../../../../../../external/libusb/libusb
+
+# the transfer engine of libmvnc, built against libusb_stub.c instead of libusb
+LOCAL_SRC_FILES := \
+	usb_link_bench.cpp \
+	libusb_stub.c \
+	../../../api/src/common/components/XLink/pc/UsbLinkTransfer.c
+
+LOCAL_MODULE := usb_link_bench
+
+LOCAL_C_INCLUDES += \
+	$(LOCAL_PATH) \
+	$(LIBUSB_HEADER) \
+	$(MVNC_API)/src/common/components/XLink/shared \
+	$(MVNC_API)/src/common/components/XLink/pc
+
+
+LOCAL_CFLAGS += -O2 -Wall -pthread -fPIC -MMD -MP -fPIE
+
+LOCAL_SHARED_LIBRARIES := liblog
+LOCAL_STATIC_LIBRARIES :=
+
+include $(BUILD_EXECUTABLE)
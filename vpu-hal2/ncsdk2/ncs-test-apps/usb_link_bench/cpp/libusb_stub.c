@@ -0,0 +1,183 @@
+// Copyright 2017 Intel Corporation.
+// The source code, information and material ("Material") contained herein is
+// owned by Intel Corporation or its suppliers or licensors, and title to such
+// Material remains with Intel Corporation or its suppliers or licensors.
+// The Material contains proprietary information of Intel or its suppliers and
+// licensors. The Material is protected by worldwide copyright laws and treaty
+// provisions.
+// No part of the Material may be used, copied, reproduced, modified, published,
+// uploaded, posted, transmitted, distributed or disclosed in any way without
+// Intel's prior express written permission. No license under any patent,
+// copyright or other intellectual property rights in the Material is granted to
+// or conferred upon you, either expressly, by implication, inducement, estoppel
+// or otherwise.
+// Any license under such intellectual property rights must be express and
+// approved by Intel in writing.
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libusb.h>
+#include "libusb_stub.h"
+
+#define MAX_PENDING 64
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t submitted = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t finished = PTHREAD_COND_INITIALIZER;
+static pthread_t bus;
+static int busStarted;
+
+static struct libusb_transfer* pending[MAX_PENDING];
+static double pendingSince[MAX_PENDING];
+static int pendingCount;
+static struct libusb_transfer* done[MAX_PENDING];
+static int doneCount;
+
+static unsigned int latency;
+static double bandwidth = 400e6;
+static uint8_t* sinkData;
+static size_t sinkLength;
+static size_t written;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void sleepUntil(double t)
+{
+    double d = t - now();
+    if (d <= 0)
+        return;
+    struct timespec ts;
+    ts.tv_sec = (time_t) d;
+    ts.tv_nsec = (long) ((d - ts.tv_sec) * 1e9);
+    nanosleep(&ts, NULL);
+}
+
+static void* busThread(void* arg)
+{
+    double busFree = 0;
+    (void) arg;
+    pthread_mutex_lock(&lock);
+    for (;;) {
+        while (pendingCount == 0)
+            pthread_cond_wait(&submitted, &lock);
+        struct libusb_transfer* transfer = pending[0];
+        double start = pendingSince[0] + latency * 1e-6;
+        if (start < busFree)
+            start = busFree;
+        double end = start + transfer->length / bandwidth;
+        pthread_mutex_unlock(&lock);
+        sleepUntil(end);
+        pthread_mutex_lock(&lock);
+        busFree = end;
+        // a cancel may have taken it meanwhile
+        if (pendingCount == 0 || pending[0] != transfer)
+            continue;
+        pendingCount--;
+        memmove(pending, pending + 1, pendingCount * sizeof(pending[0]));
+        memmove(pendingSince, pendingSince + 1, pendingCount * sizeof(pendingSince[0]));
+        if (sinkData && written + transfer->length <= sinkLength)
+            memcpy(sinkData + written, transfer->buffer, transfer->length);
+        written += transfer->length;
+        transfer->status = LIBUSB_TRANSFER_COMPLETED;
+        transfer->actual_length = transfer->length;
+        done[doneCount++] = transfer;
+        pthread_cond_broadcast(&finished);
+    }
+    return NULL;
+}
+
+void libusbStubConfigure(unsigned int latencyUs, double bytesPerSecond,
+                         uint8_t* sink, size_t sinkSize)
+{
+    pthread_mutex_lock(&lock);
+    latency = latencyUs;
+    bandwidth = bytesPerSecond;
+    sinkData = sink;
+    sinkLength = sinkSize;
+    written = 0;
+    if (!busStarted && pthread_create(&bus, NULL, busThread, NULL) == 0)
+        busStarted = 1;
+    pthread_mutex_unlock(&lock);
+}
+
+size_t libusbStubBytesWritten(void)
+{
+    pthread_mutex_lock(&lock);
+    size_t n = written;
+    pthread_mutex_unlock(&lock);
+    return n;
+}
+
+struct libusb_transfer* LIBUSB_CALL libusb_alloc_transfer(int iso_packets)
+{
+    (void) iso_packets;
+    return (struct libusb_transfer*) calloc(1, sizeof(struct libusb_transfer));
+}
+
+void LIBUSB_CALL libusb_free_transfer(struct libusb_transfer* transfer)
+{
+    free(transfer);
+}
+
+int LIBUSB_CALL libusb_submit_transfer(struct libusb_transfer* transfer)
+{
+    pthread_mutex_lock(&lock);
+    if (pendingCount == MAX_PENDING) {
+        pthread_mutex_unlock(&lock);
+        return LIBUSB_ERROR_BUSY;
+    }
+    pending[pendingCount] = transfer;
+    pendingSince[pendingCount] = now();
+    pendingCount++;
+    pthread_cond_signal(&submitted);
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
+
+int LIBUSB_CALL libusb_cancel_transfer(struct libusb_transfer* transfer)
+{
+    int i;
+    pthread_mutex_lock(&lock);
+    for (i = 0; i < pendingCount; i++)
+        if (pending[i] == transfer)
+            break;
+    if (i == pendingCount) {
+        pthread_mutex_unlock(&lock);
+        return LIBUSB_ERROR_NOT_FOUND;
+    }
+    pendingCount--;
+    memmove(pending + i, pending + i + 1, (pendingCount - i) * sizeof(pending[0]));
+    memmove(pendingSince + i, pendingSince + i + 1, (pendingCount - i) * sizeof(pendingSince[0]));
+    transfer->status = LIBUSB_TRANSFER_CANCELLED;
+    transfer->actual_length = 0;
+    done[doneCount++] = transfer;
+    pthread_cond_broadcast(&finished);
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
+
+int LIBUSB_CALL libusb_handle_events_completed(libusb_context* ctx, int* completed)
+{
+    struct libusb_transfer* ready[MAX_PENDING];
+    int count, i;
+    (void) ctx;
+    pthread_mutex_lock(&lock);
+    while (doneCount == 0 && !(completed && *completed))
+        pthread_cond_wait(&finished, &lock);
+    count = doneCount;
+    memcpy(ready, done, count * sizeof(ready[0]));
+    doneCount = 0;
+    pthread_mutex_unlock(&lock);
+    // callbacks run outside the lock, as libusb does
+    for (i = 0; i < count; i++)
+        ready[i]->callback(ready[i]);
+    return 0;
+}
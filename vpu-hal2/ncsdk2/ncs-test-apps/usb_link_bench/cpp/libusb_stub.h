@@ -0,0 +1,43 @@
+// Copyright 2017 Intel Corporation.
+// The source code, information and material ("Material") contained herein is
+// owned by Intel Corporation or its suppliers or licensors, and title to such
+// Material remains with Intel Corporation or its suppliers or licensors.
+// The Material contains proprietary information of Intel or its suppliers and
+// licensors. The Material is protected by worldwide copyright laws and treaty
+// provisions.
+// No part of the Material may be used, copied, reproduced, modified, published,
+// uploaded, posted, transmitted, distributed or disclosed in any way without
+// Intel's prior express written permission. No license under any patent,
+// copyright or other intellectual property rights in the Material is granted to
+// or conferred upon you, either expressly, by implication, inducement, estoppel
+// or otherwise.
+// Any license under such intellectual property rights must be express and
+// approved by Intel in writing.
+
+// Stand-in for the libusb calls UsbLinkTransfer.c makes. An OUT endpoint is
+// modeled as a bus that takes latency_us to start each transfer and then
+// moves bytes_per_second; transfers in flight overlap their start latency
+// with the data phase of the one before them, as on a real host controller.
+
+#ifndef _LIBUSB_STUB_H
+#define _LIBUSB_STUB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// sink, if not NULL, receives the bytes written, in order, up to sinkSize
+void libusbStubConfigure(unsigned int latencyUs, double bytesPerSecond,
+                         uint8_t* sink, size_t sinkSize);
+
+// Bytes the bus accepted since the last libusbStubConfigure
+size_t libusbStubBytesWritten(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,122 @@
+// Copyright 2017 Intel Corporation.
+// The source code, information and material ("Material") contained herein is
+// owned by Intel Corporation or its suppliers or licensors, and title to such
+// Material remains with Intel Corporation or its suppliers or licensors.
+// The Material contains proprietary information of Intel or its suppliers and
+// licensors. The Material is protected by worldwide copyright laws and treaty
+// provisions.
+// No part of the Material may be used, copied, reproduced, modified, published,
+// uploaded, posted, transmitted, distributed or disclosed in any way without
+// Intel's prior express written permission. No license under any patent,
+// copyright or other intellectual property rights in the Material is granted to
+// or conferred upon you, either expressly, by implication, inducement, estoppel
+// or otherwise.
+// Any license under such intellectual property rights must be express and
+// approved by Intel in writing.
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <vector>
+
+#include <UsbLinkTransfer.h>
+#include "libusb_stub.h"
+
+static void usage(const char* name)
+{
+    printf("Usage: %s [-l latency_us] [-b MB/s] [-s MiB] [-g segments]\n", name);
+    printf("    sweeps the chunk size and the queue depth of usbLinkBulkWrite\n");
+    printf("    against a simulated bus and prints the throughput in MB/s\n");
+}
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int latencyUs = 100;
+    double bandwidth = 400;
+    size_t total = 64;
+    int segmentCount = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "-l") == 0) {
+            latencyUs = atoi(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "-b") == 0) {
+            bandwidth = atof(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+            total = atoi(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "-g") == 0) {
+            segmentCount = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (total == 0 || segmentCount < 1 || bandwidth <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    total *= 1024 * 1024;
+
+    std::vector<uint8_t> data(total);
+    std::vector<uint8_t> sink(total);
+    for (size_t i = 0; i < total; i++)
+        data[i] = (uint8_t) (i * 7 + i / 4093);
+
+    // odd sized pieces, like the inputs of a multi input network
+    std::vector<streamSegmentDesc_t> segments(segmentCount);
+    size_t offset = 0;
+    for (int i = 0; i < segmentCount; i++) {
+        size_t length = i + 1 < segmentCount ? total / segmentCount - 3 * i - 1 : total - offset;
+        segments[i].data = data.data() + offset;
+        segments[i].length = (uint32_t) length;
+        offset += length;
+    }
+
+    static const int chunkSizes[] = {16 << 10, 64 << 10, 256 << 10, 1 << 20, 4 << 20};
+    static const int queueDepths[] = {1, 2, 4, 8};
+
+    printf("%zu MiB in %d segment(s), %u us per transfer, %.0f MB/s bus\n",
+           total >> 20, segmentCount, latencyUs, bandwidth);
+    printf("%10s", "chunk");
+    for (int depth : queueDepths)
+        printf("   depth %-3d", depth);
+    printf("\n");
+
+    for (int chunk : chunkSizes) {
+        printf("%8dK ", chunk >> 10);
+        for (int depth : queueDepths) {
+            usbLinkTransferConfig_t config;
+            config.chunkSize = chunk;
+            config.queueDepth = depth;
+            memset(sink.data(), 0, total);
+            libusbStubConfigure(latencyUs, bandwidth * 1e6, sink.data(), total);
+
+            double start = now();
+            int rc = usbLinkBulkWrite(NULL, 0x01, segments.data(), segmentCount, 0, &config);
+            double elapsed = now() - start;
+
+            if (rc != 0) {
+                printf("\nError - write failed with %d\n", rc);
+                return 1;
+            }
+            if (libusbStubBytesWritten() != total || memcmp(sink.data(), data.data(), total) != 0) {
+                printf("\nError - the data written doesn't match\n");
+                return 1;
+            }
+            printf("  %10.1f", total / elapsed / 1e6);
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+    return 0;
+}
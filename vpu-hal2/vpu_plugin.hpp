@@ -114,16 +114,19 @@ class ExecuteNetwork
 public:
     ExecuteNetwork(){}
     ExecuteNetwork(IRDocument &doc, TargetDevice target = TargetDevice::eCPU)
+        : ExecuteNetwork(*doc.getNetwork(), target) {}
+
+    ExecuteNetwork(ICNNNetwork &net, TargetDevice target = TargetDevice::eCPU)
     {
         InferenceEngine::PluginDispatcher dispatcher({"/vendor/lib64","/vendor/lib","/system/lib64","/system/lib","","./"});
         enginePtr = dispatcher.getSuitablePlugin(target);
 
-        network = doc.getNetwork();
+        network = &net;
         network->getInputsInfo(inputInfo);
         network->getOutputsInfo(outputInfo);
 
-        size_t batch = 1;
-        network->setBatchSize(batch);
+        // the network keeps the batch of its operands, the Myriad plugin
+        // compiles batch > 1 as the stages of one image run for each image
 
     		#ifdef NNLOG
             ALOGI("Myriad Plugin loaded");
@@ -137,11 +140,14 @@ public:
 
     }
 
-    void loadNetwork()
+    void loadNetwork(const std::map<std::string, std::string>& extraConfig = std::map<std::string, std::string>())
     {
 
         std::map<std::string, std::string> networkConfig;
         setConfig(networkConfig);
+        for (const auto& option : extraConfig) {
+            networkConfig[option.first] = option.second;
+        }
 
         InferencePlugin plugin(enginePtr);
         executable_network = plugin.LoadNetwork(*network, networkConfig);
@@ -243,4 +249,19 @@ public:
 
         return;
     }
+
+    void startAsync() {
+        inferRequest.StartAsync();
+    }
+
+    //blocks until the request started by startAsync() is done, STATUS_ONLY just polls
+    StatusCode wait(int64_t timeout = IInferRequest::WaitMode::RESULT_READY) {
+        return inferRequest.Wait(timeout);
+    }
+
+    //callback is invoked from the plugin's thread once a startAsync() request completes
+    template <typename T>
+    void setCompletionCallback(const T& callback) {
+        inferRequest.SetCompletionCallback(callback);
+    }
 };